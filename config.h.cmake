@@ -8,7 +8,9 @@
 #cmakedefine HAVE_LIBEXECINFO
 #cmakedefine HAVE_CXXABI_H
 #cmakedefine HAVE_NICE
+#cmakedefine HAVE_INOTIFY
 #cmakedefine HAVE_EDITLINE
+#cmakedefine HAVE_ZLIB
 
 #cmakedefine ICINGA2_UNITY_BUILD
 
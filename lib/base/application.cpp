@@ -53,6 +53,8 @@ Application::Ptr Application::m_Instance = NULL;
 bool Application::m_ShuttingDown = false;
 bool Application::m_RequestRestart = false;
 bool Application::m_RequestReopenLogs = false;
+bool Application::m_RequestHandover = false;
+double Application::m_ReloadRequestTime = 0;
 pid_t Application::m_ReloadProcess = 0;
 static bool l_Restarting = false;
 static bool l_InExceptionHandler = false;
@@ -367,15 +369,23 @@ pid_t Application::StartReloadProcess(void)
 	args->Add(GetExePath(m_ArgV[0]));
 
 	for (int i=1; i < Application::GetArgC(); i++) {
-		if (std::string(Application::GetArgV()[i]) != "--reload-internal")
-			args->Add(Application::GetArgV()[i]);
+		std::string arg = Application::GetArgV()[i];
+
+		/* the next parameter after --reload-internal/--reload-handover is its value, remove that too */
+		if (arg == "--reload-internal" || arg == "--reload-handover")
+			i++;
 		else
-			i++;     // the next parameter after --reload-internal is the pid, remove that too
+			args->Add(String(arg));
 	}
 
 #ifndef _WIN32
 	args->Add("--reload-internal");
 	args->Add(Convert::ToString(Utility::GetPid()));
+
+	/* Tells the new process that we can hand over our state in memory
+	 * and when the reload was requested. */
+	args->Add("--reload-handover");
+	args->Add(Convert::ToString(m_ReloadRequestTime));
 #else /* _WIN32 */
 	args->Add("--validate");
 #endif /* _WIN32 */
@@ -404,9 +414,36 @@ void Application::RequestShutdown(void)
  */
 void Application::RequestRestart(void)
 {
+	if (!l_Restarting)
+		m_ReloadRequestTime = Utility::GetTime();
+
 	m_RequestRestart = true;
 }
 
+/**
+ * Signals the application to shut down and to hand over its
+ * program state to the reload process instead of writing it
+ * to the state file. Only honored while a reload is in progress.
+ */
+void Application::RequestHandover(void)
+{
+	if (!l_Restarting)
+		return;
+
+	m_RequestHandover = true;
+	RequestShutdown();
+}
+
+/**
+ * Returns whether the reload process has asked for a state handover.
+ *
+ * @returns true if the handover was requested, false otherwise.
+ */
+bool Application::IsHandoverRequested(void)
+{
+	return m_RequestHandover;
+}
+
 /**
  * Signals the application to reopen log files during the
  * next execution of the event loop.
@@ -670,6 +707,17 @@ void Application::SigUsr1Handler(int)
 	RequestReopenLogs();
 }
 
+/**
+ * Signal handler for SIGUSR2. The reload process sends this signal once
+ * its configuration is valid and it is ready to receive our state.
+ *
+ * @param - The signal number.
+ */
+void Application::SigUsr2Handler(int)
+{
+	RequestHandover();
+}
+
 /**
  * Signal handler for SIGABRT. Helps with debugging ASSERT()s.
  *
@@ -888,6 +936,9 @@ int Application::Run(void)
 
 	sa.sa_handler = &Application::SigUsr1Handler;
 	sigaction(SIGUSR1, &sa, NULL);
+
+	sa.sa_handler = &Application::SigUsr2Handler;
+	sigaction(SIGUSR2, &sa, NULL);
 #else /* _WIN32 */
 	SetConsoleCtrlHandler(&Application::CtrlHandler, TRUE);
 #endif /* _WIN32 */
@@ -1411,6 +1462,34 @@ void Application::SetLastReloadFailed(double ts)
 	m_LastReloadFailed = ts;
 }
 
+/**
+ * Retrieves the time when the current reload was requested. In a
+ * process which took over the state of its predecessor this is the
+ * time when the reload which started it was requested.
+ *
+ * @returns The timestamp, or 0 if there was no reload.
+ */
+double Application::GetReloadRequestTime(void)
+{
+	return m_ReloadRequestTime;
+}
+
+void Application::SetReloadRequestTime(double ts)
+{
+	m_ReloadRequestTime = ts;
+}
+
+/**
+ * Retrieves the path of the socket which is used to hand over
+ * the program state to the reload process.
+ *
+ * @returns The path.
+ */
+String Application::GetHandoverPath(void)
+{
+	return GetStatePath() + ".handover";
+}
+
 void Application::ValidateName(const String& value, const ValidationUtils& utils)
 {
 	ObjectImpl<Application>::ValidateName(value, utils);
@@ -72,8 +72,10 @@ public:
 	static void RequestShutdown(void);
 	static void RequestRestart(void);
 	static void RequestReopenLogs(void);
+	static void RequestHandover(void);
 
 	static bool IsShuttingDown(void);
+	static bool IsHandoverRequested(void);
 
 	static void SetDebuggingSeverity(LogSeverity severity);
 	static LogSeverity GetDebuggingSeverity(void);
@@ -146,6 +148,11 @@ public:
 	static double GetLastReloadFailed(void);
 	static void SetLastReloadFailed(double ts);
 
+	static double GetReloadRequestTime(void);
+	static void SetReloadRequestTime(double ts);
+
+	static String GetHandoverPath(void);
+
 	static void DisplayInfoMessage(std::ostream& os, bool skipVersion = false);
 
 protected:
@@ -169,6 +176,9 @@ private:
 	static pid_t m_ReloadProcess; /**< The PID of a subprocess doing a reload, 
 									only valid when l_Restarting==true */
 	static bool m_RequestReopenLogs; /**< Whether we should re-open log files. */
+	static bool m_RequestHandover; /**< Whether the reload process asked for our state. */
+	static double m_ReloadRequestTime; /**< When the reload which started this process
+					     (or the current one) was requested. */
 
 	static int m_ArgC; /**< The number of command-line arguments. */
 	static char **m_ArgV; /**< Command-line arguments. */
@@ -191,6 +201,7 @@ private:
 
 	static void SigAbrtHandler(int signum);
 	static void SigUsr1Handler(int signum);
+	static void SigUsr2Handler(int signum);
 	static void ExceptionHandler(void);
 
 	static String GetCrashReportFilename(void);
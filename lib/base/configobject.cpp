@@ -496,6 +496,32 @@ void ConfigObject::DumpObjects(const String& filename, int attributeTypes)
 
 	StdioStream::Ptr sfp = new StdioStream(&fp, false);
 
+	WriteObjects(sfp, attributeTypes);
+
+	sfp->Close();
+
+	fp.close();
+
+#ifdef _WIN32
+	_unlink(filename.CStr());
+#endif /* _WIN32 */
+
+	if (rename(tempFilename.CStr(), filename.CStr()) < 0) {
+		BOOST_THROW_EXCEPTION(posix_error()
+		    << boost::errinfo_api_function("rename")
+		    << boost::errinfo_errno(errno)
+		    << boost::errinfo_file_name(tempFilename));
+	}
+}
+
+/**
+ * Marks the end of a program state stream. Object messages are always
+ * JSON dictionaries so this can't be mistaken for one of them.
+ */
+static const char *l_StateStreamEnd = "end";
+
+void ConfigObject::WriteObjects(const Stream::Ptr& stream, int attributeTypes)
+{
 	for (const Type::Ptr& type : Type::GetAllTypes()) {
 		ConfigType *dtype = dynamic_cast<ConfigType *>(type.get());
 
@@ -517,24 +543,23 @@ void ConfigObject::DumpObjects(const String& filename, int attributeTypes)
 
 			String json = JsonEncode(persistentObject);
 
-			NetString::WriteStringToStream(sfp, json);
+			NetString::WriteStringToStream(stream, json);
 		}
 	}
+}
 
-	sfp->Close();
-
-	fp.close();
-
-#ifdef _WIN32
-	_unlink(filename.CStr());
-#endif /* _WIN32 */
-
-	if (rename(tempFilename.CStr(), filename.CStr()) < 0) {
-		BOOST_THROW_EXCEPTION(posix_error()
-		    << boost::errinfo_api_function("rename")
-		    << boost::errinfo_errno(errno)
-		    << boost::errinfo_file_name(tempFilename));
-	}
+/**
+ * Writes the program state to a stream, e.g. for handing it over to
+ * another process. The receiver uses the end marker to tell a complete
+ * stream from one which was cut short.
+ *
+ * @param stream The stream.
+ * @param attributeTypes The attribute types which should be written.
+ */
+void ConfigObject::DumpObjects(const Stream::Ptr& stream, int attributeTypes)
+{
+	WriteObjects(stream, attributeTypes);
+	NetString::WriteStringToStream(stream, l_StateStreamEnd);
 }
 
 void ConfigObject::RestoreObject(const String& message, int attributeTypes)
@@ -572,15 +597,52 @@ void ConfigObject::RestoreObjects(const String& filename, int attributeTypes)
 
 	StdioStream::Ptr sfp = new StdioStream (&fp, false);
 
+	unsigned long restored = ReadObjects(sfp, attributeTypes, NULL);
+
+	sfp->Close();
+
+	LoadObjectsWithoutState(restored);
+}
+
+/**
+ * Restores the program state from a stream which was written by
+ * DumpObjects(const Stream::Ptr&, int).
+ *
+ * @param stream The stream.
+ * @param attributeTypes The attribute types which should be restored.
+ * @returns true if the stream was complete, false otherwise. In the latter
+ * case the caller should restore the state from another source.
+ */
+bool ConfigObject::RestoreObjects(const Stream::Ptr& stream, int attributeTypes)
+{
+	bool complete;
+	unsigned long restored = ReadObjects(stream, attributeTypes, &complete);
+
+	if (!complete) {
+		Log(LogWarning, "ConfigObject")
+		    << "Program state stream ended prematurely after " << restored << " objects.";
+		return false;
+	}
+
+	LoadObjectsWithoutState(restored);
+
+	return true;
+}
+
+unsigned long ConfigObject::ReadObjects(const Stream::Ptr& stream, int attributeTypes, bool *complete)
+{
 	unsigned long restored = 0;
 
+	if (complete)
+		*complete = false;
+
 	WorkQueue upq(25000, Application::GetConcurrency());
 	upq.SetName("ConfigObject::RestoreObjects");
 
 	String message;
 	StreamReadContext src;
 	for (;;) {
-		StreamReadStatus srs = NetString::ReadStringFromStream(sfp, &message, src);
+		StreamReadStatus srs = NetString::ReadStringFromStream(stream, &message, src);
 
 		if (srs == StatusEof)
 			break;
@@ -588,14 +650,24 @@ void ConfigObject::RestoreObjects(const String& filename, int attributeTypes)
 		if (srs != StatusNewItem)
 			continue;
 
+		if (message == l_StateStreamEnd) {
+			if (complete)
+				*complete = true;
+
+			break;
+		}
+
 		upq.Enqueue(boost::bind(&ConfigObject::RestoreObject, message, attributeTypes));
 		restored++;
 	}
 
-	sfp->Close();
-
 	upq.Join();
 
+	return restored;
+}
+
+void ConfigObject::LoadObjectsWithoutState(unsigned long restored)
+{
 	unsigned long no_state = 0;
 
 	for (const Type::Ptr& type : Type::GetAllTypes()) {
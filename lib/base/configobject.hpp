@@ -25,6 +25,7 @@
 #include "base/object.hpp"
 #include "base/type.hpp"
 #include "base/dictionary.hpp"
+#include "base/stream.hpp"
 #include <boost/signals2.hpp>
 
 namespace icinga
@@ -87,6 +88,8 @@ public:
 
 	static void DumpObjects(const String& filename, int attributeTypes = FAState);
 	static void RestoreObjects(const String& filename, int attributeTypes = FAState);
+	static void DumpObjects(const Stream::Ptr& stream, int attributeTypes = FAState);
+	static bool RestoreObjects(const Stream::Ptr& stream, int attributeTypes = FAState);
 	static void StopObjects(void);
 
 	static void DumpModifiedAttributes(const boost::function<void(const ConfigObject::Ptr&, const String&, const Value&)>& callback);
@@ -100,6 +103,9 @@ private:
 	ConfigObject::Ptr m_Zone;
 
 	static void RestoreObject(const String& message, int attributeTypes);
+	static void WriteObjects(const Stream::Ptr& stream, int attributeTypes);
+	static unsigned long ReadObjects(const Stream::Ptr& stream, int attributeTypes, bool *complete);
+	static void LoadObjectsWithoutState(unsigned long restored);
 };
 
 #define DECLARE_OBJECTNAME(klass)						\
@@ -28,12 +28,16 @@
 #include "base/utility.hpp"
 #include "base/scriptglobal.hpp"
 #include "base/json.hpp"
+#include "base/statsfunction.hpp"
 #include <boost/algorithm/string/join.hpp>
 #include <boost/thread/once.hpp>
 
 #ifndef _WIN32
 #	include <execvpe.h>
 #	include <poll.h>
+#	ifdef __linux__
+#		include <sys/epoll.h>
+#	endif /* __linux__ */
 
 #	ifndef __APPLE__
 extern char **environ;
@@ -58,10 +62,23 @@ static std::map<Process::ConsoleHandle, Process::ProcessHandle> l_FDs[IOTHREADS]
 static boost::mutex l_ProcessControlMutex;
 static int l_ProcessControlFD = -1;
 static pid_t l_ProcessControlPID;
+static boost::mutex l_SpawnBacklogMutex;
+static int l_SpawnBacklog;
+
+#	ifdef __linux__
+static int l_EpollFDs[IOTHREADS];
+
+/* Processes with a timeout, ordered by the time at which they are killed. */
+static std::set<std::pair<double, Process *> > l_Timeouts[IOTHREADS];
+#	endif /* __linux__ */
 #endif /* _WIN32 */
+static int l_ProcessTimeouts[IOTHREADS];
+static int l_ProcessSignaled[IOTHREADS];
 static boost::once_flag l_ProcessOnceFlag = BOOST_ONCE_INIT;
 static boost::once_flag l_SpawnHelperOnceFlag = BOOST_ONCE_INIT;
 
+REGISTER_STATSFUNCTION(Process, &Process::StatsFunc);
+
 Process::Process(const Process::Arguments& arguments, const Dictionary::Ptr& extraEnvironment)
 	: m_Arguments(arguments), m_ExtraEnvironment(extraEnvironment), m_Timeout(600), m_AdjustPriority(false)
 #ifdef _WIN32
@@ -378,8 +395,18 @@ static pid_t ProcessSpawn(const std::vector<String>& arguments, const Dictionary
 	String jrequest = JsonEncode(request);
 	size_t length = jrequest.GetLength();
 
+	{
+		boost::mutex::scoped_lock lock(l_SpawnBacklogMutex);
+		l_SpawnBacklog++;
+	}
+
 	boost::mutex::scoped_lock lock(l_ProcessControlMutex);
 
+	{
+		boost::mutex::scoped_lock lock(l_SpawnBacklogMutex);
+		l_SpawnBacklog--;
+	}
+
 	struct msghdr msg;
 	memset(&msg, 0, sizeof(msg));
 
@@ -520,6 +547,24 @@ static void InitializeProcess(void)
 			}
 		}
 #	endif /* HAVE_PIPE2 */
+
+#	ifdef __linux__
+		l_EpollFDs[tid] = epoll_create(128);
+
+		if (l_EpollFDs[tid] < 0) {
+			BOOST_THROW_EXCEPTION(posix_error()
+			    << boost::errinfo_api_function("epoll_create")
+			    << boost::errinfo_errno(errno));
+		}
+
+		Utility::SetCloExec(l_EpollFDs[tid]);
+
+		epoll_event event;
+		memset(&event, 0, sizeof(event));
+		event.data.ptr = NULL;
+		event.events = EPOLLIN;
+		epoll_ctl(l_EpollFDs[tid], EPOLL_CTL_ADD, l_EventFDs[tid][0], &event);
+#	endif /* __linux__ */
 #endif /* _WIN32 */
 	}
 }
@@ -530,11 +575,50 @@ void Process::ThreadInitialize(void)
 {
 	/* Note to self: Make sure this runs _after_ we've daemonized. */
 	for (int tid = 0; tid < IOTHREADS; tid++) {
+#ifdef __linux__
+		boost::thread t(boost::bind(&Process::IOThreadProcEpoll, tid));
+#else /* __linux__ */
 		boost::thread t(boost::bind(&Process::IOThreadProc, tid));
+#endif /* __linux__ */
 		t.detach();
 	}
 }
 
+void Process::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr&)
+{
+	Array::Ptr active = new Array();
+	int timeouts = 0, signaled = 0;
+
+	for (int tid = 0; tid < IOTHREADS; tid++) {
+		boost::mutex::scoped_lock lock(l_ProcessMutex[tid]);
+		active->Add(l_Processes[tid].size());
+		timeouts += l_ProcessTimeouts[tid];
+		signaled += l_ProcessSignaled[tid];
+	}
+
+	Dictionary::Ptr stats = new Dictionary();
+	stats->Set("active", active);
+	stats->Set("timeouts", timeouts);
+	stats->Set("signaled", signaled);
+	stats->Set("spawn_backlog", GetSpawnBacklog());
+
+	status->Set("process", stats);
+}
+
+/**
+ * Returns the number of threads which are waiting for the spawn helper
+ * to start a process.
+ */
+int Process::GetSpawnBacklog(void)
+{
+#ifndef _WIN32
+	boost::mutex::scoped_lock lock(l_SpawnBacklogMutex);
+	return l_SpawnBacklog;
+#else /* _WIN32 */
+	return 0;
+#endif /* _WIN32 */
+}
+
 Process::Arguments Process::PrepareCommand(const Value& command)
 {
 #ifdef _WIN32
@@ -737,6 +821,81 @@ void Process::IOThreadProc(int tid)
 	}
 }
 
+#ifdef __linux__
+/**
+ * Removes a process from the I/O thread. The caller must hold
+ * l_ProcessMutex[tid].
+ */
+void Process::RemoveProcess(int tid, const Process::Ptr& process)
+{
+	epoll_ctl(l_EpollFDs[tid], EPOLL_CTL_DEL, process->m_FD, NULL);
+	(void)close(process->m_FD);
+
+	if (process->m_Timeout != 0)
+		l_Timeouts[tid].erase(std::make_pair(process->m_Result.ExecutionStart + process->m_Timeout, process.get()));
+
+	l_Processes[tid].erase(process->m_Process);
+}
+
+/**
+ * I/O thread for Linux. Output pipes stay registered with the epoll
+ * instance for the lifetime of the process, and the next timeout is
+ * taken from l_Timeouts instead of scanning all processes.
+ */
+void Process::IOThreadProcEpoll(int tid)
+{
+	Utility::SetThreadName("ProcessIO");
+
+	for (;;) {
+		int timeout = -1;
+
+		{
+			boost::mutex::scoped_lock lock(l_ProcessMutex[tid]);
+
+			if (!l_Timeouts[tid].empty()) {
+				double delta = l_Timeouts[tid].begin()->first - Utility::GetTime();
+
+				if (delta < 0.01)
+					delta = 0.01;
+
+				timeout = static_cast<int>(delta * 1000);
+			}
+		}
+
+		epoll_event pevents[64];
+		int ready = epoll_wait(l_EpollFDs[tid], pevents, sizeof(pevents) / sizeof(pevents[0]), timeout);
+
+		boost::mutex::scoped_lock lock(l_ProcessMutex[tid]);
+
+		for (int i = 0; i < ready; i++) {
+			Process *process = static_cast<Process *>(pevents[i].data.ptr);
+
+			if (!process) {
+				char buffer[512];
+				if (read(l_EventFDs[tid][0], buffer, sizeof(buffer)) < 0)
+					Log(LogCritical, "base", "Read from event FD failed.");
+
+				continue;
+			}
+
+			Process::Ptr self = process;
+
+			if (!process->DoEvents())
+				RemoveProcess(tid, self);
+		}
+
+		double now = Utility::GetTime();
+
+		while (!l_Timeouts[tid].empty() && l_Timeouts[tid].begin()->first < now) {
+			Process::Ptr process = l_Timeouts[tid].begin()->second;
+
+			if (!process->DoEvents())
+				RemoveProcess(tid, process);
+		}
+	}
+}
+#endif /* __linux__ */
+
 String Process::PrettyPrintArguments(const Process::Arguments& arguments)
 {
 #ifdef _WIN32
@@ -988,6 +1147,30 @@ void Process::Run(const boost::function<void(const ProcessResult&)>& callback)
 
 	int tid = GetTID();
 
+#ifdef __linux__
+	bool wakeup = false;
+
+	{
+		boost::mutex::scoped_lock lock(l_ProcessMutex[tid]);
+		l_Processes[tid][m_Process] = this;
+
+		epoll_event event;
+		memset(&event, 0, sizeof(event));
+		event.data.ptr = this;
+		event.events = EPOLLIN;
+		epoll_ctl(l_EpollFDs[tid], EPOLL_CTL_ADD, m_FD, &event);
+
+		if (m_Timeout != 0) {
+			std::pair<double, Process *> key = std::make_pair(m_Result.ExecutionStart + m_Timeout, this);
+
+			/* Only wake up the I/O thread if its current timeout is too long. */
+			wakeup = (l_Timeouts[tid].insert(key).first == l_Timeouts[tid].begin());
+		}
+	}
+
+	if (wakeup && write(l_EventFDs[tid][1], "T", 1) < 0 && errno != EINTR && errno != EAGAIN)
+		Log(LogCritical, "base", "Write to event FD failed.");
+#else /* __linux__ */
 	{
 		boost::mutex::scoped_lock lock(l_ProcessMutex[tid]);
 		l_Processes[tid][m_Process] = this;
@@ -1002,6 +1185,7 @@ void Process::Run(const boost::function<void(const ProcessResult&)>& callback)
 	if (write(l_EventFDs[tid][1], "T", 1) < 0 && errno != EINTR && errno != EAGAIN)
 		Log(LogCritical, "base", "Write to event FD failed.");
 #endif /* _WIN32 */
+#endif /* __linux__ */
 }
 
 bool Process::DoEvents(void)
@@ -1016,13 +1200,14 @@ bool Process::DoEvents(void)
 			    << "Killing process group " << m_PID << " (" << PrettyPrintArguments(m_Arguments)
 			    << ") after timeout of " << m_Timeout << " seconds";
 
-			m_OutputStream << "<Timeout exceeded.>";
+			m_Output += "<Timeout exceeded.>";
 #ifdef _WIN32
 			TerminateProcess(m_Process, 1);
 #else /* _WIN32 */
 			ProcessKill(-m_Process, SIGKILL);
 #endif /* _WIN32 */
 
+			l_ProcessTimeouts[GetTID()]++;
 			is_timeout = true;
 		}
 	}
@@ -1033,19 +1218,19 @@ bool Process::DoEvents(void)
 
 		DWORD rc;
 		if (!m_ReadFailed && GetOverlappedResult(m_FD, &m_Overlapped, &rc, TRUE) && rc > 0) {
-			m_OutputStream.write(m_ReadBuffer, rc);
+			m_Output.GetData().append(m_ReadBuffer, rc);
 			return true;
 		}
 #else /* _WIN32 */
-		char buffer[512];
+		char buffer[16384];
 		for (;;) {
-			int rc = read(m_FD, buffer, sizeof(buffer));
+			ssize_t rc = read(m_FD, buffer, sizeof(buffer));
 
 			if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
 				return true;
 
 			if (rc > 0) {
-				m_OutputStream.write(buffer, rc);
+				m_Output.GetData().append(buffer, rc);
 				continue;
 			}
 
@@ -1054,7 +1239,8 @@ bool Process::DoEvents(void)
 #endif /* _WIN32 */
 	}
 
-	String output = m_OutputStream.str();
+	String output;
+	output.GetData().swap(m_Output.GetData());
 
 #ifdef _WIN32
 	WaitForSingleObject(m_Process, INFINITE);
@@ -1077,6 +1263,8 @@ bool Process::DoEvents(void)
 		Log(LogNotice, "Process")
 		    << "PID " << m_PID << " (" << PrettyPrintArguments(m_Arguments) << ") terminated with exit code " << exitcode;
 	} else if (WIFSIGNALED(status)) {
+		l_ProcessSignaled[GetTID()]++;
+
 		int signum = WTERMSIG(status);
 		const char *zsigname = strsignal(signum);
 
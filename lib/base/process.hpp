@@ -22,6 +22,7 @@
 
 #include "base/i2-base.hpp"
 #include "base/dictionary.hpp"
+#include "base/array.hpp"
 #include <boost/function.hpp>
 #include <sstream>
 #include <deque>
@@ -86,6 +87,9 @@ public:
 
 	static String PrettyPrintArguments(const Arguments& arguments);
 
+	static void StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata);
+	static int GetSpawnBacklog(void);
+
 #ifndef _WIN32
 	static void InitializeSpawnHelper(void);
 #endif /* _WIN32 */
@@ -108,11 +112,15 @@ private:
 	char m_ReadBuffer[1024];
 #endif /* _WIN32 */
 
-	std::ostringstream m_OutputStream;
+	String m_Output;
 	boost::function<void (const ProcessResult&)> m_Callback;
 	ProcessResult m_Result;
 
 	static void IOThreadProc(int tid);
+#ifdef __linux__
+	static void IOThreadProcEpoll(int tid);
+	static void RemoveProcess(int tid, const Process::Ptr& process);
+#endif /* __linux__ */
 	bool DoEvents(void);
 	int GetTID(void) const;
 };
@@ -71,7 +71,7 @@ bool Stream::WaitForData(int timeout)
 		if (timeout < 0)
 			m_CV.wait(lock);
 		else
-			m_CV.timed_wait(lock, boost::posix_time::milliseconds(timeout * 1000));
+			m_CV.timed_wait(lock, boost::posix_time::milliseconds(static_cast<long>(timeout * 1000)));
 
 	return IsDataAvailable() || IsEof();
 }
@@ -23,18 +23,56 @@
 #include "base/convert.hpp"
 #include "base/application.hpp"
 #include "base/exception.hpp"
+#include "base/statsfunction.hpp"
 #include <boost/bind.hpp>
 #include <boost/thread/tss.hpp>
+#include <iterator>
+#include <set>
 
 using namespace icinga;
 
 int WorkQueue::m_NextID = 1;
 boost::thread_specific_ptr<WorkQueue *> l_ThreadWorkQueue;
 
+/* The maximum number of tasks a worker thread takes from the queue at once. */
+static const size_t l_MaxBatchSize = 32;
+
+static inline long AtomicAdd(volatile long *value, long delta)
+{
+#ifdef _WIN32
+	return InterlockedExchangeAdd(value, delta) + delta;
+#else /* _WIN32 */
+	return __sync_add_and_fetch(value, delta);
+#endif /* _WIN32 */
+}
+
+REGISTER_STATSFUNCTION(WorkQueue, &WorkQueue::StatsFunc);
+
+/* Work queues may be static objects themselves, so the registry is
+ * constructed on first use. */
+static boost::mutex& GetWorkQueuesMutex(void)
+{
+	static boost::mutex mutex;
+	return mutex;
+}
+
+static std::set<WorkQueue *>& GetWorkQueues(void)
+{
+	static std::set<WorkQueue *> queues;
+	return queues;
+}
+
 WorkQueue::WorkQueue(size_t maxItems, int threadCount)
 	: m_ID(m_NextID++), m_ThreadCount(threadCount), m_Spawned(false), m_MaxItems(maxItems), m_Stopped(false),
-	  m_Processing(0), m_NextTaskID(0)
+	  m_Processing(0), m_Pending(0), m_LaneLength(), m_IdleThreads(0), m_Enqueued(0), m_Started(0),
+	  m_LastEnqueued(0), m_LastStarted(0), m_LatencySum(0), m_LatencyMax(0), m_LastStatus(Utility::GetTime()),
+	  m_EnqueueRate(0), m_TaskRate(0), m_AvgLatency(0), m_MaxLatency(0)
 {
+	{
+		boost::mutex::scoped_lock lock(GetWorkQueuesMutex());
+		GetWorkQueues().insert(this);
+	}
+
 	m_StatusTimer = new Timer();
 	m_StatusTimer->SetInterval(10);
 	m_StatusTimer->OnTimerExpired.connect(boost::bind(&WorkQueue::StatusTimerHandler, this));
@@ -43,6 +81,11 @@ WorkQueue::WorkQueue(size_t maxItems, int threadCount)
 
 WorkQueue::~WorkQueue(void)
 {
+	{
+		boost::mutex::scoped_lock lock(GetWorkQueuesMutex());
+		GetWorkQueues().erase(this);
+	}
+
 	m_StatusTimer->Stop(true);
 
 	Join(true);
@@ -75,6 +118,8 @@ void WorkQueue::Enqueue(boost::function<void (void)>&& function, WorkQueuePriori
 		return;
 	}
 
+	double now = Utility::GetTime();
+
 	boost::mutex::scoped_lock lock(m_Mutex);
 
 	if (!m_Spawned) {
@@ -89,11 +134,14 @@ void WorkQueue::Enqueue(boost::function<void (void)>&& function, WorkQueuePriori
 	}
 
 	if (!wq_thread) {
-		while (m_Tasks.size() >= m_MaxItems && m_MaxItems != 0)
+		while (m_Pending >= m_MaxItems && m_MaxItems != 0)
 			m_CVFull.wait(lock);
 	}
 
-	m_Tasks.emplace(std::move(function), priority, ++m_NextTaskID);
+	m_Tasks[priority].emplace_back(std::move(function), now);
+	AtomicAdd(&m_LaneLength[priority], 1);
+	m_Pending++;
+	m_Enqueued++;
 
 	m_CVEmpty.notify_one();
 }
@@ -108,7 +156,7 @@ void WorkQueue::Join(bool stop)
 {
 	boost::mutex::scoped_lock lock(m_Mutex);
 
-	while (m_Processing || !m_Tasks.empty())
+	while (m_Processing || m_Pending)
 		m_CVStarved.wait(lock);
 
 	if (stop) {
@@ -185,13 +233,99 @@ size_t WorkQueue::GetLength(void) const
 {
 	boost::mutex::scoped_lock lock(m_Mutex);
 
-	return m_Tasks.size();
+	return m_Pending;
+}
+
+/**
+ * Returns the statistics for this work queue: the number of pending tasks,
+ * the rates at which tasks were enqueued and started and the time tasks
+ * spent waiting in the queue during the last status interval.
+ *
+ * @returns A dictionary with the statistics.
+ */
+Dictionary::Ptr WorkQueue::GetStats(void) const
+{
+	boost::mutex::scoped_lock lock(m_Mutex);
+
+	Dictionary::Ptr stats = new Dictionary();
+	stats->Set("length", m_Pending);
+	stats->Set("enqueue_rate", m_EnqueueRate);
+	stats->Set("task_rate", m_TaskRate);
+	stats->Set("avg_latency", m_AvgLatency);
+	stats->Set("max_latency", m_MaxLatency);
+	return stats;
+}
+
+/**
+ * Reports the statistics for all work queues. Queues which share a name
+ * (e.g. one per connection) are combined.
+ */
+void WorkQueue::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr&)
+{
+	Dictionary::Ptr queues = new Dictionary();
+
+	boost::mutex::scoped_lock lock(GetWorkQueuesMutex());
+
+	for (WorkQueue *wq : GetWorkQueues()) {
+		String name = wq->GetName();
+
+		if (name.IsEmpty())
+			name = "#" + Convert::ToString(wq->m_ID);
+
+		Dictionary::Ptr stats = wq->GetStats();
+		Dictionary::Ptr total = queues->Get(name);
+
+		if (!total) {
+			stats->Set("count", 1);
+			queues->Set(name, stats);
+			continue;
+		}
+
+		double taskRate = total->Get("task_rate");
+		double queueTaskRate = stats->Get("task_rate");
+		double avgLatency = 0;
+
+		if (taskRate + queueTaskRate > 0)
+			avgLatency = (static_cast<double>(total->Get("avg_latency")) * taskRate + static_cast<double>(stats->Get("avg_latency")) * queueTaskRate) / (taskRate + queueTaskRate);
+
+		total->Set("count", total->Get("count") + 1);
+		total->Set("length", total->Get("length") + stats->Get("length"));
+		total->Set("enqueue_rate", total->Get("enqueue_rate") + stats->Get("enqueue_rate"));
+		total->Set("task_rate", taskRate + queueTaskRate);
+		total->Set("avg_latency", avgLatency);
+		total->Set("max_latency", std::max(static_cast<double>(total->Get("max_latency")), static_cast<double>(stats->Get("max_latency"))));
+	}
+
+	status->Set("workqueue", queues);
 }
 
 void WorkQueue::StatusTimerHandler(void)
 {
 	boost::mutex::scoped_lock lock(m_Mutex);
 
+	double now = Utility::GetTime();
+	double interval = now - m_LastStatus;
+
+	if (interval <= 0)
+		return;
+
+	unsigned long started = m_Started - m_LastStarted;
+
+	m_EnqueueRate = (m_Enqueued - m_LastEnqueued) / interval;
+	m_TaskRate = started / interval;
+	m_AvgLatency = started > 0 ? m_LatencySum / started : 0;
+	m_MaxLatency = m_LatencyMax;
+
+	m_LastEnqueued = m_Enqueued;
+	m_LastStarted = m_Started;
+	m_LatencySum = 0;
+	m_LatencyMax = 0;
+	m_LastStatus = now;
+
+	/* idle queues aren't worth a log message */
+	if (m_Pending == 0 && started == 0)
+		return;
+
 	Log log(LogNotice, "WorkQueue");
 
 	log << "#" << m_ID;
@@ -199,7 +333,28 @@ void WorkQueue::StatusTimerHandler(void)
 	if (!m_Name.IsEmpty())
 		log << " (" << m_Name << ")";
 
-	log << " tasks: " << m_Tasks.size();
+	log << " tasks: " << m_Pending << ", rate: " << m_TaskRate << "/s (enqueued: " << m_EnqueueRate
+	    << "/s), latency: " << m_AvgLatency * 1000 << "ms avg, " << m_MaxLatency * 1000 << "ms max";
+}
+
+/**
+ * Checks whether a worker thread should stop processing its batch and hand
+ * the remaining tasks back: either a task with a higher priority than the
+ * batch is waiting or another worker thread is idle and could run them.
+ *
+ * This is called without holding m_Mutex.
+ */
+bool WorkQueue::ShouldYieldBatch(int priority)
+{
+	if (AtomicAdd(&m_IdleThreads, 0) > 0)
+		return true;
+
+	for (int i = priority + 1; i < WQ_PRIORITY_COUNT; i++) {
+		if (AtomicAdd(&m_LaneLength[i], 0) > 0)
+			return true;
+	}
+
+	return false;
 }
 
 void WorkQueue::WorkerThreadProc(void)
@@ -210,49 +365,113 @@ void WorkQueue::WorkerThreadProc(void)
 
 	l_ThreadWorkQueue.reset(new WorkQueue *(this));
 
+	std::vector<Task> tasks;
+	tasks.reserve(l_MaxBatchSize);
+
 	boost::mutex::scoped_lock lock(m_Mutex);
 
 	for (;;) {
-		while (m_Tasks.empty() && !m_Stopped)
+		while (m_Pending == 0 && !m_Stopped) {
+			AtomicAdd(&m_IdleThreads, 1);
 			m_CVEmpty.wait(lock);
+			AtomicAdd(&m_IdleThreads, -1);
+		}
 
 		if (m_Stopped)
 			break;
 
-		if (m_Tasks.size() >= m_MaxItems && m_MaxItems != 0)
+		if (m_Pending >= m_MaxItems && m_MaxItems != 0)
 			m_CVFull.notify_all();
 
-		Task task = m_Tasks.top();
-		m_Tasks.pop();
+		/* Take a fair share of the pending tasks so the other worker
+		 * threads aren't starved. Batches only contain tasks from the
+		 * highest non-empty lane. */
+		size_t count = m_Pending / std::max(m_ThreadCount, 1);
 
-		m_Processing++;
+		if (count < 1)
+			count = 1;
+		else if (count > l_MaxBatchSize)
+			count = l_MaxBatchSize;
 
-		lock.unlock();
+		int priority = WQ_PRIORITY_COUNT - 1;
+
+		while (m_Tasks[priority].empty())
+			priority--;
 
-		try {
-			task.Function();
-		} catch (const std::exception&) {
-			lock.lock();
+		std::deque<Task>& lane = m_Tasks[priority];
 
-			if (!m_ExceptionCallback)
-				m_Exceptions.push_back(boost::current_exception());
+		double now = Utility::GetTime();
 
-			lock.unlock();
+		while (!lane.empty() && tasks.size() < count) {
+			double latency = now - lane.front().EnqueueTime;
 
-			if (m_ExceptionCallback)
-				m_ExceptionCallback(boost::current_exception());
+			m_LatencySum += latency;
+
+			if (latency > m_LatencyMax)
+				m_LatencyMax = latency;
+
+			tasks.push_back(std::move(lane.front()));
+			lane.pop_front();
 		}
 
-		/* clear the task so whatever other resources it holds are released
-		   _before_ we re-acquire the mutex */
-		task = Task();
+		AtomicAdd(&m_LaneLength[priority], -static_cast<long>(tasks.size()));
+		m_Pending -= tasks.size();
+		m_Started += tasks.size();
+		m_Processing += tasks.size();
+
+		lock.unlock();
+
+		size_t processed = 0;
+
+		for (; processed < tasks.size(); processed++) {
+			if (processed > 0 && ShouldYieldBatch(priority))
+				break;
+
+			Task& task = tasks[processed];
+
+			try {
+				task.Function();
+			} catch (const std::exception&) {
+				lock.lock();
+
+				if (!m_ExceptionCallback)
+					m_Exceptions.push_back(boost::current_exception());
+
+				lock.unlock();
+
+				if (m_ExceptionCallback)
+					m_ExceptionCallback(boost::current_exception());
+			}
+
+			/* clear the task so whatever other resources it holds are released
+			   _before_ we re-acquire the mutex */
+			task = Task();
+		}
 
 		lock.lock();
 
-		m_Processing--;
+		m_Processing -= tasks.size();
+
+		/* Put the tasks which weren't started back at the front of their
+		 * lane so they keep their position. */
+		if (processed < tasks.size()) {
+			size_t remaining = tasks.size() - processed;
+
+			for (size_t i = processed; i < tasks.size(); i++)
+				m_LatencySum -= now - tasks[i].EnqueueTime;
 
-		if (m_Tasks.empty())
+			lane.insert(lane.begin(), std::make_move_iterator(tasks.begin() + processed),
+			    std::make_move_iterator(tasks.end()));
+			AtomicAdd(&m_LaneLength[priority], static_cast<long>(remaining));
+			m_Pending += remaining;
+			m_Started -= remaining;
+
+			m_CVEmpty.notify_all();
+		}
+
+		tasks.clear();
+
+		if (m_Pending == 0)
 			m_CVStarved.notify_all();
 	}
 }
-
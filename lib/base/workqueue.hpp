@@ -22,12 +22,12 @@
 
 #include "base/i2-base.hpp"
 #include "base/timer.hpp"
+#include "base/dictionary.hpp"
 #include <boost/function.hpp>
 #include <boost/thread/thread.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/condition_variable.hpp>
 #include <boost/exception_ptr.hpp>
-#include <queue>
 #include <deque>
 
 namespace icinga
@@ -40,36 +40,22 @@ enum WorkQueuePriority
 	PriorityHigh
 };
 
+#define WQ_PRIORITY_COUNT (PriorityHigh + 1)
+
 struct Task
 {
 	Task(void)
-	    : Priority(PriorityNormal), ID(-1)
+	    : EnqueueTime(0)
 	{ }
 
-	Task(boost::function<void (void)>&& function, WorkQueuePriority priority, int id)
-	    : Function(std::move(function)), Priority(priority), ID(id)
+	Task(boost::function<void (void)>&& function, double enqueueTime)
+	    : Function(std::move(function)), EnqueueTime(enqueueTime)
 	{ }
 
 	boost::function<void (void)> Function;
-	WorkQueuePriority Priority;
-	int ID;
+	double EnqueueTime;
 };
 
-inline bool operator<(const Task& a, const Task& b)
-{
-	if (a.Priority < b.Priority)
-		return true;
-
-	if (a.Priority == b.Priority) {
-		if (a.ID > b.ID)
-			return true;
-		else
-			return false;
-	}
-
-	return false;
-}
-
 /**
  * A workqueue.
  *
@@ -93,6 +79,9 @@ public:
 	bool IsWorkerThread(void) const;
 
 	size_t GetLength(void) const;
+	Dictionary::Ptr GetStats(void) const;
+
+	static void StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata);
 
 	void SetExceptionCallback(const ExceptionCallback& callback);
 
@@ -115,13 +104,33 @@ private:
 	size_t m_MaxItems;
 	bool m_Stopped;
 	int m_Processing;
-	std::priority_queue<Task, std::deque<Task> > m_Tasks;
-	int m_NextTaskID;
+	std::deque<Task> m_Tasks[WQ_PRIORITY_COUNT]; /**< One FIFO lane per priority. */
+	size_t m_Pending;
+
+	/* Read by the worker threads between the tasks of a batch without
+	 * holding m_Mutex, see ShouldYieldBatch(). */
+	volatile long m_LaneLength[WQ_PRIORITY_COUNT];
+	volatile long m_IdleThreads;
+
 	ExceptionCallback m_ExceptionCallback;
 	std::vector<boost::exception_ptr> m_Exceptions;
 	Timer::Ptr m_StatusTimer;
 
+	/* statistics, updated by the status timer */
+	unsigned long m_Enqueued;
+	unsigned long m_Started;
+	unsigned long m_LastEnqueued;
+	unsigned long m_LastStarted;
+	double m_LatencySum;
+	double m_LatencyMax;
+	double m_LastStatus;
+	double m_EnqueueRate;
+	double m_TaskRate;
+	double m_AvgLatency;
+	double m_MaxLatency;
+
 	void WorkerThreadProc(void);
+	bool ShouldYieldBatch(int priority);
 	void StatusTimerHandler(void);
 };
 
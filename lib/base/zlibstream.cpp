@@ -0,0 +1,336 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "base/zlibstream.hpp"
+#include "base/exception.hpp"
+#include <time.h>
+
+using namespace icinga;
+
+ZlibStream::ZlibStream(const Stream::Ptr& innerStream)
+	: m_InnerStream(innerStream), m_Inflating(false), m_PendingInput(new FIFO()), m_Output(new FIFO()),
+	  m_BytesIn(0), m_CompressedBytesIn(0), m_InflateCpuTime(0), m_Deflating(false), m_BytesOut(0),
+	  m_CompressedBytesOut(0), m_DeflateCpuTime(0)
+{ }
+
+ZlibStream::~ZlibStream(void)
+{
+#ifdef HAVE_ZLIB
+	if (m_Inflating)
+		inflateEnd(&m_InflateStream);
+
+	if (m_Deflating)
+		deflateEnd(&m_DeflateStream);
+#endif /* HAVE_ZLIB */
+}
+
+/**
+ * Checks whether Icinga was built with zlib support.
+ */
+bool ZlibStream::IsSupported(void)
+{
+#ifdef HAVE_ZLIB
+	return true;
+#else /* HAVE_ZLIB */
+	return false;
+#endif /* HAVE_ZLIB */
+}
+
+/**
+ * Writes the marker uncompressed and compresses all data that is written
+ * afterwards.
+ *
+ * @param level The zlib compression level (1-9).
+ * @param marker Data which tells the peer that compressed data follows.
+ */
+void ZlibStream::StartDeflate(int level, const String& marker)
+{
+#ifdef HAVE_ZLIB
+	boost::mutex::scoped_lock lock(m_WriteMutex);
+
+	if (m_Deflating)
+		return;
+
+	m_InnerStream->Write(marker.CStr(), marker.GetLength());
+	m_BytesOut += marker.GetLength();
+	m_CompressedBytesOut += marker.GetLength();
+
+	memset(&m_DeflateStream, 0, sizeof(m_DeflateStream));
+
+	if (deflateInit(&m_DeflateStream, level) != Z_OK)
+		BOOST_THROW_EXCEPTION(std::runtime_error("deflateInit() failed"));
+
+	m_Deflating = true;
+#else /* HAVE_ZLIB */
+	BOOST_THROW_EXCEPTION(std::runtime_error("Icinga was built without zlib support."));
+#endif /* HAVE_ZLIB */
+}
+
+/**
+ * Decompresses all data that is read from now on.
+ *
+ * @param pending Data which was already read from the inner stream but
+ *		  belongs to the compressed part.
+ * @param size The size of the pending data.
+ */
+void ZlibStream::StartInflate(const char *pending, size_t size)
+{
+#ifdef HAVE_ZLIB
+	boost::mutex::scoped_lock lock(m_ReadMutex);
+
+	if (m_Inflating)
+		return;
+
+	memset(&m_InflateStream, 0, sizeof(m_InflateStream));
+
+	if (inflateInit(&m_InflateStream) != Z_OK)
+		BOOST_THROW_EXCEPTION(std::runtime_error("inflateInit() failed"));
+
+	if (size > 0)
+		m_PendingInput->Write(pending, size);
+
+	m_Inflating = true;
+#else /* HAVE_ZLIB */
+	BOOST_THROW_EXCEPTION(std::runtime_error("Icinga was built without zlib support."));
+#endif /* HAVE_ZLIB */
+}
+
+bool ZlibStream::IsDeflating(void) const
+{
+	boost::mutex::scoped_lock lock(m_WriteMutex);
+	return m_Deflating;
+}
+
+bool ZlibStream::IsInflating(void) const
+{
+	boost::mutex::scoped_lock lock(m_ReadMutex);
+	return m_Inflating;
+}
+
+size_t ZlibStream::Read(void *buffer, size_t count, bool allow_partial)
+{
+	boost::mutex::scoped_lock lock(m_ReadMutex);
+
+	if (!m_Inflating) {
+		size_t rc = m_InnerStream->Read(buffer, count, allow_partial);
+		m_BytesIn += rc;
+		m_CompressedBytesIn += rc;
+		return rc;
+	}
+
+	size_t total = 0;
+
+	for (;;) {
+		total += m_Output->Read(buffer ? static_cast<char *>(buffer) + total : NULL, count - total, true);
+
+		if (total == count || (allow_partial && total > 0))
+			break;
+
+		if (!InflateSome(!allow_partial))
+			break;
+	}
+
+	m_BytesIn += total;
+
+	return total;
+}
+
+/**
+ * Decompresses the next chunk of input data into the output buffer.
+ *
+ * @param may_block Whether to wait for more data from the inner stream.
+ * @returns false if there was no more input data.
+ */
+bool ZlibStream::InflateSome(bool may_block)
+{
+#ifdef HAVE_ZLIB
+	char input[16 * 1024];
+	size_t size = m_PendingInput->Read(input, sizeof(input), true);
+
+	if (size == 0) {
+		if (m_InnerStream->IsDataAvailable())
+			size = m_InnerStream->Read(input, sizeof(input), true);
+		else if (may_block)
+			size = m_InnerStream->Read(input, 1, false);
+	}
+
+	if (size == 0)
+		return false;
+
+	m_CompressedBytesIn += size;
+
+	double cpuStart = GetThreadCpuTime();
+
+	m_InflateStream.next_in = reinterpret_cast<Bytef *>(input);
+	m_InflateStream.avail_in = size;
+
+	char output[64 * 1024];
+
+	do {
+		m_InflateStream.next_out = reinterpret_cast<Bytef *>(output);
+		m_InflateStream.avail_out = sizeof(output);
+
+		int rc = inflate(&m_InflateStream, Z_SYNC_FLUSH);
+
+		if (rc != Z_OK && rc != Z_BUF_ERROR && rc != Z_STREAM_END)
+			BOOST_THROW_EXCEPTION(std::runtime_error("Failed to decompress data: "
+			    + String(m_InflateStream.msg ? m_InflateStream.msg : "unknown error")));
+
+		m_Output->Write(output, sizeof(output) - m_InflateStream.avail_out);
+
+		if (rc == Z_STREAM_END && m_InflateStream.avail_in > 0)
+			BOOST_THROW_EXCEPTION(std::runtime_error("Unexpected data after the end of the compressed stream."));
+	} while (m_InflateStream.avail_in > 0 || m_InflateStream.avail_out == 0);
+
+	m_InflateCpuTime += GetThreadCpuTime() - cpuStart;
+
+	return true;
+#else /* HAVE_ZLIB */
+	return false;
+#endif /* HAVE_ZLIB */
+}
+
+void ZlibStream::Write(const void *buffer, size_t count)
+{
+	boost::mutex::scoped_lock lock(m_WriteMutex);
+
+	m_BytesOut += count;
+
+	if (!m_Deflating) {
+		m_InnerStream->Write(buffer, count);
+		m_CompressedBytesOut += count;
+		return;
+	}
+
+#ifdef HAVE_ZLIB
+	double cpuStart = GetThreadCpuTime();
+
+	m_DeflateStream.next_in = reinterpret_cast<Bytef *>(const_cast<void *>(buffer));
+	m_DeflateStream.avail_in = count;
+
+	char output[16 * 1024];
+
+	/* Flush after every write so that the peer can decode each message as soon as it arrives. */
+	do {
+		m_DeflateStream.next_out = reinterpret_cast<Bytef *>(output);
+		m_DeflateStream.avail_out = sizeof(output);
+
+		if (deflate(&m_DeflateStream, Z_SYNC_FLUSH) == Z_STREAM_ERROR)
+			BOOST_THROW_EXCEPTION(std::runtime_error("Failed to compress data."));
+
+		size_t size = sizeof(output) - m_DeflateStream.avail_out;
+
+		m_InnerStream->Write(output, size);
+		m_CompressedBytesOut += size;
+	} while (m_DeflateStream.avail_out == 0);
+
+	m_DeflateCpuTime += GetThreadCpuTime() - cpuStart;
+#endif /* HAVE_ZLIB */
+}
+
+void ZlibStream::Close(void)
+{
+	m_InnerStream->Close();
+}
+
+void ZlibStream::Shutdown(void)
+{
+	m_InnerStream->Shutdown();
+}
+
+bool ZlibStream::IsEof(void) const
+{
+	boost::mutex::scoped_lock lock(m_ReadMutex);
+
+	if (m_Inflating && (m_Output->GetAvailableBytes() > 0 || m_PendingInput->GetAvailableBytes() > 0))
+		return false;
+
+	return m_InnerStream->IsEof();
+}
+
+/* Waiters would have to be notified by the inner stream. */
+bool ZlibStream::SupportsWaiting(void) const
+{
+	return false;
+}
+
+bool ZlibStream::IsDataAvailable(void) const
+{
+	boost::mutex::scoped_lock lock(m_ReadMutex);
+
+	if (m_Inflating && (m_Output->GetAvailableBytes() > 0 || m_PendingInput->GetAvailableBytes() > 0))
+		return true;
+
+	return m_InnerStream->IsDataAvailable();
+}
+
+double ZlibStream::GetBytesIn(void) const
+{
+	boost::mutex::scoped_lock lock(m_ReadMutex);
+	return m_BytesIn;
+}
+
+double ZlibStream::GetCompressedBytesIn(void) const
+{
+	boost::mutex::scoped_lock lock(m_ReadMutex);
+	return m_CompressedBytesIn;
+}
+
+double ZlibStream::GetBytesOut(void) const
+{
+	boost::mutex::scoped_lock lock(m_WriteMutex);
+	return m_BytesOut;
+}
+
+double ZlibStream::GetCompressedBytesOut(void) const
+{
+	boost::mutex::scoped_lock lock(m_WriteMutex);
+	return m_CompressedBytesOut;
+}
+
+/**
+ * Returns the CPU time in seconds that was spent compressing and
+ * decompressing data.
+ */
+double ZlibStream::GetCpuTime(void) const
+{
+	double cpuTime;
+
+	{
+		boost::mutex::scoped_lock lock(m_ReadMutex);
+		cpuTime = m_InflateCpuTime;
+	}
+
+	boost::mutex::scoped_lock lock(m_WriteMutex);
+	return cpuTime + m_DeflateCpuTime;
+}
+
+double ZlibStream::GetThreadCpuTime(void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) < 0)
+		return 0;
+
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+#else /* CLOCK_THREAD_CPUTIME_ID */
+	return 0;
+#endif /* CLOCK_THREAD_CPUTIME_ID */
+}
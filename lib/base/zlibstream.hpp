@@ -0,0 +1,101 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#ifndef ZLIBSTREAM_H
+#define ZLIBSTREAM_H
+
+#include "base/i2-base.hpp"
+#include "base/stream.hpp"
+#include "base/fifo.hpp"
+#include <boost/thread/mutex.hpp>
+
+#ifdef HAVE_ZLIB
+#	include <zlib.h>
+#endif /* HAVE_ZLIB */
+
+namespace icinga
+{
+
+/**
+ * A stream which transparently compresses data written to and decompresses
+ * data read from another stream. Both directions start out uncompressed and
+ * are switched to the deflate format independently, so that the peers can
+ * negotiate compression in-band.
+ *
+ * @ingroup base
+ */
+class I2_BASE_API ZlibStream : public Stream
+{
+public:
+	DECLARE_PTR_TYPEDEFS(ZlibStream);
+
+	ZlibStream(const Stream::Ptr& innerStream);
+	~ZlibStream(void);
+
+	static bool IsSupported(void);
+
+	void StartDeflate(int level, const String& marker);
+	void StartInflate(const char *pending, size_t size);
+
+	bool IsDeflating(void) const;
+	bool IsInflating(void) const;
+
+	virtual size_t Read(void *buffer, size_t count, bool allow_partial = false) override;
+	virtual void Write(const void *buffer, size_t count) override;
+	virtual void Close(void) override;
+	virtual void Shutdown(void) override;
+	virtual bool IsEof(void) const override;
+	virtual bool SupportsWaiting(void) const override;
+	virtual bool IsDataAvailable(void) const override;
+
+	double GetBytesIn(void) const;
+	double GetCompressedBytesIn(void) const;
+	double GetBytesOut(void) const;
+	double GetCompressedBytesOut(void) const;
+	double GetCpuTime(void) const;
+
+private:
+	Stream::Ptr m_InnerStream;
+
+	mutable boost::mutex m_ReadMutex;
+	bool m_Inflating;
+	FIFO::Ptr m_PendingInput;
+	FIFO::Ptr m_Output;
+	double m_BytesIn;
+	double m_CompressedBytesIn;
+	double m_InflateCpuTime;
+
+	mutable boost::mutex m_WriteMutex;
+	bool m_Deflating;
+	double m_BytesOut;
+	double m_CompressedBytesOut;
+	double m_DeflateCpuTime;
+
+#ifdef HAVE_ZLIB
+	z_stream m_InflateStream;
+	z_stream m_DeflateStream;
+#endif /* HAVE_ZLIB */
+
+	bool InflateSome(bool may_block);
+	static double GetThreadCpuTime(void);
+};
+
+}
+
+#endif /* ZLIBSTREAM_H */
@@ -23,6 +23,7 @@
 #include "icinga/cib.hpp"
 #include "icinga/perfdatavalue.hpp"
 #include "remote/apilistener.hpp"
+#include "remote/endpoint.hpp"
 #include "base/configtype.hpp"
 #include "base/objectlock.hpp"
 #include "base/utility.hpp"
@@ -30,6 +31,8 @@
 #include "base/exception.hpp"
 #include "base/convert.hpp"
 #include "base/statsfunction.hpp"
+#include "base/process.hpp"
+#include <fstream>
 
 using namespace icinga;
 
@@ -45,15 +48,22 @@ void CheckerComponent::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr
 		unsigned long idle = checker->GetIdleCheckables();
 		unsigned long pending = checker->GetPendingCheckables();
 
+		int concurrentChecks = checker->GetEffectiveConcurrentChecks();
+
 		Dictionary::Ptr stats = new Dictionary();
 		stats->Set("idle", idle);
 		stats->Set("pending", pending);
+		stats->Set("concurrent_checks", concurrentChecks);
+
+		if (checker->GetAdaptiveConcurrency())
+			stats->Set("concurrency", checker->m_ConcurrencyController.GetStats());
 
 		nodes->Set(checker->GetName(), stats);
 
 		String perfdata_prefix = "checkercomponent_" + checker->GetName() + "_";
 		perfdata->Add(new PerfdataValue(perfdata_prefix + "idle", Convert::ToDouble(idle)));
 		perfdata->Add(new PerfdataValue(perfdata_prefix + "pending", Convert::ToDouble(pending)));
+		perfdata->Add(new PerfdataValue(perfdata_prefix + "concurrent_checks", concurrentChecks));
 	}
 
 	status->Set("checkercomponent", nodes);
@@ -69,6 +79,7 @@ void CheckerComponent::OnConfigLoaded(void)
 	ConfigObject::OnPausedChanged.connect(bind(&CheckerComponent::ObjectHandler, this, _1));
 
 	Checkable::OnNextCheckChanged.connect(bind(&CheckerComponent::NextCheckChangedHandler, this, _1));
+	Checkable::OnNewCheckResult.connect(bind(&CheckerComponent::CheckResultHandler, this, _1, _2, _3));
 }
 
 void CheckerComponent::Start(bool runtimeCreated)
@@ -78,6 +89,15 @@ void CheckerComponent::Start(bool runtimeCreated)
 	Log(LogInformation, "CheckerComponent")
 	    << "'" << GetName() << "' started.";
 
+	if (GetAdaptiveConcurrency()) {
+		m_ConcurrencyController.SetBounds(GetMinConcurrentChecks(), GetMaxConcurrentChecks());
+		m_ConcurrencyController.SetLimit(GetConcurrentChecks());
+
+		m_ConcurrencyTimer = new Timer();
+		m_ConcurrencyTimer->SetInterval(1);
+		m_ConcurrencyTimer->OnTimerExpired.connect(boost::bind(&CheckerComponent::ConcurrencyTimerHandler, this));
+		m_ConcurrencyTimer->Start();
+	}
 
 	m_Thread = boost::thread(boost::bind(&CheckerComponent::CheckThreadProc, this));
 
@@ -99,8 +119,14 @@ void CheckerComponent::Stop(bool runtimeRemoved)
 	}
 
 	m_ResultTimer->Stop();
+
+	if (m_ConcurrencyTimer)
+		m_ConcurrencyTimer->Stop();
+
 	m_Thread.join();
 
+	CancelCheckBatches();
+
 	ObjectImpl<CheckerComponent>::Stop(runtimeRemoved);
 }
 
@@ -114,23 +140,40 @@ void CheckerComponent::CheckThreadProc(void)
 		typedef boost::multi_index::nth_index<CheckableSet, 1>::type CheckTimeView;
 		CheckTimeView& idx = boost::get<1>(m_IdleCheckables);
 
-		while (idx.begin() == idx.end() && !m_Stopped)
+		double batchWait = FlushCheckBatches();
+
+		while (idx.begin() == idx.end() && batchWait < 0 && !m_Stopped)
 			m_CV.wait(lock);
 
 		if (m_Stopped)
 			break;
 
+		if (idx.begin() == idx.end()) {
+			/* Wait for the next batch to become due. */
+			m_CV.timed_wait(lock, boost::posix_time::milliseconds(static_cast<long>(batchWait * 1000)));
+
+			continue;
+		}
+
 		auto it = idx.begin();
 		CheckableScheduleInfo csi = *it;
 
 		double wait = csi.NextCheck - Utility::GetTime();
 
-		if (Checkable::GetPendingChecks() >= GetConcurrentChecks())
+		if (batchWait >= 0 && batchWait < wait)
+			wait = batchWait;
+
+		if (Checkable::GetPendingChecks() >= GetEffectiveConcurrentChecks()) {
+			/* only count as saturated if a check is actually due */
+			if (wait <= 0 && GetAdaptiveConcurrency())
+				m_ConcurrencyController.NotifySaturated();
+
 			wait = 0.5;
+		}
 
 		if (wait > 0) {
 			/* Wait for the next check. */
-			m_CV.timed_wait(lock, boost::posix_time::milliseconds(wait * 1000));
+			m_CV.timed_wait(lock, boost::posix_time::milliseconds(static_cast<long>(wait * 1000)));
 
 			continue;
 		}
@@ -200,34 +243,152 @@ void CheckerComponent::CheckThreadProc(void)
 
 		Checkable::IncreasePendingChecks();
 
-		Utility::QueueAsyncCallback(boost::bind(&CheckerComponent::ExecuteCheckHelper, CheckerComponent::Ptr(this), checkable));
+		CheckCommand::Ptr command = checkable->GetCheckCommand();
+		Endpoint::Ptr endpoint = checkable->GetCommandEndpoint();
+
+		/* only local checks can be batched */
+		bool batch = command && command->GetBatchSize() > 1 && (!endpoint || endpoint == Endpoint::GetLocalEndpoint());
+
+		if (!batch)
+			Utility::QueueAsyncCallback(boost::bind(&CheckerComponent::ExecuteCheckHelper, CheckerComponent::Ptr(this), checkable));
 
 		lock.lock();
+
+		if (batch)
+			AddToCheckBatch(command, checkable);
+	}
+}
+
+/**
+ * Adds a checkable to the batch for its check command. The batch is
+ * executed once it is full or its batch_window has passed.
+ *
+ * Must be called with m_Mutex held.
+ */
+void CheckerComponent::AddToCheckBatch(const CheckCommand::Ptr& command, const Checkable::Ptr& checkable)
+{
+	CheckBatch& batch = m_CheckBatches[command];
+
+	if (batch.Checkables.empty())
+		batch.Deadline = Utility::GetTime() + command->GetBatchWindow();
+
+	batch.Checkables.push_back(checkable);
+
+	if (batch.Checkables.size() >= static_cast<size_t>(command->GetBatchSize())) {
+		Log(LogDebug, "CheckerComponent")
+		    << "Executing batch of " << batch.Checkables.size() << " checks for command '" << command->GetName() << "'";
+
+		Utility::QueueAsyncCallback(boost::bind(&CheckerComponent::ExecuteBatchHelper, CheckerComponent::Ptr(this), command, batch.Checkables));
+		m_CheckBatches.erase(command);
 	}
 }
 
+/**
+ * Executes all batches whose window has passed.
+ *
+ * Must be called with m_Mutex held.
+ *
+ * @returns The number of seconds until the next batch is due or -1 if
+ *          there are no batches left.
+ */
+double CheckerComponent::FlushCheckBatches(void)
+{
+	double now = Utility::GetTime();
+	double wait = -1;
+
+	for (auto it = m_CheckBatches.begin(); it != m_CheckBatches.end(); ) {
+		if (it->second.Deadline > now) {
+			if (wait < 0 || it->second.Deadline - now < wait)
+				wait = it->second.Deadline - now;
+
+			it++;
+			continue;
+		}
+
+		Log(LogDebug, "CheckerComponent")
+		    << "Executing batch of " << it->second.Checkables.size() << " checks for command '" << it->first->GetName() << "'";
+
+		Utility::QueueAsyncCallback(boost::bind(&CheckerComponent::ExecuteBatchHelper, CheckerComponent::Ptr(this), it->first, it->second.Checkables));
+		m_CheckBatches.erase(it++);
+	}
+
+	return wait;
+}
+
+/**
+ * Drops all batches which haven't been executed yet and releases their
+ * checkables as if their checks had finished.
+ */
+void CheckerComponent::CancelCheckBatches(void)
+{
+	boost::mutex::scoped_lock lock(m_Mutex);
+
+	for (const std::pair<CheckCommand::Ptr, CheckBatch>& kv : m_CheckBatches) {
+		Log(LogDebug, "CheckerComponent")
+		    << "Cancelling batch of " << kv.second.Checkables.size() << " checks for command '" << kv.first->GetName() << "'";
+
+		for (const Checkable::Ptr& checkable : kv.second.Checkables) {
+			Checkable::DecreasePendingChecks();
+
+			auto it = m_PendingCheckables.find(checkable);
+
+			if (it != m_PendingCheckables.end()) {
+				m_PendingCheckables.erase(it);
+
+				if (checkable->IsActive())
+					m_IdleCheckables.insert(GetCheckableScheduleInfo(checkable));
+			}
+		}
+	}
+
+	m_CheckBatches.clear();
+}
+
+static void ProcessCheckException(const Checkable::Ptr& checkable, const std::exception& ex)
+{
+	CheckResult::Ptr cr = new CheckResult();
+	cr->SetState(ServiceUnknown);
+
+	String output = "Exception occured while checking '" + checkable->GetName() + "': " + DiagnosticInformation(ex);
+	cr->SetOutput(output);
+
+	double now = Utility::GetTime();
+	cr->SetScheduleStart(now);
+	cr->SetScheduleEnd(now);
+	cr->SetExecutionStart(now);
+	cr->SetExecutionEnd(now);
+
+	checkable->ProcessCheckResult(cr);
+
+	Log(LogCritical, "checker", output);
+}
+
 void CheckerComponent::ExecuteCheckHelper(const Checkable::Ptr& checkable)
 {
 	try {
 		checkable->ExecuteCheck();
 	} catch (const std::exception& ex) {
-		CheckResult::Ptr cr = new CheckResult();
-		cr->SetState(ServiceUnknown);
-
-		String output = "Exception occured while checking '" + checkable->GetName() + "': " + DiagnosticInformation(ex);
-		cr->SetOutput(output);
-
-		double now = Utility::GetTime();
-		cr->SetScheduleStart(now);
-		cr->SetScheduleEnd(now);
-		cr->SetExecutionStart(now);
-		cr->SetExecutionEnd(now);
+		ProcessCheckException(checkable, ex);
+	}
 
-		checkable->ProcessCheckResult(cr);
+	FinishCheck(checkable);
+}
 
-		Log(LogCritical, "checker", output);
+void CheckerComponent::ExecuteBatchHelper(const CheckCommand::Ptr& command, const std::vector<Checkable::Ptr>& checkables)
+{
+	try {
+		Checkable::ExecuteCheckBatch(command, checkables);
+	} catch (const std::exception& ex) {
+		for (const Checkable::Ptr& checkable : checkables)
+			ProcessCheckException(checkable, ex);
 	}
 
+	for (const Checkable::Ptr& checkable : checkables)
+		FinishCheck(checkable);
+}
+
+void CheckerComponent::FinishCheck(const Checkable::Ptr& checkable)
+{
 	Checkable::DecreasePendingChecks();
 
 	{
@@ -266,6 +427,62 @@ void CheckerComponent::ResultTimerHandler(void)
 	Log(LogNotice, "CheckerComponent", msgbuf.str());
 }
 
+/**
+ * Returns the current limit for concurrent checks. This is either the
+ * static concurrent_checks setting or the limit determined by the
+ * concurrency controller.
+ */
+int CheckerComponent::GetEffectiveConcurrentChecks(void) const
+{
+	if (GetAdaptiveConcurrency())
+		return m_ConcurrencyController.GetLimit();
+	else
+		return GetConcurrentChecks();
+}
+
+void CheckerComponent::ConcurrencyTimerHandler(void)
+{
+	double runQueue = -1;
+
+#ifdef __linux__
+	/* the fourth field is the number of currently runnable tasks, e.g. "3/456" */
+	std::ifstream fp("/proc/loadavg");
+	std::string load1, load5, load15;
+	int runnable;
+	char slash;
+
+	if (fp >> load1 >> load5 >> load15 >> runnable >> slash)
+		runQueue = runnable;
+#elif !defined(_WIN32)
+	double load;
+
+	if (getloadavg(&load, 1) == 1)
+		runQueue = load;
+#endif /* __linux__ */
+
+	double loadPerCpu = -1;
+
+	if (runQueue >= 0)
+		loadPerCpu = runQueue / std::max(1u, boost::thread::hardware_concurrency());
+
+	m_ConcurrencyController.Update(Process::GetSpawnBacklog(), loadPerCpu);
+
+	/* the limit might have been raised */
+	m_CV.notify_all();
+}
+
+void CheckerComponent::CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr,
+    const MessageOrigin::Ptr& origin)
+{
+	if (!GetAdaptiveConcurrency() || !cr->GetActive() || (origin && !origin->IsLocal()))
+		return;
+
+	m_ConcurrencyController.AddLatencySample(checkable->GetCheckCommandRaw(), cr->CalculateExecutionTime());
+
+	/* a slot for another check might be available now */
+	m_CV.notify_all();
+}
+
 void CheckerComponent::ObjectHandler(const ConfigObject::Ptr& object)
 {
 	Checkable::Ptr checkable = dynamic_pointer_cast<Checkable>(object);
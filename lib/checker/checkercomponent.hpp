@@ -21,7 +21,9 @@
 #define CHECKERCOMPONENT_H
 
 #include "checker/checkercomponent.thpp"
+#include "checker/concurrencycontroller.hpp"
 #include "icinga/service.hpp"
+#include "icinga/checkcommand.hpp"
 #include "base/configobject.hpp"
 #include "base/timer.hpp"
 #include "base/utility.hpp"
@@ -60,6 +62,18 @@ struct CheckableNextCheckExtractor
 	}
 };
 
+/**
+ * Checkables which share a batch capable check command and are waiting
+ * to be checked together.
+ *
+ * @ingroup checker
+ */
+struct CheckBatch
+{
+	double Deadline;
+	std::vector<Checkable::Ptr> Checkables;
+};
+
 /**
  * @ingroup checker
  */
@@ -86,6 +100,7 @@ public:
 	static void StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata);
 	unsigned long GetIdleCheckables(void);
 	unsigned long GetPendingCheckables(void);
+	int GetEffectiveConcurrentChecks(void) const;
 
 private:
 	boost::mutex m_Mutex;
@@ -95,13 +110,25 @@ private:
 
 	CheckableSet m_IdleCheckables;
 	CheckableSet m_PendingCheckables;
+	std::map<CheckCommand::Ptr, CheckBatch> m_CheckBatches;
 
 	Timer::Ptr m_ResultTimer;
 
+	ConcurrencyController m_ConcurrencyController;
+	Timer::Ptr m_ConcurrencyTimer;
+
 	void CheckThreadProc(void);
 	void ResultTimerHandler(void);
+	void ConcurrencyTimerHandler(void);
+	void CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr, const MessageOrigin::Ptr& origin);
 
 	void ExecuteCheckHelper(const Checkable::Ptr& checkable);
+	void ExecuteBatchHelper(const CheckCommand::Ptr& command, const std::vector<Checkable::Ptr>& checkables);
+	void FinishCheck(const Checkable::Ptr& checkable);
+
+	void AddToCheckBatch(const CheckCommand::Ptr& command, const Checkable::Ptr& checkable);
+	double FlushCheckBatches(void);
+	void CancelCheckBatches(void);
 
 	void AdjustCheckTimer(void);
 
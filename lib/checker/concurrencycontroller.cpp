@@ -0,0 +1,204 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "checker/concurrencycontroller.hpp"
+#include "base/logger.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace icinga;
+
+/* Weight of the most recent interval in the baseline latency. */
+static const double l_BaselineWeight = 0.05;
+
+/* The median latency gradient (baseline / current) of all check commands
+ * below which we back off. */
+static const double l_MinGradient = 0.67;
+
+/* Runnable processes per CPU above which we back off. */
+static const double l_MaxLoadPerCpu = 2.0;
+
+/* Pending spawn requests above which we back off. */
+static const int l_MaxSpawnBacklog = 16;
+
+/* Weight of the most recent run queue sample. */
+static const double l_LoadWeight = 0.3;
+
+static const double l_DecreaseFactor = 0.8;
+
+/* Number of intervals to wait after a decrease until its effect is visible. */
+static const int l_DecreaseCooldown = 3;
+
+ConcurrencyController::ConcurrencyController(void)
+	: m_Limit(512), m_MinLimit(1), m_MaxLimit(512), m_Saturated(false), m_Gradient(1), m_SpawnBacklog(0),
+	  m_LoadPerCpu(-1), m_Cooldown(0), m_Increases(0), m_Decreases(0), m_Decision("hold")
+{ }
+
+void ConcurrencyController::SetBounds(int minLimit, int maxLimit)
+{
+	boost::mutex::scoped_lock lock(m_Mutex);
+
+	m_MinLimit = std::max(1, minLimit);
+	m_MaxLimit = std::max(m_MinLimit, maxLimit);
+	m_Limit = std::min(std::max(m_Limit, m_MinLimit), m_MaxLimit);
+}
+
+void ConcurrencyController::SetLimit(int limit)
+{
+	boost::mutex::scoped_lock lock(m_Mutex);
+
+	m_Limit = std::min(std::max(limit, m_MinLimit), m_MaxLimit);
+}
+
+int ConcurrencyController::GetLimit(void) const
+{
+	boost::mutex::scoped_lock lock(m_Mutex);
+
+	return m_Limit;
+}
+
+/**
+ * Records the execution time of a finished check.
+ *
+ * @param command The name of the check command.
+ * @param executionTime The check's execution time in seconds.
+ */
+void ConcurrencyController::AddLatencySample(const String& command, double executionTime)
+{
+	boost::mutex::scoped_lock lock(m_Mutex);
+
+	CommandLatency& latency = m_Latencies[command];
+	latency.SampleSum += executionTime;
+	latency.SampleCount++;
+}
+
+/**
+ * Records that a check had to wait because the limit was reached.
+ */
+void ConcurrencyController::NotifySaturated(void)
+{
+	boost::mutex::scoped_lock lock(m_Mutex);
+
+	m_Saturated = true;
+}
+
+/**
+ * Adjusts the limit based on the samples collected since the last call.
+ *
+ * @param spawnBacklog The number of processes waiting for the spawn helper.
+ * @param loadPerCpu The system's run queue length per CPU, or a negative
+ *        value if unknown.
+ */
+void ConcurrencyController::Update(int spawnBacklog, double loadPerCpu)
+{
+	boost::mutex::scoped_lock lock(m_Mutex);
+
+	std::vector<double> gradients;
+
+	for (std::pair<const String, CommandLatency>& kv : m_Latencies) {
+		CommandLatency& latency = kv.second;
+
+		if (latency.SampleCount == 0)
+			continue;
+
+		double current = latency.SampleSum / latency.SampleCount;
+
+		if (latency.Baseline == 0)
+			latency.Baseline = current;
+		else
+			latency.Baseline = (1 - l_BaselineWeight) * latency.Baseline + l_BaselineWeight * current;
+
+		gradients.push_back((current > 0) ? std::min(1.0, latency.Baseline / current) : 1);
+
+		latency.SampleSum = 0;
+		latency.SampleCount = 0;
+	}
+
+	if (!gradients.empty()) {
+		std::sort(gradients.begin(), gradients.end());
+
+		size_t middle = gradients.size() / 2;
+
+		if (gradients.size() % 2 == 0)
+			m_Gradient = (gradients[middle - 1] + gradients[middle]) / 2;
+		else
+			m_Gradient = gradients[middle];
+	}
+
+	m_SpawnBacklog = spawnBacklog;
+
+	if (loadPerCpu < 0 || m_LoadPerCpu < 0)
+		m_LoadPerCpu = loadPerCpu;
+	else
+		m_LoadPerCpu = (1 - l_LoadWeight) * m_LoadPerCpu + l_LoadWeight * loadPerCpu;
+
+	String reason;
+
+	if (!gradients.empty() && m_Gradient < l_MinGradient)
+		reason = "latency";
+	else if (m_LoadPerCpu > l_MaxLoadPerCpu)
+		reason = "load";
+	else if (spawnBacklog > l_MaxSpawnBacklog)
+		reason = "spawn_backlog";
+
+	int oldLimit = m_Limit;
+
+	if (m_Cooldown > 0) {
+		m_Cooldown--;
+		m_Decision = "hold (cooldown)";
+	} else if (!reason.IsEmpty()) {
+		m_Limit = std::max(m_MinLimit, static_cast<int>(m_Limit * l_DecreaseFactor));
+		m_Decision = "decrease (" + reason + ")";
+		m_Cooldown = l_DecreaseCooldown;
+	} else if (m_Saturated) {
+		m_Limit = std::min(m_MaxLimit, m_Limit + std::max(1, static_cast<int>(std::sqrt(static_cast<double>(m_Limit)))));
+		m_Decision = "increase";
+	} else
+		m_Decision = "hold";
+
+	if (m_Limit > oldLimit)
+		m_Increases++;
+	else if (m_Limit < oldLimit) {
+		m_Decreases++;
+
+		Log(LogNotice, "ConcurrencyController")
+		    << "Reducing the number of concurrent checks from " << oldLimit << " to " << m_Limit << ": " << m_Decision;
+	}
+
+	m_Saturated = false;
+}
+
+Dictionary::Ptr ConcurrencyController::GetStats(void) const
+{
+	boost::mutex::scoped_lock lock(m_Mutex);
+
+	Dictionary::Ptr stats = new Dictionary();
+	stats->Set("limit", m_Limit);
+	stats->Set("min_limit", m_MinLimit);
+	stats->Set("max_limit", m_MaxLimit);
+	stats->Set("decision", m_Decision);
+	stats->Set("increases", m_Increases);
+	stats->Set("decreases", m_Decreases);
+	stats->Set("gradient", m_Gradient);
+	stats->Set("load_per_cpu", m_LoadPerCpu);
+	stats->Set("spawn_backlog", m_SpawnBacklog);
+
+	return stats;
+}
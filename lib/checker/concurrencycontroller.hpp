@@ -0,0 +1,97 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#ifndef CONCURRENCYCONTROLLER_H
+#define CONCURRENCYCONTROLLER_H
+
+#include "checker/i2-checker.hpp"
+#include "base/dictionary.hpp"
+#include <boost/thread/mutex.hpp>
+#include <map>
+
+namespace icinga
+{
+
+/**
+ * Execution time samples and the long-term baseline for a single check
+ * command.
+ *
+ * @ingroup checker
+ */
+struct CommandLatency
+{
+	double SampleSum;
+	int SampleCount;
+	double Baseline;
+
+	CommandLatency(void)
+		: SampleSum(0), SampleCount(0), Baseline(0)
+	{ }
+};
+
+/**
+ * Tunes the number of concurrent checks. The limit is increased additively
+ * while the checker is saturated and decreased multiplicatively when check
+ * execution times rise above their long-term baseline, the system's run
+ * queue is too long or the spawn helper falls behind (AIMD).
+ *
+ * Each check command has its own baseline so that a change in the mix of
+ * executed commands isn't mistaken for rising execution times.
+ *
+ * @ingroup checker
+ */
+class I2_CHECKER_API ConcurrencyController
+{
+public:
+	ConcurrencyController(void);
+
+	void SetBounds(int minLimit, int maxLimit);
+	void SetLimit(int limit);
+	int GetLimit(void) const;
+
+	void AddLatencySample(const String& command, double executionTime);
+	void NotifySaturated(void);
+
+	void Update(int spawnBacklog, double loadPerCpu);
+
+	Dictionary::Ptr GetStats(void) const;
+
+private:
+	mutable boost::mutex m_Mutex;
+
+	int m_Limit;
+	int m_MinLimit;
+	int m_MaxLimit;
+
+	std::map<String, CommandLatency> m_Latencies;
+	bool m_Saturated;
+
+	double m_Gradient;
+	int m_SpawnBacklog;
+	double m_LoadPerCpu;
+	int m_Cooldown;
+
+	int m_Increases;
+	int m_Decreases;
+	String m_Decision;
+};
+
+}
+
+#endif /* CONCURRENCYCONTROLLER_H */
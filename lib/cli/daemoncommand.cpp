@@ -32,9 +32,14 @@
 #include "base/convert.hpp"
 #include "base/scriptglobal.hpp"
 #include "base/context.hpp"
+#include "base/unixsocket.hpp"
+#include "base/networkstream.hpp"
 #include "config.h"
 #include <boost/program_options.hpp>
 #include <boost/tuple/tuple.hpp>
+#include <boost/exception/errinfo_api_function.hpp>
+#include <boost/exception/errinfo_errno.hpp>
+#include <boost/exception/errinfo_file_name.hpp>
 #include <iostream>
 #include <fstream>
 
@@ -137,17 +142,17 @@ static bool SetDaemonIO(const String& stderrFile)
 }
 
 /**
- * Terminate another process and wait till it has ended
+ * Wait till another process has ended, killing it if it takes too long
  *
- * @params target PID of the process to end
+ * @params target PID of the process to wait for
  */
-static void TerminateAndWaitForEnd(pid_t target)
+static void WaitForEnd(pid_t target)
 {
 #ifndef _WIN32
 	// allow 30 seconds timeout
 	double timeout = Utility::GetTime() + 30;
 
-	int ret = kill(target, SIGTERM);
+	int ret = kill(target, 0);
 
 	while (Utility::GetTime() < timeout && (ret == 0 || errno != ESRCH)) {
 		Utility::Sleep(0.1);
@@ -169,6 +174,106 @@ static void TerminateAndWaitForEnd(pid_t target)
 #endif /* _WIN32 */
 }
 
+/**
+ * Terminate another process and wait till it has ended
+ *
+ * @params target PID of the process to end
+ */
+static void TerminateAndWaitForEnd(pid_t target)
+{
+#ifndef _WIN32
+	kill(target, SIGTERM);
+#endif /* _WIN32 */
+
+	WaitForEnd(target);
+}
+
+/**
+ * Asks the previous instance to stop and to send us its program state
+ * instead of writing it to the state file, then waits till it has ended.
+ *
+ * @params target PID of the previous instance
+ * @returns true if the program state was restored, false if the caller
+ * has to fall back to the state file.
+ */
+static bool ReceiveProgramState(pid_t target)
+{
+#ifndef _WIN32
+	String path = Application::GetHandoverPath();
+	double start = Utility::GetTime();
+	bool restored = false;
+
+	try {
+		(void) unlink(path.CStr());
+
+		UnixSocket::Ptr listener = new UnixSocket();
+		listener->Bind(path);
+
+		if (chmod(path.CStr(), 0600) < 0) {
+			BOOST_THROW_EXCEPTION(posix_error()
+			    << boost::errinfo_api_function("chmod")
+			    << boost::errinfo_errno(errno)
+			    << boost::errinfo_file_name(path));
+		}
+
+		listener->Listen();
+
+		Log(LogInformation, "cli")
+		    << "Asking previous instance of Icinga (PID " << target << ") to hand over its program state";
+
+		if (kill(target, SIGUSR2) < 0) {
+			BOOST_THROW_EXCEPTION(posix_error()
+			    << boost::errinfo_api_function("kill")
+			    << boost::errinfo_errno(errno));
+		}
+
+		/* The previous instance connects once it has stopped its objects. */
+		Socket::Ptr client;
+		double timeout = start + 30;
+
+		while (Utility::GetTime() < timeout) {
+			timeval tv = { 0, 100 * 1000 };
+
+			if (listener->Poll(true, false, &tv)) {
+				client = listener->Accept();
+				break;
+			}
+
+			if (kill(target, 0) < 0 && errno == ESRCH)
+				break;
+		}
+
+		listener->Close();
+		(void) unlink(path.CStr());
+
+		if (client) {
+			NetworkStream::Ptr stream = new NetworkStream(client);
+			restored = ConfigObject::RestoreObjects(stream);
+			stream->Close();
+		}
+	} catch (const std::exception& ex) {
+		Log(LogWarning, "cli")
+		    << "Program state handover failed: " << DiagnosticInformation(ex, false);
+		(void) unlink(path.CStr());
+	}
+
+	if (restored) {
+		Log(LogInformation, "cli")
+		    << "Received program state from previous instance in " << Utility::GetTime() - start << " seconds.";
+
+		WaitForEnd(target);
+	} else {
+		Log(LogWarning, "cli", "Previous instance did not hand over its program state, falling back to the state file.");
+
+		TerminateAndWaitForEnd(target);
+	}
+
+	return restored;
+#else /* _WIN32 */
+	return false;
+#endif /* _WIN32 */
+}
+
 String DaemonCommand::GetDescription(void) const
 {
 	return "Starts Icinga 2.";
@@ -194,7 +299,8 @@ void DaemonCommand::InitParameters(boost::program_options::options_description&
 
 #ifndef _WIN32
 	hiddenDesc.add_options()
-		("reload-internal", po::value<int>(), "used internally to implement config reload: do not call manually, send SIGHUP instead");
+		("reload-internal", po::value<int>(), "used internally to implement config reload: do not call manually, send SIGHUP instead")
+		("reload-handover", po::value<double>(), "used internally to implement config reload: do not call manually, send SIGHUP instead");
 #endif /* _WIN32 */
 }
 
@@ -250,11 +356,20 @@ int DaemonCommand::Run(const po::variables_map& vm, const std::vector<std::strin
 		return EXIT_SUCCESS;
 	}
 
+	bool stateRestored = false;
+
 	if (vm.count("reload-internal")) {
 		int parentpid = vm["reload-internal"].as<int>();
-		Log(LogInformation, "cli")
-		    << "Terminating previous instance of Icinga (PID " << parentpid << ")";
-		TerminateAndWaitForEnd(parentpid);
+
+		if (vm.count("reload-handover")) {
+			Application::SetReloadRequestTime(vm["reload-handover"].as<double>());
+			stateRestored = ReceiveProgramState(parentpid);
+		} else {
+			Log(LogInformation, "cli")
+			    << "Terminating previous instance of Icinga (PID " << parentpid << ")";
+			TerminateAndWaitForEnd(parentpid);
+		}
+
 		Log(LogInformation, "cli", "Previous instance has ended, taking over now.");
 	}
 
@@ -271,12 +386,14 @@ int DaemonCommand::Run(const po::variables_map& vm, const std::vector<std::strin
 	}
 
 	/* restore the previous program state */
-	try {
-		ConfigObject::RestoreObjects(Application::GetStatePath());
-	} catch (const std::exception& ex) {
-		Log(LogCritical, "cli")
-		    << "Failed to restore state file: " << DiagnosticInformation(ex);
-		return EXIT_FAILURE;
+	if (!stateRestored) {
+		try {
+			ConfigObject::RestoreObjects(Application::GetStatePath());
+		} catch (const std::exception& ex) {
+			Log(LogCritical, "cli")
+			    << "Failed to restore state file: " << DiagnosticInformation(ex);
+			return EXIT_FAILURE;
+		}
 	}
 
 	{
@@ -290,6 +407,13 @@ int DaemonCommand::Run(const po::variables_map& vm, const std::vector<std::strin
 		}
 	}
 
+	if (Application::GetReloadRequestTime() > 0) {
+		Log(LogInformation, "cli")
+		    << "Reload finished " << Utility::GetTime() - Application::GetReloadRequestTime()
+		    << " seconds after it was requested (program state "
+		    << (stateRestored ? "handed over in memory" : "restored from the state file") << ").";
+	}
+
 	if (vm.count("daemonize")) {
 		String errorLog;
 		if (vm.count("errorlog"))
@@ -51,8 +51,11 @@ static void IncludeZoneDirRecursive(const String& path, const String& package, b
 	/* register this zone path for cluster config sync */
 	ConfigCompiler::RegisterZoneDir("_etc", path, zoneName);
 
+	std::vector<std::pair<String, String> > files;
+	Utility::GlobRecursive(path, "*.conf", boost::bind(&ConfigCompiler::CollectIncludeFile, boost::ref(files), _1, zoneName), GlobFile);
+
 	std::vector<Expression *> expressions;
-	Utility::GlobRecursive(path, "*.conf", boost::bind(&ConfigCompiler::CollectIncludes, boost::ref(expressions), _1, zoneName, package), GlobFile);
+	ConfigCompiler::CompileFiles(expressions, files, package);
 	DictExpression expr(expressions);
 	if (!ExecuteExpression(&expr))
 		success = false;
@@ -74,8 +77,11 @@ static void IncludeNonLocalZone(const String& zonePath, const String& package, b
 		return;
 	}
 
+	std::vector<std::pair<String, String> > files;
+	Utility::GlobRecursive(zonePath, "*.conf", boost::bind(&ConfigCompiler::CollectIncludeFile, boost::ref(files), _1, zoneName), GlobFile);
+
 	std::vector<Expression *> expressions;
-	Utility::GlobRecursive(zonePath, "*.conf", boost::bind(&ConfigCompiler::CollectIncludes, boost::ref(expressions), _1, zoneName, package), GlobFile);
+	ConfigCompiler::CompileFiles(expressions, files, package);
 	DictExpression expr(expressions);
 	if (!ExecuteExpression(&expr))
 		success = false;
@@ -163,11 +169,18 @@ bool DaemonUtility::LoadConfigFiles(const std::vector<std::string>& configs,
 {
 	ActivationScope ascope;
 
+	double start = Utility::GetTime();
+	double compileStart = ConfigCompiler::GetCompileTime();
+	size_t filesStart = ConfigCompiler::GetCompiledFileCount();
+
 	if (!DaemonUtility::ValidateConfigFiles(configs, objectsFile)) {
 		ConfigCompilerContext::GetInstance()->CancelObjectsFile();
 		return false;
 	}
 
+	double evaluated = Utility::GetTime();
+	double compileTime = ConfigCompiler::GetCompileTime() - compileStart;
+
 	WorkQueue upq(25000, Application::GetConcurrency());
 	upq.SetName("DaemonUtility::LoadConfigFiles");
 	bool result = ConfigItem::CommitItems(ascope.GetContext(), upq, newItems);
@@ -177,6 +190,12 @@ bool DaemonUtility::LoadConfigFiles(const std::vector<std::string>& configs,
 		return false;
 	}
 
+	Log(LogInformation, "cli")
+	    << "Configuration loaded in " << Utility::GetTime() - start << " seconds: parsing "
+	    << ConfigCompiler::GetCompiledFileCount() - filesStart << " files took " << compileTime
+	    << " seconds, evaluation " << evaluated - start - compileTime
+	    << " seconds, committing and validating objects " << Utility::GetTime() - evaluated << " seconds.";
+
 	ConfigCompilerContext::GetInstance()->FinishObjectsFile();
 	ScriptGlobal::WriteToFile(varsfile);
 
@@ -27,6 +27,7 @@
 #include "base/tlsutility.hpp"
 #include "base/json.hpp"
 #include "base/objectlock.hpp"
+#include <boost/bind.hpp>
 #include <boost/algorithm/string/join.hpp>
 #include <boost/algorithm/string/replace.hpp>
 #include <iostream>
@@ -34,6 +34,7 @@
 #include "base/console.hpp"
 #include "base/exception.hpp"
 #include "base/configwriter.hpp"
+#include <boost/bind.hpp>
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/join.hpp>
 #include <boost/algorithm/string/replace.hpp>
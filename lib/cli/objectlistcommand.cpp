@@ -19,6 +19,7 @@
 
 #include "cli/objectlistcommand.hpp"
 #include "cli/objectlistutility.hpp"
+#include "config/objectsfileindex.hpp"
 #include "base/logger.hpp"
 #include "base/application.hpp"
 #include "base/convert.hpp"
@@ -76,10 +77,6 @@ int ObjectListCommand::Run(const boost::program_options::variables_map& vm, cons
 		return 1;
 	}
 
-	std::fstream fp;
-	fp.open(objectfile.CStr(), std::ios_base::in);
-
-	StdioStream::Ptr sfp = new StdioStream(&fp, false);
 	unsigned long objects_count = 0;
 	std::map<String, int> type_count;
 
@@ -92,23 +89,42 @@ int ObjectListCommand::Run(const boost::program_options::variables_map& vm, cons
 
 	bool first = true;
 
-	String message;
-	StreamReadContext src;
-	for (;;) {
-		StreamReadStatus srs = NetString::ReadStringFromStream(sfp, &message, src);
+	ObjectsFileIndex index;
 
-		if (srs == StatusEof)
-			break;
+	if (index.Open(objectfile)) {
+		/* Only decode the records which match the filters. */
+		for (const ObjectsFileIndexEntry& entry : index.FindObjects(type_filter, name_filter))
+			ObjectListUtility::PrintObject(std::cout, first, index.ReadObject(entry), type_count, name_filter, type_filter);
 
-		if (srs != StatusNewItem)
-			continue;
+		objects_count = index.GetCount();
+	} else {
+		Log(LogNotice, "cli")
+		    << "Objects index file '" << ObjectsFileIndex::GetIndexPath(objectfile)
+		    << "' is missing or outdated. Reading the whole objects file.";
 
-		ObjectListUtility::PrintObject(std::cout, first, message, type_count, name_filter, type_filter);
-		objects_count++;
-	}
+		std::fstream fp;
+		fp.open(objectfile.CStr(), std::ios_base::in);
+
+		StdioStream::Ptr sfp = new StdioStream(&fp, false);
+
+		String message;
+		StreamReadContext src;
+		for (;;) {
+			StreamReadStatus srs = NetString::ReadStringFromStream(sfp, &message, src);
 
-	sfp->Close();
-	fp.close();
+			if (srs == StatusEof)
+				break;
+
+			if (srs != StatusNewItem)
+				continue;
+
+			ObjectListUtility::PrintObject(std::cout, first, message, type_count, name_filter, type_filter);
+			objects_count++;
+		}
+
+		sfp->Close();
+		fp.close();
+	}
 
 	if (vm.count("count")) {
 		if (!first)
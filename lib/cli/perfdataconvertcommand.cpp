@@ -0,0 +1,98 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "cli/perfdataconvertcommand.hpp"
+#include "perfdata/perfdataspoolreader.hpp"
+#include "base/logger.hpp"
+#include "base/exception.hpp"
+#include <fstream>
+#include <iostream>
+
+using namespace icinga;
+namespace po = boost::program_options;
+
+REGISTER_CLICOMMAND("perfdata/convert", PerfdataConvertCommand);
+
+String PerfdataConvertCommand::GetDescription(void) const
+{
+	return "Converts binary perfdata spool files to the PerfdataWriter text format.";
+}
+
+String PerfdataConvertCommand::GetShortDescription(void) const
+{
+	return "converts binary perfdata spool files";
+}
+
+void PerfdataConvertCommand::InitParameters(boost::program_options::options_description& visibleDesc,
+	boost::program_options::options_description& hiddenDesc) const
+{
+	visibleDesc.add_options()
+		("output", po::value<std::string>(), "Output file (defaults to stdout)");
+}
+
+int PerfdataConvertCommand::GetMinArguments(void) const
+{
+	return 1;
+}
+
+int PerfdataConvertCommand::GetMaxArguments(void) const
+{
+	return -1;
+}
+
+ImpersonationLevel PerfdataConvertCommand::GetImpersonationLevel(void) const
+{
+	return ImpersonateNone;
+}
+
+/**
+ * The entry point for the "perfdata convert" CLI command.
+ *
+ * @returns An exit status.
+ */
+int PerfdataConvertCommand::Run(const boost::program_options::variables_map& vm, const std::vector<std::string>& ap) const
+{
+	std::ofstream outputFile;
+
+	if (vm.count("output")) {
+		String outputPath = vm["output"].as<std::string>();
+		outputFile.open(outputPath.CStr(), std::ofstream::app);
+
+		if (!outputFile) {
+			Log(LogCritical, "cli")
+			    << "Could not open output file '" << outputPath << "'.";
+			return 1;
+		}
+	}
+
+	std::ostream& fp = outputFile.is_open() ? outputFile : std::cout;
+
+	for (const std::string& path : ap) {
+		try {
+			PerfdataSpoolReader::Ptr reader = new PerfdataSpoolReader(path);
+			reader->WriteLegacyText(fp);
+		} catch (const std::exception& ex) {
+			Log(LogCritical, "cli")
+			    << "Could not convert perfdata spool file '" << path << "': " << DiagnosticInformation(ex, false);
+			return 1;
+		}
+	}
+
+	return 0;
+}
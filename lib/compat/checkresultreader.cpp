@@ -32,7 +32,15 @@
 #include "base/exception.hpp"
 #include "base/context.hpp"
 #include "base/statsfunction.hpp"
-#include <fstream>
+#include "icinga/perfdatavalue.hpp"
+#include <boost/functional/hash.hpp>
+#include <algorithm>
+#include <sys/stat.h>
+#include <fcntl.h>
+#ifdef HAVE_INOTIFY
+#	include <sys/inotify.h>
+#	include <poll.h>
+#endif /* HAVE_INOTIFY */
 
 using namespace icinga;
 
@@ -40,12 +48,46 @@ REGISTER_TYPE(CheckResultReader);
 
 REGISTER_STATSFUNCTION(CheckResultReader, &CheckResultReader::StatsFunc);
 
-void CheckResultReader::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr&)
+/* Number of processed files which are removed from the spool directory at once. */
+static const size_t l_UnlinkBatchSize = 128;
+
+/* Number of check results a single work queue may hold before reading
+ * further files is delayed. */
+static const size_t l_MaxPendingResults = 10000;
+
+CheckResultReader::CheckResultReader(void)
+	: m_ProcessQueueCount(Application::GetConcurrency()), m_ProcessedStats(15 * 60), m_ProcessedResults(0)
+#ifdef HAVE_INOTIFY
+	, m_InotifyFD(-1), m_Stopped(false)
+#endif /* HAVE_INOTIFY */
+{
+	m_ProcessQueues.reset(new WorkQueue[m_ProcessQueueCount]);
+}
+
+void CheckResultReader::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata)
 {
 	Dictionary::Ptr nodes = new Dictionary();
 
 	for (const CheckResultReader::Ptr& checkresultreader : ConfigType::GetObjectsByType<CheckResultReader>()) {
-		nodes->Set(checkresultreader->GetName(), 1); //add more stats
+		String name = checkresultreader->GetName();
+		size_t backlog = checkresultreader->GetBacklog();
+		double rate = checkresultreader->GetProcessedResults(60) / 60.0;
+		int processed;
+
+		{
+			boost::mutex::scoped_lock lock(checkresultreader->m_StatsMutex);
+			processed = checkresultreader->m_ProcessedResults;
+		}
+
+		Dictionary::Ptr stats = new Dictionary();
+		stats->Set("backlog", backlog);
+		stats->Set("results_processed", processed);
+		stats->Set("results_per_second", rate);
+
+		nodes->Set(name, stats);
+
+		perfdata->Add(new PerfdataValue("checkresultreader_" + name + "_backlog", backlog));
+		perfdata->Add(new PerfdataValue("checkresultreader_" + name + "_results_per_second", rate));
 	}
 
 	status->Set("checkresultreader", nodes);
@@ -62,6 +104,31 @@ void CheckResultReader::Start(bool runtimeCreated)
 	    << "'" << GetName() << "' started.";
 
 #ifndef _WIN32
+	for (size_t i = 0; i < m_ProcessQueueCount; i++) {
+		m_ProcessQueues[i].SetName("CheckResultReader, " + GetName() + ", #" + Convert::ToString(i));
+		m_ProcessQueues[i].SetExceptionCallback(boost::bind(&CheckResultReader::ExceptionHandler, this, _1));
+	}
+
+#ifdef HAVE_INOTIFY
+	m_InotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	if (m_InotifyFD < 0) {
+		Log(LogWarning, "CheckResultReader")
+		    << "inotify_init1() failed with error code " << errno << ", \"" << Utility::FormatErrorNumber(errno) << "\"";
+	} else if (inotify_add_watch(m_InotifyFD, GetSpoolDir().CStr(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+		Log(LogWarning, "CheckResultReader")
+		    << "inotify_add_watch() for spool directory '" << GetSpoolDir() << "' failed with error code "
+		    << errno << ", \"" << Utility::FormatErrorNumber(errno) << "\"";
+
+		close(m_InotifyFD);
+		m_InotifyFD = -1;
+	} else {
+		m_WatchThread = boost::thread(boost::bind(&CheckResultReader::WatchThreadProc, this));
+	}
+#endif /* HAVE_INOTIFY */
+
+	/* The timer picks up files which were already in the spool directory
+	 * and is the only source of new files if inotify isn't available. */
 	m_ReadTimer = new Timer();
 	m_ReadTimer->OnTimerExpired.connect(boost::bind(&CheckResultReader::ReadTimerHandler, this));
 	m_ReadTimer->SetInterval(5);
@@ -77,80 +144,323 @@ void CheckResultReader::Stop(bool runtimeRemoved)
 	Log(LogInformation, "CheckResultReader")
 	    << "'" << GetName() << "' stopped.";
 
+#ifndef _WIN32
+	if (m_ReadTimer)
+		m_ReadTimer->Stop(true);
+
+#ifdef HAVE_INOTIFY
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+		m_Stopped = true;
+	}
+
+	if (m_WatchThread.joinable())
+		m_WatchThread.join();
+
+	if (m_InotifyFD >= 0) {
+		close(m_InotifyFD);
+		m_InotifyFD = -1;
+	}
+#endif /* HAVE_INOTIFY */
+
+	for (size_t i = 0; i < m_ProcessQueueCount; i++)
+		m_ProcessQueues[i].Join();
+
+	FlushUnlinkFiles();
+#endif /* _WIN32 */
+
 	ObjectImpl<CheckResultReader>::Stop(runtimeRemoved);
 }
 
 /**
  * @threadsafety Always.
  */
-void CheckResultReader::ReadTimerHandler(void) const
+void CheckResultReader::ReadTimerHandler(void)
 {
 	CONTEXT("Processing check result files in '" + GetSpoolDir() + "'");
 
-	Utility::Glob(GetSpoolDir() + "/c??????.ok", boost::bind(&CheckResultReader::ProcessCheckResultFile, this, _1), GlobFile);
+	FlushUnlinkFiles();
+
+	ScanSpoolDir();
+}
+
+static void AddSpoolFile(std::vector<std::pair<time_t, String> >& files, const String& path)
+{
+	struct stat statbuf;
+
+	if (stat(path.CStr(), &statbuf) < 0)
+		return;
+
+	files.push_back(std::make_pair(statbuf.st_mtime, path));
+}
+
+/**
+ * Queues all check result files in the spool directory. Files are queued
+ * in the order in which they were written so that multiple results for
+ * the same host or service are processed in that order.
+ */
+void CheckResultReader::ScanSpoolDir(void)
+{
+	std::vector<std::pair<time_t, String> > files;
+
+	Utility::Glob(GetSpoolDir() + "/c??????.ok", boost::bind(&AddSpoolFile, boost::ref(files), _1), GlobFile);
+
+	std::stable_sort(files.begin(), files.end(),
+	    [](const std::pair<time_t, String>& a, const std::pair<time_t, String>& b) { return a.first < b.first; });
+
+	for (const std::pair<time_t, String>& file : files)
+		EnqueueCheckResultFile(file.second);
+
+	FlushUnlinkFiles();
+}
+
+#ifdef HAVE_INOTIFY
+void CheckResultReader::WatchThreadProc(void)
+{
+	Utility::SetThreadName("CR Reader");
+
+	String spoolDir = GetSpoolDir();
+
+	for (;;) {
+		{
+			boost::mutex::scoped_lock lock(m_Mutex);
+
+			if (m_Stopped)
+				break;
+		}
+
+		pollfd pfd;
+		pfd.fd = m_InotifyFD;
+		pfd.events = POLLIN;
+
+		if (poll(&pfd, 1, 500) <= 0)
+			continue;
+
+		char buffer[16384] __attribute__((aligned(__alignof__(struct inotify_event))));
+		ssize_t rc = read(m_InotifyFD, buffer, sizeof(buffer));
+
+		if (rc <= 0)
+			continue;
+
+		for (char *p = buffer; p < buffer + rc; ) {
+			struct inotify_event *event = reinterpret_cast<struct inotify_event *>(p);
+			p += sizeof(struct inotify_event) + event->len;
+
+			/* We've missed events, fall back to scanning the directory. */
+			if (event->mask & IN_Q_OVERFLOW) {
+				ScanSpoolDir();
+				continue;
+			}
+
+			if (event->len == 0)
+				continue;
+
+			String name = event->name;
+
+			if (Utility::Match("c??????.ok", name))
+				EnqueueCheckResultFile(spoolDir + "/" + name);
+		}
+
+		FlushUnlinkFiles();
+	}
+}
+#endif /* HAVE_INOTIFY */
+
+/**
+ * Reads a check result file unless it has already been read and is waiting
+ * to be removed, and queues the check result for processing. Results for
+ * the same host or service always end up on the same work queue so that
+ * they're processed in the order in which they were queued.
+ */
+void CheckResultReader::EnqueueCheckResultFile(const String& path)
+{
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+
+		if (!m_PendingFiles.insert(path).second)
+			return;
+	}
+
+	Dictionary::Ptr attrs = ReadCheckResultFile(path);
+
+	if (!attrs)
+		return;
+
+	String key = attrs->Get("host_name");
+
+	if (attrs->Contains("service_description"))
+		key += "!" + attrs->Get("service_description");
+
+	WorkQueue& queue = m_ProcessQueues[boost::hash_range(key.Begin(), key.End()) % m_ProcessQueueCount];
+
+	if (queue.GetLength() >= l_MaxPendingResults)
+		queue.Join();
+
+	queue.Enqueue(boost::bind(&CheckResultReader::ProcessCheckResult, CheckResultReader::Ptr(this), attrs));
+}
+
+/**
+ * Removes processed check result files from the spool directory.
+ */
+void CheckResultReader::FlushUnlinkFiles(void)
+{
+	std::vector<String> files;
+
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+		files.swap(m_UnlinkFiles);
+	}
+
+	if (files.empty())
+		return;
+
+	for (const String& file : files) {
+		if (unlink(file.CStr()) < 0 && errno != ENOENT) {
+			Log(LogWarning, "CheckResultReader")
+			    << "unlink() for check result file '" << file << "' failed with error code "
+			    << errno << ", \"" << Utility::FormatErrorNumber(errno) << "\"";
+		}
+	}
+
+	/* Only forget about the files once they're gone, otherwise the next
+	 * directory scan would process them again. */
+	boost::mutex::scoped_lock lock(m_Mutex);
+
+	for (const String& file : files)
+		m_PendingFiles.erase(file);
 }
 
-void CheckResultReader::ProcessCheckResultFile(const String& path) const
+void CheckResultReader::ExceptionHandler(boost::exception_ptr exp)
 {
-	CONTEXT("Processing check result file '" + path + "'");
+	Log(LogCritical, "CheckResultReader")
+	    << "Exception while processing check result file: " << DiagnosticInformation(exp);
+}
+
+size_t CheckResultReader::GetBacklog(void) const
+{
+	size_t backlog = 0;
+
+	for (size_t i = 0; i < m_ProcessQueueCount; i++)
+		backlog += m_ProcessQueues[i].GetLength();
+
+	return backlog;
+}
+
+int CheckResultReader::GetProcessedResults(RingBuffer::SizeType span) const
+{
+	boost::mutex::scoped_lock lock(m_StatsMutex);
+	return m_ProcessedStats.GetValues(span);
+}
+
+static inline bool MatchKey(const char *key, size_t length, const char *name)
+{
+	return strncmp(key, name, length) == 0 && name[length] == '\0';
+}
+
+/**
+ * Reads and parses a check result file and marks it for removal.
+ *
+ * @returns The file's attributes, or an empty pointer if the file could
+ * not be read.
+ */
+Dictionary::Ptr CheckResultReader::ReadCheckResultFile(const String& path)
+{
+	CONTEXT("Reading check result file '" + path + "'");
 
 	String crfile = String(path.Begin(), path.End() - 3); /* Remove the ".ok" extension. */
 
-	std::ifstream fp;
-	fp.exceptions(std::ifstream::badbit);
-	fp.open(crfile.CStr());
+	std::vector<char> data;
+	int fd = open(crfile.CStr(), O_RDONLY | O_CLOEXEC);
 
-	std::map<String, String> attrs;
+	if (fd < 0) {
+		Log(LogWarning, "CheckResultReader")
+		    << "open() for check result file '" << crfile << "' failed with error code "
+		    << errno << ", \"" << Utility::FormatErrorNumber(errno) << "\"";
+	} else {
+		char buffer[4096];
+		ssize_t rc;
 
-	while (fp.good()) {
-		std::string line;
-		std::getline(fp, line);
+		while ((rc = read(fd, buffer, sizeof(buffer))) > 0)
+			data.insert(data.end(), buffer, buffer + rc);
 
-		if (line.empty() || line[0] == '#')
+		close(fd);
+	}
+
+	/* The files are removed in batches, see FlushUnlinkFiles(). */
+	bool flush;
+
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+		m_UnlinkFiles.push_back(path);
+		m_UnlinkFiles.push_back(crfile);
+		flush = (m_UnlinkFiles.size() >= 2 * l_UnlinkBatchSize);
+	}
+
+	if (flush)
+		FlushUnlinkFiles();
+
+	if (fd < 0)
+		return Dictionary::Ptr();
+
+	Dictionary::Ptr attrs = new Dictionary();
+
+	const char *p = data.empty() ? NULL : &data[0];
+	const char *end = p + data.size();
+
+	while (p < end) {
+		const char *eol = static_cast<const char *>(memchr(p, '\n', end - p));
+
+		if (!eol)
+			eol = end;
+
+		const char *line = p;
+		p = eol + 1;
+
+		if (line == eol || line[0] == '#')
 			continue; /* Ignore comments and empty lines. */
 
-		size_t pos = line.find_first_of('=');
+		const char *sep = static_cast<const char *>(memchr(line, '=', eol - line));
 
-		if (pos == std::string::npos)
+		if (!sep)
 			continue; /* Ignore invalid lines. */
 
-		String key = line.substr(0, pos);
-		String value = line.substr(pos + 1);
+		size_t keyLength = sep - line;
+		String value(sep + 1, eol);
 
-		attrs[key] = value;
+		if (MatchKey(line, keyLength, "host_name") || MatchKey(line, keyLength, "service_description") ||
+		    MatchKey(line, keyLength, "output") || MatchKey(line, keyLength, "return_code") ||
+		    MatchKey(line, keyLength, "start_time") || MatchKey(line, keyLength, "finish_time"))
+			attrs->Set(String(line, sep), value);
 	}
 
-	/* Remove the checkresult files. */
-	if (unlink(path.CStr()) < 0)
-		BOOST_THROW_EXCEPTION(posix_error()
-		    << boost::errinfo_api_function("unlink")
-		    << boost::errinfo_errno(errno)
-		    << boost::errinfo_file_name(path));
+	return attrs;
+}
 
-	if (unlink(crfile.CStr()) < 0)
-		BOOST_THROW_EXCEPTION(posix_error()
-		    << boost::errinfo_api_function("unlink")
-		    << boost::errinfo_errno(errno)
-		    << boost::errinfo_file_name(crfile));
+void CheckResultReader::ProcessCheckResult(const Dictionary::Ptr& attrs)
+{
+	String hostName = attrs->Get("host_name");
+
+	CONTEXT("Processing check result for host '" + hostName + "'");
 
 	Checkable::Ptr checkable;
 
-	Host::Ptr host = Host::GetByName(attrs["host_name"]);
+	Host::Ptr host = Host::GetByName(hostName);
 
 	if (!host) {
 		Log(LogWarning, "CheckResultReader")
-		    << "Ignoring checkresult file for host '" << attrs["host_name"] << "': Host does not exist.";
+		    << "Ignoring checkresult file for host '" << hostName << "': Host does not exist.";
 
 		return;
 	}
 
-	if (attrs.find("service_description") != attrs.end()) {
-		Service::Ptr service = host->GetServiceByShortName(attrs["service_description"]);
+	if (attrs->Contains("service_description")) {
+		String serviceDescription = attrs->Get("service_description");
+		Service::Ptr service = host->GetServiceByShortName(serviceDescription);
 
 		if (!service) {
 			Log(LogWarning, "CheckResultReader")
-			    << "Ignoring checkresult file for host '" << attrs["host_name"]
-			    << "', service '" << attrs["service_description"] << "': Service does not exist.";
+			    << "Ignoring checkresult file for host '" << hostName
+			    << "', service '" << serviceDescription << "': Service does not exist.";
 
 			return;
 		}
@@ -160,13 +470,12 @@ void CheckResultReader::ProcessCheckResultFile(const String& path) const
 		checkable = host;
 
 	CheckResult::Ptr result = new CheckResult();
-	String output = CompatUtility::UnEscapeString(attrs["output"]);
-	std::pair<String, Value> co = PluginUtility::ParseCheckOutput(output);
+	std::pair<String, Value> co = PluginUtility::ParseCheckOutput(CompatUtility::UnEscapeString(attrs->Get("output")));
 	result->SetOutput(co.first);
 	result->SetPerformanceData(PluginUtility::SplitPerfdata(co.second));
-	result->SetState(PluginUtility::ExitStatusToState(Convert::ToLong(attrs["return_code"])));
-	result->SetExecutionStart(Convert::ToDouble(attrs["start_time"]));
-	result->SetExecutionEnd(Convert::ToDouble(attrs["finish_time"]));
+	result->SetState(PluginUtility::ExitStatusToState(Convert::ToLong(attrs->Get("return_code"))));
+	result->SetExecutionStart(Convert::ToDouble(attrs->Get("start_time")));
+	result->SetExecutionEnd(Convert::ToDouble(attrs->Get("finish_time")));
 
 	checkable->ProcessCheckResult(result);
 
@@ -177,4 +486,8 @@ void CheckResultReader::ProcessCheckResultFile(const String& path) const
 	 * as we receive check result files for a host/service we won't execute any
 	 * active checks. */
 	checkable->SetNextCheck(Utility::GetTime() + checkable->GetCheckInterval());
+
+	boost::mutex::scoped_lock lock(m_StatsMutex);
+	m_ProcessedStats.InsertValue(Utility::GetTime(), 1);
+	m_ProcessedResults++;
 }
@@ -22,7 +22,11 @@
 
 #include "compat/checkresultreader.thpp"
 #include "base/timer.hpp"
-#include <fstream>
+#include "base/workqueue.hpp"
+#include "base/ringbuffer.hpp"
+#include <boost/thread/thread.hpp>
+#include <boost/scoped_array.hpp>
+#include <set>
 
 namespace icinga
 {
@@ -38,6 +42,8 @@ public:
 	DECLARE_OBJECT(CheckResultReader);
 	DECLARE_OBJECTNAME(CheckResultReader);
 
+	CheckResultReader(void);
+
 	static void StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata);
 
 protected:
@@ -46,8 +52,35 @@ protected:
 
 private:
 	Timer::Ptr m_ReadTimer;
-	void ReadTimerHandler(void) const;
-	void ProcessCheckResultFile(const String& path) const;
+	boost::scoped_array<WorkQueue> m_ProcessQueues;
+	size_t m_ProcessQueueCount;
+
+	mutable boost::mutex m_Mutex;
+	std::set<String> m_PendingFiles;
+	std::vector<String> m_UnlinkFiles;
+
+	mutable boost::mutex m_StatsMutex;
+	RingBuffer m_ProcessedStats;
+	int m_ProcessedResults;
+
+#ifdef HAVE_INOTIFY
+	int m_InotifyFD;
+	bool m_Stopped;
+	boost::thread m_WatchThread;
+
+	void WatchThreadProc(void);
+#endif /* HAVE_INOTIFY */
+
+	void ReadTimerHandler(void);
+	void ScanSpoolDir(void);
+	void EnqueueCheckResultFile(const String& path);
+	Dictionary::Ptr ReadCheckResultFile(const String& path);
+	void ProcessCheckResult(const Dictionary::Ptr& attrs);
+	void FlushUnlinkFiles(void);
+	void ExceptionHandler(boost::exception_ptr exp);
+
+	size_t GetBacklog(void) const;
+	int GetProcessedResults(RingBuffer::SizeType span) const;
 };
 
 }
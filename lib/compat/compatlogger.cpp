@@ -34,7 +34,11 @@
 #include "base/application.hpp"
 #include "base/utility.hpp"
 #include "base/statsfunction.hpp"
+#include "icinga/perfdatavalue.hpp"
 #include <boost/algorithm/string.hpp>
+#ifdef _WIN32
+#	include <io.h>
+#endif /* _WIN32 */
 
 using namespace icinga;
 
@@ -42,17 +46,65 @@ REGISTER_TYPE(CompatLogger);
 
 REGISTER_STATSFUNCTION(CompatLogger, &CompatLogger::StatsFunc);
 
-void CompatLogger::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr&)
+CompatLogger::CompatLogger(void)
+	: m_RotationPending(false), m_RotationArchive(false), m_RotationPosition(0),
+	  m_Stopped(false), m_LinesWritten(0), m_OutputFile(NULL)
+{ }
+
+void CompatLogger::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata)
 {
 	Dictionary::Ptr nodes = new Dictionary();
 
 	for (const CompatLogger::Ptr& compat_logger : ConfigType::GetObjectsByType<CompatLogger>()) {
-		nodes->Set(compat_logger->GetName(), 1); //add more stats
+		String name = compat_logger->GetName();
+		size_t pendingLines;
+		int linesWritten;
+
+		{
+			boost::mutex::scoped_lock lock(compat_logger->m_Mutex);
+			pendingLines = compat_logger->m_Lines.size();
+			linesWritten = compat_logger->m_LinesWritten;
+		}
+
+		Dictionary::Ptr stats = new Dictionary();
+		stats->Set("pending_lines", pendingLines);
+		stats->Set("lines_written", linesWritten);
+
+		nodes->Set(name, stats);
+
+		perfdata->Add(new PerfdataValue("compatlogger_" + name + "_pending_lines", pendingLines));
 	}
 
 	status->Set("compatlogger", nodes);
 }
 
+/**
+ * Joins the fields with ';' into a buffer that is allocated only once.
+ */
+static String JoinFields(const char *prefix, std::initializer_list<String> fields)
+{
+	size_t length = strlen(prefix) + fields.size();
+
+	for (const String& field : fields)
+		length += field.GetLength();
+
+	std::string result;
+	result.reserve(length);
+	result += prefix;
+
+	bool first = true;
+
+	for (const String& field : fields) {
+		if (!first)
+			result += ';';
+
+		first = false;
+		result += field.GetData();
+	}
+
+	return result;
+}
+
 /**
  * @threadsafety Always.
  */
@@ -63,21 +115,28 @@ void CompatLogger::Start(bool runtimeCreated)
 	Log(LogInformation, "CompatLogger")
 	    << "'" << GetName() << "' started.";
 
-	Checkable::OnNewCheckResult.connect(bind(&CompatLogger::CheckResultHandler, this, _1, _2));
-	Checkable::OnNotificationSentToUser.connect(bind(&CompatLogger::NotificationSentHandler, this, _1, _2, _3, _4, _5, _6, _7, _8));
-	Downtime::OnDowntimeTriggered.connect(boost::bind(&CompatLogger::TriggerDowntimeHandler, this, _1));
-	Downtime::OnDowntimeRemoved.connect(boost::bind(&CompatLogger::RemoveDowntimeHandler, this, _1));
-	Checkable::OnEventCommandExecuted.connect(bind(&CompatLogger::EventCommandHandler, this, _1));
-	
-	Checkable::OnFlappingChanged.connect(boost::bind(&CompatLogger::FlappingChangedHandler, this, _1));
-	Checkable::OnEnableFlappingChanged.connect(boost::bind(&CompatLogger::EnableFlappingChangedHandler, this, _1));
-	
-	ExternalCommandProcessor::OnNewExternalCommand.connect(boost::bind(&CompatLogger::ExternalCommandHandler, this, _2, _3));
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+		m_Stopped = false;
+	}
+
+	m_Connections.push_back(Checkable::OnNewCheckResult.connect(bind(&CompatLogger::CheckResultHandler, this, _1, _2)));
+	m_Connections.push_back(Checkable::OnNotificationSentToUser.connect(bind(&CompatLogger::NotificationSentHandler, this, _1, _2, _3, _4, _5, _6, _7, _8)));
+	m_Connections.push_back(Downtime::OnDowntimeTriggered.connect(boost::bind(&CompatLogger::TriggerDowntimeHandler, this, _1)));
+	m_Connections.push_back(Downtime::OnDowntimeRemoved.connect(boost::bind(&CompatLogger::RemoveDowntimeHandler, this, _1)));
+	m_Connections.push_back(Checkable::OnEventCommandExecuted.connect(bind(&CompatLogger::EventCommandHandler, this, _1)));
+
+	m_Connections.push_back(Checkable::OnFlappingChanged.connect(boost::bind(&CompatLogger::FlappingChangedHandler, this, _1)));
+	m_Connections.push_back(Checkable::OnEnableFlappingChanged.connect(boost::bind(&CompatLogger::EnableFlappingChangedHandler, this, _1)));
+
+	m_Connections.push_back(ExternalCommandProcessor::OnNewExternalCommand.connect(boost::bind(&CompatLogger::ExternalCommandHandler, this, _2, _3)));
 
 	m_RotationTimer = new Timer();
 	m_RotationTimer->OnTimerExpired.connect(boost::bind(&CompatLogger::RotationTimerHandler, this));
 	m_RotationTimer->Start();
 
+	m_WriterThread = boost::thread(boost::bind(&CompatLogger::WriterThreadProc, this));
+
 	ReopenFile(false);
 	ScheduleNextRotation();
 }
@@ -90,6 +149,23 @@ void CompatLogger::Stop(bool runtimeRemoved)
 	Log(LogInformation, "CompatLogger")
 	    << "'" << GetName() << "' stopped.";
 
+	for (boost::signals2::connection& conn : m_Connections)
+		conn.disconnect();
+
+	m_Connections.clear();
+
+	if (m_RotationTimer)
+		m_RotationTimer->Stop(true);
+
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+		m_Stopped = true;
+		m_CV.notify_one();
+	}
+
+	if (m_WriterThread.joinable())
+		m_WriterThread.join();
+
 	ObjectImpl<CompatLogger>::Stop(runtimeRemoved);
 }
 
@@ -126,34 +202,23 @@ void CompatLogger::CheckResultHandler(const Checkable::Ptr& checkable, const Che
 	if (cr)
 		output = CompatUtility::GetCheckResultOutput(cr);
 
-	std::ostringstream msgbuf;
-
 	if (service) {
-		msgbuf << "SERVICE ALERT: "
-		       << host->GetName() << ";"
-		       << service->GetShortName() << ";"
-		       << Service::StateToString(service->GetState()) << ";"
-		       << Service::StateTypeToString(service->GetStateType()) << ";"
-		       << attempt_after << ";"
-		       << output << ""
-		       << "";
+		WriteLine(JoinFields("SERVICE ALERT: ", {
+			host->GetName(),
+			service->GetShortName(),
+			Service::StateToString(service->GetState()),
+			Service::StateTypeToString(service->GetStateType()),
+			Convert::ToString(attempt_after),
+			output
+		}));
 	} else {
-		String state = Host::StateToString(Host::CalculateState(static_cast<ServiceState>(state_after)));
-
-		msgbuf << "HOST ALERT: "
-		       << host->GetName() << ";"
-		       << CompatUtility::GetHostStateString(host) << ";"
-		       << Host::StateTypeToString(host->GetStateType()) << ";"
-		       << attempt_after << ";"
-		       << output << ""
-		       << "";
-
-	}
-
-	{
-		ObjectLock olock(this);
-		WriteLine(msgbuf.str());
-		Flush();
+		WriteLine(JoinFields("HOST ALERT: ", {
+			host->GetName(),
+			CompatUtility::GetHostStateString(host),
+			Host::StateTypeToString(host->GetStateType()),
+			Convert::ToString(attempt_after),
+			output
+		}));
 	}
 }
 
@@ -169,27 +234,19 @@ void CompatLogger::TriggerDowntimeHandler(const Downtime::Ptr& downtime)
 	if (!downtime)
 		return;
 
-	std::ostringstream msgbuf;
-
 	if (service) {
-		msgbuf << "SERVICE DOWNTIME ALERT: "
-			<< host->GetName() << ";"
-			<< service->GetShortName() << ";"
-			<< "STARTED" << "; "
-			<< "Checkable has entered a period of scheduled downtime."
-			<< "";
+		WriteLine(JoinFields("SERVICE DOWNTIME ALERT: ", {
+			host->GetName(),
+			service->GetShortName(),
+			"STARTED",
+			" Checkable has entered a period of scheduled downtime."
+		}));
 	} else {
-		msgbuf << "HOST DOWNTIME ALERT: "
-			<< host->GetName() << ";"
-			<< "STARTED" << "; "
-			<< "Checkable has entered a period of scheduled downtime."
-			<< "";
-	}
-
-	{
-		ObjectLock oLock(this);
-		WriteLine(msgbuf.str());
-		Flush();
+		WriteLine(JoinFields("HOST DOWNTIME ALERT: ", {
+			host->GetName(),
+			"STARTED",
+			" Checkable has entered a period of scheduled downtime."
+		}));
 	}
 }
 
@@ -216,27 +273,19 @@ void CompatLogger::RemoveDowntimeHandler(const Downtime::Ptr& downtime)
 		downtime_state_str = "STOPPED";
 	}
 
-	std::ostringstream msgbuf;
-
 	if (service) {
-		msgbuf << "SERVICE DOWNTIME ALERT: "
-			<< host->GetName() << ";"
-			<< service->GetShortName() << ";"
-			<< downtime_state_str << "; "
-			<< downtime_output
-			<< "";
+		WriteLine(JoinFields("SERVICE DOWNTIME ALERT: ", {
+			host->GetName(),
+			service->GetShortName(),
+			downtime_state_str,
+			" " + downtime_output
+		}));
 	} else {
-		msgbuf << "HOST DOWNTIME ALERT: "
-			<< host->GetName() << ";"
-			<< downtime_state_str << "; "
-			<< downtime_output
-			<< "";
-	}
-
-	{
-		ObjectLock oLock(this);
-		WriteLine(msgbuf.str());
-		Flush();
+		WriteLine(JoinFields("HOST DOWNTIME ALERT: ", {
+			host->GetName(),
+			downtime_state_str,
+			" " + downtime_output
+		}));
 	}
 }
 
@@ -273,34 +322,25 @@ void CompatLogger::NotificationSentHandler(const Notification::Ptr& notification
 	if (cr)
 		output = CompatUtility::GetCheckResultOutput(cr);
 
-	std::ostringstream msgbuf;
-
 	if (service) {
-		msgbuf << "SERVICE NOTIFICATION: "
-			<< user->GetName() << ";"
-			<< host->GetName() << ";"
-			<< service->GetShortName() << ";"
-			<< notification_type_str << ";"
-			<< command_name << ";"
-			<< output << ";"
-			<< author_comment
-			<< "";
+		WriteLine(JoinFields("SERVICE NOTIFICATION: ", {
+			user->GetName(),
+			host->GetName(),
+			service->GetShortName(),
+			notification_type_str,
+			command_name,
+			output,
+			author_comment
+		}));
 	} else {
-		msgbuf << "HOST NOTIFICATION: "
-			<< user->GetName() << ";"
-			<< host->GetName() << ";"
-			<< notification_type_str << " "
-			<< "(" << CompatUtility::GetHostStateString(host) << ");"
-			<< command_name << ";"
-			<< output << ";"
-			<< author_comment
-			<< "";
-	}
-
-	{
-		ObjectLock oLock(this);
-		WriteLine(msgbuf.str());
-		Flush();
+		WriteLine(JoinFields("HOST NOTIFICATION: ", {
+			user->GetName(),
+			host->GetName(),
+			notification_type_str + " (" + CompatUtility::GetHostStateString(host) + ")",
+			command_name,
+			output,
+			author_comment
+		}));
 	}
 }
 
@@ -324,27 +364,19 @@ void CompatLogger::FlappingChangedHandler(const Checkable::Ptr& checkable)
 		flapping_state_str = "STOPPED";
 	}
 
-	std::ostringstream msgbuf;
-
 	if (service) {
-		msgbuf << "SERVICE FLAPPING ALERT: "
-			<< host->GetName() << ";"
-			<< service->GetShortName() << ";"
-			<< flapping_state_str << "; "
-			<< flapping_output
-			<< "";
+		WriteLine(JoinFields("SERVICE FLAPPING ALERT: ", {
+			host->GetName(),
+			service->GetShortName(),
+			flapping_state_str,
+			" " + flapping_output
+		}));
 	} else {
-		msgbuf << "HOST FLAPPING ALERT: "
-			<< host->GetName() << ";"
-			<< flapping_state_str << "; "
-			<< flapping_output
-			<< "";
-	}
-
-	{
-		ObjectLock oLock(this);
-		WriteLine(msgbuf.str());
-		Flush();
+		WriteLine(JoinFields("HOST FLAPPING ALERT: ", {
+			host->GetName(),
+			flapping_state_str,
+			" " + flapping_output
+		}));
 	}
 }
 
@@ -360,43 +392,28 @@ void CompatLogger::EnableFlappingChangedHandler(const Checkable::Ptr& checkable)
 	String flapping_output = "Flap detection has been disabled";
 	String flapping_state_str = "DISABLED";
 
-	std::ostringstream msgbuf;
-
 	if (service) {
-		msgbuf << "SERVICE FLAPPING ALERT: "
-			<< host->GetName() << ";"
-			<< service->GetShortName() << ";"
-			<< flapping_state_str << "; "
-			<< flapping_output
-			<< "";
+		WriteLine(JoinFields("SERVICE FLAPPING ALERT: ", {
+			host->GetName(),
+			service->GetShortName(),
+			flapping_state_str,
+			" " + flapping_output
+		}));
 	} else {
-		msgbuf << "HOST FLAPPING ALERT: "
-			<< host->GetName() << ";"
-			<< flapping_state_str << "; "
-			<< flapping_output
-			<< "";
-	}
-
-	{
-		ObjectLock oLock(this);
-		WriteLine(msgbuf.str());
-		Flush();
+		WriteLine(JoinFields("HOST FLAPPING ALERT: ", {
+			host->GetName(),
+			flapping_state_str,
+			" " + flapping_output
+		}));
 	}
 }
 
 void CompatLogger::ExternalCommandHandler(const String& command, const std::vector<String>& arguments)
 {
-	std::ostringstream msgbuf;
-	msgbuf << "EXTERNAL COMMAND: "
-		<< command << ";"
-		<< boost::algorithm::join(arguments, ";")
-		<< "";
-
-	{
-		ObjectLock oLock(this);
-		WriteLine(msgbuf.str());
-		Flush();
-	}
+	WriteLine(JoinFields("EXTERNAL COMMAND: ", {
+		command,
+		boost::algorithm::join(arguments, ";")
+	}));
 }
 
 void CompatLogger::EventCommandHandler(const Checkable::Ptr& checkable)
@@ -409,63 +426,199 @@ void CompatLogger::EventCommandHandler(const Checkable::Ptr& checkable)
 	String event_command_name = event_command->GetName();
 	long current_attempt = checkable->GetCheckAttempt();
 
-	std::ostringstream msgbuf;
-
 	if (service) {
-		msgbuf << "SERVICE EVENT HANDLER: "
-			<< host->GetName() << ";"
-			<< service->GetShortName() << ";"
-			<< Service::StateToString(service->GetState()) << ";"
-			<< Service::StateTypeToString(service->GetStateType()) << ";"
-			<< current_attempt << ";"
-			<< event_command_name;
+		WriteLine(JoinFields("SERVICE EVENT HANDLER: ", {
+			host->GetName(),
+			service->GetShortName(),
+			Service::StateToString(service->GetState()),
+			Service::StateTypeToString(service->GetStateType()),
+			Convert::ToString(current_attempt),
+			event_command_name
+		}));
 	} else {
-		msgbuf << "HOST EVENT HANDLER: "
-			<< host->GetName() << ";"
-			<< CompatUtility::GetHostStateString(host) << ";"
-			<< Host::StateTypeToString(host->GetStateType()) << ";"
-			<< current_attempt << ";"
-			<< event_command_name;
-	}
-
-	{
-		ObjectLock oLock(this);
-		WriteLine(msgbuf.str());
-		Flush();
+		WriteLine(JoinFields("HOST EVENT HANDLER: ", {
+			host->GetName(),
+			CompatUtility::GetHostStateString(host),
+			Host::StateTypeToString(host->GetStateType()),
+			Convert::ToString(current_attempt),
+			event_command_name
+		}));
 	}
 }
 
-void CompatLogger::WriteLine(const String& line)
+String CompatLogger::FormatLine(const String& line)
 {
-	ASSERT(OwnsLock());
+	String timestamp = Convert::ToString(static_cast<long>(Utility::GetTime()));
 
-	if (!m_OutputFile.good())
-		return;
+	std::string result;
+	result.reserve(timestamp.GetLength() + line.GetLength() + 4);
+	result += '[';
+	result += timestamp.GetData();
+	result += "] ";
+	result += line.GetData();
+	result += '\n';
 
-	m_OutputFile << "[" << (long)Utility::GetTime() << "] " << line << "\n";
+	return result;
 }
 
-void CompatLogger::Flush(void)
+/**
+ * Queues a line for the writer thread.
+ *
+ * @threadsafety Always.
+ */
+void CompatLogger::WriteLine(const String& line)
 {
-	ASSERT(OwnsLock());
+	String formattedLine = FormatLine(line);
 
-	if (!m_OutputFile.good())
+	boost::mutex::scoped_lock lock(m_Mutex);
+
+	/* Handlers which were already running when Stop() disconnected
+	 * them must not queue lines the writer thread will never see. */
+	if (m_Stopped)
 		return;
 
-	m_OutputFile << std::flush;
+	m_Lines.push_back(std::move(formattedLine));
+	m_CV.notify_one();
 }
 
 /**
+ * Requests that the writer thread reopens the log file. The state snapshot
+ * which starts the new file is built here so the writer thread and the
+ * producers are not held up by it.
+ *
  * @threadsafety Always.
  */
 void CompatLogger::ReopenFile(bool rotate)
 {
-	ObjectLock olock(this);
+	std::vector<String> header;
+
+	header.push_back(FormatLine("LOG ROTATION: " + GetRotationMethod()));
+	header.push_back(FormatLine("LOG VERSION: 2.0"));
+
+	for (const Host::Ptr& host : ConfigType::GetObjectsByType<Host>()) {
+		String output;
+		CheckResult::Ptr cr = host->GetLastCheckResult();
+
+		if (cr)
+			output = CompatUtility::GetCheckResultOutput(cr);
+
+		header.push_back(FormatLine(JoinFields("CURRENT HOST STATE: ", {
+			host->GetName(),
+			CompatUtility::GetHostStateString(host),
+			Host::StateTypeToString(host->GetStateType()),
+			Convert::ToString(host->GetCheckAttempt()),
+			output
+		})));
+	}
+
+	for (const Service::Ptr& service : ConfigType::GetObjectsByType<Service>()) {
+		Host::Ptr host = service->GetHost();
+
+		String output;
+		CheckResult::Ptr cr = service->GetLastCheckResult();
+
+		if (cr)
+			output = CompatUtility::GetCheckResultOutput(cr);
+
+		header.push_back(FormatLine(JoinFields("CURRENT SERVICE STATE: ", {
+			host->GetName(),
+			service->GetShortName(),
+			Service::StateToString(service->GetState()),
+			Service::StateTypeToString(service->GetStateType()),
+			Convert::ToString(service->GetCheckAttempt()),
+			output
+		})));
+	}
+
+	boost::mutex::scoped_lock lock(m_Mutex);
+
+	if (!m_RotationPending) {
+		m_RotationPending = true;
+		m_RotationArchive = rotate;
+		m_RotationPosition = m_Lines.size();
+	} else
+		m_RotationArchive = m_RotationArchive || rotate;
+
+	m_RotationHeader.swap(header);
+	m_CV.notify_one();
+}
+
+void CompatLogger::WriterThreadProc(void)
+{
+	Utility::SetThreadName("Compat Log");
+
+	String policy = GetFsyncPolicy();
+	double interval = GetFsyncInterval();
+	double lastSync = Utility::GetTime();
+	bool dirty = false;
+
+	for (;;) {
+		std::vector<String> lines, header;
+		bool rotate = false, archive = false, stopped;
+		size_t position = 0;
+
+		{
+			boost::mutex::scoped_lock lock(m_Mutex);
+
+			while (m_Lines.empty() && !m_RotationPending && !m_Stopped) {
+				if (dirty && policy == "INTERVAL") {
+					if (!m_CV.timed_wait(lock, boost::posix_time::milliseconds(static_cast<long>(interval * 1000))))
+						break;
+				} else
+					m_CV.wait(lock);
+			}
+
+			/* Everything that has been queued so far is written as a single group. */
+			lines.swap(m_Lines);
+
+			if (m_RotationPending) {
+				rotate = true;
+				archive = m_RotationArchive;
+				position = m_RotationPosition;
+				header.swap(m_RotationHeader);
+				m_RotationPending = false;
+			}
+
+			stopped = m_Stopped;
+		}
+
+		if (rotate) {
+			WriteLines(lines.begin(), lines.begin() + position);
+			OpenFile(archive);
+			WriteLines(header.begin(), header.end());
+			WriteLines(lines.begin() + position, lines.end());
+		} else
+			WriteLines(lines.begin(), lines.end());
+
+		if (!lines.empty() || rotate)
+			dirty = true;
+
+		if (dirty && (policy == "BATCH" || stopped ||
+		    (policy == "INTERVAL" && Utility::GetTime() - lastSync >= interval))) {
+			if (policy != "NONE")
+				SyncFile();
+
+			lastSync = Utility::GetTime();
+			dirty = false;
+		}
+
+		if (stopped && lines.empty() && !rotate)
+			break;
+	}
+
+	if (m_OutputFile) {
+		fclose(m_OutputFile);
+		m_OutputFile = NULL;
+	}
+}
 
+void CompatLogger::OpenFile(bool rotate)
+{
 	String tempFile = GetLogDir() + "/icinga.log";
 
 	if (m_OutputFile) {
-		m_OutputFile.close();
+		fclose(m_OutputFile);
+		m_OutputFile = NULL;
 
 		if (rotate) {
 			String archiveFile = GetLogDir() + "/archives/icinga-" + Utility::FormatDateTime("%m-%d-%Y-%H", Utility::GetTime()) + ".log";
@@ -477,58 +630,38 @@ void CompatLogger::ReopenFile(bool rotate)
 		}
 	}
 
-	m_OutputFile.open(tempFile.CStr(), std::ofstream::app);
+	m_OutputFile = fopen(tempFile.CStr(), "a");
 
 	if (!m_OutputFile) {
 		Log(LogWarning, "CompatLogger")
 		    << "Could not open compat log file '" << tempFile << "' for writing. Log output will be lost.";
-
-		return;
-	}
-
-	WriteLine("LOG ROTATION: " + GetRotationMethod());
-	WriteLine("LOG VERSION: 2.0");
-
-	for (const Host::Ptr& host : ConfigType::GetObjectsByType<Host>()) {
-		String output;
-		CheckResult::Ptr cr = host->GetLastCheckResult();
-
-		if (cr)
-			output = CompatUtility::GetCheckResultOutput(cr);
-
-		std::ostringstream msgbuf;
-		msgbuf << "CURRENT HOST STATE: "
-		       << host->GetName() << ";"
-		       << CompatUtility::GetHostStateString(host) << ";"
-		       << Host::StateTypeToString(host->GetStateType()) << ";"
-		       << host->GetCheckAttempt() << ";"
-		       << output << "";
-
-		WriteLine(msgbuf.str());
 	}
+}
 
-	for (const Service::Ptr& service : ConfigType::GetObjectsByType<Service>()) {
-		Host::Ptr host = service->GetHost();
+void CompatLogger::WriteLines(std::vector<String>::const_iterator begin, std::vector<String>::const_iterator end)
+{
+	if (begin == end || !m_OutputFile)
+		return;
 
-		String output;
-		CheckResult::Ptr cr = service->GetLastCheckResult();
+	for (std::vector<String>::const_iterator it = begin; it != end; it++)
+		fwrite(it->CStr(), 1, it->GetLength(), m_OutputFile);
 
-		if (cr)
-			output = CompatUtility::GetCheckResultOutput(cr);
+	fflush(m_OutputFile);
 
-		std::ostringstream msgbuf;
-		msgbuf << "CURRENT SERVICE STATE: "
-		       << host->GetName() << ";"
-		       << service->GetShortName() << ";"
-		       << Service::StateToString(service->GetState()) << ";"
-		       << Service::StateTypeToString(service->GetStateType()) << ";"
-		       << service->GetCheckAttempt() << ";"
-		       << output << "";
+	boost::mutex::scoped_lock lock(m_Mutex);
+	m_LinesWritten += end - begin;
+}
 
-		WriteLine(msgbuf.str());
-	}
+void CompatLogger::SyncFile(void)
+{
+	if (!m_OutputFile)
+		return;
 
-	Flush();
+#ifdef _WIN32
+	_commit(_fileno(m_OutputFile));
+#else /* _WIN32 */
+	fsync(fileno(m_OutputFile));
+#endif /* _WIN32 */
 }
 
 void CompatLogger::ScheduleNextRotation(void)
@@ -598,6 +731,15 @@ void CompatLogger::RotationTimerHandler(void)
 	ScheduleNextRotation();
 }
 
+void CompatLogger::ValidateFsyncPolicy(const String& value, const ValidationUtils& utils)
+{
+	ObjectImpl<CompatLogger>::ValidateFsyncPolicy(value, utils);
+
+	if (value != "NONE" && value != "BATCH" && value != "INTERVAL") {
+		BOOST_THROW_EXCEPTION(ValidationError(this, boost::assign::list_of("fsync_policy"), "Fsync policy '" + value + "' is invalid."));
+	}
+}
+
 void CompatLogger::ValidateRotationMethod(const String& value, const ValidationUtils& utils)
 {
 	ObjectImpl<CompatLogger>::ValidateRotationMethod(value, utils);
@@ -23,7 +23,10 @@
 #include "compat/compatlogger.thpp"
 #include "icinga/service.hpp"
 #include "base/timer.hpp"
-#include <fstream>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <cstdio>
 
 namespace icinga
 {
@@ -39,17 +42,20 @@ public:
 	DECLARE_OBJECT(CompatLogger);
 	DECLARE_OBJECTNAME(CompatLogger);
 
+	CompatLogger(void);
+
 	static void StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata);
 
 	virtual void ValidateRotationMethod(const String& value, const ValidationUtils& utils) override;
+	virtual void ValidateFsyncPolicy(const String& value, const ValidationUtils& utils) override;
 
 protected:
 	virtual void Start(bool runtimeCreated) override;
 	virtual void Stop(bool runtimeRemoved) override;
 
 private:
+	static String FormatLine(const String& line);
 	void WriteLine(const String& line);
-	void Flush(void);
 
 	void CheckResultHandler(const Checkable::Ptr& service, const CheckResult::Ptr& cr);
 	void NotificationSentHandler(const Notification::Ptr& notification, const Checkable::Ptr& service,
@@ -63,11 +69,31 @@ private:
 	void EventCommandHandler(const Checkable::Ptr& service);
 
 	Timer::Ptr m_RotationTimer;
+	std::vector<boost::signals2::connection> m_Connections;
 	void RotationTimerHandler(void);
 	void ScheduleNextRotation(void);
 
-	std::ofstream m_OutputFile;
 	void ReopenFile(bool rotate);
+
+	/* Lines are handed over to the writer thread in m_Lines. A rotation
+	 * request takes effect after the first m_RotationPosition lines. */
+	boost::mutex m_Mutex;
+	boost::condition_variable m_CV;
+	std::vector<String> m_Lines;
+	bool m_RotationPending;
+	bool m_RotationArchive;
+	size_t m_RotationPosition;
+	std::vector<String> m_RotationHeader;
+	bool m_Stopped;
+	int m_LinesWritten;
+
+	boost::thread m_WriterThread;
+	FILE *m_OutputFile;
+
+	void WriterThreadProc(void);
+	void OpenFile(bool rotate);
+	void WriteLines(std::vector<String>::const_iterator begin, std::vector<String>::const_iterator end);
+	void SyncFile(void);
 };
 
 }
@@ -25,6 +25,9 @@
 #include "base/exception.hpp"
 #include "base/application.hpp"
 #include "base/statsfunction.hpp"
+#include "icinga/perfdatavalue.hpp"
+#include "base/convert.hpp"
+#include <algorithm>
 
 using namespace icinga;
 
@@ -32,17 +35,57 @@ REGISTER_TYPE(ExternalCommandListener);
 
 REGISTER_STATSFUNCTION(ExternalCommandListener, &ExternalCommandListener::StatsFunc);
 
-void ExternalCommandListener::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr&)
+/* Number of commands a single work queue may hold before the pipe thread
+ * stops reading from the command pipe. */
+static const size_t l_MaxPendingCommands = 10000;
+
+/* Longer command lines are discarded so that a writer which never sends a
+ * newline can't make the buffer grow without bound. */
+static const size_t l_MaxLineLength = 1024 * 1024;
+
+ExternalCommandListener::ExternalCommandListener(void)
+	: m_WorkQueueCount(0), m_CommandsProcessed(0), m_CommandsFailed(0)
+{ }
+
+void ExternalCommandListener::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata)
 {
 	Dictionary::Ptr nodes = new Dictionary();
 
 	for (const ExternalCommandListener::Ptr& externalcommandlistener : ConfigType::GetObjectsByType<ExternalCommandListener>()) {
-		nodes->Set(externalcommandlistener->GetName(), 1); //add more stats
+		String name = externalcommandlistener->GetName();
+		size_t pendingCommands = externalcommandlistener->GetPendingCommands();
+		int commandsProcessed, commandsFailed;
+
+		{
+			boost::mutex::scoped_lock lock(externalcommandlistener->m_StatsMutex);
+			commandsProcessed = externalcommandlistener->m_CommandsProcessed;
+			commandsFailed = externalcommandlistener->m_CommandsFailed;
+		}
+
+		Dictionary::Ptr stats = new Dictionary();
+		stats->Set("commands_processed", commandsProcessed);
+		stats->Set("commands_failed", commandsFailed);
+		stats->Set("pending_commands", pendingCommands);
+
+		nodes->Set(name, stats);
+
+		perfdata->Add(new PerfdataValue("externalcommandlistener_" + name + "_commands_processed", commandsProcessed));
+		perfdata->Add(new PerfdataValue("externalcommandlistener_" + name + "_pending_commands", pendingCommands));
 	}
 
 	status->Set("externalcommandlistener", nodes);
 }
 
+size_t ExternalCommandListener::GetPendingCommands(void) const
+{
+	size_t pending = 0;
+
+	for (size_t i = 0; i < m_WorkQueueCount; i++)
+		pending += m_WorkQueues[i].GetLength();
+
+	return pending;
+}
+
 /**
  * Starts the component.
  */
@@ -54,6 +97,12 @@ void ExternalCommandListener::Start(bool runtimeCreated)
 	    << "'" << GetName() << "' started.";
 
 #ifndef _WIN32
+	m_WorkQueueCount = Application::GetConcurrency();
+	m_WorkQueues.reset(new WorkQueue[m_WorkQueueCount]);
+
+	for (size_t i = 0; i < m_WorkQueueCount; i++)
+		m_WorkQueues[i].SetName("ExternalCommandListener, #" + Convert::ToString(i));
+
 	m_CommandThread = boost::thread(boost::bind(&ExternalCommandListener::CommandPipeThread, this, GetCommandPath()));
 	m_CommandThread.detach();
 #endif /* _WIN32 */
@@ -64,6 +113,11 @@ void ExternalCommandListener::Start(bool runtimeCreated)
  */
 void ExternalCommandListener::Stop(bool runtimeRemoved)
 {
+#ifndef _WIN32
+	/* Finish the check results which have already been read. */
+	WaitForWorkQueues();
+#endif /* _WIN32 */
+
 	Log(LogInformation, "ExternalCommandListener")
 	    << "'" << GetName() << "' stopped.";
 
@@ -116,18 +170,32 @@ void ExternalCommandListener::CommandPipeThread(const String& commandPath)
 			return;
 		}
 
-		FIFO::Ptr fifo = new FIFO();
 		Socket::Ptr sock = new Socket(fd);
-		StreamReadContext src;
+
+		/* Lines are split and parsed in place; only an incomplete
+		 * line at the end of the buffer is moved to the front. */
+		std::vector<char> buffer(65536);
+		size_t offset = 0;
+		bool skipLine = false;
 
 		for (;;) {
 			sock->Poll(true, false);
 
-			char buffer[8192];
+			if (offset == buffer.size()) {
+				if (buffer.size() >= l_MaxLineLength) {
+					Log(LogWarning, "ExternalCommandListener")
+					    << "Discarding command line which is longer than " << l_MaxLineLength << " bytes.";
+
+					offset = 0;
+					skipLine = true;
+				} else
+					buffer.resize(std::min(buffer.size() * 2, l_MaxLineLength));
+			}
+
 			size_t rc;
 
 			try {
-				rc = sock->Read(buffer, sizeof(buffer));
+				rc = sock->Read(&buffer[offset], buffer.size() - offset);
 			} catch (const std::exception& ex) {
 				/* We have read all data. */
 				if (errno == EAGAIN)
@@ -142,28 +210,117 @@ void ExternalCommandListener::CommandPipeThread(const String& commandPath)
 			if (rc == 0)
 				continue;
 
-			fifo->Write(buffer, rc);
+			const char *begin = &buffer[0];
+			const char *end = begin + offset + rc;
+			const char *line = begin;
 
 			for (;;) {
-				String command;
-				StreamReadStatus srs = fifo->ReadLine(&command, src);
+				const char *eol = static_cast<const char *>(memchr(line, '\n', end - line));
 
-				if (srs != StatusNewItem)
+				if (!eol)
 					break;
 
-				try {
-					Log(LogInformation, "ExternalCommandListener")
-					    << "Executing external command: " << command;
-
-					ExternalCommandProcessor::Execute(command);
-				} catch (const std::exception& ex) {
-					Log(LogWarning, "ExternalCommandListener")
-					    << "External command failed: " << DiagnosticInformation(ex, false);
-					Log(LogNotice, "ExternalCommandListener")
-					    << "External command failed: " << DiagnosticInformation(ex, true);
+				/* the rest of a line which was too long */
+				if (skipLine) {
+					skipLine = false;
+					line = eol + 1;
+					continue;
 				}
+
+				size_t length = eol - line;
+
+				if (length > 0 && line[length - 1] == '\r')
+					length--;
+
+				if (length > 0)
+					ProcessLine(line, length);
+
+				line = eol + 1;
+			}
+
+			if (skipLine) {
+				offset = 0;
+				continue;
 			}
+
+			offset = end - line;
+
+			if (offset > 0 && line != begin)
+				memmove(&buffer[0], line, offset);
 		}
+
+		/* Finish the commands we've already read before re-opening the pipe. */
+		WaitForWorkQueues();
+	}
+}
+
+/**
+ * Dispatches a single command line. Passive check results are processed in
+ * parallel; results for the same checkable always end up on the same work
+ * queue so that they're processed in the order they were received. All other
+ * commands are executed on the pipe thread once the work queues are drained.
+ */
+void ExternalCommandListener::ProcessLine(const char *line, size_t length)
+{
+	ExternalCommandLine cl;
+	String command;
+	std::vector<String> arguments;
+	size_t key;
+
+	Log(LogInformation, "ExternalCommandListener")
+	    << "Executing external command: " << String(line, line + length);
+
+	try {
+		ExternalCommandProcessor::ParseLine(line, length, cl);
+		ExternalCommandProcessor::SplitArguments(cl, command, arguments);
+	} catch (const std::exception& ex) {
+		Log(LogWarning, "ExternalCommandListener")
+		    << "External command failed: " << DiagnosticInformation(ex, false);
+
+		boost::mutex::scoped_lock lock(m_StatsMutex);
+		m_CommandsFailed++;
+		return;
 	}
+
+	if (ExternalCommandProcessor::GetCheckResultKey(cl, key)) {
+		WorkQueue& queue = m_WorkQueues[key % m_WorkQueueCount];
+
+		if (queue.GetLength() >= l_MaxPendingCommands)
+			queue.Join();
+
+		queue.Enqueue(boost::bind(&ExternalCommandListener::ExecuteCommand, this, cl.Timestamp, command, arguments));
+	} else {
+		WaitForWorkQueues();
+		ExecuteCommand(cl.Timestamp, command, arguments);
+	}
+}
+
+void ExternalCommandListener::ExecuteCommand(double time, const String& command, const std::vector<String>& arguments)
+{
+	bool failed = false;
+
+	try {
+		ExternalCommandProcessor::Execute(time, command, arguments);
+	} catch (const std::exception& ex) {
+		Log(LogWarning, "ExternalCommandListener")
+		    << "External command failed: " << DiagnosticInformation(ex, false);
+		Log(LogNotice, "ExternalCommandListener")
+		    << "External command failed: " << DiagnosticInformation(ex, true);
+
+		failed = true;
+	}
+
+	boost::mutex::scoped_lock lock(m_StatsMutex);
+
+	if (failed)
+		m_CommandsFailed++;
+	else
+		m_CommandsProcessed++;
+}
+
+void ExternalCommandListener::WaitForWorkQueues(void)
+{
+	for (size_t i = 0; i < m_WorkQueueCount; i++)
+		m_WorkQueues[i].Join();
 }
 #endif /* _WIN32 */
@@ -24,7 +24,9 @@
 #include "base/objectlock.hpp"
 #include "base/timer.hpp"
 #include "base/utility.hpp"
+#include "base/workqueue.hpp"
 #include <boost/thread/thread.hpp>
+#include <boost/scoped_array.hpp>
 #include <iostream>
 
 namespace icinga
@@ -39,6 +41,8 @@ public:
 	DECLARE_OBJECT(ExternalCommandListener);
 	DECLARE_OBJECTNAME(ExternalCommandListener);
 
+	ExternalCommandListener(void);
+
 	static void StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata);
 
 protected:
@@ -46,10 +50,22 @@ protected:
 	virtual void Stop(bool runtimeRemoved) override;
 
 private:
+	boost::scoped_array<WorkQueue> m_WorkQueues;
+	size_t m_WorkQueueCount;
+
+	mutable boost::mutex m_StatsMutex;
+	int m_CommandsProcessed;
+	int m_CommandsFailed;
+
+	size_t GetPendingCommands(void) const;
+
 #ifndef _WIN32
 	boost::thread m_CommandThread;
 
 	void CommandPipeThread(const String& commandPath);
+	void ProcessLine(const char *line, size_t length);
+	void ExecuteCommand(double time, const String& command, const std::vector<String>& arguments);
+	void WaitForWorkQueues(void);
 #endif /* _WIN32 */
 };
 
@@ -24,6 +24,8 @@
 #include "base/loader.hpp"
 #include "base/context.hpp"
 #include "base/exception.hpp"
+#include "base/workqueue.hpp"
+#include "base/application.hpp"
 #include <fstream>
 
 using namespace icinga;
@@ -31,6 +33,9 @@ using namespace icinga;
 std::vector<String> ConfigCompiler::m_IncludeSearchDirs;
 boost::mutex ConfigCompiler::m_ZoneDirsMutex;
 std::map<String, std::vector<ZoneFragment> > ConfigCompiler::m_ZoneDirs;
+boost::mutex ConfigCompiler::m_CompileStatsMutex;
+double ConfigCompiler::m_CompileTime = 0;
+size_t ConfigCompiler::m_CompiledFileCount = 0;
 
 /**
  * Constructor for the ConfigCompiler class.
@@ -109,17 +114,65 @@ String ConfigCompiler::GetPackage(void) const
 	return m_Package;
 }
 
-void ConfigCompiler::CollectIncludes(std::vector<Expression *>& expressions,
-    const String& file, const String& zone, const String& package)
+void ConfigCompiler::CollectIncludeFile(std::vector<std::pair<String, String> >& files,
+    const String& file, const String& zone)
+{
+	files.push_back(std::make_pair(file, zone));
+}
+
+void ConfigCompiler::CompileFragment(const String& path, const String& zone, const String& package,
+    Expression **result, String *error)
 {
 	try {
-		Expression *expr = CompileFile(file, zone, package);
-		expressions.push_back(expr);
+		*result = CompileFileInternal(path, zone, package);
 	} catch (const std::exception& ex) {
-		Log(LogWarning, "ConfigCompiler")
-		    << "Cannot compile file '"
-		    << file << "': " << DiagnosticInformation(ex);
+		*error = DiagnosticInformation(ex);
+	}
+}
+
+/**
+ * Compiles a list of files. The files are independent of each other
+ * so they are lexed and parsed in parallel. The resulting expressions
+ * are appended in the order of the list which keeps evaluation order
+ * and error reporting the same as compiling the files one by one.
+ *
+ * @param expressions The list the expressions are appended to.
+ * @param files The paths and zones of the files.
+ * @param package The package.
+ */
+void ConfigCompiler::CompileFiles(std::vector<Expression *>& expressions,
+    const std::vector<std::pair<String, String> >& files, const String& package)
+{
+	double start = Utility::GetTime();
+
+	std::vector<Expression *> results(files.size(), NULL);
+	std::vector<String> errors(files.size());
+
+	if (files.size() < 2) {
+		for (std::vector<std::pair<String, String> >::size_type i = 0; i < files.size(); i++)
+			CompileFragment(files[i].first, files[i].second, package, &results[i], &errors[i]);
+	} else {
+		WorkQueue upq(25000, Application::GetConcurrency());
+		upq.SetName("ConfigCompiler::CompileFiles");
+
+		for (std::vector<std::pair<String, String> >::size_type i = 0; i < files.size(); i++)
+			upq.Enqueue(boost::bind(&ConfigCompiler::CompileFragment, files[i].first, files[i].second, package, &results[i], &errors[i]));
+
+		upq.Join();
+	}
+
+	for (std::vector<std::pair<String, String> >::size_type i = 0; i < files.size(); i++) {
+		if (!errors[i].IsEmpty()) {
+			Log(LogWarning, "ConfigCompiler")
+			    << "Cannot compile file '"
+			    << files[i].first << "': " << errors[i];
+			continue;
+		}
+
+		expressions.push_back(results[i]);
 	}
+
+	AddCompileStats(Utility::GetTime() - start, files.size());
 }
 
 /**
@@ -153,14 +206,17 @@ Expression *ConfigCompiler::HandleInclude(const String& relativeBase, const Stri
 		}
 	}
 
-	std::vector<Expression *> expressions;
+	std::vector<std::pair<String, String> > files;
 
-	if (!Utility::Glob(includePath, boost::bind(&ConfigCompiler::CollectIncludes, boost::ref(expressions), _1, zone, package), GlobFile) && includePath.FindFirstOf("*?") == String::NPos) {
+	if (!Utility::Glob(includePath, boost::bind(&ConfigCompiler::CollectIncludeFile, boost::ref(files), _1, zone), GlobFile) && includePath.FindFirstOf("*?") == String::NPos) {
 		std::ostringstream msgbuf;
 		msgbuf << "Include file '" + path + "' does not exist";
 		BOOST_THROW_EXCEPTION(ScriptError(msgbuf.str(), debuginfo));
 	}
 
+	std::vector<Expression *> expressions;
+	CompileFiles(expressions, files, package);
+
 	DictExpression *expr = new DictExpression(expressions);
 	expr->MakeInline();
 	return expr;
@@ -184,15 +240,18 @@ Expression *ConfigCompiler::HandleIncludeRecursive(const String& relativeBase, c
 	else
 		ppath = relativeBase + "/" + path;
 
+	std::vector<std::pair<String, String> > files;
+	Utility::GlobRecursive(ppath, pattern, boost::bind(&ConfigCompiler::CollectIncludeFile, boost::ref(files), _1, zone), GlobFile);
+
 	std::vector<Expression *> expressions;
-	Utility::GlobRecursive(ppath, pattern, boost::bind(&ConfigCompiler::CollectIncludes, boost::ref(expressions), _1, zone, package), GlobFile);
+	CompileFiles(expressions, files, package);
 
 	DictExpression *dict = new DictExpression(expressions);
 	dict->MakeInline();
 	return dict;
 }
 
-void ConfigCompiler::HandleIncludeZone(const String& relativeBase, const String& tag, const String& path, const String& pattern, const String& package, std::vector<Expression *>& expressions)
+void ConfigCompiler::HandleIncludeZone(const String& relativeBase, const String& tag, const String& path, const String& pattern, std::vector<std::pair<String, String> >& files)
 {
 	String zoneName = Utility::BaseName(path);
 
@@ -205,7 +264,7 @@ void ConfigCompiler::HandleIncludeZone(const String& relativeBase, const String&
 
 	RegisterZoneDir(tag, ppath, zoneName);
 
-	Utility::GlobRecursive(ppath, pattern, boost::bind(&ConfigCompiler::CollectIncludes, boost::ref(expressions), _1, zoneName, package), GlobFile);
+	Utility::GlobRecursive(ppath, pattern, boost::bind(&ConfigCompiler::CollectIncludeFile, boost::ref(files), _1, zoneName), GlobFile);
 }
 
 /**
@@ -230,8 +289,11 @@ Expression *ConfigCompiler::HandleIncludeZones(const String& relativeBase, const
 		newRelativeBase = ".";
 	}
 
+	std::vector<std::pair<String, String> > files;
+	Utility::Glob(ppath + "/*", boost::bind(&ConfigCompiler::HandleIncludeZone, newRelativeBase, tag, _1, pattern, boost::ref(files)), GlobDirectory);
+
 	std::vector<Expression *> expressions;
-	Utility::Glob(ppath + "/*", boost::bind(&ConfigCompiler::HandleIncludeZone, newRelativeBase, tag, _1, pattern, package, boost::ref(expressions)), GlobDirectory);
+	CompileFiles(expressions, files, package);
 	return new DictExpression(expressions);
 }
 
@@ -268,6 +330,18 @@ Expression *ConfigCompiler::CompileStream(const String& path,
  */
 Expression *ConfigCompiler::CompileFile(const String& path, const String& zone,
     const String& package)
+{
+	double start = Utility::GetTime();
+
+	Expression *expr = CompileFileInternal(path, zone, package);
+
+	AddCompileStats(Utility::GetTime() - start, 1);
+
+	return expr;
+}
+
+Expression *ConfigCompiler::CompileFileInternal(const String& path, const String& zone,
+    const String& package)
 {
 	CONTEXT("Compiling configuration file '" + path + "'");
 
@@ -285,6 +359,35 @@ Expression *ConfigCompiler::CompileFile(const String& path, const String& zone,
 	return CompileStream(path, &stream, zone, package);
 }
 
+void ConfigCompiler::AddCompileStats(double time, size_t files)
+{
+	boost::mutex::scoped_lock lock(m_CompileStatsMutex);
+	m_CompileTime += time;
+	m_CompiledFileCount += files;
+}
+
+/**
+ * Returns the wall time which was spent compiling configuration files.
+ *
+ * @returns The time in seconds.
+ */
+double ConfigCompiler::GetCompileTime(void)
+{
+	boost::mutex::scoped_lock lock(m_CompileStatsMutex);
+	return m_CompileTime;
+}
+
+/**
+ * Returns the number of configuration files which were compiled.
+ *
+ * @returns The number of files.
+ */
+size_t ConfigCompiler::GetCompiledFileCount(void)
+{
+	boost::mutex::scoped_lock lock(m_CompileStatsMutex);
+	return m_CompiledFileCount;
+}
+
 /**
  * Compiles a snippet of text.
  *
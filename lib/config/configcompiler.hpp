@@ -109,8 +109,13 @@ public:
 	void SetPackage(const String& package);
 	String GetPackage(void) const;
 
-	static void CollectIncludes(std::vector<Expression *>& expressions,
-	    const String& file, const String& zone, const String& package);
+	static void CollectIncludeFile(std::vector<std::pair<String, String> >& files,
+	    const String& file, const String& zone);
+	static void CompileFiles(std::vector<Expression *>& expressions,
+	    const std::vector<std::pair<String, String> >& files, const String& package);
+
+	static double GetCompileTime(void);
+	static size_t GetCompiledFileCount(void);
 
 	static Expression *HandleInclude(const String& relativeBase, const String& path, bool search,
 	    const String& zone, const String& package, const DebugInfo& debuginfo = DebugInfo());
@@ -141,10 +146,19 @@ private:
 	static boost::mutex m_ZoneDirsMutex;
 	static std::map<String, std::vector<ZoneFragment> > m_ZoneDirs;
 
+	static boost::mutex m_CompileStatsMutex;
+	static double m_CompileTime;
+	static size_t m_CompiledFileCount;
+
 	void InitializeScanner(void);
 	void DestroyScanner(void);
 
-	static void HandleIncludeZone(const String& relativeBase, const String& tag, const String& path, const String& pattern, const String& package, std::vector<Expression *>& expressions);
+	static void HandleIncludeZone(const String& relativeBase, const String& tag, const String& path, const String& pattern, std::vector<std::pair<String, String> >& files);
+
+	static Expression *CompileFileInternal(const String& path, const String& zone, const String& package);
+	static void CompileFragment(const String& path, const String& zone, const String& package,
+	    Expression **result, String *error);
+	static void AddCompileStats(double time, size_t files);
 
 public:
 	bool m_Eof;
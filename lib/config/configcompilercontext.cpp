@@ -22,6 +22,8 @@
 #include "base/json.hpp"
 #include "base/netstring.hpp"
 #include "base/exception.hpp"
+#include "base/convert.hpp"
+#include "base/logger.hpp"
 
 using namespace icinga;
 
@@ -54,9 +56,25 @@ void ConfigCompilerContext::WriteObject(const Dictionary::Ptr& object)
 
 	String json = JsonEncode(object);
 
+	ObjectsFileIndexEntry entry;
+	entry.Type = object->Get("type");
+	entry.Name = object->Get("name");
+
+	Dictionary::Ptr properties = object->Get("properties");
+
+	if (properties)
+		entry.InternalName = properties->Get("__name");
+
+	entry.Length = json.GetLength();
+
 	{
 		boost::mutex::scoped_lock lock(m_Mutex);
+
+		/* the index points to the JSON payload rather than the netstring */
+		entry.Offset = static_cast<uint64_t>(m_ObjectsFP->tellp()) + Convert::ToString(json.GetLength()).GetLength() + 1;
+
 		NetString::WriteStringToStream(*m_ObjectsFP, json);
+		m_IndexEntries.push_back(entry);
 	}
 }
 
@@ -64,6 +82,7 @@ void ConfigCompilerContext::CancelObjectsFile(void)
 {
 	delete m_ObjectsFP;
 	m_ObjectsFP = NULL;
+	m_IndexEntries.clear();
 
 #ifdef _WIN32
 	_unlink(m_ObjectsTempFile.CStr());
@@ -74,6 +93,8 @@ void ConfigCompilerContext::CancelObjectsFile(void)
 
 void ConfigCompilerContext::FinishObjectsFile(void)
 {
+	uint64_t objectsSize = m_ObjectsFP ? static_cast<uint64_t>(m_ObjectsFP->tellp()) : 0;
+
 	delete m_ObjectsFP;
 	m_ObjectsFP = NULL;
 
@@ -87,5 +108,15 @@ void ConfigCompilerContext::FinishObjectsFile(void)
 		    << boost::errinfo_errno(errno)
 		    << boost::errinfo_file_name(m_ObjectsTempFile));
 	}
-}
 
+	String indexPath = ObjectsFileIndex::GetIndexPath(m_ObjectsPath);
+
+	try {
+		ObjectsFileIndex::WriteIndex(indexPath, m_IndexEntries, objectsSize);
+	} catch (const std::exception& ex) {
+		Log(LogWarning, "ConfigCompilerContext")
+		    << "Could not write objects index file '" << indexPath << "': " << DiagnosticInformation(ex, false);
+	}
+
+	m_IndexEntries.clear();
+}
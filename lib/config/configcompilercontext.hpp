@@ -21,6 +21,7 @@
 #define CONFIGCOMPILERCONTEXT_H
 
 #include "config/i2-config.hpp"
+#include "config/objectsfileindex.hpp"
 #include "base/dictionary.hpp"
 #include <boost/thread/mutex.hpp>
 #include <fstream>
@@ -47,6 +48,7 @@ private:
 	String m_ObjectsPath;
 	String m_ObjectsTempFile;
 	std::fstream *m_ObjectsFP;
+	std::vector<ObjectsFileIndexEntry> m_IndexEntries;
 
 	mutable boost::mutex m_Mutex;
 };
@@ -0,0 +1,408 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "config/objectsfileindex.hpp"
+#include "base/utility.hpp"
+#include "base/exception.hpp"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#	include <sys/mman.h>
+#endif /* _WIN32 */
+
+using namespace icinga;
+
+namespace {
+
+/* The index file starts with this header, followed by one IndexRecord
+ * per object (sorted by type and name) and a pool holding the strings
+ * referenced by the records.
+ */
+struct IndexHeader
+{
+	char Magic[8];
+	uint32_t Version;
+	uint32_t Reserved;
+	uint64_t ObjectsSize;
+	uint64_t Count;
+};
+
+struct IndexRecord
+{
+	uint64_t Offset;
+	uint64_t Length;
+	uint64_t TypeOffset;
+	uint64_t NameOffset;
+	uint64_t InternalNameOffset;
+	uint32_t TypeLength;
+	uint32_t NameLength;
+	uint32_t InternalNameLength;
+	uint32_t Reserved;
+};
+
+const char l_IndexMagic[8] = { 'I', '2', 'O', 'B', 'J', 'I', 'D', 'X' };
+const uint32_t l_IndexVersion = 1;
+
+bool HasWildcards(const String& pattern)
+{
+	return pattern.FindFirstOf("*?") != String::NPos;
+}
+
+}
+
+ObjectsFileIndex::ObjectsFileIndex(void)
+	: m_Count(0)
+{ }
+
+ObjectsFileIndex::~ObjectsFileIndex(void)
+{
+	Close();
+}
+
+String ObjectsFileIndex::GetIndexPath(const String& objectsPath)
+{
+	return objectsPath + ".index";
+}
+
+/**
+ * Writes the index for an objects file. The entries are sorted in-place.
+ *
+ * @param path The path of the index file.
+ * @param entries The location of each record in the objects file.
+ * @param objectsSize The size of the objects file, used to detect stale indexes.
+ */
+void ObjectsFileIndex::WriteIndex(const String& path, std::vector<ObjectsFileIndexEntry>& entries, uint64_t objectsSize)
+{
+	std::sort(entries.begin(), entries.end(), [](const ObjectsFileIndexEntry& a, const ObjectsFileIndexEntry& b) {
+		if (a.Type != b.Type)
+			return a.Type < b.Type;
+
+		return a.InternalName < b.InternalName;
+	});
+
+	std::vector<IndexRecord> records;
+	records.reserve(entries.size());
+
+	std::string pool;
+	std::map<String, uint64_t> types;
+
+	for (const ObjectsFileIndexEntry& entry : entries) {
+		IndexRecord record;
+		memset(&record, 0, sizeof(record));
+
+		record.Offset = entry.Offset;
+		record.Length = entry.Length;
+
+		auto it = types.find(entry.Type);
+
+		if (it == types.end()) {
+			it = types.insert(std::make_pair(entry.Type, pool.size())).first;
+			pool += entry.Type;
+		}
+
+		record.TypeOffset = it->second;
+		record.TypeLength = entry.Type.GetLength();
+
+		record.NameOffset = pool.size();
+		record.NameLength = entry.Name.GetLength();
+		pool += entry.Name;
+
+		record.InternalNameOffset = pool.size();
+		record.InternalNameLength = entry.InternalName.GetLength();
+		pool += entry.InternalName;
+
+		records.push_back(record);
+	}
+
+	IndexHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.Magic, l_IndexMagic, sizeof(header.Magic));
+	header.Version = l_IndexVersion;
+	header.ObjectsSize = objectsSize;
+	header.Count = records.size();
+
+	std::fstream fp;
+	String tempFilename = Utility::CreateTempFile(path + ".XXXXXX", 0600, fp);
+
+	fp.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+	if (!records.empty())
+		fp.write(reinterpret_cast<const char *>(&records[0]), records.size() * sizeof(IndexRecord));
+
+	fp.write(pool.c_str(), pool.size());
+	fp.close();
+
+	if (fp.fail()) {
+		(void) unlink(tempFilename.CStr());
+		BOOST_THROW_EXCEPTION(std::runtime_error("Could not write objects index file '" + tempFilename + "'"));
+	}
+
+#ifdef _WIN32
+	_unlink(path.CStr());
+#endif /* _WIN32 */
+
+	if (rename(tempFilename.CStr(), path.CStr()) < 0) {
+		BOOST_THROW_EXCEPTION(posix_error()
+		    << boost::errinfo_api_function("rename")
+		    << boost::errinfo_errno(errno)
+		    << boost::errinfo_file_name(tempFilename));
+	}
+}
+
+/**
+ * Maps the objects file and its index.
+ *
+ * @param objectsPath The path of the objects file.
+ * @returns false if there is no index or if it doesn't match the objects file.
+ */
+bool ObjectsFileIndex::Open(const String& objectsPath)
+{
+	Close();
+
+	if (!MapFile(GetIndexPath(objectsPath), m_Index))
+		return false;
+
+	if (m_Index.Size < sizeof(IndexHeader)) {
+		Close();
+		return false;
+	}
+
+	IndexHeader header;
+	memcpy(&header, m_Index.Data, sizeof(header));
+
+	if (memcmp(header.Magic, l_IndexMagic, sizeof(header.Magic)) != 0 || header.Version != l_IndexVersion ||
+	    header.Count > (m_Index.Size - sizeof(IndexHeader)) / sizeof(IndexRecord)) {
+		Close();
+		return false;
+	}
+
+	if (!MapFile(objectsPath, m_Objects) || m_Objects.Size != header.ObjectsSize) {
+		Close();
+		return false;
+	}
+
+	m_Count = header.Count;
+
+	return true;
+}
+
+void ObjectsFileIndex::Close(void)
+{
+	UnmapFile(m_Index);
+	UnmapFile(m_Objects);
+	m_Count = 0;
+}
+
+size_t ObjectsFileIndex::GetCount(void) const
+{
+	return m_Count;
+}
+
+/**
+ * Looks up the objects matching the specified filters. Both filters
+ * use the same syntax as Utility::Match; the name filter matches either
+ * the object's short name or its full name.
+ *
+ * @param typeFilter The type filter, or an empty string.
+ * @param nameFilter The name filter, or an empty string.
+ * @returns The matching entries in the order of the index.
+ */
+std::vector<ObjectsFileIndexEntry> ObjectsFileIndex::FindObjects(const String& typeFilter, const String& nameFilter) const
+{
+	std::vector<ObjectsFileIndexEntry> result;
+
+	size_t begin = 0, end = m_Count;
+	bool matchType = !typeFilter.IsEmpty();
+
+	/* The records are sorted by type, so a type without wildcards
+	 * only requires looking at a contiguous range of records. The
+	 * range is only used if the filter is the exact name of a type;
+	 * Utility::Match() is case-insensitive so a filter like "host"
+	 * has to be matched against all records.
+	 */
+	if (matchType && !HasWildcards(typeFilter)) {
+		size_t lo = 0, hi = m_Count;
+
+		while (lo < hi) {
+			size_t mid = lo + (hi - lo) / 2;
+
+			if (GetType(mid) < typeFilter)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+
+		begin = lo;
+		hi = m_Count;
+
+		while (lo < hi) {
+			size_t mid = lo + (hi - lo) / 2;
+
+			if (GetType(mid) == typeFilter)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+
+		if (lo > begin) {
+			end = lo;
+			matchType = false;
+		} else
+			begin = 0;
+	}
+
+	for (size_t i = begin; i < end; i++) {
+		if (matchType && !Utility::Match(typeFilter, GetType(i)))
+			continue;
+
+		ObjectsFileIndexEntry entry = GetEntry(i);
+
+		if (!nameFilter.IsEmpty() && !Utility::Match(nameFilter, entry.Name) && !Utility::Match(nameFilter, entry.InternalName))
+			continue;
+
+		result.push_back(entry);
+	}
+
+	return result;
+}
+
+/**
+ * Returns the JSON-encoded record for an index entry.
+ *
+ * @param entry The index entry.
+ * @returns The record.
+ */
+String ObjectsFileIndex::ReadObject(const ObjectsFileIndexEntry& entry) const
+{
+	if (entry.Offset > m_Objects.Size || entry.Length > m_Objects.Size - entry.Offset)
+		BOOST_THROW_EXCEPTION(std::runtime_error("Objects index entry is out of range."));
+
+	const char *data = m_Objects.Data + entry.Offset;
+	return String(data, data + entry.Length);
+}
+
+ObjectsFileIndexEntry ObjectsFileIndex::GetEntry(size_t index) const
+{
+	IndexRecord record;
+	memcpy(&record, m_Index.Data + sizeof(IndexHeader) + index * sizeof(IndexRecord), sizeof(record));
+
+	size_t poolOffset = sizeof(IndexHeader) + m_Count * sizeof(IndexRecord);
+	size_t poolSize = m_Index.Size - poolOffset;
+	const char *pool = m_Index.Data + poolOffset;
+
+	if (record.TypeOffset > poolSize || record.TypeLength > poolSize - record.TypeOffset ||
+	    record.NameOffset > poolSize || record.NameLength > poolSize - record.NameOffset ||
+	    record.InternalNameOffset > poolSize || record.InternalNameLength > poolSize - record.InternalNameOffset)
+		BOOST_THROW_EXCEPTION(std::runtime_error("Objects index is corrupt."));
+
+	ObjectsFileIndexEntry entry;
+	entry.Type = String(pool + record.TypeOffset, pool + record.TypeOffset + record.TypeLength);
+	entry.Name = String(pool + record.NameOffset, pool + record.NameOffset + record.NameLength);
+	entry.InternalName = String(pool + record.InternalNameOffset, pool + record.InternalNameOffset + record.InternalNameLength);
+	entry.Offset = record.Offset;
+	entry.Length = record.Length;
+
+	return entry;
+}
+
+String ObjectsFileIndex::GetType(size_t index) const
+{
+	IndexRecord record;
+	memcpy(&record, m_Index.Data + sizeof(IndexHeader) + index * sizeof(IndexRecord), sizeof(record));
+
+	size_t poolOffset = sizeof(IndexHeader) + m_Count * sizeof(IndexRecord);
+	size_t poolSize = m_Index.Size - poolOffset;
+	const char *pool = m_Index.Data + poolOffset;
+
+	if (record.TypeOffset > poolSize || record.TypeLength > poolSize - record.TypeOffset)
+		BOOST_THROW_EXCEPTION(std::runtime_error("Objects index is corrupt."));
+
+	return String(pool + record.TypeOffset, pool + record.TypeOffset + record.TypeLength);
+}
+
+bool ObjectsFileIndex::MapFile(const String& path, MappedFile& file)
+{
+#ifndef _WIN32
+	int fd = open(path.CStr(), O_RDONLY);
+
+	if (fd < 0)
+		return false;
+
+	struct stat statbuf;
+
+	if (fstat(fd, &statbuf) < 0) {
+		close(fd);
+		return false;
+	}
+
+	file.Size = statbuf.st_size;
+
+	if (file.Size > 0) {
+		void *data = mmap(NULL, file.Size, PROT_READ, MAP_SHARED, fd, 0);
+
+		if (data == MAP_FAILED) {
+			close(fd);
+			file.Size = 0;
+			return false;
+		}
+
+		file.Data = static_cast<const char *>(data);
+		file.Mapped = true;
+	}
+
+	close(fd);
+
+	return true;
+#else /* _WIN32 */
+	std::ifstream fp(path.CStr(), std::ios::in | std::ios::binary);
+
+	if (!fp)
+		return false;
+
+	fp.seekg(0, std::ios::end);
+	file.Size = fp.tellg();
+	fp.seekg(0, std::ios::beg);
+
+	char *data = new char[file.Size + 1];
+	fp.read(data, file.Size);
+
+	file.Data = data;
+	file.Mapped = false;
+
+	return true;
+#endif /* _WIN32 */
+}
+
+void ObjectsFileIndex::UnmapFile(MappedFile& file)
+{
+#ifndef _WIN32
+	if (file.Mapped)
+		munmap(const_cast<char *>(file.Data), file.Size);
+#else /* _WIN32 */
+	delete [] file.Data;
+#endif /* _WIN32 */
+
+	file.Data = NULL;
+	file.Size = 0;
+	file.Mapped = false;
+}
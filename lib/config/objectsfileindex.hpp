@@ -0,0 +1,98 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#ifndef OBJECTSFILEINDEX_H
+#define OBJECTSFILEINDEX_H
+
+#include "config/i2-config.hpp"
+#include "base/string.hpp"
+#include <boost/noncopyable.hpp>
+#include <vector>
+
+namespace icinga
+{
+
+/**
+ * The location of a single record in the objects file.
+ *
+ * @ingroup config
+ */
+struct I2_CONFIG_API ObjectsFileIndexEntry
+{
+	String Type;
+	String Name;
+	String InternalName;
+	uint64_t Offset;
+	uint64_t Length;
+
+	ObjectsFileIndexEntry(void)
+		: Offset(0), Length(0)
+	{ }
+};
+
+/**
+ * A sidecar index for the objects file which is written during config
+ * validation. It maps type and name of each object to the offset and length
+ * of its JSON record in the objects file so that filtered listings only have
+ * to decode the matching records.
+ *
+ * @ingroup config
+ */
+class I2_CONFIG_API ObjectsFileIndex : private boost::noncopyable
+{
+public:
+	ObjectsFileIndex(void);
+	~ObjectsFileIndex(void);
+
+	static String GetIndexPath(const String& objectsPath);
+	static void WriteIndex(const String& path, std::vector<ObjectsFileIndexEntry>& entries, uint64_t objectsSize);
+
+	bool Open(const String& objectsPath);
+	void Close(void);
+
+	size_t GetCount(void) const;
+	std::vector<ObjectsFileIndexEntry> FindObjects(const String& typeFilter, const String& nameFilter) const;
+	String ReadObject(const ObjectsFileIndexEntry& entry) const;
+
+private:
+	struct MappedFile
+	{
+		const char *Data;
+		size_t Size;
+		bool Mapped;
+
+		MappedFile(void)
+			: Data(NULL), Size(0), Mapped(false)
+		{ }
+	};
+
+	MappedFile m_Index;
+	MappedFile m_Objects;
+	size_t m_Count;
+
+	static bool MapFile(const String& path, MappedFile& file);
+	static void UnmapFile(MappedFile& file);
+
+	ObjectsFileIndexEntry GetEntry(size_t index) const;
+	String GetType(size_t index) const;
+};
+
+}
+
+#endif /* OBJECTSFILEINDEX_H */
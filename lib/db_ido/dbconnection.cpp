@@ -29,6 +29,8 @@
 #include "base/utility.hpp"
 #include "base/logger.hpp"
 #include "base/exception.hpp"
+#include "base/workqueue.hpp"
+#include <iomanip>
 
 using namespace icinga;
 
@@ -39,7 +41,9 @@ boost::once_flag DbConnection::m_OnceFlag = BOOST_ONCE_INIT;
 
 DbConnection::DbConnection(void)
 	: m_IDCacheValid(false), m_QueryStats(15 * 60), m_PendingQueries(0),
-	  m_PendingQueriesTimestamp(0), m_ActiveChangedHandler(false)
+	  m_PendingQueriesTimestamp(0), m_ConfigDumpTotal(0), m_ConfigDumpDone(0),
+	  m_ConfigDumpUpdated(0), m_ConfigDumpStart(0), m_ConfigDumpEnd(0),
+	  m_ActiveChangedHandler(false)
 { }
 
 void DbConnection::OnConfigLoaded(void)
@@ -440,37 +444,60 @@ void DbConnection::UpdateObject(const ConfigObject::Ptr& object)
 	DbObject::Ptr dbobj = DbObject::GetOrCreateByObject(object);
 
 	if (dbobj) {
-		bool dbActive = GetObjectActive(dbobj);
-		bool active = object->IsActive();
-
-		if (active) {
-			if (!dbActive)
-				ActivateObject(dbobj);
-
-			Dictionary::Ptr configFields = dbobj->GetConfigFields();
-			String configHash = dbobj->CalculateConfigHash(configFields);
-			ASSERT(configHash.GetLength() <= 64);
-			configFields->Set("config_hash", configHash);
-
-			String cachedHash = GetConfigHash(dbobj);
-
-			if (cachedHash != configHash) {
-				dbobj->SendConfigUpdateHeavy(configFields);
-				dbobj->SendStatusUpdate();
-			} else {
-				dbobj->SendConfigUpdateLight();
-			}
-		} else if (!active) {
-			/* Deactivate the deleted object no matter
-			 * which state it had in the database.
-			 */
-			DeactivateObject(dbobj);
+		Dictionary::Ptr configFields;
+		String configHash;
+
+		if (object->IsActive())
+			configHash = CalculateConfigFields(dbobj, configFields);
+
+		UpdateObject(dbobj, object->IsActive(), configFields, configHash);
+	}
+}
+
+String DbConnection::CalculateConfigFields(const DbObject::Ptr& dbobj, Dictionary::Ptr& configFields)
+{
+	configFields = dbobj->GetConfigFields();
+	String configHash = dbobj->CalculateConfigHash(configFields);
+	ASSERT(configHash.GetLength() <= 64);
+	configFields->Set("config_hash", configHash);
+
+	return configHash;
+}
+
+bool DbConnection::UpdateObject(const DbObject::Ptr& dbobj, bool active,
+    const Dictionary::Ptr& configFields, const String& configHash)
+{
+	bool dbActive = GetObjectActive(dbobj);
+
+	if (active) {
+		if (!dbActive)
+			ActivateObject(dbobj);
+
+		String cachedHash = GetConfigHash(dbobj);
+
+		if (cachedHash != configHash) {
+			dbobj->SendConfigUpdateHeavy(configFields);
+			dbobj->SendStatusUpdate();
+			return true;
+		} else {
+			dbobj->SendConfigUpdateLight();
 		}
+	} else {
+		/* Deactivate the deleted object no matter
+		 * which state it had in the database.
+		 */
+		DeactivateObject(dbobj);
 	}
+
+	return false;
 }
 
 void DbConnection::UpdateAllObjects(void)
 {
+	double start = Utility::GetTime();
+
+	std::vector<ConfigObject::Ptr> objects;
+
 	for (const Type::Ptr& type : Type::GetAllTypes()) {
 		ConfigType *dtype = dynamic_cast<ConfigType *>(type.get());
 
@@ -478,9 +505,115 @@ void DbConnection::UpdateAllObjects(void)
 			continue;
 
 		for (const ConfigObject::Ptr& object : dtype->GetObjects()) {
-			UpdateObject(object);
+			objects.push_back(object);
+		}
+	}
+
+	{
+		boost::mutex::scoped_lock lock(m_StatsMutex);
+		m_ConfigDumpTotal = objects.size();
+		m_ConfigDumpDone = 0;
+		m_ConfigDumpUpdated = 0;
+		m_ConfigDumpStart = start;
+		m_ConfigDumpEnd = 0;
+	}
+
+	/* Serializing and hashing the config attributes is by far the most
+	 * expensive part of the config dump. Do that in parallel for each
+	 * chunk and send the queries for changed objects afterwards, in the
+	 * same order as before.
+	 */
+	WorkQueue upq(25000, Application::GetConcurrency());
+	upq.SetName("DbConnection, ConfigHash");
+
+	const size_t chunkSize = 2500;
+	size_t done = 0, updated = 0;
+
+	for (size_t offset = 0; offset < objects.size(); offset += chunkSize) {
+		if (!GetConnected() || Application::IsShuttingDown())
+			break;
+
+		size_t count = std::min(chunkSize, objects.size() - offset);
+
+		std::vector<DbObject::Ptr> dbobjs(count);
+		std::vector<bool> actives(count);
+		std::vector<Dictionary::Ptr> configFields(count);
+		std::vector<String> configHashes(count);
+
+		for (size_t i = 0; i < count; i++) {
+			const ConfigObject::Ptr& object = objects[offset + i];
+
+			dbobjs[i] = DbObject::GetOrCreateByObject(object);
+			actives[i] = object->IsActive();
+
+			if (!dbobjs[i] || !actives[i])
+				continue;
+
+			upq.Enqueue([&dbobjs, &configFields, &configHashes, i]() {
+				configHashes[i] = CalculateConfigFields(dbobjs[i], configFields[i]);
+			});
+		}
+
+		upq.Join();
+
+		if (upq.HasExceptions()) {
+			upq.ReportExceptions("DbConnection");
+			break;
+		}
+
+		size_t chunkUpdated = 0;
+
+		for (size_t i = 0; i < count; i++) {
+			if (!dbobjs[i])
+				continue;
+
+			if (UpdateObject(dbobjs[i], actives[i], configFields[i], configHashes[i]))
+				chunkUpdated++;
 		}
+
+		done += count;
+		updated += chunkUpdated;
+
+		boost::mutex::scoped_lock lock(m_StatsMutex);
+		m_ConfigDumpDone += count;
+		m_ConfigDumpUpdated += chunkUpdated;
+	}
+
+	double end = Utility::GetTime();
+
+	{
+		boost::mutex::scoped_lock lock(m_StatsMutex);
+		m_ConfigDumpEnd = end;
 	}
+
+	if (done < objects.size()) {
+		Log(LogWarning, "DbConnection")
+		    << "'" << GetName() << "' aborted the config dump after " << done << " of " << objects.size() << " objects.";
+		return;
+	}
+
+	Log(LogInformation, "DbConnection")
+	    << "'" << GetName() << "' finished the config dump for " << done << " objects in "
+	    << std::fixed << std::setprecision(2) << (end - start) << " seconds ("
+	    << updated << " changed, " << (done - updated) << " unchanged or inactive).";
+}
+
+Dictionary::Ptr DbConnection::GetConfigDumpStats(void) const
+{
+	boost::mutex::scoped_lock lock(m_StatsMutex);
+
+	Dictionary::Ptr stats = new Dictionary();
+	stats->Set("total", m_ConfigDumpTotal);
+	stats->Set("done", m_ConfigDumpDone);
+	stats->Set("updated", m_ConfigDumpUpdated);
+	stats->Set("skipped", m_ConfigDumpDone - m_ConfigDumpUpdated);
+	stats->Set("progress", m_ConfigDumpTotal > 0 ? static_cast<double>(m_ConfigDumpDone) / m_ConfigDumpTotal : 1.0);
+	stats->Set("in_progress", m_ConfigDumpStart > 0 && m_ConfigDumpEnd == 0);
+
+	if (m_ConfigDumpStart > 0)
+		stats->Set("duration", (m_ConfigDumpEnd > 0 ? m_ConfigDumpEnd : Utility::GetTime()) - m_ConfigDumpStart);
+
+	return stats;
 }
 
 void DbConnection::PrepareDatabase(void)
@@ -76,6 +76,8 @@ public:
 	int GetQueryCount(RingBuffer::SizeType span) const;
 	virtual int GetPendingQueryCount(void) const = 0;
 
+	Dictionary::Ptr GetConfigDumpStats(void) const;
+
 	virtual void ValidateFailoverTimeout(double value, const ValidationUtils& utils) override;
 
 protected:
@@ -95,6 +97,8 @@ protected:
 	virtual void NewTransaction(void) = 0;
 
 	void UpdateObject(const ConfigObject::Ptr& object);
+	bool UpdateObject(const DbObject::Ptr& dbobj, bool active,
+	    const Dictionary::Ptr& configFields, const String& configHash);
 	void UpdateAllObjects(void);
 
 	void PrepareDatabase(void);
@@ -130,10 +134,17 @@ private:
 
 	static void InsertRuntimeVariable(const String& key, const Value& value);
 
+	static String CalculateConfigFields(const DbObject::Ptr& dbobj, Dictionary::Ptr& configFields);
+
 	mutable boost::mutex m_StatsMutex;
 	RingBuffer m_QueryStats;
 	int m_PendingQueries;
 	double m_PendingQueriesTimestamp;
+	size_t m_ConfigDumpTotal;
+	size_t m_ConfigDumpDone;
+	size_t m_ConfigDumpUpdated;
+	double m_ConfigDumpStart;
+	double m_ConfigDumpEnd;
 	bool m_ActiveChangedHandler;
 };
 
@@ -61,6 +61,9 @@ void IdoMysqlConnection::StatsFunc(const Dictionary::Ptr& status, const Array::P
 		stats->Set("connected", idomysqlconnection->GetConnected());
 		stats->Set("query_queue_items", items);
 
+		Dictionary::Ptr configDump = idomysqlconnection->GetConfigDumpStats();
+		stats->Set("config_dump", configDump);
+
 		nodes->Set(idomysqlconnection->GetName(), stats);
 
 		perfdata->Add(new PerfdataValue("idomysqlconnection_" + idomysqlconnection->GetName() + "_queries_rate", idomysqlconnection->GetQueryCount(60) / 60.0));
@@ -68,6 +71,7 @@ void IdoMysqlConnection::StatsFunc(const Dictionary::Ptr& status, const Array::P
 		perfdata->Add(new PerfdataValue("idomysqlconnection_" + idomysqlconnection->GetName() + "_queries_5mins", idomysqlconnection->GetQueryCount(5 * 60)));
 		perfdata->Add(new PerfdataValue("idomysqlconnection_" + idomysqlconnection->GetName() + "_queries_15mins", idomysqlconnection->GetQueryCount(15 * 60)));
 		perfdata->Add(new PerfdataValue("idomysqlconnection_" + idomysqlconnection->GetName() + "_query_queue_items", items));
+		perfdata->Add(new PerfdataValue("idomysqlconnection_" + idomysqlconnection->GetName() + "_config_dump_progress", configDump->Get("progress")));
 	}
 
 	status->Set("idomysqlconnection", nodes);
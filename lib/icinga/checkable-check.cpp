@@ -408,10 +408,13 @@ void Checkable::ExecuteRemoteCheck(const Dictionary::Ptr& resolvedMacros)
 	GetCheckCommand()->Execute(this, cr, resolvedMacros, true);
 }
 
-void Checkable::ExecuteCheck(void)
+/**
+ * Marks the check as running and creates the check result for it.
+ *
+ * @returns The check result or NULL if there is a check pending already.
+ */
+CheckResult::Ptr Checkable::PrepareCheck(void)
 {
-	CONTEXT("Executing check for object '" + GetName() + "'");
-
 	/* keep track of scheduling info in case the check type doesn't provide its own information */
 	double scheduled_start = GetNextCheck();
 	double before_check = Utility::GetTime();
@@ -425,7 +428,7 @@ void Checkable::ExecuteCheck(void)
 
 		/* don't run another check if there is one pending */
 		if (m_CheckRunning)
-			return;
+			return CheckResult::Ptr();
 
 		m_CheckRunning = true;
 
@@ -439,6 +442,18 @@ void Checkable::ExecuteCheck(void)
 	cr->SetScheduleStart(scheduled_start);
 	cr->SetExecutionStart(before_check);
 
+	return cr;
+}
+
+void Checkable::ExecuteCheck(void)
+{
+	CONTEXT("Executing check for object '" + GetName() + "'");
+
+	CheckResult::Ptr cr = PrepareCheck();
+
+	if (!cr)
+		return;
+
 	Endpoint::Ptr endpoint = GetCommandEndpoint();
 	bool local = !endpoint || endpoint == Endpoint::GetLocalEndpoint();
 
@@ -503,6 +518,31 @@ void Checkable::ExecuteCheck(void)
 	}
 }
 
+/**
+ * Executes the checks for several local checkables which share a batch
+ * capable check command with a single invocation of the command.
+ */
+void Checkable::ExecuteCheckBatch(const CheckCommand::Ptr& command, const std::vector<Checkable::Ptr>& checkables)
+{
+	CONTEXT("Executing batch check with command '" + command->GetName() + "'");
+
+	std::vector<Checkable::Ptr> targets;
+	std::vector<CheckResult::Ptr> results;
+
+	for (const Checkable::Ptr& checkable : checkables) {
+		CheckResult::Ptr cr = checkable->PrepareCheck();
+
+		if (!cr)
+			continue;
+
+		targets.push_back(checkable);
+		results.push_back(cr);
+	}
+
+	if (!targets.empty())
+		command->ExecuteBatch(targets, results);
+}
+
 void Checkable::UpdateStatistics(const CheckResult::Ptr& cr, CheckableType type)
 {
 	time_t ts = cr->GetScheduleEnd();
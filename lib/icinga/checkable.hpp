@@ -105,6 +105,7 @@ public:
 
 	void ExecuteRemoteCheck(const Dictionary::Ptr& resolvedMacros = Dictionary::Ptr());
 	void ExecuteCheck();
+	static void ExecuteCheckBatch(const intrusive_ptr<CheckCommand>& command, const std::vector<Checkable::Ptr>& checkables);
 	void ProcessCheckResult(const CheckResult::Ptr& cr, const MessageOrigin::Ptr& origin = MessageOrigin::Ptr());
 
 	Endpoint::Ptr GetCommandEndpoint(void) const;
@@ -197,6 +198,8 @@ private:
 	static boost::mutex m_StatsMutex;
 	static int m_PendingChecks;
 
+	CheckResult::Ptr PrepareCheck(void);
+
 	/* Downtimes */
 	std::set<Downtime::Ptr> m_Downtimes;
 	mutable boost::mutex m_DowntimeMutex;
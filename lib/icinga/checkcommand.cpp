@@ -19,7 +19,11 @@
 
 #include "icinga/checkcommand.hpp"
 #include "icinga/checkcommand.tcpp"
+#include "icinga/pluginutility.hpp"
+#include "icinga/icingaapplication.hpp"
+#include "icinga/service.hpp"
 #include "base/configtype.hpp"
+#include "base/logger.hpp"
 
 using namespace icinga;
 
@@ -35,3 +39,88 @@ void CheckCommand::Execute(const Checkable::Ptr& checkable, const CheckResult::P
 	arguments.push_back(useResolvedMacros);
 	GetExecute()->Invoke(arguments);
 }
+
+/**
+ * Runs the command once for all specified checkables. The command line is
+ * built from the first checkable's macros, followed by the resolved
+ * batch_target for each checkable. The output is split into the individual
+ * check results with PluginUtility::ParseBatchOutput().
+ */
+void CheckCommand::ExecuteBatch(const std::vector<Checkable::Ptr>& checkables, const std::vector<CheckResult::Ptr>& results)
+{
+	Array::Ptr targets = new Array();
+	MacroProcessor::ResolverList firstResolvers;
+
+	for (std::vector<Checkable::Ptr>::size_type i = 0; i < checkables.size(); i++) {
+		Host::Ptr host;
+		Service::Ptr service;
+		tie(host, service) = GetHostService(checkables[i]);
+
+		MacroProcessor::ResolverList resolvers;
+		if (service)
+			resolvers.push_back(std::make_pair("service", service));
+		resolvers.push_back(std::make_pair("host", host));
+		resolvers.push_back(std::make_pair("command", this));
+		resolvers.push_back(std::make_pair("icinga", IcingaApplication::GetInstance()));
+
+		targets->Add(MacroProcessor::ResolveMacros(GetBatchTarget(), resolvers, results[i]));
+
+		if (i == 0)
+			firstResolvers = resolvers;
+	}
+
+	PluginUtility::ExecuteCommand(this, checkables[0], results[0], firstResolvers, Dictionary::Ptr(), false,
+	    boost::bind(&CheckCommand::BatchFinishedHandler, checkables, results, targets, _1, _2), targets);
+
+	for (std::vector<Checkable::Ptr>::size_type i = 0; i < checkables.size(); i++)
+		Checkable::IncreasePendingChecks();
+}
+
+void CheckCommand::BatchFinishedHandler(const std::vector<Checkable::Ptr>& checkables,
+    const std::vector<CheckResult::Ptr>& results, const Array::Ptr& targets,
+    const Value& commandLine, const ProcessResult& pr)
+{
+	std::map<String, std::pair<int, String> > batchResults = PluginUtility::ParseBatchOutput(pr.Output);
+
+	if (!commandLine.IsEmpty() && (pr.ExitStatus > 3 || batchResults.size() < checkables.size())) {
+		Process::Arguments parguments = Process::PrepareCommand(commandLine);
+		Log(LogWarning, "CheckCommand")
+		    << "Batch check command (PID: " << pr.PID << ", arguments: " << Process::PrettyPrintArguments(parguments)
+		    << ") terminated with exit code " << pr.ExitStatus << " and returned " << batchResults.size()
+		    << " results for " << checkables.size() << " targets";
+	}
+
+	for (std::vector<Checkable::Ptr>::size_type i = 0; i < checkables.size(); i++) {
+		Checkable::DecreasePendingChecks();
+
+		const CheckResult::Ptr& cr = results[i];
+		String target = targets->Get(i);
+
+		cr->SetCommand(commandLine);
+		cr->SetExecutionStart(pr.ExecutionStart);
+		cr->SetExecutionEnd(pr.ExecutionEnd);
+
+		auto it = batchResults.find(target);
+
+		if (it != batchResults.end()) {
+			std::pair<String, String> co = PluginUtility::ParseCheckOutput(it->second.second.Trim());
+			cr->SetOutput(co.first);
+			cr->SetPerformanceData(PluginUtility::SplitPerfdata(co.second));
+			cr->SetState(PluginUtility::ExitStatusToState(it->second.first));
+			cr->SetExitStatus(it->second.first);
+		} else {
+			String output = "Batch check command returned no result for target '" + target + "'";
+
+			String processOutput = pr.Output.Trim();
+
+			if (!processOutput.IsEmpty() && batchResults.empty())
+				output += ": " + processOutput;
+
+			cr->SetOutput(output);
+			cr->SetState(ServiceUnknown);
+			cr->SetExitStatus(3);
+		}
+
+		checkables[i]->ProcessCheckResult(cr);
+	}
+}
@@ -22,6 +22,7 @@
 
 #include "icinga/checkcommand.thpp"
 #include "icinga/checkable.hpp"
+#include "base/process.hpp"
 
 namespace icinga
 {
@@ -40,6 +41,13 @@ public:
 	virtual void Execute(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr,
 	    const Dictionary::Ptr& resolvedMacros = Dictionary::Ptr(),
 	    bool useResolvedMacros = false);
+
+	void ExecuteBatch(const std::vector<Checkable::Ptr>& checkables, const std::vector<CheckResult::Ptr>& results);
+
+private:
+	static void BatchFinishedHandler(const std::vector<Checkable::Ptr>& checkables,
+	    const std::vector<CheckResult::Ptr>& results, const Array::Ptr& targets,
+	    const Value& commandLine, const ProcessResult& pr);
 };
 
 }
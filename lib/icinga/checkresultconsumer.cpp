@@ -0,0 +1,175 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "icinga/checkresultconsumer.hpp"
+#include "icinga/perfdatavalue.hpp"
+#include "base/statsfunction.hpp"
+#include "base/logger.hpp"
+#include "base/exception.hpp"
+#include "base/utility.hpp"
+
+using namespace icinga;
+
+static boost::mutex l_ConsumersMutex;
+static std::set<CheckResultConsumer *> l_Consumers;
+
+REGISTER_STATSFUNCTION(CheckResultConsumer, &CheckResultConsumer::StatsFunc);
+
+CheckResultConsumer::CheckResultConsumer(const String& name, const Callback& callback, size_t maxItems)
+	: m_Name(name), m_Callback(callback), m_MaxItems(maxItems), m_Stopped(false), m_Dropped(0), m_Lag(0)
+{
+	m_Queue.SetName("CheckResultConsumer, " + name);
+	m_Queue.SetExceptionCallback(boost::bind(&CheckResultConsumer::ExceptionHandler, this, _1));
+}
+
+void CheckResultConsumer::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata)
+{
+	Dictionary::Ptr nodes = new Dictionary();
+
+	boost::mutex::scoped_lock lock(l_ConsumersMutex);
+
+	for (CheckResultConsumer *consumer : l_Consumers) {
+		String name = consumer->GetName();
+		size_t pending = consumer->GetPending();
+		int dropped = consumer->GetDropped();
+		double lag = consumer->GetLag();
+
+		Dictionary::Ptr stats = new Dictionary();
+		stats->Set("pending", pending);
+		stats->Set("dropped", dropped);
+		stats->Set("lag", lag);
+
+		nodes->Set(name, stats);
+
+		perfdata->Add(new PerfdataValue("checkresultconsumer_" + name + "_pending", pending));
+		perfdata->Add(new PerfdataValue("checkresultconsumer_" + name + "_dropped", dropped));
+		perfdata->Add(new PerfdataValue("checkresultconsumer_" + name + "_lag", lag));
+	}
+
+	status->Set("checkresultconsumer", nodes);
+}
+
+void CheckResultConsumer::Start(void)
+{
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+		m_Stopped = false;
+	}
+
+	{
+		boost::mutex::scoped_lock lock(l_ConsumersMutex);
+		l_Consumers.insert(this);
+	}
+
+	m_Connection = Checkable::OnNewCheckResult.connect(boost::bind(&CheckResultConsumer::CheckResultHandler, this, _1, _2));
+}
+
+/**
+ * Disconnects from the signal and waits until all pending check results
+ * have been delivered. Check results which are being processed concurrently
+ * are discarded.
+ */
+void CheckResultConsumer::Stop(void)
+{
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+		m_Stopped = true;
+	}
+
+	m_Connection.disconnect();
+
+	m_Queue.Join();
+
+	boost::mutex::scoped_lock lock(l_ConsumersMutex);
+	l_Consumers.erase(this);
+}
+
+String CheckResultConsumer::GetName(void) const
+{
+	return m_Name;
+}
+
+size_t CheckResultConsumer::GetPending(void) const
+{
+	return m_Queue.GetLength();
+}
+
+int CheckResultConsumer::GetDropped(void) const
+{
+	boost::mutex::scoped_lock lock(m_Mutex);
+	return m_Dropped;
+}
+
+/**
+ * Returns how long the most recently delivered check result was queued.
+ */
+double CheckResultConsumer::GetLag(void) const
+{
+	boost::mutex::scoped_lock lock(m_Mutex);
+	return m_Lag;
+}
+
+void CheckResultConsumer::CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr)
+{
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+
+		if (m_Stopped)
+			return;
+
+		if (m_Queue.GetLength() >= m_MaxItems) {
+			if (m_Dropped++ == 0) {
+				Log(LogWarning, "CheckResultConsumer")
+				    << "'" << m_Name << "' cannot keep up, dropping check results.";
+			}
+
+			return;
+		}
+	}
+
+	Task task = m_Callback(checkable, cr);
+
+	if (!task)
+		return;
+
+	/* Enqueue while holding the lock so that Stop() either sees the
+	 * task in the queue or prevents it from being added. */
+	boost::mutex::scoped_lock lock(m_Mutex);
+
+	if (m_Stopped)
+		return;
+
+	m_Queue.Enqueue(boost::bind(&CheckResultConsumer::RunTask, CheckResultConsumer::Ptr(this), task, Utility::GetTime()));
+}
+
+void CheckResultConsumer::RunTask(const Task& task, double queued)
+{
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+		m_Lag = Utility::GetTime() - queued;
+	}
+
+	task();
+}
+
+void CheckResultConsumer::ExceptionHandler(boost::exception_ptr exp)
+{
+	Log(LogCritical, "CheckResultConsumer")
+	    << "Exception while delivering check result to '" << m_Name << "': " << DiagnosticInformation(exp);
+}
@@ -0,0 +1,87 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#ifndef CHECKRESULTCONSUMER_H
+#define CHECKRESULTCONSUMER_H
+
+#include "icinga/i2-icinga.hpp"
+#include "icinga/checkable.hpp"
+#include "base/workqueue.hpp"
+
+namespace icinga
+{
+
+/**
+ * Delivers Checkable::OnNewCheckResult to a single consumer on a dedicated
+ * worker thread, so that slow consumers do not delay check processing.
+ *
+ * The consumer's callback is invoked synchronously while the checkable's
+ * state still matches the check result. It reads whatever it needs from
+ * the checkable and returns a task which is then run on the worker thread;
+ * that task must not access the checkable's live state.
+ *
+ * Tasks are run one at a time and in the order in which the check results
+ * were processed. If the consumer falls behind by more than the
+ * configured number of check results, new check results are dropped
+ * until it catches up. Consumers which depend on the relative order of
+ * check results and other checkable events must connect to the signal
+ * directly instead.
+ *
+ * @ingroup icinga
+ */
+class I2_ICINGA_API CheckResultConsumer : public Object
+{
+public:
+	DECLARE_PTR_TYPEDEFS(CheckResultConsumer);
+
+	typedef boost::function<void (void)> Task;
+	typedef boost::function<Task (const Checkable::Ptr&, const CheckResult::Ptr&)> Callback;
+
+	CheckResultConsumer(const String& name, const Callback& callback, size_t maxItems = 100000);
+
+	void Start(void);
+	void Stop(void);
+
+	String GetName(void) const;
+	size_t GetPending(void) const;
+	int GetDropped(void) const;
+	double GetLag(void) const;
+
+	static void StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata);
+
+private:
+	String m_Name;
+	Callback m_Callback;
+	size_t m_MaxItems;
+	WorkQueue m_Queue;
+	boost::signals2::connection m_Connection;
+
+	mutable boost::mutex m_Mutex;
+	bool m_Stopped;
+	int m_Dropped;
+	double m_Lag;
+
+	void CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
+	void RunTask(const Task& task, double queued);
+	void ExceptionHandler(boost::exception_ptr exp);
+};
+
+}
+
+#endif /* CHECKRESULTCONSUMER_H */
@@ -199,32 +199,17 @@ ServiceStatistics CIB::CalculateServiceStats(void)
 {
 	ServiceStatistics ss = {};
 
-	for (const Service::Ptr& service : ConfigType::GetObjectsByType<Service>()) {
-		ObjectLock olock(service);
-
-		CheckResult::Ptr cr = service->GetLastCheckResult();
-
-		if (service->GetState() == ServiceOK)
-			ss.services_ok++;
-		if (service->GetState() == ServiceWarning)
-			ss.services_warning++;
-		if (service->GetState() == ServiceCritical)
-			ss.services_critical++;
-		if (service->GetState() == ServiceUnknown)
-			ss.services_unknown++;
-
-		if (!cr)
-			ss.services_pending++;
-		if (!service->IsReachable())
-			ss.services_unreachable++;
-
-		if (service->IsFlapping())
-			ss.services_flapping++;
-		if (service->IsInDowntime())
-			ss.services_in_downtime++;
-		if (service->IsAcknowledged())
-			ss.services_acknowledged++;
-	}
+	ServiceStateCounters counters = ServiceStateCounters::GetGlobal();
+
+	ss.services_ok = counters.GetState(ServiceOK);
+	ss.services_warning = counters.GetState(ServiceWarning);
+	ss.services_critical = counters.GetState(ServiceCritical);
+	ss.services_unknown = counters.GetState(ServiceUnknown);
+	ss.services_pending = counters.GetPending();
+	ss.services_unreachable = counters.GetUnreachable();
+	ss.services_flapping = counters.GetFlapping();
+	ss.services_in_downtime = counters.GetInDowntime();
+	ss.services_acknowledged = counters.GetAcknowledged();
 
 	return ss;
 }
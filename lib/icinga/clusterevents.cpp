@@ -33,6 +33,9 @@
 #include "base/initialize.hpp"
 #include "base/serializer.hpp"
 #include "base/json.hpp"
+#include "base/convert.hpp"
+#include "base/workqueue.hpp"
+#include <boost/make_shared.hpp>
 #include <fstream>
 
 using namespace icinga;
@@ -40,6 +43,7 @@ using namespace icinga;
 INITIALIZE_ONCE(&ClusterEvents::StaticInitialize);
 
 REGISTER_APIFUNCTION(CheckResult, event, &ClusterEvents::CheckResultAPIHandler);
+REGISTER_APIFUNCTION(CheckResults, event, &ClusterEvents::CheckResultsAPIHandler);
 REGISTER_APIFUNCTION(SetNextCheck, event, &ClusterEvents::NextCheckChangedAPIHandler);
 REGISTER_APIFUNCTION(SetNextNotification, event, &ClusterEvents::NextNotificationChangedAPIHandler);
 REGISTER_APIFUNCTION(SetForceNextCheck, event, &ClusterEvents::ForceNextCheckChangedAPIHandler);
@@ -54,6 +58,63 @@ REGISTER_APIFUNCTION(NotificationSentToAllUsers, event, &ClusterEvents::Notifica
 
 static Timer::Ptr l_RepositoryTimer;
 
+/* Check results are coalesced for up to this many seconds before they are relayed.
+ *
+ * Batching delays event::CheckResult relative to the other events. Events
+ * which depend on the check result (notifications and acknowledgements)
+ * flush the pending batch for their checkable before they are relayed.
+ * event::SetNextCheck is sent before the check result anyway. The receiver
+ * handles all events for a checkable on the queue which processes its check
+ * results so they keep that order. */
+static const double l_CheckResultBatchWindow = 0.1;
+static const size_t l_CheckResultBatchMaxSize = 500;
+
+/* Incoming results each queue may hold before the JSON-RPC connection
+ * which received them has to wait. */
+static const size_t l_CheckResultQueueMaxItems = 25000;
+
+struct CheckResultBatch
+{
+	MessageOrigin::Ptr Origin;
+	Zone::Ptr TargetZone;
+	Array::Ptr Results;
+	std::set<Checkable::Ptr> Checkables;
+	double Deadline;
+};
+
+static boost::mutex l_CheckResultBatchMutex;
+static std::map<String, CheckResultBatch> l_CheckResultBatches;
+static Timer::Ptr l_CheckResultBatchTimer;
+
+static std::vector<boost::shared_ptr<WorkQueue> > l_CheckResultQueues;
+
+static void CheckResultQueueExceptionHandler(boost::exception_ptr exp)
+{
+	Log(LogWarning, "ClusterEvents")
+	    << "Error while processing cluster event: " << DiagnosticInformation(exp);
+}
+
+/**
+ * Moves an incoming event for a checkable onto the work queue which
+ * processes the checkable's check results. Otherwise an event could be
+ * handled before a batch of check results which was received earlier.
+ *
+ * @returns true if the event was queued, false if the caller already runs
+ *          on that queue and has to handle the event itself.
+ */
+static bool QueueCheckableEvent(Value (*handler)(const MessageOrigin::Ptr&, const Dictionary::Ptr&),
+    const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params)
+{
+	WorkQueue& queue = *l_CheckResultQueues[ClusterEvents::GetCheckResultQueueIndex(params)];
+
+	if (queue.IsWorkerThread())
+		return false;
+
+	queue.Enqueue(boost::bind(handler, origin, params));
+
+	return true;
+}
+
 void ClusterEvents::StaticInitialize(void)
 {
 	Checkable::OnNewCheckResult.connect(&ClusterEvents::CheckResultHandler);
@@ -73,6 +134,20 @@ void ClusterEvents::StaticInitialize(void)
 	l_RepositoryTimer->OnTimerExpired.connect(boost::bind(&ClusterEvents::RepositoryTimerHandler));
 	l_RepositoryTimer->Start();
 	l_RepositoryTimer->Reschedule(0);
+
+	l_CheckResultBatchTimer = new Timer();
+	l_CheckResultBatchTimer->SetInterval(l_CheckResultBatchWindow);
+	l_CheckResultBatchTimer->OnTimerExpired.connect(boost::bind(&ClusterEvents::CheckResultBatchTimerHandler));
+	l_CheckResultBatchTimer->Start();
+
+	ApiListener::OnStopping.connect(boost::bind(&ClusterEvents::FlushCheckResultBatches, true));
+
+	for (int i = 0; i < Application::GetConcurrency(); i++) {
+		boost::shared_ptr<WorkQueue> queue = boost::make_shared<WorkQueue>(l_CheckResultQueueMaxItems);
+		queue->SetName("ClusterEvents, CheckResults#" + Convert::ToString(i));
+		queue->SetExceptionCallback(&CheckResultQueueExceptionHandler);
+		l_CheckResultQueues.push_back(queue);
+	}
 }
 
 Dictionary::Ptr ClusterEvents::MakeCheckResultMessage(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr)
@@ -80,7 +155,13 @@ Dictionary::Ptr ClusterEvents::MakeCheckResultMessage(const Checkable::Ptr& chec
 	Dictionary::Ptr message = new Dictionary();
 	message->Set("jsonrpc", "2.0");
 	message->Set("method", "event::CheckResult");
+	message->Set("params", MakeCheckResultParams(checkable, cr));
+
+	return message;
+}
 
+Dictionary::Ptr ClusterEvents::MakeCheckResultParams(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr)
+{
 	Host::Ptr host;
 	Service::Ptr service;
 	tie(host, service) = GetHostService(checkable);
@@ -97,9 +178,7 @@ Dictionary::Ptr ClusterEvents::MakeCheckResultMessage(const Checkable::Ptr& chec
 	}
 	params->Set("cr", Serialize(cr));
 
-	message->Set("params", params);
-
-	return message;
+	return params;
 }
 
 void ClusterEvents::CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr, const MessageOrigin::Ptr& origin)
@@ -109,8 +188,156 @@ void ClusterEvents::CheckResultHandler(const Checkable::Ptr& checkable, const Ch
 	if (!listener)
 		return;
 
-	Dictionary::Ptr message = MakeCheckResultMessage(checkable, cr);
-	listener->RelayMessage(origin, checkable, message, true);
+	Zone::Ptr zone = static_pointer_cast<Zone>(checkable->GetZone());
+
+	if (!zone)
+		zone = Zone::GetLocalZone();
+
+	if (!zone) {
+		Dictionary::Ptr message = MakeCheckResultMessage(checkable, cr);
+		listener->RelayMessage(origin, checkable, message, true);
+		return;
+	}
+
+	String key = GetCheckResultBatchKey(zone, origin);
+
+	Dictionary::Ptr params = MakeCheckResultParams(checkable, cr);
+
+	bool flush;
+
+	{
+		boost::mutex::scoped_lock lock(l_CheckResultBatchMutex);
+
+		std::map<String, CheckResultBatch>::iterator it = l_CheckResultBatches.find(key);
+
+		if (it == l_CheckResultBatches.end()) {
+			CheckResultBatch batch;
+			batch.Origin = origin;
+			batch.TargetZone = zone;
+			batch.Results = new Array();
+			batch.Deadline = Utility::GetTime() + l_CheckResultBatchWindow;
+			it = l_CheckResultBatches.insert(std::make_pair(key, batch)).first;
+		}
+
+		it->second.Results->Add(params);
+		it->second.Checkables.insert(checkable);
+
+		flush = (it->second.Results->GetLength() >= l_CheckResultBatchMaxSize);
+	}
+
+	if (flush)
+		FlushCheckResultBatches(false);
+}
+
+/**
+ * Returns the key of the batch a check result is added to. Results are
+ * relayed in event::CheckResults messages, one per target zone and origin
+ * so that the relay rules still apply to the batch.
+ */
+String ClusterEvents::GetCheckResultBatchKey(const Zone::Ptr& zone, const MessageOrigin::Ptr& origin)
+{
+	String key = zone->GetName();
+
+	if (origin) {
+		if (origin->FromClient && origin->FromClient->GetEndpoint())
+			key += "\n" + origin->FromClient->GetEndpoint()->GetName();
+		else
+			key += "\n";
+
+		if (origin->FromZone)
+			key += "\n" + origin->FromZone->GetName();
+	}
+
+	return key;
+}
+
+/**
+ * Returns the index of the work queue which processes an incoming check
+ * result. Results for the same checkable always use the same queue.
+ */
+size_t ClusterEvents::GetCheckResultQueueIndex(const Dictionary::Ptr& params)
+{
+	String name = params->Get("host");
+
+	if (params->Contains("service"))
+		name += "!" + params->Get("service");
+
+	return Utility::SDBM(name) % l_CheckResultQueues.size();
+}
+
+void ClusterEvents::CheckResultBatchTimerHandler(void)
+{
+	FlushCheckResultBatches(false);
+}
+
+static void RelayCheckResultBatches(const std::vector<CheckResultBatch>& batches)
+{
+	ApiListener::Ptr listener = ApiListener::GetInstance();
+
+	if (!listener)
+		return;
+
+	for (const CheckResultBatch& batch : batches) {
+		Dictionary::Ptr params = new Dictionary();
+		params->Set("results", batch.Results);
+
+		Dictionary::Ptr message = new Dictionary();
+		message->Set("jsonrpc", "2.0");
+		message->Set("method", "event::CheckResults");
+		message->Set("params", params);
+
+		listener->RelayMessage(batch.Origin, batch.TargetZone, message, true);
+	}
+}
+
+/**
+ * Relays pending check result batches whose window has expired or which
+ * are full.
+ *
+ * @param all Whether to relay all batches regardless of their age
+ */
+void ClusterEvents::FlushCheckResultBatches(bool all)
+{
+	std::vector<CheckResultBatch> batches;
+
+	{
+		boost::mutex::scoped_lock lock(l_CheckResultBatchMutex);
+
+		double now = Utility::GetTime();
+
+		for (std::map<String, CheckResultBatch>::iterator it = l_CheckResultBatches.begin(); it != l_CheckResultBatches.end(); ) {
+			if (all || it->second.Deadline <= now || it->second.Results->GetLength() >= l_CheckResultBatchMaxSize) {
+				batches.push_back(it->second);
+				l_CheckResultBatches.erase(it++);
+			} else
+				++it;
+		}
+	}
+
+	RelayCheckResultBatches(batches);
+}
+
+/**
+ * Relays the pending batches which contain a result for the checkable so
+ * that the next event for it doesn't overtake its check result.
+ */
+void ClusterEvents::FlushCheckableCheckResults(const Checkable::Ptr& checkable)
+{
+	std::vector<CheckResultBatch> batches;
+
+	{
+		boost::mutex::scoped_lock lock(l_CheckResultBatchMutex);
+
+		for (std::map<String, CheckResultBatch>::iterator it = l_CheckResultBatches.begin(); it != l_CheckResultBatches.end(); ) {
+			if (it->second.Checkables.find(checkable) != it->second.Checkables.end()) {
+				batches.push_back(it->second);
+				l_CheckResultBatches.erase(it++);
+			} else
+				++it;
+		}
+	}
+
+	RelayCheckResultBatches(batches);
 }
 
 Value ClusterEvents::CheckResultAPIHandler(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params)
@@ -126,6 +353,54 @@ Value ClusterEvents::CheckResultAPIHandler(const MessageOrigin::Ptr& origin, con
 	if (!params)
 		return Empty;
 
+	WorkQueue& queue = *l_CheckResultQueues[GetCheckResultQueueIndex(params)];
+	queue.Enqueue(boost::bind(&ClusterEvents::ProcessCheckResultParams, origin, params));
+
+	return Empty;
+}
+
+/**
+ * Handles the batched form of event::CheckResult. Results are spread across
+ * several work queues by checkable so that results for the same checkable
+ * are still processed in order. The other events for a checkable are
+ * handled on the same queue, see QueueCheckableEvent().
+ */
+Value ClusterEvents::CheckResultsAPIHandler(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params)
+{
+	Endpoint::Ptr endpoint = origin->FromClient->GetEndpoint();
+
+	if (!endpoint) {
+		Log(LogNotice, "ClusterEvents")
+		    << "Discarding 'check results' message from '" << origin->FromClient->GetIdentity() << "': Invalid endpoint origin (client not allowed).";
+		return Empty;
+	}
+
+	if (!params)
+		return Empty;
+
+	Array::Ptr results = params->Get("results");
+
+	if (!results)
+		return Empty;
+
+	ObjectLock olock(results);
+	for (const Value& vresult : results) {
+		if (!vresult.IsObjectType<Dictionary>())
+			continue;
+
+		Dictionary::Ptr result = vresult;
+
+		WorkQueue& queue = *l_CheckResultQueues[GetCheckResultQueueIndex(result)];
+		queue.Enqueue(boost::bind(&ClusterEvents::ProcessCheckResultParams, origin, result));
+	}
+
+	return Empty;
+}
+
+void ClusterEvents::ProcessCheckResultParams(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params)
+{
+	Endpoint::Ptr endpoint = origin->FromClient->GetEndpoint();
+
 	CheckResult::Ptr cr;
 	Array::Ptr vperf;
 
@@ -144,7 +419,7 @@ Value ClusterEvents::CheckResultAPIHandler(const MessageOrigin::Ptr& origin, con
 	}
 
 	if (!cr)
-		return Empty;
+		return;
 
 	Array::Ptr rperf = new Array();
 
@@ -167,7 +442,7 @@ Value ClusterEvents::CheckResultAPIHandler(const MessageOrigin::Ptr& origin, con
 	Host::Ptr host = Host::GetByName(params->Get("host"));
 
 	if (!host)
-		return Empty;
+		return;
 
 	Checkable::Ptr checkable;
 
@@ -177,20 +452,18 @@ Value ClusterEvents::CheckResultAPIHandler(const MessageOrigin::Ptr& origin, con
 		checkable = host;
 
 	if (!checkable)
-		return Empty;
+		return;
 
 	if (origin->FromZone && !origin->FromZone->CanAccessObject(checkable) && endpoint != checkable->GetCommandEndpoint()) {
 		Log(LogNotice, "ClusterEvents")
 		    << "Discarding 'check result' message from '" << origin->FromClient->GetIdentity() << "': Unauthorized access.";
-		return Empty;
+		return;
 	}
 
 	if (!checkable->IsPaused() && Zone::GetLocalZone() == checkable->GetZone() && endpoint == checkable->GetCommandEndpoint())
 		checkable->ProcessCheckResult(cr);
 	else
 		checkable->ProcessCheckResult(cr, origin);
-
-	return Empty;
 }
 
 void ClusterEvents::NextCheckChangedHandler(const Checkable::Ptr& checkable, const MessageOrigin::Ptr& origin)
@@ -231,6 +504,9 @@ Value ClusterEvents::NextCheckChangedAPIHandler(const MessageOrigin::Ptr& origin
 	if (!params)
 		return Empty;
 
+	if (QueueCheckableEvent(&ClusterEvents::NextCheckChangedAPIHandler, origin, params))
+		return Empty;
+
 	Host::Ptr host = Host::GetByName(params->Get("host"));
 
 	if (!host)
@@ -353,6 +629,9 @@ Value ClusterEvents::ForceNextCheckChangedAPIHandler(const MessageOrigin::Ptr& o
 	if (!params)
 		return Empty;
 
+	if (QueueCheckableEvent(&ClusterEvents::ForceNextCheckChangedAPIHandler, origin, params))
+		return Empty;
+
 	Host::Ptr host = Host::GetByName(params->Get("host"));
 
 	if (!host)
@@ -417,6 +696,9 @@ Value ClusterEvents::ForceNextNotificationChangedAPIHandler(const MessageOrigin:
 	if (!params)
 		return Empty;
 
+	if (QueueCheckableEvent(&ClusterEvents::ForceNextNotificationChangedAPIHandler, origin, params))
+		return Empty;
+
 	Host::Ptr host = Host::GetByName(params->Get("host"));
 
 	if (!host)
@@ -452,6 +734,8 @@ void ClusterEvents::AcknowledgementSetHandler(const Checkable::Ptr& checkable,
 	if (!listener)
 		return;
 
+	FlushCheckableCheckResults(checkable);
+
 	Host::Ptr host;
 	Service::Ptr service;
 	tie(host, service) = GetHostService(checkable);
@@ -487,6 +771,9 @@ Value ClusterEvents::AcknowledgementSetAPIHandler(const MessageOrigin::Ptr& orig
 	if (!params)
 		return Empty;
 
+	if (QueueCheckableEvent(&ClusterEvents::AcknowledgementSetAPIHandler, origin, params))
+		return Empty;
+
 	Host::Ptr host = Host::GetByName(params->Get("host"));
 
 	if (!host)
@@ -522,6 +809,8 @@ void ClusterEvents::AcknowledgementClearedHandler(const Checkable::Ptr& checkabl
 	if (!listener)
 		return;
 
+	FlushCheckableCheckResults(checkable);
+
 	Host::Ptr host;
 	Service::Ptr service;
 	tie(host, service) = GetHostService(checkable);
@@ -552,6 +841,9 @@ Value ClusterEvents::AcknowledgementClearedAPIHandler(const MessageOrigin::Ptr&
 	if (!params)
 		return Empty;
 
+	if (QueueCheckableEvent(&ClusterEvents::AcknowledgementClearedAPIHandler, origin, params))
+		return Empty;
+
 	Host::Ptr host = Host::GetByName(params->Get("host"));
 
 	if (!host)
@@ -793,6 +1085,8 @@ void ClusterEvents::SendNotificationsHandler(const Checkable::Ptr& checkable, No
 	if (!listener)
 		return;
 
+	FlushCheckableCheckResults(checkable);
+
 	Dictionary::Ptr message = MakeCheckResultMessage(checkable, cr);
 	message->Set("method", "event::SendNotifications");
 
@@ -817,6 +1111,9 @@ Value ClusterEvents::SendNotificationsAPIHandler(const MessageOrigin::Ptr& origi
 	if (!params)
 		return Empty;
 
+	if (QueueCheckableEvent(&ClusterEvents::SendNotificationsAPIHandler, origin, params))
+		return Empty;
+
 	Host::Ptr host = Host::GetByName(params->Get("host"));
 
 	if (!host)
@@ -873,6 +1170,8 @@ void ClusterEvents::NotificationSentUserHandler(const Notification::Ptr& notific
 	if (!listener)
 		return;
 
+	FlushCheckableCheckResults(checkable);
+
 	Host::Ptr host;
 	Service::Ptr service;
 	tie(host, service) = GetHostService(checkable);
@@ -910,6 +1209,9 @@ Value ClusterEvents::NotificationSentUserAPIHandler(const MessageOrigin::Ptr& or
 	if (!params)
 		return Empty;
 
+	if (QueueCheckableEvent(&ClusterEvents::NotificationSentUserAPIHandler, origin, params))
+		return Empty;
+
 	Host::Ptr host = Host::GetByName(params->Get("host"));
 
 	if (!host)
@@ -977,6 +1279,8 @@ void ClusterEvents::NotificationSentToAllUsersHandler(const Notification::Ptr& n
 	if (!listener)
 		return;
 
+	FlushCheckableCheckResults(checkable);
+
 	Host::Ptr host;
 	Service::Ptr service;
 	tie(host, service) = GetHostService(checkable);
@@ -1025,6 +1329,9 @@ Value ClusterEvents::NotificationSentToAllUsersAPIHandler(const MessageOrigin::P
 	if (!params)
 		return Empty;
 
+	if (QueueCheckableEvent(&ClusterEvents::NotificationSentToAllUsersAPIHandler, origin, params))
+		return Empty;
+
 	Host::Ptr host = Host::GetByName(params->Get("host"));
 
 	if (!host)
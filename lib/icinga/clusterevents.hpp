@@ -25,6 +25,8 @@
 #include "icinga/checkcommand.hpp"
 #include "icinga/eventcommand.hpp"
 #include "icinga/notificationcommand.hpp"
+#include "remote/messageorigin.hpp"
+#include "remote/zone.hpp"
 
 namespace icinga
 {
@@ -39,6 +41,7 @@ public:
 
 	static void CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr, const MessageOrigin::Ptr& origin);
 	static Value CheckResultAPIHandler(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params);
+	static Value CheckResultsAPIHandler(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params);
 
 	static void NextCheckChangedHandler(const Checkable::Ptr& checkable, const MessageOrigin::Ptr& origin);
 	static Value NextCheckChangedAPIHandler(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params);
@@ -67,6 +70,9 @@ public:
 
 	static Dictionary::Ptr MakeCheckResultMessage(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
 
+	static String GetCheckResultBatchKey(const Zone::Ptr& zone, const MessageOrigin::Ptr& origin);
+	static size_t GetCheckResultQueueIndex(const Dictionary::Ptr& params);
+
 	static void SendNotificationsHandler(const Checkable::Ptr& checkable, NotificationType type,
 	    const CheckResult::Ptr& cr, const String& author, const String& text, const MessageOrigin::Ptr& origin);
 	static Value SendNotificationsAPIHandler(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params);
@@ -78,6 +84,14 @@ public:
 	static void NotificationSentToAllUsersHandler(const Notification::Ptr& notification, const Checkable::Ptr& checkable, const std::set<User::Ptr>& users,
 	    NotificationType notificationType, const CheckResult::Ptr& cr, const String& author, const String& commentText, const MessageOrigin::Ptr& origin);
 	static Value NotificationSentToAllUsersAPIHandler(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params);
+
+private:
+	static Dictionary::Ptr MakeCheckResultParams(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
+	static void ProcessCheckResultParams(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params);
+
+	static void CheckResultBatchTimerHandler(void);
+	static void FlushCheckResultBatches(bool all);
+	static void FlushCheckableCheckResults(const Checkable::Ptr& checkable);
 };
 
 }
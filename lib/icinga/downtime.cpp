@@ -40,6 +40,8 @@ boost::signals2::signal<void (const Downtime::Ptr&)> Downtime::OnDowntimeAdded;
 boost::signals2::signal<void (const Downtime::Ptr&)> Downtime::OnDowntimeRemoved;
 boost::signals2::signal<void (const Downtime::Ptr&)> Downtime::OnDowntimeStarted;
 boost::signals2::signal<void (const Downtime::Ptr&)> Downtime::OnDowntimeTriggered;
+boost::signals2::signal<void (const Downtime::Ptr&)> Downtime::OnDowntimeLoaded;
+boost::signals2::signal<void (const Downtime::Ptr&)> Downtime::OnDowntimeExpired;
 
 INITIALIZE_ONCE(&Downtime::StaticInitialize);
 
@@ -129,6 +131,8 @@ void Downtime::Start(bool runtimeCreated)
 
 	if (runtimeCreated)
 		OnDowntimeAdded(this);
+	else
+		OnDowntimeLoaded(this);
 
 	/* if this object is already in a NOT-OK state trigger
 	 * this downtime now *after* it has been added (important
@@ -406,8 +410,18 @@ void Downtime::DowntimesExpireTimerHandler(void)
 	}
 
 	for (const Downtime::Ptr& downtime : downtimes) {
+		if (!downtime->IsActive())
+			continue;
+
+		bool expired = downtime->IsExpired();
+
+		/* Downtimes which aren't removed below (e.g. from config files)
+		 * stay registered, so tell listeners that they ended. */
+		if (expired)
+			OnDowntimeExpired(downtime);
+
 		/* Only remove downtimes which are activated after daemon start. */
-		if (downtime->IsActive() && (downtime->IsExpired() || !downtime->HasValidConfigOwner()))
+		if (expired || !downtime->HasValidConfigOwner())
 			RemoveDowntime(downtime->GetName(), false, true);
 	}
 }
@@ -43,6 +43,8 @@ public:
 	static boost::signals2::signal<void (const Downtime::Ptr&)> OnDowntimeRemoved;
 	static boost::signals2::signal<void (const Downtime::Ptr&)> OnDowntimeStarted;
 	static boost::signals2::signal<void (const Downtime::Ptr&)> OnDowntimeTriggered;
+	static boost::signals2::signal<void (const Downtime::Ptr&)> OnDowntimeLoaded;
+	static boost::signals2::signal<void (const Downtime::Ptr&)> OnDowntimeExpired;
 
 	intrusive_ptr<Checkable> GetCheckable(void) const;
 
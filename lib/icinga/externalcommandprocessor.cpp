@@ -37,6 +37,7 @@
 #include "base/utility.hpp"
 #include "base/exception.hpp"
 #include <fstream>
+#include <boost/functional/hash.hpp>
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
 
@@ -53,11 +54,8 @@ struct ExternalCommandInfo
 	size_t MaxArgs;
 };
 
-static boost::mutex& GetMutex(void)
-{
-	static boost::mutex mtx;
-	return mtx;
-}
+/* The command table is only modified by StaticInitialize() which runs before
+ * any other threads are started; lookups therefore don't need a lock. */
 static std::map<String, ExternalCommandInfo>& GetCommands(void)
 {
 	static std::map<String, ExternalCommandInfo> commands;
@@ -68,7 +66,6 @@ boost::signals2::signal<void (double, const String&, const std::vector<String>&)
 
 static void RegisterCommand(const String& command, const ExternalCommandCallback& callback, size_t minArgs = 0, size_t maxArgs = UINT_MAX)
 {
-	boost::mutex::scoped_lock lock(GetMutex());
 	ExternalCommandInfo eci;
 	eci.Callback = callback;
 	eci.MinArgs = minArgs;
@@ -76,54 +73,168 @@ static void RegisterCommand(const String& command, const ExternalCommandCallback
 	GetCommands()[command] = eci;
 }
 
-void ExternalCommandProcessor::Execute(const String& line)
+static const ExternalCommandInfo& LookupCommand(const String& command)
 {
-	if (line.IsEmpty())
-		return;
+	auto it = GetCommands().find(command);
 
-	if (line[0] != '[')
-		BOOST_THROW_EXCEPTION(std::invalid_argument("Missing timestamp in command: " + line));
+	if (it == GetCommands().end())
+		BOOST_THROW_EXCEPTION(std::invalid_argument("The external command '" + command + "' does not exist."));
 
-	size_t pos = line.FindFirstOf("]");
+	return it->second;
+}
 
-	if (pos == String::NPos)
-		BOOST_THROW_EXCEPTION(std::invalid_argument("Missing timestamp in command: " + line));
+static void ExecuteCommand(double time, const String& command, const ExternalCommandInfo& eci, const std::vector<String>& arguments)
+{
+	if (arguments.size() < eci.MinArgs)
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Expected " + Convert::ToString(eci.MinArgs) + " arguments"));
 
-	String timestamp = line.SubStr(1, pos - 1);
-	String args = line.SubStr(pos + 2, String::NPos);
+	ExternalCommandProcessor::OnNewExternalCommand(time, command, arguments);
 
-	double ts = Convert::ToDouble(timestamp);
+	eci.Callback(time, arguments);
+}
 
-	if (ts == 0)
-		BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid timestamp in command: " + line));
+/**
+ * Splits an external command line into its timestamp, the command name and
+ * the argument string. This does not copy any data, the result points into
+ * the specified buffer.
+ *
+ * @param line The command line, without the trailing newline.
+ * @param length The length of the command line.
+ * @param result The parsed command line.
+ */
+void ExternalCommandProcessor::ParseLine(const char *line, size_t length, ExternalCommandLine& result)
+{
+	const char *end = line + length;
 
-	std::vector<String> argv;
-	boost::algorithm::split(argv, args, boost::is_any_of(";"));
+	if (length == 0 || line[0] != '[')
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Missing timestamp in command: " + String(line, end)));
 
-	if (argv.empty())
-		BOOST_THROW_EXCEPTION(std::invalid_argument("Missing arguments in command: " + line));
+	const char *tsEnd = static_cast<const char *>(memchr(line, ']', length));
 
-	std::vector<String> argvExtra(argv.begin() + 1, argv.end());
-	Execute(ts, argv[0], argvExtra);
+	if (!tsEnd)
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Missing timestamp in command: " + String(line, end)));
+
+	char *numEnd;
+	result.Timestamp = strtod(line + 1, &numEnd);
+
+	if (numEnd != tsEnd || result.Timestamp == 0)
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid timestamp in command: " + String(line, end)));
+
+	/* The timestamp is followed by a single space. */
+	const char *command = std::min(tsEnd + 2, end);
+	const char *sep = static_cast<const char *>(memchr(command, ';', end - command));
+
+	result.Command = command;
+
+	if (sep) {
+		result.CommandLength = sep - command;
+		result.Arguments = sep + 1;
+		result.ArgumentsLength = end - (sep + 1);
+	} else {
+		result.CommandLength = end - command;
+		result.Arguments = NULL;
+		result.ArgumentsLength = 0;
+	}
+
+	if (result.CommandLength == 0)
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Missing arguments in command: " + String(line, end)));
 }
 
-void ExternalCommandProcessor::Execute(double time, const String& command, const std::vector<String>& arguments)
+/**
+ * Determines whether the command is a passive check result and calculates a
+ * key for the checkable it refers to. Commands with the same key have to be
+ * processed in order.
+ *
+ * @param line The parsed command line.
+ * @param key The checkable's key.
+ * @returns true if the command is a host or service check result, false otherwise.
+ */
+bool ExternalCommandProcessor::GetCheckResultKey(const ExternalCommandLine& line, size_t& key)
 {
-	ExternalCommandInfo eci;
+	static const char hostCommand[] = "PROCESS_HOST_CHECK_RESULT";
+	static const char serviceCommand[] = "PROCESS_SERVICE_CHECK_RESULT";
 
-	{
-		boost::mutex::scoped_lock lock(GetMutex());
+	int fields;
 
-		auto it = GetCommands().find(command);
+	if (line.CommandLength == sizeof(hostCommand) - 1 && memcmp(line.Command, hostCommand, line.CommandLength) == 0)
+		fields = 1;
+	else if (line.CommandLength == sizeof(serviceCommand) - 1 && memcmp(line.Command, serviceCommand, line.CommandLength) == 0)
+		fields = 2;
+	else
+		return false;
 
-		if (it == GetCommands().end())
-			BOOST_THROW_EXCEPTION(std::invalid_argument("The external command '" + command + "' does not exist."));
+	if (!line.Arguments)
+		return false;
 
-		eci = it->second;
+	/* The key covers the host name and - for services - the service name. */
+	const char *p = line.Arguments, *end = line.Arguments + line.ArgumentsLength;
+
+	for (int i = 0; i < fields && p < end; i++) {
+		const char *sep = static_cast<const char *>(memchr(p, ';', end - p));
+		p = sep ? sep + 1 : end;
 	}
 
-	if (arguments.size() < eci.MinArgs)
-		BOOST_THROW_EXCEPTION(std::invalid_argument("Expected " + Convert::ToString(eci.MinArgs) + " arguments"));
+	key = boost::hash_range(line.Arguments, p);
+	return true;
+}
+
+void ExternalCommandProcessor::Execute(const String& line)
+{
+	if (line.IsEmpty())
+		return;
+
+	ExternalCommandLine cl;
+	ParseLine(line.CStr(), line.GetLength(), cl);
+	Execute(cl);
+}
+
+void ExternalCommandProcessor::Execute(const ExternalCommandLine& line)
+{
+	String command;
+	std::vector<String> arguments;
+	SplitArguments(line, command, arguments);
+
+	ExecuteCommand(line.Timestamp, command, LookupCommand(command), arguments);
+}
+
+/**
+ * Copies the command name and arguments out of a parsed line so that the
+ * command can be executed after the line's buffer has been reused. At most
+ * as many fields as the command accepts are split; the last one keeps any
+ * remaining separators.
+ */
+void ExternalCommandProcessor::SplitArguments(const ExternalCommandLine& line, String& command, std::vector<String>& arguments)
+{
+	command = String(line.Command, line.Command + line.CommandLength);
+	const ExternalCommandInfo& eci = LookupCommand(command);
+
+	arguments.clear();
+
+	if (line.Arguments && eci.MaxArgs > 0) {
+		arguments.reserve(eci.MaxArgs);
+
+		const char *p = line.Arguments, *end = line.Arguments + line.ArgumentsLength;
+
+		for (;;) {
+			const char *sep = NULL;
+
+			if (arguments.size() + 1 < eci.MaxArgs)
+				sep = static_cast<const char *>(memchr(p, ';', end - p));
+
+			if (!sep) {
+				arguments.push_back(String(p, end));
+				break;
+			}
+
+			arguments.push_back(String(p, sep));
+			p = sep + 1;
+		}
+	}
+}
+
+void ExternalCommandProcessor::Execute(double time, const String& command, const std::vector<String>& arguments)
+{
+	const ExternalCommandInfo& eci = LookupCommand(command);
 
 	size_t argnum = std::min(arguments.size(), eci.MaxArgs);
 
@@ -144,9 +255,7 @@ void ExternalCommandProcessor::Execute(double time, const String& command, const
 		realArguments[argnum - 1] = last_argument;
 	}
 
-	OnNewExternalCommand(time, command, realArguments);
-
-	eci.Callback(time, realArguments);
+	ExecuteCommand(time, command, eci, realArguments);
 }
 
 void ExternalCommandProcessor::StaticInitialize(void)
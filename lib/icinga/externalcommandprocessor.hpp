@@ -30,11 +30,31 @@
 namespace icinga
 {
 
+/**
+ * An external command line which was split in place. The pointers refer to
+ * the buffer that was passed to ExternalCommandProcessor::ParseLine().
+ *
+ * @ingroup icinga
+ */
+struct ExternalCommandLine
+{
+	double Timestamp;
+	const char *Command;
+	size_t CommandLength;
+	const char *Arguments; /* NULL if the command has no arguments */
+	size_t ArgumentsLength;
+};
+
 class I2_ICINGA_API ExternalCommandProcessor {
 public:
 	static void Execute(const String& line);
+	static void Execute(const ExternalCommandLine& line);
 	static void Execute(double time, const String& command, const std::vector<String>& arguments);
 
+	static void ParseLine(const char *line, size_t length, ExternalCommandLine& result);
+	static void SplitArguments(const ExternalCommandLine& line, String& command, std::vector<String>& arguments);
+	static bool GetCheckResultKey(const ExternalCommandLine& line, size_t& key);
+
 	static void StaticInitialize(void);
 
 	static boost::signals2::signal<void(double, const String&, const std::vector<String>&)> OnNewExternalCommand;
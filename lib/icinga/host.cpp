@@ -115,21 +115,90 @@ std::vector<Service::Ptr> Host::GetServices(void) const
 
 void Host::AddService(const Service::Ptr& service)
 {
-	boost::mutex::scoped_lock lock(m_ServicesMutex);
+	Service::Ptr previous;
+
+	{
+		boost::mutex::scoped_lock lock(m_ServicesMutex);
+
+		Service::Ptr& slot = m_Services[service->GetShortName()];
+
+		if (slot == service)
+			return;
 
-	m_Services[service->GetShortName()] = service;
+		previous = slot;
+		slot = service;
+	}
+
+	if (previous)
+		previous->SetCountingHost(Host::Ptr());
+
+	service->SetCountingHost(this);
 }
 
 void Host::RemoveService(const Service::Ptr& service)
 {
-	boost::mutex::scoped_lock lock(m_ServicesMutex);
+	{
+		boost::mutex::scoped_lock lock(m_ServicesMutex);
 
-	m_Services.erase(service->GetShortName());
+		auto it = m_Services.find(service->GetShortName());
+
+		if (it == m_Services.end() || it->second != service)
+			return;
+
+		m_Services.erase(it);
+	}
+
+	service->SetCountingHost(Host::Ptr());
 }
 
 int Host::GetTotalServices(void) const
 {
-	return GetServices().size();
+	return GetServiceStateCounters().GetTotal();
+}
+
+ServiceStateCounters Host::GetServiceStateCounters(void) const
+{
+	boost::mutex::scoped_lock lock(m_ServiceStateCountersMutex);
+	return m_ServiceStateCounters;
+}
+
+/**
+ * Applies a change of one of this host's services to the host's counters,
+ * the counters of its host groups and the global counters.
+ */
+void Host::AddServiceStateCounters(const ServiceStateCounters& delta)
+{
+	boost::mutex::scoped_lock lock(m_ServiceStateCountersMutex);
+
+	m_ServiceStateCounters.Add(delta);
+
+	for (const SharedServiceStateCounters::Ptr& counters : m_GroupCounters) {
+		counters->Add(delta);
+	}
+
+	ServiceStateCounters::AddGlobal(delta);
+}
+
+/**
+ * Starts including this host's service counts in a host group's counters.
+ */
+void Host::AddGroupCounters(const SharedServiceStateCounters::Ptr& counters)
+{
+	boost::mutex::scoped_lock lock(m_ServiceStateCountersMutex);
+
+	if (m_GroupCounters.insert(counters).second)
+		counters->Add(m_ServiceStateCounters);
+}
+
+void Host::RemoveGroupCounters(const SharedServiceStateCounters::Ptr& counters)
+{
+	boost::mutex::scoped_lock lock(m_ServiceStateCountersMutex);
+
+	if (m_GroupCounters.erase(counters) > 0) {
+		ServiceStateCounters delta;
+		delta.Add(m_ServiceStateCounters, -1);
+		counters->Add(delta);
+	}
 }
 
 Service::Ptr Host::GetServiceByShortName(const Value& name)
@@ -24,11 +24,13 @@
 #include "icinga/host.thpp"
 #include "icinga/macroresolver.hpp"
 #include "icinga/checkresult.hpp"
+#include "icinga/servicestatecounters.hpp"
 
 namespace icinga
 {
 
 class Service;
+class HostGroup;
 
 /**
  * An Icinga host.
@@ -49,6 +51,11 @@ public:
 
 	int GetTotalServices(void) const;
 
+	ServiceStateCounters GetServiceStateCounters(void) const;
+	void AddServiceStateCounters(const ServiceStateCounters& delta);
+	void AddGroupCounters(const SharedServiceStateCounters::Ptr& counters);
+	void RemoveGroupCounters(const SharedServiceStateCounters::Ptr& counters);
+
 	static HostState CalculateState(ServiceState state);
 
 	virtual HostState GetState(void) const override;
@@ -76,6 +83,10 @@ private:
 	mutable boost::mutex m_ServicesMutex;
 	std::map<String, intrusive_ptr<Service> > m_Services;
 
+	mutable boost::mutex m_ServiceStateCountersMutex;
+	ServiceStateCounters m_ServiceStateCounters;
+	std::set<SharedServiceStateCounters::Ptr> m_GroupCounters;
+
 	static void RefreshServicesCache(void);
 };
 
@@ -31,6 +31,10 @@ using namespace icinga;
 
 REGISTER_TYPE(HostGroup);
 
+HostGroup::HostGroup(void)
+	: m_ServiceStateCounters(new SharedServiceStateCounters())
+{ }
+
 INITIALIZE_ONCE([]() {
 	ObjectRule::RegisterType("HostGroup");
 });
@@ -81,14 +85,27 @@ void HostGroup::AddMember(const Host::Ptr& host)
 {
 	host->AddGroup(GetName());
 
-	boost::mutex::scoped_lock lock(m_HostGroupMutex);
-	m_Members.insert(host);
+	{
+		boost::mutex::scoped_lock lock(m_HostGroupMutex);
+		m_Members.insert(host);
+	}
+
+	host->AddGroupCounters(m_ServiceStateCounters);
 }
 
 void HostGroup::RemoveMember(const Host::Ptr& host)
 {
-	boost::mutex::scoped_lock lock(m_HostGroupMutex);
-	m_Members.erase(host);
+	{
+		boost::mutex::scoped_lock lock(m_HostGroupMutex);
+		m_Members.erase(host);
+	}
+
+	host->RemoveGroupCounters(m_ServiceStateCounters);
+}
+
+ServiceStateCounters HostGroup::GetServiceStateCounters(void) const
+{
+	return m_ServiceStateCounters->Get();
 }
 
 bool HostGroup::ResolveGroupMembership(const Host::Ptr& host, bool add, int rstack) {
@@ -40,17 +40,22 @@ public:
 	DECLARE_OBJECT(HostGroup);
 	DECLARE_OBJECTNAME(HostGroup);
 
+	HostGroup(void);
+
 	std::set<Host::Ptr> GetMembers(void) const;
 	void AddMember(const Host::Ptr& host);
 	void RemoveMember(const Host::Ptr& host);
 
 	bool ResolveGroupMembership(const Host::Ptr& host, bool add = true, int rstack = 0);
 
+	ServiceStateCounters GetServiceStateCounters(void) const;
+
 	static void EvaluateObjectRules(const Host::Ptr& host);
 
 private:
 	mutable boost::mutex m_HostGroupMutex;
 	std::set<Host::Ptr> m_Members;
+	SharedServiceStateCounters::Ptr m_ServiceStateCounters;
 
 	static bool EvaluateObjectRule(const Host::Ptr& host, const intrusive_ptr<ConfigItem>& item);
 };
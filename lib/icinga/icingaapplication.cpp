@@ -34,6 +34,8 @@
 #include "base/initialize.hpp"
 #include "base/statsfunction.hpp"
 #include "base/loader.hpp"
+#include "base/unixsocket.hpp"
+#include "base/networkstream.hpp"
 
 using namespace icinga;
 
@@ -103,6 +105,11 @@ int IcingaApplication::Main(void)
 	l_RetentionTimer->OnTimerExpired.connect(boost::bind(&IcingaApplication::DumpProgramState, this));
 	l_RetentionTimer->Start();
 
+	/* The state was handed over in memory by the previous instance: write
+	 * the state file soon so that it is not out of date for long. */
+	if (GetReloadRequestTime() > 0)
+		l_RetentionTimer->Reschedule(Utility::GetTime() + 60);
+
 	/* restore modified attributes */
 	if (Utility::PathExists(GetModAttrPath())) {
 		Expression *expression = ConfigCompiler::CompileFile(GetModAttrPath());
@@ -133,9 +140,49 @@ void IcingaApplication::OnShutdown(void)
 		l_RetentionTimer->Stop();
 	}
 
+#ifndef _WIN32
+	if (IsHandoverRequested()) {
+		try {
+			HandOverProgramState();
+			DumpModifiedAttributes();
+			return;
+		} catch (const std::exception& ex) {
+			Log(LogWarning, "IcingaApplication")
+			    << "Could not hand over program state to the new instance, writing the state file instead: "
+			    << DiagnosticInformation(ex, false);
+		}
+	}
+#endif /* _WIN32 */
+
 	DumpProgramState();
 }
 
+#ifndef _WIN32
+/**
+ * Sends the program state to the reload process which is waiting
+ * for it on the handover socket.
+ */
+void IcingaApplication::HandOverProgramState(void)
+{
+	String path = GetHandoverPath();
+
+	Log(LogInformation, "IcingaApplication")
+	    << "Handing over program state to the new instance via '" << path << "'";
+
+	double start = Utility::GetTime();
+
+	UnixSocket::Ptr socket = new UnixSocket();
+	socket->Connect(path);
+
+	NetworkStream::Ptr stream = new NetworkStream(socket);
+	ConfigObject::DumpObjects(stream);
+	stream->Close();
+
+	Log(LogInformation, "IcingaApplication")
+	    << "Handed over program state in " << Utility::GetTime() - start << " seconds.";
+}
+#endif /* _WIN32 */
+
 static void PersistModAttrHelper(std::fstream& fp, ConfigObject::Ptr& previousObject, const ConfigObject::Ptr& object, const String& attr, const Value& value)
 {
 	if (object != previousObject) {
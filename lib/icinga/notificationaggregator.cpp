@@ -0,0 +1,258 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "icinga/notificationaggregator.hpp"
+#include "base/timer.hpp"
+#include "base/logger.hpp"
+#include "base/utility.hpp"
+#include "base/exception.hpp"
+#include <boost/thread/mutex.hpp>
+#include <deque>
+#include <map>
+
+using namespace icinga;
+
+/* Aggregated invocations pass a summary line per notification as a macro value.
+ * This keeps that value well below the per-argument size limit of exec(). */
+static const size_t l_MaxBatchSize = 100;
+
+struct AggregationBatch
+{
+	std::vector<PendingNotification> Notifications;
+	NotificationAggregator::FlushCallback Callback;
+	double Deadline;
+};
+
+static boost::mutex l_AggregatorMutex;
+static std::map<String, AggregationBatch> l_Batches;
+static std::map<String, double> l_RecentCommandLines;
+static std::multimap<double, String> l_RecentCommandLineExpiry;
+static std::map<String, std::deque<double> > l_Invocations;
+static Timer::Ptr l_FlushTimer;
+static unsigned long l_Aggregated = 0;
+static unsigned long l_Suppressed = 0;
+static unsigned long l_Executed = 0;
+
+static void RunCallback(const AggregationBatch& batch)
+{
+	try {
+		batch.Callback(batch.Notifications);
+	} catch (const std::exception& ex) {
+		Log(LogWarning, "NotificationAggregator")
+		    << "Exception occured while sending aggregated notifications: " << DiagnosticInformation(ex);
+	}
+}
+
+/**
+ * Queues a notification for an aggregated invocation of its command.
+ *
+ * Only problem notifications are aggregated. Any other notification type
+ * first sends the pending problem notifications for the same user so that
+ * e.g. a recovery can't overtake the problem it belongs to.
+ *
+ * @param command The notification command.
+ * @param pn The notification.
+ * @param callback The function which sends the aggregated notifications.
+ * @returns true if the notification was queued, false if the caller has to
+ * send it right away.
+ */
+bool NotificationAggregator::Enqueue(const NotificationCommand::Ptr& command, const PendingNotification& pn,
+    const FlushCallback& callback)
+{
+	double window = command->GetAggregationWindow();
+
+	if (window <= 0)
+		return false;
+
+	String key = command->GetName() + "\n" + pn.UserObject->GetName();
+
+	if (pn.Type != NotificationProblem) {
+		AggregationBatch batch;
+
+		{
+			boost::mutex::scoped_lock lock(l_AggregatorMutex);
+
+			std::map<String, AggregationBatch>::iterator it = l_Batches.find(key);
+
+			if (it == l_Batches.end())
+				return false;
+
+			batch = it->second;
+			l_Batches.erase(it);
+			l_Aggregated += batch.Notifications.size() - 1;
+		}
+
+		RunCallback(batch);
+
+		return false;
+	}
+
+	bool flush;
+
+	{
+		boost::mutex::scoped_lock lock(l_AggregatorMutex);
+
+		if (!l_FlushTimer) {
+			l_FlushTimer = new Timer();
+			l_FlushTimer->SetInterval(0.5);
+			l_FlushTimer->OnTimerExpired.connect(boost::bind(&NotificationAggregator::FlushTimerHandler));
+			l_FlushTimer->Start();
+		}
+
+		std::map<String, AggregationBatch>::iterator it = l_Batches.find(key);
+
+		if (it == l_Batches.end()) {
+			AggregationBatch batch;
+			batch.Callback = callback;
+			batch.Deadline = Utility::GetTime() + window;
+			it = l_Batches.insert(std::make_pair(key, batch)).first;
+		}
+
+		it->second.Notifications.push_back(pn);
+
+		flush = (it->second.Notifications.size() >= l_MaxBatchSize);
+	}
+
+	if (flush)
+		Flush(false);
+
+	return true;
+}
+
+/**
+ * Decides whether a notification command line should be executed. Command
+ * lines which were already executed within the command's aggregation window
+ * are skipped, as are invocations which exceed the command's rate limit.
+ *
+ * @param command The notification command.
+ * @param commandLine A string which identifies the rendered command line,
+ * or an empty string if identical command lines shouldn't be skipped.
+ * @param now The current time, -1 for Utility::GetTime().
+ * @returns true if the command should be executed, false otherwise.
+ */
+bool NotificationAggregator::ShouldExecute(const NotificationCommand::Ptr& command, const String& commandLine, double now)
+{
+	if (now < 0)
+		now = Utility::GetTime();
+
+	double window = command->GetAggregationWindow();
+	int rateLimit = command->GetRateLimit();
+	String key = command->GetName() + "\n" + commandLine;
+
+	boost::mutex::scoped_lock lock(l_AggregatorMutex);
+
+	if (window > 0 && !commandLine.IsEmpty()) {
+		/* l_RecentCommandLineExpiry is ordered by deadline so only the
+		 * expired command lines have to be looked at. */
+		while (!l_RecentCommandLineExpiry.empty() && l_RecentCommandLineExpiry.begin()->first <= now) {
+			std::multimap<double, String>::iterator eit = l_RecentCommandLineExpiry.begin();
+			std::map<String, double>::iterator it = l_RecentCommandLines.find(eit->second);
+
+			if (it != l_RecentCommandLines.end() && it->second == eit->first)
+				l_RecentCommandLines.erase(it);
+
+			l_RecentCommandLineExpiry.erase(eit);
+		}
+
+		if (l_RecentCommandLines.find(key) != l_RecentCommandLines.end()) {
+			l_Aggregated++;
+			return false;
+		}
+	}
+
+	if (rateLimit > 0) {
+		std::deque<double>& invocations = l_Invocations[command->GetName()];
+
+		while (!invocations.empty() && invocations.front() <= now - 60)
+			invocations.pop_front();
+
+		if (invocations.size() >= static_cast<size_t>(rateLimit)) {
+			l_Suppressed++;
+
+			Log(LogWarning, "NotificationAggregator")
+			    << "Not executing notification command '" << command->GetName()
+			    << "': rate limit of " << rateLimit << " invocations per minute exceeded.";
+
+			return false;
+		}
+
+		invocations.push_back(now);
+	}
+
+	if (window > 0 && !commandLine.IsEmpty()) {
+		l_RecentCommandLines[key] = now + window;
+		l_RecentCommandLineExpiry.insert(std::make_pair(now + window, key));
+	}
+
+	l_Executed++;
+
+	return true;
+}
+
+void NotificationAggregator::FlushTimerHandler(void)
+{
+	Flush(false);
+}
+
+/**
+ * Sends pending notifications whose aggregation window has expired or
+ * which have reached the maximum batch size.
+ *
+ * @param all Whether to send all pending notifications regardless of their age
+ */
+void NotificationAggregator::Flush(bool all)
+{
+	std::vector<AggregationBatch> batches;
+
+	{
+		boost::mutex::scoped_lock lock(l_AggregatorMutex);
+
+		double now = Utility::GetTime();
+
+		for (std::map<String, AggregationBatch>::iterator it = l_Batches.begin(); it != l_Batches.end(); ) {
+			if (all || it->second.Deadline <= now || it->second.Notifications.size() >= l_MaxBatchSize) {
+				l_Aggregated += it->second.Notifications.size() - 1;
+				batches.push_back(it->second);
+				l_Batches.erase(it++);
+			} else
+				++it;
+		}
+	}
+
+	for (const AggregationBatch& batch : batches)
+		RunCallback(batch);
+}
+
+Dictionary::Ptr NotificationAggregator::GetStats(void)
+{
+	boost::mutex::scoped_lock lock(l_AggregatorMutex);
+
+	size_t pending = 0;
+
+	typedef std::pair<String, AggregationBatch> kv_pair;
+	for (const kv_pair& kv : l_Batches)
+		pending += kv.second.Notifications.size();
+
+	Dictionary::Ptr stats = new Dictionary();
+	stats->Set("executed", l_Executed);
+	stats->Set("aggregated", l_Aggregated);
+	stats->Set("suppressed", l_Suppressed);
+	stats->Set("pending", pending);
+	return stats;
+}
@@ -0,0 +1,78 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#ifndef NOTIFICATIONAGGREGATOR_H
+#define NOTIFICATIONAGGREGATOR_H
+
+#include "icinga/i2-icinga.hpp"
+#include "icinga/notificationcommand.hpp"
+#include "base/dictionary.hpp"
+#include <boost/function.hpp>
+#include <vector>
+
+namespace icinga
+{
+
+/**
+ * A notification which is waiting to be sent as part of an aggregated
+ * command invocation.
+ *
+ * @ingroup icinga
+ */
+struct PendingNotification
+{
+	intrusive_ptr<Notification> NotificationObject;
+	User::Ptr UserObject;
+	CheckResult::Ptr CR;
+	NotificationType Type;
+	String Author;
+	String Comment;
+};
+
+/**
+ * Combines notifications which share a notification command: problem
+ * notifications for the same user are collected for the command's
+ * aggregation window and sent with a single invocation, identical command
+ * lines within the window are only executed once, and the number of
+ * invocations per minute is limited to the command's rate limit.
+ *
+ * @ingroup icinga
+ */
+class I2_ICINGA_API NotificationAggregator
+{
+public:
+	typedef boost::function<void (const std::vector<PendingNotification>&)> FlushCallback;
+
+	static bool Enqueue(const NotificationCommand::Ptr& command, const PendingNotification& pn,
+	    const FlushCallback& callback);
+	static bool ShouldExecute(const NotificationCommand::Ptr& command, const String& commandLine,
+	    double now = -1);
+	static void Flush(bool all);
+
+	static Dictionary::Ptr GetStats(void);
+
+private:
+	NotificationAggregator(void);
+
+	static void FlushTimerHandler(void);
+};
+
+}
+
+#endif /* NOTIFICATIONAGGREGATOR_H */
@@ -19,6 +19,7 @@
 
 #include "icinga/notificationcommand.hpp"
 #include "icinga/notificationcommand.tcpp"
+#include <boost/assign/list_of.hpp>
 
 using namespace icinga;
 
@@ -40,3 +41,19 @@ Dictionary::Ptr NotificationCommand::Execute(const Notification::Ptr& notificati
 	arguments.push_back(useResolvedMacros);
 	return GetExecute()->Invoke(arguments);
 }
+
+void NotificationCommand::ValidateAggregationWindow(double value, const ValidationUtils& utils)
+{
+	ObjectImpl<NotificationCommand>::ValidateAggregationWindow(value, utils);
+
+	if (value < 0)
+		BOOST_THROW_EXCEPTION(ValidationError(this, boost::assign::list_of("aggregation_window"), "Aggregation window must not be negative."));
+}
+
+void NotificationCommand::ValidateRateLimit(int value, const ValidationUtils& utils)
+{
+	ObjectImpl<NotificationCommand>::ValidateRateLimit(value, utils);
+
+	if (value < 0)
+		BOOST_THROW_EXCEPTION(ValidationError(this, boost::assign::list_of("rate_limit"), "Rate limit must not be negative."));
+}
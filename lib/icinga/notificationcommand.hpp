@@ -44,6 +44,9 @@ public:
 	    const String& author, const String& comment,
 	    const Dictionary::Ptr& resolvedMacros = Dictionary::Ptr(),
 	    bool useResolvedMacros = false);
+
+	virtual void ValidateAggregationWindow(double value, const ValidationUtils& utils) override;
+	virtual void ValidateRateLimit(int value, const ValidationUtils& utils) override;
 };
 
 }
@@ -35,7 +35,8 @@ using namespace icinga;
 void PluginUtility::ExecuteCommand(const Command::Ptr& commandObj, const Checkable::Ptr& checkable,
     const CheckResult::Ptr& cr, const MacroProcessor::ResolverList& macroResolvers,
     const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros,
-    const boost::function<void(const Value& commandLine, const ProcessResult&)>& callback)
+    const boost::function<void(const Value& commandLine, const ProcessResult&)>& callback,
+    const Array::Ptr& extraArguments)
 {
 	Value raw_command = commandObj->GetCommandLine();
 	Dictionary::Ptr raw_arguments = commandObj->GetArguments();
@@ -63,6 +64,23 @@ void PluginUtility::ExecuteCommand(const Command::Ptr& commandObj, const Checkab
 		return;
 	}
 
+	/* batch commands receive their targets as additional arguments */
+	if (extraArguments) {
+		if (command.IsObjectType<Array>()) {
+			Array::Ptr args = static_cast<Array::Ptr>(command)->ShallowClone();
+			extraArguments->CopyTo(args);
+			command = args;
+		} else {
+			String commandLine = command;
+
+			ObjectLock olock(extraArguments);
+			for (const String& arg : extraArguments)
+				commandLine += " " + Utility::EscapeShellArg(arg);
+
+			command = commandLine;
+		}
+	}
+
 	Dictionary::Ptr envMacros = new Dictionary();
 
 	Dictionary::Ptr env = commandObj->GetEnv();
@@ -98,6 +116,58 @@ void PluginUtility::ExecuteCommand(const Command::Ptr& commandObj, const Checkab
 	process->Run(boost::bind(callback, command, _1));
 }
 
+/**
+ * Splits the output of a batch command into the results for the individual
+ * targets. Each result is a single line of the form
+ *
+ *   <target> TAB <exit status> TAB <plugin output>
+ *
+ * where the plugin output may contain escaped line breaks (\n) and
+ * backslashes (\\). Lines which do not match are ignored; if there is
+ * more than one result for a target the last one wins.
+ */
+std::map<String, std::pair<int, String> > PluginUtility::ParseBatchOutput(const String& output)
+{
+	std::map<String, std::pair<int, String> > results;
+
+	std::vector<String> lines;
+	boost::algorithm::split(lines, output, boost::is_any_of("\r\n"));
+
+	for (const String& line : lines) {
+		size_t first = line.FindFirstOf('\t');
+
+		if (first == String::NPos || first == 0)
+			continue;
+
+		size_t second = line.FindFirstOf('\t', first + 1);
+
+		if (second == String::NPos)
+			continue;
+
+		String exitStatus = line.SubStr(first + 1, second - first - 1);
+
+		if (exitStatus.IsEmpty() || exitStatus.FindFirstNotOf("0123456789") != String::NPos)
+			continue;
+
+		String text;
+		bool escaped = false;
+
+		for (String::ConstIterator it = line.Begin() + second + 1; it != line.End(); it++) {
+			if (escaped) {
+				text += (*it == 'n') ? '\n' : *it;
+				escaped = false;
+			} else if (*it == '\\')
+				escaped = true;
+			else
+				text += *it;
+		}
+
+		results[line.SubStr(0, first)] = std::make_pair(Convert::ToLong(exitStatus), text);
+	}
+
+	return results;
+}
+
 ServiceState PluginUtility::ExitStatusToState(int exitStatus)
 {
 	switch (exitStatus) {
@@ -25,6 +25,7 @@
 #include "icinga/checkcommand.hpp"
 #include "icinga/macroprocessor.hpp"
 #include <vector>
+#include <map>
 
 namespace icinga
 {
@@ -42,10 +43,12 @@ public:
 	static void ExecuteCommand(const Command::Ptr& commandObj, const Checkable::Ptr& checkable,
 	    const CheckResult::Ptr& cr, const MacroProcessor::ResolverList& macroResolvers,
 	    const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros,
-	    const boost::function<void(const Value& commandLine, const ProcessResult&)>& callback = boost::function<void(const Value& commandLine, const ProcessResult&)>());
+	    const boost::function<void(const Value& commandLine, const ProcessResult&)>& callback = boost::function<void(const Value& commandLine, const ProcessResult&)>(),
+	    const Array::Ptr& extraArguments = Array::Ptr());
 
 	static ServiceState ExitStatusToState(int exitStatus);
 	static std::pair<String, String> ParseCheckOutput(const String& output);
+	static std::map<String, std::pair<int, String> > ParseBatchOutput(const String& output);
 
 	static Array::Ptr SplitPerfdata(const String& perfdata);
 	static String FormatPerfdata(const Array::Ptr& perfdata);
@@ -20,6 +20,8 @@
 #include "icinga/service.hpp"
 #include "icinga/service.tcpp"
 #include "icinga/servicegroup.hpp"
+#include "icinga/hostgroup.hpp"
+#include "icinga/downtime.hpp"
 #include "icinga/scheduleddowntime.hpp"
 #include "icinga/pluginutility.hpp"
 #include "base/objectlock.hpp"
@@ -31,6 +33,23 @@
 using namespace icinga;
 
 REGISTER_TYPE(Service);
+INITIALIZE_ONCE(&Service::StaticInitialize);
+
+void Service::StaticInitialize(void)
+{
+	Checkable::OnNewCheckResult.connect(boost::bind(&Service::StateCountersHandler, _1));
+	Checkable::OnStateChange.connect(boost::bind(&Service::StateCountersHandler, _1));
+	Checkable::OnAcknowledgementSet.connect(boost::bind(&Service::StateCountersHandler, _1));
+	Checkable::OnAcknowledgementCleared.connect(boost::bind(&Service::StateCountersHandler, _1));
+	Checkable::OnFlappingChanged.connect(boost::bind(&Service::StateCountersHandler, _1));
+	Checkable::OnReachabilityChanged.connect(boost::bind(&Service::ReachabilityCountersHandler, _3));
+	Downtime::OnDowntimeAdded.connect(boost::bind(&Service::DowntimeCountersHandler, _1));
+	Downtime::OnDowntimeLoaded.connect(boost::bind(&Service::DowntimeCountersHandler, _1));
+	Downtime::OnDowntimeStarted.connect(boost::bind(&Service::DowntimeCountersHandler, _1));
+	Downtime::OnDowntimeTriggered.connect(boost::bind(&Service::DowntimeCountersHandler, _1));
+	Downtime::OnDowntimeRemoved.connect(boost::bind(&Service::DowntimeCountersHandler, _1));
+	Downtime::OnDowntimeExpired.connect(boost::bind(&Service::DowntimeCountersHandler, _1));
+}
 
 String ServiceNameComposer::MakeName(const String& shortName, const Object::Ptr& context) const
 {
@@ -72,6 +91,8 @@ void Service::OnAllConfigLoaded(void)
 
 	m_Host = Host::GetByName(GetHostName());
 
+	UpdateStateCounters();
+
 	if (m_Host)
 		m_Host->AddService(this);
 
@@ -93,6 +114,174 @@ void Service::OnAllConfigLoaded(void)
 	}
 }
 
+void Service::Start(bool runtimeCreated)
+{
+	ObjectImpl<Service>::Start(runtimeCreated);
+
+	/* pick up the state which was restored from the state file */
+	UpdateStateCounters();
+}
+
+void Service::Stop(bool runtimeRemoved)
+{
+	ObjectImpl<Service>::Stop(runtimeRemoved);
+
+	Array::Ptr groups = GetGroups();
+
+	if (groups) {
+		groups = groups->ShallowClone();
+
+		ObjectLock olock(groups);
+
+		for (const String& name : groups) {
+			ServiceGroup::Ptr sg = ServiceGroup::GetByName(name);
+
+			if (sg)
+				sg->ResolveGroupMembership(this, false);
+		}
+	}
+
+	/* remove the service's counts from whatever counters still include it */
+	std::set<SharedServiceStateCounters::Ptr> groupCounters;
+
+	{
+		boost::mutex::scoped_lock lock(m_StateCountersMutex);
+		groupCounters.swap(m_GroupCounters);
+
+		ServiceStateCounters delta;
+		delta.Add(m_StateSnapshot, -1);
+
+		for (const SharedServiceStateCounters::Ptr& counters : groupCounters) {
+			counters->Add(delta);
+		}
+	}
+
+	if (m_Host)
+		m_Host->RemoveService(this);
+
+	SetCountingHost(Host::Ptr());
+}
+
+/**
+ * Determines the parts of the service's current state which are tracked
+ * by the service state counters.
+ */
+ServiceStateSnapshot Service::GetStateSnapshot(void)
+{
+	ServiceStateSnapshot snapshot;
+
+	snapshot.State = GetState();
+	snapshot.Type = GetStateType();
+	snapshot.Pending = !GetLastCheckResult();
+	snapshot.Acknowledged = IsAcknowledged();
+	snapshot.InDowntime = IsInDowntime();
+	snapshot.Flapping = IsFlapping();
+	snapshot.Reachable = IsReachable();
+
+	return snapshot;
+}
+
+/**
+ * Refreshes the service's snapshot and applies the difference to the
+ * counters of its host and its groups.
+ */
+void Service::UpdateStateCounters(void)
+{
+	/* determine the state before taking the counter lock: checking
+	 * for acknowledgements may clear expired ones and re-enter this
+	 * function through OnAcknowledgementCleared */
+	ServiceStateSnapshot snapshot = GetStateSnapshot();
+
+	boost::mutex::scoped_lock lock(m_StateCountersMutex);
+
+	ServiceStateCounters delta;
+	delta.Add(snapshot);
+	delta.Add(m_StateSnapshot, -1);
+
+	m_StateSnapshot = snapshot;
+
+	if (delta.IsEmpty())
+		return;
+
+	for (const SharedServiceStateCounters::Ptr& counters : m_GroupCounters) {
+		counters->Add(delta);
+	}
+
+	if (m_CountingHost)
+		m_CountingHost->AddServiceStateCounters(delta);
+}
+
+/**
+ * Sets the host whose counters include this service. Called by the host
+ * when the service is added to or removed from it.
+ */
+void Service::SetCountingHost(const Host::Ptr& host)
+{
+	boost::mutex::scoped_lock lock(m_StateCountersMutex);
+
+	if (m_CountingHost == host)
+		return;
+
+	if (m_CountingHost) {
+		ServiceStateCounters delta;
+		delta.Add(m_StateSnapshot, -1);
+		m_CountingHost->AddServiceStateCounters(delta);
+	}
+
+	m_CountingHost = host;
+
+	if (m_CountingHost) {
+		ServiceStateCounters delta;
+		delta.Add(m_StateSnapshot);
+		m_CountingHost->AddServiceStateCounters(delta);
+	}
+}
+
+/**
+ * Starts including this service in a service group's counters.
+ */
+void Service::AddGroupCounters(const SharedServiceStateCounters::Ptr& counters)
+{
+	boost::mutex::scoped_lock lock(m_StateCountersMutex);
+
+	if (m_GroupCounters.insert(counters).second) {
+		ServiceStateCounters delta;
+		delta.Add(m_StateSnapshot);
+		counters->Add(delta);
+	}
+}
+
+void Service::RemoveGroupCounters(const SharedServiceStateCounters::Ptr& counters)
+{
+	boost::mutex::scoped_lock lock(m_StateCountersMutex);
+
+	if (m_GroupCounters.erase(counters) > 0) {
+		ServiceStateCounters delta;
+		delta.Add(m_StateSnapshot, -1);
+		counters->Add(delta);
+	}
+}
+
+void Service::StateCountersHandler(const Checkable::Ptr& checkable)
+{
+	Service::Ptr service = dynamic_pointer_cast<Service>(checkable);
+
+	if (service)
+		service->UpdateStateCounters();
+}
+
+void Service::ReachabilityCountersHandler(const std::set<Checkable::Ptr>& children)
+{
+	for (const Checkable::Ptr& child : children) {
+		StateCountersHandler(child);
+	}
+}
+
+void Service::DowntimeCountersHandler(const Downtime::Ptr& downtime)
+{
+	StateCountersHandler(downtime->GetCheckable());
+}
+
 void Service::CreateChildObjects(const Type::Ptr& childType)
 {
 	if (childType == ScheduledDowntime::TypeInstance)
@@ -28,6 +28,9 @@
 namespace icinga
 {
 
+class ServiceGroup;
+class Downtime;
+
 /**
  * An Icinga service.
  *
@@ -56,13 +59,32 @@ public:
 
 	static void EvaluateApplyRules(const Host::Ptr& host);
 
+	ServiceStateSnapshot GetStateSnapshot(void);
+	void UpdateStateCounters(void);
+	void SetCountingHost(const Host::Ptr& host);
+	void AddGroupCounters(const SharedServiceStateCounters::Ptr& counters);
+	void RemoveGroupCounters(const SharedServiceStateCounters::Ptr& counters);
+
+	static void StaticInitialize(void);
+
 protected:
+	virtual void Start(bool runtimeCreated) override;
+	virtual void Stop(bool runtimeRemoved) override;
 	virtual void OnAllConfigLoaded(void) override;
 	virtual void CreateChildObjects(const Type::Ptr& childType) override;
 
 private:
 	Host::Ptr m_Host;
 
+	mutable boost::mutex m_StateCountersMutex;
+	ServiceStateSnapshot m_StateSnapshot;
+	Host::Ptr m_CountingHost;
+	std::set<SharedServiceStateCounters::Ptr> m_GroupCounters;
+
+	static void StateCountersHandler(const Checkable::Ptr& checkable);
+	static void ReachabilityCountersHandler(const std::set<Checkable::Ptr>& children);
+	static void DowntimeCountersHandler(const intrusive_ptr<Downtime>& downtime);
+
 	static bool EvaluateApplyRuleInstance(const Host::Ptr& host, const String& name, ScriptFrame& frame, const ApplyRule& rule);
 	static bool EvaluateApplyRule(const Host::Ptr& host, const ApplyRule& rule);
 };
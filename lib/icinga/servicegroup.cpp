@@ -31,6 +31,10 @@ using namespace icinga;
 
 REGISTER_TYPE(ServiceGroup);
 
+ServiceGroup::ServiceGroup(void)
+	: m_ServiceStateCounters(new SharedServiceStateCounters())
+{ }
+
 INITIALIZE_ONCE([]() {
 	ObjectRule::RegisterType("ServiceGroup");
 });
@@ -84,14 +88,27 @@ void ServiceGroup::AddMember(const Service::Ptr& service)
 {
 	service->AddGroup(GetName());
 
-	boost::mutex::scoped_lock lock(m_ServiceGroupMutex);
-	m_Members.insert(service);
+	{
+		boost::mutex::scoped_lock lock(m_ServiceGroupMutex);
+		m_Members.insert(service);
+	}
+
+	service->AddGroupCounters(m_ServiceStateCounters);
 }
 
 void ServiceGroup::RemoveMember(const Service::Ptr& service)
 {
-	boost::mutex::scoped_lock lock(m_ServiceGroupMutex);
-	m_Members.erase(service);
+	{
+		boost::mutex::scoped_lock lock(m_ServiceGroupMutex);
+		m_Members.erase(service);
+	}
+
+	service->RemoveGroupCounters(m_ServiceStateCounters);
+}
+
+ServiceStateCounters ServiceGroup::GetServiceStateCounters(void) const
+{
+	return m_ServiceStateCounters->Get();
 }
 
 bool ServiceGroup::ResolveGroupMembership(const Service::Ptr& service, bool add, int rstack) {
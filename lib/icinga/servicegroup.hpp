@@ -40,17 +40,22 @@ public:
 	DECLARE_OBJECT(ServiceGroup);
 	DECLARE_OBJECTNAME(ServiceGroup);
 
+	ServiceGroup(void);
+
 	std::set<Service::Ptr> GetMembers(void) const;
 	void AddMember(const Service::Ptr& service);
 	void RemoveMember(const Service::Ptr& service);
 
 	bool ResolveGroupMembership(const Service::Ptr& service, bool add = true, int rstack = 0);
 
+	ServiceStateCounters GetServiceStateCounters(void) const;
+
 	static void EvaluateObjectRules(const Service::Ptr& service);
 
 private:
 	mutable boost::mutex m_ServiceGroupMutex;
 	std::set<Service::Ptr> m_Members;
+	SharedServiceStateCounters::Ptr m_ServiceStateCounters;
 
 	static bool EvaluateObjectRule(const Service::Ptr& service, const intrusive_ptr<ConfigItem>& group);
 };
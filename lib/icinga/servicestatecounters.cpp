@@ -0,0 +1,267 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "icinga/servicestatecounters.hpp"
+#include "icinga/hostgroup.hpp"
+#include "icinga/servicegroup.hpp"
+#include "base/configtype.hpp"
+
+using namespace icinga;
+
+ServiceStateCounters ServiceStateCounters::m_Global;
+static boost::mutex l_GlobalMutex;
+
+bool ServiceStateSnapshot::IsHandled(void) const
+{
+	return State != ServiceOK && (Acknowledged || InDowntime);
+}
+
+ServiceStateCounters::ServiceStateCounters(void)
+	: m_Total(0), m_Pending(0), m_Acknowledged(0), m_InDowntime(0),
+	  m_Handled(0), m_Flapping(0), m_Unreachable(0)
+{
+	for (int i = 0; i < 4; i++) {
+		m_States[i] = 0;
+		m_HardStates[i] = 0;
+	}
+}
+
+void ServiceStateCounters::Add(const ServiceStateSnapshot& snapshot, int count)
+{
+	m_Total += count;
+
+	if (snapshot.Pending)
+		m_Pending += count;
+
+	m_States[snapshot.State] += count;
+
+	if (snapshot.Type == StateTypeHard)
+		m_HardStates[snapshot.State] += count;
+
+	if (snapshot.Acknowledged)
+		m_Acknowledged += count;
+
+	if (snapshot.InDowntime)
+		m_InDowntime += count;
+
+	if (snapshot.IsHandled())
+		m_Handled += count;
+
+	if (snapshot.Flapping)
+		m_Flapping += count;
+
+	if (!snapshot.Reachable)
+		m_Unreachable += count;
+}
+
+void ServiceStateCounters::Add(const ServiceStateCounters& other, int count)
+{
+	m_Total += count * other.m_Total;
+	m_Pending += count * other.m_Pending;
+
+	for (int i = 0; i < 4; i++) {
+		m_States[i] += count * other.m_States[i];
+		m_HardStates[i] += count * other.m_HardStates[i];
+	}
+
+	m_Acknowledged += count * other.m_Acknowledged;
+	m_InDowntime += count * other.m_InDowntime;
+	m_Handled += count * other.m_Handled;
+	m_Flapping += count * other.m_Flapping;
+	m_Unreachable += count * other.m_Unreachable;
+}
+
+bool ServiceStateCounters::IsEmpty(void) const
+{
+	return *this == ServiceStateCounters();
+}
+
+int ServiceStateCounters::GetTotal(void) const
+{
+	return m_Total;
+}
+
+int ServiceStateCounters::GetPending(void) const
+{
+	return m_Pending;
+}
+
+int ServiceStateCounters::GetState(ServiceState state) const
+{
+	return m_States[state];
+}
+
+int ServiceStateCounters::GetHardState(ServiceState state) const
+{
+	return m_HardStates[state];
+}
+
+int ServiceStateCounters::GetAcknowledged(void) const
+{
+	return m_Acknowledged;
+}
+
+int ServiceStateCounters::GetInDowntime(void) const
+{
+	return m_InDowntime;
+}
+
+int ServiceStateCounters::GetHandled(void) const
+{
+	return m_Handled;
+}
+
+int ServiceStateCounters::GetFlapping(void) const
+{
+	return m_Flapping;
+}
+
+int ServiceStateCounters::GetUnreachable(void) const
+{
+	return m_Unreachable;
+}
+
+/**
+ * Returns the numerically highest state any of the services is in,
+ * or ServiceOK if there are no services.
+ */
+ServiceState ServiceStateCounters::GetWorstState(void) const
+{
+	for (int i = 3; i > 0; i--) {
+		if (m_States[i] > 0)
+			return static_cast<ServiceState>(i);
+	}
+
+	return ServiceOK;
+}
+
+ServiceState ServiceStateCounters::GetWorstHardState(void) const
+{
+	for (int i = 3; i > 0; i--) {
+		if (m_HardStates[i] > 0)
+			return static_cast<ServiceState>(i);
+	}
+
+	return ServiceOK;
+}
+
+bool ServiceStateCounters::operator==(const ServiceStateCounters& other) const
+{
+	for (int i = 0; i < 4; i++) {
+		if (m_States[i] != other.m_States[i] || m_HardStates[i] != other.m_HardStates[i])
+			return false;
+	}
+
+	return m_Total == other.m_Total && m_Pending == other.m_Pending &&
+	    m_Acknowledged == other.m_Acknowledged && m_InDowntime == other.m_InDowntime &&
+	    m_Handled == other.m_Handled && m_Flapping == other.m_Flapping &&
+	    m_Unreachable == other.m_Unreachable;
+}
+
+bool ServiceStateCounters::operator!=(const ServiceStateCounters& other) const
+{
+	return !(*this == other);
+}
+
+ServiceStateCounters ServiceStateCounters::GetGlobal(void)
+{
+	boost::mutex::scoped_lock lock(l_GlobalMutex);
+	return m_Global;
+}
+
+/**
+ * Adds a delta to the instance-wide counters.
+ */
+void ServiceStateCounters::AddGlobal(const ServiceStateCounters& delta)
+{
+	boost::mutex::scoped_lock lock(l_GlobalMutex);
+	m_Global.Add(delta);
+}
+
+ServiceStateCounters SharedServiceStateCounters::Get(void) const
+{
+	boost::mutex::scoped_lock lock(m_Mutex);
+	return m_Counters;
+}
+
+void SharedServiceStateCounters::Add(const ServiceStateCounters& delta)
+{
+	boost::mutex::scoped_lock lock(m_Mutex);
+	m_Counters.Add(delta);
+}
+
+/**
+ * Recalculates all counters from the current service states and compares
+ * them with the incrementally maintained ones. The result is only meaningful
+ * while no service states or group memberships are changing.
+ *
+ * @returns A description of each mismatch, empty if all counters are consistent.
+ */
+std::vector<String> ServiceStateCounters::CheckConsistency(void)
+{
+	std::map<Service::Ptr, ServiceStateSnapshot> snapshots;
+
+	for (const Service::Ptr& service : ConfigType::GetObjectsByType<Service>()) {
+		snapshots[service] = service->GetStateSnapshot();
+	}
+
+	std::vector<String> errors;
+	std::map<Host::Ptr, ServiceStateCounters> hostCounters;
+	ServiceStateCounters global;
+
+	for (const Host::Ptr& host : ConfigType::GetObjectsByType<Host>()) {
+		ServiceStateCounters& expected = hostCounters[host];
+
+		for (const Service::Ptr& service : host->GetServices()) {
+			expected.Add(snapshots[service]);
+		}
+
+		global.Add(expected);
+
+		if (host->GetServiceStateCounters() != expected)
+			errors.push_back("Service state counters for host '" + host->GetName() + "' are inconsistent.");
+	}
+
+	for (const HostGroup::Ptr& hg : ConfigType::GetObjectsByType<HostGroup>()) {
+		ServiceStateCounters expected;
+
+		for (const Host::Ptr& host : hg->GetMembers()) {
+			expected.Add(hostCounters[host]);
+		}
+
+		if (hg->GetServiceStateCounters() != expected)
+			errors.push_back("Service state counters for host group '" + hg->GetName() + "' are inconsistent.");
+	}
+
+	for (const ServiceGroup::Ptr& sg : ConfigType::GetObjectsByType<ServiceGroup>()) {
+		ServiceStateCounters expected;
+
+		for (const Service::Ptr& service : sg->GetMembers()) {
+			expected.Add(snapshots[service]);
+		}
+
+		if (sg->GetServiceStateCounters() != expected)
+			errors.push_back("Service state counters for service group '" + sg->GetName() + "' are inconsistent.");
+	}
+
+	if (GetGlobal() != global)
+		errors.push_back("Global service state counters are inconsistent.");
+
+	return errors;
+}
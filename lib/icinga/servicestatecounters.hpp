@@ -0,0 +1,128 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#ifndef SERVICESTATECOUNTERS_H
+#define SERVICESTATECOUNTERS_H
+
+#include "icinga/i2-icinga.hpp"
+#include "icinga/checkresult.hpp"
+#include <boost/thread/mutex.hpp>
+
+namespace icinga
+{
+
+/**
+ * The parts of a service's state which are tracked by ServiceStateCounters.
+ *
+ * @ingroup icinga
+ */
+struct ServiceStateSnapshot
+{
+	ServiceStateSnapshot(void)
+		: State(ServiceOK), Type(StateTypeSoft), Pending(true), Acknowledged(false),
+		  InDowntime(false), Flapping(false), Reachable(true)
+	{ }
+
+	ServiceState State;
+	StateType Type;
+	bool Pending;
+	bool Acknowledged;
+	bool InDowntime;
+	bool Flapping;
+	bool Reachable;
+
+	bool IsHandled(void) const;
+};
+
+/**
+ * Incrementally maintained service state counts for a host, a group or
+ * the whole instance.
+ *
+ * Instances are not synchronized; their owners protect them with their
+ * own mutexes.
+ *
+ * @ingroup icinga
+ */
+class I2_ICINGA_API ServiceStateCounters
+{
+public:
+	ServiceStateCounters(void);
+
+	void Add(const ServiceStateSnapshot& snapshot, int count = 1);
+	void Add(const ServiceStateCounters& other, int count = 1);
+
+	bool IsEmpty(void) const;
+
+	int GetTotal(void) const;
+	int GetPending(void) const;
+	int GetState(ServiceState state) const;
+	int GetHardState(ServiceState state) const;
+	int GetAcknowledged(void) const;
+	int GetInDowntime(void) const;
+	int GetHandled(void) const;
+	int GetFlapping(void) const;
+	int GetUnreachable(void) const;
+
+	ServiceState GetWorstState(void) const;
+	ServiceState GetWorstHardState(void) const;
+
+	bool operator==(const ServiceStateCounters& other) const;
+	bool operator!=(const ServiceStateCounters& other) const;
+
+	static ServiceStateCounters GetGlobal(void);
+	static void AddGlobal(const ServiceStateCounters& delta);
+
+	static std::vector<String> CheckConsistency(void);
+
+private:
+	int m_Total;
+	int m_Pending;
+	int m_States[4];
+	int m_HardStates[4];
+	int m_Acknowledged;
+	int m_InDowntime;
+	int m_Handled;
+	int m_Flapping;
+	int m_Unreachable;
+
+	static ServiceStateCounters m_Global;
+};
+
+/**
+ * Service state counters of a group which are referenced by its members so
+ * that they can apply their changes without looking up the group.
+ *
+ * @ingroup icinga
+ */
+class I2_ICINGA_API SharedServiceStateCounters : public Object
+{
+public:
+	DECLARE_PTR_TYPEDEFS(SharedServiceStateCounters);
+
+	ServiceStateCounters Get(void) const;
+	void Add(const ServiceStateCounters& delta);
+
+private:
+	mutable boost::mutex m_Mutex;
+	ServiceStateCounters m_Counters;
+};
+
+}
+
+#endif /* SERVICESTATECOUNTERS_H */
@@ -24,6 +24,13 @@ using namespace icinga;
 Aggregator::Aggregator(void)
 { }
 
+void Aggregator::Merge(AggregatorState& state, const AggregatorState& other) const
+{
+	state.Accumulator += other.Accumulator;
+	state.SquareSum += other.SquareSum;
+	state.Count += other.Count;
+}
+
 void Aggregator::SetFilter(const Filter::Ptr& filter)
 {
 	m_Filter = filter;
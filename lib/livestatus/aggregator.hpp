@@ -28,6 +28,26 @@ namespace icinga
 {
 
 /**
+ * Intermediate result of an aggregator for one group of rows. States for
+ * disjoint sets of rows can be merged with Aggregator::Merge.
+ *
+ * @ingroup livestatus
+ */
+struct AggregatorState
+{
+	AggregatorState(void)
+	    : Accumulator(0), SquareSum(0), Count(0)
+	{ }
+
+	double Accumulator;
+	double SquareSum;
+	double Count;
+};
+
+/**
+ * Aggregators do not hold any per-query state and may be applied to
+ * different rows from multiple threads concurrently.
+ *
  * @ingroup livestatus
  */
 class I2_LIVESTATUS_API Aggregator : public Object
@@ -35,8 +55,9 @@ class I2_LIVESTATUS_API Aggregator : public Object
 public:
 	DECLARE_PTR_TYPEDEFS(Aggregator);
 
-	virtual void Apply(const Table::Ptr& table, const Value& row) = 0;
-	virtual double GetResult(void) const = 0;
+	virtual void Apply(const Table::Ptr& table, const Value& row, AggregatorState& state) const = 0;
+	virtual void Merge(AggregatorState& state, const AggregatorState& other) const;
+	virtual double GetResult(const AggregatorState& state) const = 0;
 	void SetFilter(const Filter::Ptr& filter);
 
 protected:
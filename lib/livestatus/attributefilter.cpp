@@ -27,15 +27,13 @@
 
 using namespace icinga;
 
-AttributeFilter::AttributeFilter(const String& column, const String& op, const String& operand)
-	: m_Column(column), m_Operator(op), m_Operand(operand)
+AttributeFilter::AttributeFilter(const Table::Ptr& table, const String& column, const String& op, const String& operand)
+	: m_Column(column), m_ColumnId(table->GetColumnId(column)), m_Operator(op), m_Operand(operand)
 { }
 
 bool AttributeFilter::Apply(const Table::Ptr& table, const Value& row)
 {
-	Column column = table->GetColumn(m_Column);
-
-	Value value = column.ExtractValue(row);
+	Value value = table->GetColumn(m_ColumnId).ExtractValue(row);
 
 	if (value.IsObjectType<Array>()) {
 		Array::Ptr array = value;
@@ -35,12 +35,13 @@ class I2_LIVESTATUS_API AttributeFilter : public Filter
 public:
 	DECLARE_PTR_TYPEDEFS(AttributeFilter);
 
-	AttributeFilter(const String& column, const String& op, const String& operand);
+	AttributeFilter(const Table::Ptr& table, const String& column, const String& op, const String& operand);
 
 	virtual bool Apply(const Table::Ptr& table, const Value& row) override;
 
 protected:
 	String m_Column;
+	int m_ColumnId;
 	String m_Operator;
 	String m_Operand;
 };
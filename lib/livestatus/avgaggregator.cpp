@@ -21,21 +21,19 @@
 
 using namespace icinga;
 
-AvgAggregator::AvgAggregator(const String& attr)
-    : m_Avg(0), m_AvgCount(0), m_AvgAttr(attr)
+AvgAggregator::AvgAggregator(int column)
+    : m_AvgColumn(column)
 { }
 
-void AvgAggregator::Apply(const Table::Ptr& table, const Value& row)
+void AvgAggregator::Apply(const Table::Ptr& table, const Value& row, AggregatorState& state) const
 {
-	Column column = table->GetColumn(m_AvgAttr);
+	Value value = table->GetColumn(m_AvgColumn).ExtractValue(row);
 
-	Value value = column.ExtractValue(row);
-
-	m_Avg += value;
-	m_AvgCount++;
+	state.Accumulator += value;
+	state.Count++;
 }
 
-double AvgAggregator::GetResult(void) const
+double AvgAggregator::GetResult(const AggregatorState& state) const
 {
-	return (m_Avg / m_AvgCount);
+	return (state.Accumulator / state.Count);
 }
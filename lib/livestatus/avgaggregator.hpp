@@ -34,15 +34,13 @@ class I2_LIVESTATUS_API AvgAggregator : public Aggregator
 public:
 	DECLARE_PTR_TYPEDEFS(AvgAggregator);
 
-	AvgAggregator(const String& attr);
+	AvgAggregator(int column);
 
-	virtual void Apply(const Table::Ptr& table, const Value& row) override;
-	virtual double GetResult(void) const override;
+	virtual void Apply(const Table::Ptr& table, const Value& row, AggregatorState& state) const override;
+	virtual double GetResult(const AggregatorState& state) const override;
 
 private:
-	double m_Avg;
-	double m_AvgCount;
-	String m_AvgAttr;
+	int m_AvgColumn;
 };
 
 }
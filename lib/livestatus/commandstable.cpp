@@ -32,7 +32,7 @@ using namespace icinga;
 
 CommandsTable::CommandsTable(void)
 {
-	AddColumns(this);
+	InitializeSchema("commands", &CommandsTable::AddColumns);
 }
 
 void CommandsTable::AddColumns(Table *table, const String& prefix,
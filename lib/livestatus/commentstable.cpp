@@ -29,7 +29,7 @@ using namespace icinga;
 
 CommentsTable::CommentsTable(void)
 {
-	AddColumns(this);
+	InitializeSchema("comments", &CommentsTable::AddColumns);
 }
 
 void CommentsTable::AddColumns(Table *table, const String& prefix,
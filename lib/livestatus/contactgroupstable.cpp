@@ -25,7 +25,7 @@ using namespace icinga;
 
 ContactGroupsTable::ContactGroupsTable(void)
 {
-	AddColumns(this);
+	InitializeSchema("contactgroups", &ContactGroupsTable::AddColumns);
 }
 
 void ContactGroupsTable::AddColumns(Table *table, const String& prefix,
@@ -31,7 +31,7 @@ using namespace icinga;
 
 ContactsTable::ContactsTable(void)
 {
-	AddColumns(this);
+	InitializeSchema("contacts", &ContactsTable::AddColumns);
 }
 
 void ContactsTable::AddColumns(Table *table, const String& prefix,
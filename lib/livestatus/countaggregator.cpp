@@ -22,16 +22,15 @@
 using namespace icinga;
 
 CountAggregator::CountAggregator(void)
-    : m_Count(0)
 { }
 
-void CountAggregator::Apply(const Table::Ptr& table, const Value& row)
+void CountAggregator::Apply(const Table::Ptr& table, const Value& row, AggregatorState& state) const
 {
 	if (GetFilter()->Apply(table, row))
-		m_Count++;
+		state.Count++;
 }
 
-double CountAggregator::GetResult(void) const
+double CountAggregator::GetResult(const AggregatorState& state) const
 {
-	return m_Count;
+	return state.Count;
 }
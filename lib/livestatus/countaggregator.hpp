@@ -36,11 +36,8 @@ public:
 
 	CountAggregator(void);
 
-	virtual void Apply(const Table::Ptr& table, const Value& row) override;
-	virtual double GetResult(void) const override;
-	
-private:
-	int m_Count;
+	virtual void Apply(const Table::Ptr& table, const Value& row, AggregatorState& state) const override;
+	virtual double GetResult(const AggregatorState& state) const override;
 };
 
 }
@@ -29,7 +29,7 @@ using namespace icinga;
 
 DowntimesTable::DowntimesTable(void)
 {
-	AddColumns(this);
+	InitializeSchema("downtimes", &DowntimesTable::AddColumns);
 }
 
 void DowntimesTable::AddColumns(Table *table, const String& prefix,
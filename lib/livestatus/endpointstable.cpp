@@ -36,7 +36,7 @@ using namespace icinga;
 
 EndpointsTable::EndpointsTable(void)
 {
-	AddColumns(this);
+	InitializeSchema("endpoints", &EndpointsTable::AddColumns);
 }
 
 void EndpointsTable::AddColumns(Table *table, const String& prefix,
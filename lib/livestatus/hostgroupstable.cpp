@@ -27,7 +27,7 @@ using namespace icinga;
 
 HostGroupsTable::HostGroupsTable(void)
 {
-	AddColumns(this);
+	InitializeSchema("hostgroups", &HostGroupsTable::AddColumns);
 }
 
 void HostGroupsTable::AddColumns(Table *table, const String& prefix,
@@ -266,16 +266,7 @@ Value HostGroupsTable::NumServicesAccessor(const Value& row)
 	if (!hg)
 		return Empty;
 
-	int num_services = 0;
-
-	if (hg->GetMembers().size() == 0)
-		return 0;
-
-	for (const Host::Ptr& host : hg->GetMembers()) {
-		num_services += host->GetServices().size();
-	}
-
-	return num_services;
+	return hg->GetServiceStateCounters().GetTotal();
 }
 
 Value HostGroupsTable::WorstServiceStateAccessor(const Value& row)
@@ -285,16 +276,7 @@ Value HostGroupsTable::WorstServiceStateAccessor(const Value& row)
 	if (!hg)
 		return Empty;
 
-	Value worst_service = ServiceOK;
-
-	for (const Host::Ptr& host : hg->GetMembers()) {
-		for (const Service::Ptr& service : host->GetServices()) {
-			if (service->GetState() > worst_service)
-				worst_service = service->GetState();
-		}
-	}
-
-	return worst_service;
+	return hg->GetServiceStateCounters().GetWorstState();
 }
 
 Value HostGroupsTable::NumServicesPendingAccessor(const Value& row)
@@ -304,16 +286,7 @@ Value HostGroupsTable::NumServicesPendingAccessor(const Value& row)
 	if (!hg)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Host::Ptr& host : hg->GetMembers()) {
-		for (const Service::Ptr& service : host->GetServices()) {
-			if (!service->GetLastCheckResult())
-				num_services++;
-		}
-	}
-
-	return num_services;
+	return hg->GetServiceStateCounters().GetPending();
 }
 
 Value HostGroupsTable::NumServicesOkAccessor(const Value& row)
@@ -323,16 +296,7 @@ Value HostGroupsTable::NumServicesOkAccessor(const Value& row)
 	if (!hg)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Host::Ptr& host : hg->GetMembers()) {
-		for (const Service::Ptr& service : host->GetServices()) {
-			if (service->GetState() == ServiceOK)
-				num_services++;
-		}
-	}
-
-	return num_services;
+	return hg->GetServiceStateCounters().GetState(ServiceOK);
 }
 
 Value HostGroupsTable::NumServicesWarnAccessor(const Value& row)
@@ -342,16 +306,7 @@ Value HostGroupsTable::NumServicesWarnAccessor(const Value& row)
 	if (!hg)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Host::Ptr& host : hg->GetMembers()) {
-		for (const Service::Ptr& service : host->GetServices()) {
-			if (service->GetState() == ServiceWarning)
-				num_services++;
-		}
-	}
-
-	return num_services;
+	return hg->GetServiceStateCounters().GetState(ServiceWarning);
 }
 
 Value HostGroupsTable::NumServicesCritAccessor(const Value& row)
@@ -361,16 +316,7 @@ Value HostGroupsTable::NumServicesCritAccessor(const Value& row)
 	if (!hg)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Host::Ptr& host : hg->GetMembers()) {
-		for (const Service::Ptr& service : host->GetServices()) {
-			if (service->GetState() == ServiceCritical)
-				num_services++;
-		}
-	}
-
-	return num_services;
+	return hg->GetServiceStateCounters().GetState(ServiceCritical);
 }
 
 Value HostGroupsTable::NumServicesUnknownAccessor(const Value& row)
@@ -380,16 +326,7 @@ Value HostGroupsTable::NumServicesUnknownAccessor(const Value& row)
 	if (!hg)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Host::Ptr& host : hg->GetMembers()) {
-		for (const Service::Ptr& service : host->GetServices()) {
-			if (service->GetState() == ServiceUnknown)
-				num_services++;
-		}
-	}
-
-	return num_services;
+	return hg->GetServiceStateCounters().GetState(ServiceUnknown);
 }
 
 Value HostGroupsTable::WorstServiceHardStateAccessor(const Value& row)
@@ -399,18 +336,7 @@ Value HostGroupsTable::WorstServiceHardStateAccessor(const Value& row)
 	if (!hg)
 		return Empty;
 
-	Value worst_service = ServiceOK;
-
-	for (const Host::Ptr& host : hg->GetMembers()) {
-		for (const Service::Ptr& service : host->GetServices()) {
-			if (service->GetStateType() == StateTypeHard) {
-				if (service->GetState() > worst_service)
-					worst_service = service->GetState();
-			}
-		}
-	}
-
-	return worst_service;
+	return hg->GetServiceStateCounters().GetWorstHardState();
 }
 
 Value HostGroupsTable::NumServicesHardOkAccessor(const Value& row)
@@ -420,16 +346,7 @@ Value HostGroupsTable::NumServicesHardOkAccessor(const Value& row)
 	if (!hg)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Host::Ptr& host : hg->GetMembers()) {
-		for (const Service::Ptr& service : host->GetServices()) {
-			if (service->GetStateType() == StateTypeHard && service->GetState() == ServiceOK)
-				num_services++;
-		}
-	}
-
-	return num_services;
+	return hg->GetServiceStateCounters().GetHardState(ServiceOK);
 }
 
 Value HostGroupsTable::NumServicesHardWarnAccessor(const Value& row)
@@ -439,16 +356,7 @@ Value HostGroupsTable::NumServicesHardWarnAccessor(const Value& row)
 	if (!hg)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Host::Ptr& host : hg->GetMembers()) {
-		for (const Service::Ptr& service : host->GetServices()) {
-			if (service->GetStateType() == StateTypeHard && service->GetState() == ServiceWarning)
-				num_services++;
-		}
-	}
-
-	return num_services;
+	return hg->GetServiceStateCounters().GetHardState(ServiceWarning);
 }
 
 Value HostGroupsTable::NumServicesHardCritAccessor(const Value& row)
@@ -458,16 +366,7 @@ Value HostGroupsTable::NumServicesHardCritAccessor(const Value& row)
 	if (!hg)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Host::Ptr& host : hg->GetMembers()) {
-		for (const Service::Ptr& service : host->GetServices()) {
-			if (service->GetStateType() == StateTypeHard && service->GetState() == ServiceCritical)
-				num_services++;
-		}
-	}
-
-	return num_services;
+	return hg->GetServiceStateCounters().GetHardState(ServiceCritical);
 }
 
 Value HostGroupsTable::NumServicesHardUnknownAccessor(const Value& row)
@@ -477,14 +376,5 @@ Value HostGroupsTable::NumServicesHardUnknownAccessor(const Value& row)
 	if (!hg)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Host::Ptr& host : hg->GetMembers()) {
-		for (const Service::Ptr& service : host->GetServices()) {
-			if (service->GetStateType() == StateTypeHard && service->GetState() == ServiceUnknown)
-				num_services++;
-		}
-	}
-
-	return num_services;
+	return hg->GetServiceStateCounters().GetHardState(ServiceUnknown);
 }
@@ -42,7 +42,7 @@ using namespace icinga;
 HostsTable::HostsTable(LivestatusGroupByType type)
     :Table(type)
 {
-	AddColumns(this);
+	InitializeSchema("hosts", &HostsTable::AddColumns);
 }
 
 void HostsTable::AddColumns(Table *table, const String& prefix,
@@ -1182,14 +1182,7 @@ Value HostsTable::WorstServiceStateAccessor(const Value& row)
 	if (!host)
 		return Empty;
 
-	Value worst_service = ServiceOK;
-
-	for (const Service::Ptr& service : host->GetServices()) {
-		if (service->GetState() > worst_service)
-			worst_service = service->GetState();
-	}
-
-	return worst_service;
+	return host->GetServiceStateCounters().GetWorstState();
 }
 
 Value HostsTable::NumServicesOkAccessor(const Value& row)
@@ -1199,14 +1192,7 @@ Value HostsTable::NumServicesOkAccessor(const Value& row)
 	if (!host)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Service::Ptr& service : host->GetServices()) {
-		if (service->GetState() == ServiceOK)
-			num_services++;
-	}
-
-	return num_services;
+	return host->GetServiceStateCounters().GetState(ServiceOK);
 }
 
 Value HostsTable::NumServicesWarnAccessor(const Value& row)
@@ -1216,14 +1202,7 @@ Value HostsTable::NumServicesWarnAccessor(const Value& row)
 	if (!host)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Service::Ptr& service : host->GetServices()) {
-		if (service->GetState() == ServiceWarning)
-			num_services++;
-	}
-
-	return num_services;
+	return host->GetServiceStateCounters().GetState(ServiceWarning);
 }
 
 Value HostsTable::NumServicesCritAccessor(const Value& row)
@@ -1233,14 +1212,7 @@ Value HostsTable::NumServicesCritAccessor(const Value& row)
 	if (!host)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Service::Ptr& service : host->GetServices()) {
-		if (service->GetState() == ServiceCritical)
-			num_services++;
-	}
-
-	return num_services;
+	return host->GetServiceStateCounters().GetState(ServiceCritical);
 }
 
 Value HostsTable::NumServicesUnknownAccessor(const Value& row)
@@ -1250,14 +1222,7 @@ Value HostsTable::NumServicesUnknownAccessor(const Value& row)
 	if (!host)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Service::Ptr& service : host->GetServices()) {
-		if (service->GetState() == ServiceUnknown)
-			num_services++;
-	}
-
-	return num_services;
+	return host->GetServiceStateCounters().GetState(ServiceUnknown);
 }
 
 Value HostsTable::NumServicesPendingAccessor(const Value& row)
@@ -1267,14 +1232,7 @@ Value HostsTable::NumServicesPendingAccessor(const Value& row)
 	if (!host)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Service::Ptr& service : host->GetServices()) {
-		if (!service->GetLastCheckResult())
-			num_services++;
-	}
-
-	return num_services;
+	return host->GetServiceStateCounters().GetPending();
 }
 
 Value HostsTable::WorstServiceHardStateAccessor(const Value& row)
@@ -1284,16 +1242,7 @@ Value HostsTable::WorstServiceHardStateAccessor(const Value& row)
 	if (!host)
 		return Empty;
 
-	Value worst_service = ServiceOK;
-
-	for (const Service::Ptr& service : host->GetServices()) {
-		if (service->GetStateType() == StateTypeHard) {
-			if (service->GetState() > worst_service)
-				worst_service = service->GetState();
-		}
-	}
-
-	return worst_service;
+	return host->GetServiceStateCounters().GetWorstHardState();
 }
 
 Value HostsTable::NumServicesHardOkAccessor(const Value& row)
@@ -1303,14 +1252,7 @@ Value HostsTable::NumServicesHardOkAccessor(const Value& row)
 	if (!host)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Service::Ptr& service : host->GetServices()) {
-		if (service->GetStateType() == StateTypeHard && service->GetState() == ServiceOK)
-			num_services++;
-	}
-
-	return num_services;
+	return host->GetServiceStateCounters().GetHardState(ServiceOK);
 }
 
 Value HostsTable::NumServicesHardWarnAccessor(const Value& row)
@@ -1320,14 +1262,7 @@ Value HostsTable::NumServicesHardWarnAccessor(const Value& row)
 	if (!host)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Service::Ptr& service : host->GetServices()) {
-		if (service->GetStateType() == StateTypeHard && service->GetState() == ServiceWarning)
-			num_services++;
-	}
-
-	return num_services;
+	return host->GetServiceStateCounters().GetHardState(ServiceWarning);
 }
 
 Value HostsTable::NumServicesHardCritAccessor(const Value& row)
@@ -1337,14 +1272,7 @@ Value HostsTable::NumServicesHardCritAccessor(const Value& row)
 	if (!host)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Service::Ptr& service : host->GetServices()) {
-		if (service->GetStateType() == StateTypeHard && service->GetState() == ServiceCritical)
-			num_services++;
-	}
-
-	return num_services;
+	return host->GetServiceStateCounters().GetHardState(ServiceCritical);
 }
 
 Value HostsTable::NumServicesHardUnknownAccessor(const Value& row)
@@ -1354,14 +1282,7 @@ Value HostsTable::NumServicesHardUnknownAccessor(const Value& row)
 	if (!host)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Service::Ptr& service : host->GetServices()) {
-		if (service->GetStateType() == StateTypeHard && service->GetState() == ServiceUnknown)
-			num_services++;
-	}
-
-	return num_services;
+	return host->GetServiceStateCounters().GetHardState(ServiceUnknown);
 }
 
 Value HostsTable::HardStateAccessor(const Value& row)
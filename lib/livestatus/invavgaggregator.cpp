@@ -21,21 +21,19 @@
 
 using namespace icinga;
 
-InvAvgAggregator::InvAvgAggregator(const String& attr)
-    : m_InvAvg(0), m_InvAvgCount(0), m_InvAvgAttr(attr)
+InvAvgAggregator::InvAvgAggregator(int column)
+    : m_InvAvgColumn(column)
 { }
 
-void InvAvgAggregator::Apply(const Table::Ptr& table, const Value& row)
+void InvAvgAggregator::Apply(const Table::Ptr& table, const Value& row, AggregatorState& state) const
 {
-	Column column = table->GetColumn(m_InvAvgAttr);
+	Value value = table->GetColumn(m_InvAvgColumn).ExtractValue(row);
 
-	Value value = column.ExtractValue(row);
-
-	m_InvAvg += (1.0 / value);
-	m_InvAvgCount++;
+	state.Accumulator += (1.0 / value);
+	state.Count++;
 }
 
-double InvAvgAggregator::GetResult(void) const
+double InvAvgAggregator::GetResult(const AggregatorState& state) const
 {
-	return (m_InvAvg / m_InvAvgCount);
+	return (state.Accumulator / state.Count);
 }
@@ -34,15 +34,13 @@ class I2_LIVESTATUS_API InvAvgAggregator : public Aggregator
 public:
 	DECLARE_PTR_TYPEDEFS(InvAvgAggregator);
 
-	InvAvgAggregator(const String& attr);
+	InvAvgAggregator(int column);
 
-	virtual void Apply(const Table::Ptr& table, const Value& row) override;
-	virtual double GetResult(void) const override;
+	virtual void Apply(const Table::Ptr& table, const Value& row, AggregatorState& state) const override;
+	virtual double GetResult(const AggregatorState& state) const override;
 
 private:
-	double m_InvAvg;
-	double m_InvAvgCount;
-	String m_InvAvgAttr;
+	int m_InvAvgColumn;
 };
 
 }
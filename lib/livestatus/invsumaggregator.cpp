@@ -21,20 +21,18 @@
 
 using namespace icinga;
 
-InvSumAggregator::InvSumAggregator(const String& attr)
-    : m_InvSum(0), m_InvSumAttr(attr)
+InvSumAggregator::InvSumAggregator(int column)
+    : m_InvSumColumn(column)
 { }
 
-void InvSumAggregator::Apply(const Table::Ptr& table, const Value& row)
+void InvSumAggregator::Apply(const Table::Ptr& table, const Value& row, AggregatorState& state) const
 {
-	Column column = table->GetColumn(m_InvSumAttr);
+	Value value = table->GetColumn(m_InvSumColumn).ExtractValue(row);
 
-	Value value = column.ExtractValue(row);
-
-	m_InvSum += (1.0 / value);
+	state.Accumulator += (1.0 / value);
 }
 
-double InvSumAggregator::GetResult(void) const
+double InvSumAggregator::GetResult(const AggregatorState& state) const
 {
-	return m_InvSum;
+	return state.Accumulator;
 }
@@ -0,0 +1,313 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "livestatus/livestatusconnection.hpp"
+#include "livestatus/livestatuslistener.hpp"
+#include "base/logger.hpp"
+#include "base/utility.hpp"
+#include "base/exception.hpp"
+
+using namespace icinga;
+
+/* requests which do not fit into this buffer are rejected */
+static const size_t l_MaxRequestSize = 1024 * 1024;
+
+LivestatusConnection::LivestatusConnection(const LivestatusListener::Ptr& listener, const Socket::Ptr& socket)
+	: SocketEvents(socket, this), m_Listener(listener), m_Socket(socket), m_SendQ(new FIFO()),
+	  m_Executing(false), m_ReadEof(false), m_CloseAfterSend(false), m_Disconnected(false)
+{ }
+
+LivestatusConnection::~LivestatusConnection(void)
+{
+	SocketEvents::Unregister();
+}
+
+void LivestatusConnection::Start(void)
+{
+	boost::mutex::scoped_lock lock(m_Mutex);
+
+	ChangeEvents(POLLIN);
+}
+
+void LivestatusConnection::Disconnect(void)
+{
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+
+		if (m_Disconnected)
+			return;
+
+		m_Disconnected = true;
+		m_Queries.clear();
+	}
+
+	Log(LogNotice, "LivestatusConnection", "Client disconnected");
+
+	/* must not hold m_Mutex here: Unregister() waits for the I/O thread */
+	SocketEvents::Unregister();
+
+	m_Socket->Close();
+
+	m_Listener->RemoveConnection(this);
+}
+
+void LivestatusConnection::OnEvent(int revents)
+{
+	bool disconnect;
+
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+
+		if (m_Disconnected)
+			return;
+
+		bool ok = true;
+
+		if (revents & (POLLIN | POLLERR | POLLHUP))
+			ok = ReadInput();
+
+		if (ok && (revents & POLLOUT))
+			ok = WriteOutput();
+
+		disconnect = !ok || UpdateEvents();
+	}
+
+	if (disconnect)
+		Disconnect();
+}
+
+/**
+ * Reads everything the socket has to offer without blocking.
+ *
+ * @returns false if the connection should be dropped.
+ */
+bool LivestatusConnection::ReadInput(void)
+{
+	char buffer[64 * 1024];
+
+	for (;;) {
+		int rc = recv(m_Socket->GetFD(), buffer, sizeof(buffer), 0);
+
+		if (rc > 0) {
+			ParseInput(buffer, rc);
+
+			if (m_Buffer.GetLength() > l_MaxRequestSize) {
+				Log(LogWarning, "LivestatusConnection")
+				    << "Request exceeds " << l_MaxRequestSize << " bytes, closing connection.";
+				return false;
+			}
+
+			continue;
+		}
+
+		if (rc < 0) {
+#ifndef _WIN32
+			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+#else /* _WIN32 */
+			if (WSAGetLastError() == WSAEWOULDBLOCK)
+#endif /* _WIN32 */
+				return true;
+		}
+
+		/* EOF or error: finish the last request and answer what we have */
+		m_ReadEof = true;
+
+		if (!m_Buffer.IsEmpty()) {
+			m_Lines.push_back(m_Buffer);
+			m_Buffer.Clear();
+		}
+
+		QueueQuery();
+
+		return true;
+	}
+}
+
+/**
+ * Sends as much of the queued output as the socket accepts.
+ *
+ * @returns false if the connection should be dropped.
+ */
+bool LivestatusConnection::WriteOutput(void)
+{
+	char buffer[64 * 1024];
+
+	while (m_SendQ->GetAvailableBytes() > 0) {
+		size_t count = m_SendQ->Peek(buffer, sizeof(buffer), true);
+
+		int rc = send(m_Socket->GetFD(), buffer, count, 0);
+
+		if (rc < 0) {
+#ifndef _WIN32
+			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+#else /* _WIN32 */
+			if (WSAGetLastError() == WSAEWOULDBLOCK)
+#endif /* _WIN32 */
+				return true;
+
+			Log(LogNotice, "LivestatusConnection", "Cannot write query response to socket.");
+			return false;
+		}
+
+		m_SendQ->Read(NULL, rc, true);
+	}
+
+	return true;
+}
+
+/**
+ * Splits the input into lines. An empty line terminates a request.
+ */
+void LivestatusConnection::ParseInput(const char *buffer, size_t count)
+{
+	const char *end = buffer + count;
+
+	while (buffer < end) {
+		const char *newline = static_cast<const char *>(memchr(buffer, '\n', end - buffer));
+
+		if (!newline) {
+			m_Buffer += String(buffer, end);
+			return;
+		}
+
+		m_Buffer += String(buffer, newline);
+		buffer = newline + 1;
+
+		if (!m_Buffer.IsEmpty() && m_Buffer[m_Buffer.GetLength() - 1] == '\r')
+			m_Buffer = m_Buffer.SubStr(0, m_Buffer.GetLength() - 1);
+
+		if (m_Buffer.IsEmpty())
+			QueueQuery();
+		else
+			m_Lines.push_back(m_Buffer);
+
+		m_Buffer.Clear();
+	}
+}
+
+void LivestatusConnection::QueueQuery(void)
+{
+	if (m_Lines.empty() || m_CloseAfterSend)
+		return;
+
+	LivestatusQuery::Ptr query = new LivestatusQuery(m_Lines, m_Listener->GetCompatLogPath());
+	m_Lines.clear();
+
+	m_Queries.push_back(query);
+
+	ProcessNextQuery();
+}
+
+/**
+ * Hands the next request to the work queue. Requests of a connection are
+ * executed one at a time so that responses are sent in order.
+ */
+void LivestatusConnection::ProcessNextQuery(void)
+{
+	if (m_Executing || m_Queries.empty())
+		return;
+
+	LivestatusQuery::Ptr query = m_Queries.front();
+	m_Queries.pop_front();
+
+	m_Executing = true;
+
+	if (!m_Listener->EnqueueQuery(boost::bind(&LivestatusConnection::ExecuteQuery,
+	    LivestatusConnection::Ptr(this), query, Utility::GetTime()))) {
+		/* answering with an error is cheap enough for the I/O thread */
+		query->SetError(LivestatusErrorQuery, "Too many pending queries, please try again later.");
+
+		if (!query->Execute(m_SendQ))
+			m_CloseAfterSend = true;
+
+		m_Executing = false;
+
+		if (!m_CloseAfterSend)
+			ProcessNextQuery();
+		else
+			m_Queries.clear();
+	}
+}
+
+/**
+ * Updates the events we're interested in.
+ *
+ * @returns true if the connection is done and should be closed.
+ */
+bool LivestatusConnection::UpdateEvents(void)
+{
+	bool sending = m_SendQ->GetAvailableBytes() > 0;
+
+	if (!sending && !m_Executing) {
+		if (m_CloseAfterSend || (m_ReadEof && m_Queries.empty()))
+			return true;
+	}
+
+	int events = 0;
+
+	if (!m_ReadEof && !m_CloseAfterSend)
+		events |= POLLIN;
+
+	if (sending)
+		events |= POLLOUT;
+
+	ChangeEvents(events);
+
+	return false;
+}
+
+void LivestatusConnection::ExecuteQuery(const LivestatusQuery::Ptr& query, double received)
+{
+	FIFO::Ptr output = new FIFO();
+
+	bool keepAlive = query->Execute(output);
+
+	LivestatusListener::ReportQuery(Utility::GetTime() - received);
+
+	bool disconnect;
+
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+
+		m_Executing = false;
+
+		if (m_Disconnected)
+			return;
+
+		char buffer[64 * 1024];
+
+		while (output->GetAvailableBytes() > 0) {
+			size_t count = output->Read(buffer, sizeof(buffer), true);
+			m_SendQ->Write(buffer, count);
+		}
+
+		if (keepAlive)
+			ProcessNextQuery();
+		else {
+			m_CloseAfterSend = true;
+			m_Queries.clear();
+		}
+
+		/* try to send the response right away, POLLOUT takes care of the rest */
+		disconnect = !WriteOutput() || UpdateEvents();
+	}
+
+	if (disconnect)
+		Disconnect();
+}
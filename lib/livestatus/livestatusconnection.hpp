@@ -0,0 +1,80 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#ifndef LIVESTATUSCONNECTION_H
+#define LIVESTATUSCONNECTION_H
+
+#include "livestatus/i2-livestatus.hpp"
+#include "livestatus/livestatusquery.hpp"
+#include "base/socket.hpp"
+#include "base/socketevents.hpp"
+#include "base/fifo.hpp"
+#include <deque>
+
+namespace icinga
+{
+
+class LivestatusListener;
+
+/**
+ * A Livestatus client connection. Requests are read and parsed by the
+ * socket event engine, queries are executed on the listener's work queue.
+ *
+ * @ingroup livestatus
+ */
+class I2_LIVESTATUS_API LivestatusConnection : public Object, private SocketEvents
+{
+public:
+	DECLARE_PTR_TYPEDEFS(LivestatusConnection);
+
+	LivestatusConnection(const intrusive_ptr<LivestatusListener>& listener, const Socket::Ptr& socket);
+	~LivestatusConnection(void);
+
+	void Start(void);
+	void Disconnect(void);
+
+private:
+	intrusive_ptr<LivestatusListener> m_Listener;
+	Socket::Ptr m_Socket;
+
+	boost::mutex m_Mutex;
+	String m_Buffer;
+	std::vector<String> m_Lines;
+	std::deque<LivestatusQuery::Ptr> m_Queries;
+	FIFO::Ptr m_SendQ;
+	bool m_Executing;
+	bool m_ReadEof;
+	bool m_CloseAfterSend;
+	bool m_Disconnected;
+
+	virtual void OnEvent(int revents) override;
+
+	bool ReadInput(void);
+	bool WriteOutput(void);
+	void ParseInput(const char *buffer, size_t count);
+	void QueueQuery(void);
+	void ProcessNextQuery(void);
+	bool UpdateEvents(void);
+
+	void ExecuteQuery(const LivestatusQuery::Ptr& query, double received);
+};
+
+}
+
+#endif /* LIVESTATUSCONNECTION_H */
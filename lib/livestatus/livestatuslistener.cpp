@@ -39,21 +39,57 @@ REGISTER_TYPE(LivestatusListener);
 
 static int l_ClientsConnected = 0;
 static int l_Connections = 0;
+static int l_Queries = 0;
+static int l_QueriesRejected = 0;
+static double l_QueryLatencySum = 0;
+static double l_QueryLatencyMax = 0;
 static boost::mutex l_ComponentMutex;
 
+/* queries beyond this limit are answered with an error right away */
+static const size_t l_MaxPendingQueries = 1000;
+
 REGISTER_STATSFUNCTION(LivestatusListener, &LivestatusListener::StatsFunc);
 
+LivestatusListener::LivestatusListener(void)
+	: m_QueryQueue(0, Application::GetConcurrency())
+{ }
+
 void LivestatusListener::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata)
 {
 	Dictionary::Ptr nodes = new Dictionary();
 
-	for (const LivestatusListener::Ptr& livestatuslistener : ConfigType::GetObjectsByType<LivestatusListener>()) {
-		Dictionary::Ptr stats = new Dictionary();
-		stats->Set("connections", l_Connections);
+	int clientsConnected, connections, queries, queriesRejected;
+	double avgLatency, maxLatency;
+
+	{
+		boost::mutex::scoped_lock lock(l_ComponentMutex);
+		clientsConnected = l_ClientsConnected;
+		connections = l_Connections;
+		queries = l_Queries;
+		queriesRejected = l_QueriesRejected;
+		avgLatency = (l_Queries > 0) ? l_QueryLatencySum / l_Queries : 0;
+		maxLatency = l_QueryLatencyMax;
+	}
 
-		nodes->Set(livestatuslistener->GetName(), stats);
+	for (const LivestatusListener::Ptr& livestatuslistener : ConfigType::GetObjectsByType<LivestatusListener>()) {
+		String name = livestatuslistener->GetName();
+		size_t pendingQueries = livestatuslistener->m_QueryQueue.GetLength();
 
-		perfdata->Add(new PerfdataValue("livestatuslistener_" + livestatuslistener->GetName() + "_connections", l_Connections));
+		Dictionary::Ptr stats = new Dictionary();
+		stats->Set("connections", connections);
+		stats->Set("clients_connected", clientsConnected);
+		stats->Set("queries", queries);
+		stats->Set("queries_rejected", queriesRejected);
+		stats->Set("pending_queries", pendingQueries);
+		stats->Set("avg_query_latency", avgLatency);
+		stats->Set("max_query_latency", maxLatency);
+
+		nodes->Set(name, stats);
+
+		perfdata->Add(new PerfdataValue("livestatuslistener_" + name + "_connections", connections));
+		perfdata->Add(new PerfdataValue("livestatuslistener_" + name + "_clients_connected", clientsConnected));
+		perfdata->Add(new PerfdataValue("livestatuslistener_" + name + "_pending_queries", pendingQueries));
+		perfdata->Add(new PerfdataValue("livestatuslistener_" + name + "_avg_query_latency", avgLatency));
 	}
 
 	status->Set("livestatuslistener", nodes);
@@ -66,6 +102,8 @@ void LivestatusListener::Start(bool runtimeCreated)
 {
 	ObjectImpl<LivestatusListener>::Start(runtimeCreated);
 
+	m_QueryQueue.SetName("LivestatusListener, " + GetName());
+
 	Log(LogInformation, "LivestatusListener")
 	    << "'" << GetName() << "' started.";
 
@@ -133,6 +171,19 @@ void LivestatusListener::Stop(bool runtimeRemoved)
 
 	if (m_Thread.joinable())
 		m_Thread.join();
+
+	std::set<LivestatusConnection::Ptr> connections;
+
+	{
+		boost::mutex::scoped_lock lock(m_ConnectionsMutex);
+		connections = m_Connections;
+	}
+
+	for (const LivestatusConnection::Ptr& connection : connections) {
+		connection->Disconnect();
+	}
+
+	m_QueryQueue.Join();
 }
 
 int LivestatusListener::GetClientsConnected(void)
@@ -160,7 +211,23 @@ void LivestatusListener::ServerThreadProc(void)
 			if (m_Listener->Poll(true, false, &tv)) {
 				Socket::Ptr client = m_Listener->Accept();
 				Log(LogNotice, "LivestatusListener", "Client connected");
-				Utility::QueueAsyncCallback(boost::bind(&LivestatusListener::ClientHandler, this, client), LowLatencyScheduler);
+
+				client->MakeNonBlocking();
+
+				LivestatusConnection::Ptr connection = new LivestatusConnection(this, client);
+
+				{
+					boost::mutex::scoped_lock lock(m_ConnectionsMutex);
+					m_Connections.insert(connection);
+				}
+
+				{
+					boost::mutex::scoped_lock lock(l_ComponentMutex);
+					l_ClientsConnected++;
+					l_Connections++;
+				}
+
+				connection->Start();
 			}
 
 			if (!IsActive())
@@ -173,53 +240,49 @@ void LivestatusListener::ServerThreadProc(void)
 	m_Listener->Close();
 }
 
-void LivestatusListener::ClientHandler(const Socket::Ptr& client)
+void LivestatusListener::RemoveConnection(const LivestatusConnection::Ptr& connection)
 {
 	{
-		boost::mutex::scoped_lock lock(l_ComponentMutex);
-		l_ClientsConnected++;
-		l_Connections++;
-	}
-
-	Stream::Ptr stream = new NetworkStream(client);
-
-	StreamReadContext context;
+		boost::mutex::scoped_lock lock(m_ConnectionsMutex);
 
-	for (;;) {
-		String line;
+		if (m_Connections.erase(connection) == 0)
+			return;
+	}
 
-		std::vector<String> lines;
+	boost::mutex::scoped_lock lock(l_ComponentMutex);
+	l_ClientsConnected--;
+}
 
-		for (;;) {
-			StreamReadStatus srs = stream->ReadLine(&line, context);
+/**
+ * Schedules a query for execution unless too many queries are pending.
+ *
+ * @returns false if the query was rejected.
+ */
+bool LivestatusListener::EnqueueQuery(boost::function<void (void)>&& callback)
+{
+	if (m_QueryQueue.GetLength() >= l_MaxPendingQueries) {
+		boost::mutex::scoped_lock lock(l_ComponentMutex);
+		l_QueriesRejected++;
 
-			if (srs == StatusEof)
-				break;
+		return false;
+	}
 
-			if (srs != StatusNewItem)
-				continue;
+	m_QueryQueue.Enqueue(std::move(callback));
 
-			if (line.GetLength() > 0)
-				lines.push_back(line);
-			else
-				break;
-		}
+	return true;
+}
 
-		if (lines.empty())
-			break;
+void LivestatusListener::ReportQuery(double latency)
+{
+	boost::mutex::scoped_lock lock(l_ComponentMutex);
 
-		LivestatusQuery::Ptr query = new LivestatusQuery(lines, GetCompatLogPath());
-		if (!query->Execute(stream))
-			break;
-	}
+	l_Queries++;
+	l_QueryLatencySum += latency;
 
-	{
-		boost::mutex::scoped_lock lock(l_ComponentMutex);
-		l_ClientsConnected--;
-	}
+	if (latency > l_QueryLatencyMax)
+		l_QueryLatencyMax = latency;
 }
 
-
 void LivestatusListener::ValidateSocketType(const String& value, const ValidationUtils& utils)
 {
 	ObjectImpl<LivestatusListener>::ValidateSocketType(value, utils);
@@ -23,7 +23,9 @@
 #include "livestatus/i2-livestatus.hpp"
 #include "livestatus/livestatuslistener.thpp"
 #include "livestatus/livestatusquery.hpp"
+#include "livestatus/livestatusconnection.hpp"
 #include "base/socket.hpp"
+#include "base/workqueue.hpp"
 #include <boost/thread/thread.hpp>
 
 using namespace icinga;
@@ -40,11 +42,18 @@ public:
 	DECLARE_OBJECT(LivestatusListener);
 	DECLARE_OBJECTNAME(LivestatusListener);
 
+	LivestatusListener(void);
+
 	static void StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata);
 
 	static int GetClientsConnected(void);
 	static int GetConnections(void);
 
+	bool EnqueueQuery(boost::function<void (void)>&& callback);
+	void RemoveConnection(const LivestatusConnection::Ptr& connection);
+
+	static void ReportQuery(double latency);
+
 	virtual void ValidateSocketType(const String& value, const ValidationUtils& utils) override;
 
 protected:
@@ -53,10 +62,14 @@ protected:
 
 private:
 	void ServerThreadProc(void);
-	void ClientHandler(const Socket::Ptr& client);
 
 	Socket::Ptr m_Listener;
 	boost::thread m_Thread;
+
+	WorkQueue m_QueryQueue;
+
+	boost::mutex m_ConnectionsMutex;
+	std::set<LivestatusConnection::Ptr> m_Connections;
 };
 
 }
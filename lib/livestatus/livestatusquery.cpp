@@ -41,6 +41,9 @@
 #include "base/serializer.hpp"
 #include "base/timer.hpp"
 #include "base/initialize.hpp"
+#include "base/workqueue.hpp"
+#include "base/application.hpp"
+#include <boost/thread/condition_variable.hpp>
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/algorithm/string/split.hpp>
@@ -49,6 +52,7 @@
 using namespace icinga;
 
 static int l_ExternalCommands = 0;
+static const size_t l_StatsRowsPerPartition = 10000;
 static boost::mutex l_QueryMutex;
 
 LivestatusQuery::LivestatusQuery(const std::vector<String>& lines, const String& compat_log_path)
@@ -100,6 +104,23 @@ LivestatusQuery::LivestatusQuery(const std::vector<String>& lines, const String&
 		return;
 	}
 
+	/* Column names are resolved to IDs once while parsing the query. The
+	 * IDs are shared by all instances of a table type, so a table without
+	 * the log time frame is sufficient here.
+	 */
+	Table::Ptr table;
+
+	if (m_Verb == "GET") {
+		table = Table::GetByName(m_Table, m_CompatLogPath);
+
+		if (!table) {
+			m_Verb = "ERROR";
+			m_ErrorCode = LivestatusErrorNotFound;
+			m_ErrorMessage = "Table '" + m_Table + "' does not exist.";
+			return;
+		}
+	}
+
 	std::deque<Filter::Ptr> filters, stats;
 	std::deque<Aggregator::Ptr> aggregators;
 
@@ -114,78 +135,48 @@ LivestatusQuery::LivestatusQuery(const std::vector<String>& lines, const String&
 		if (line.GetLength() > col_index + 1)
 			params = line.SubStr(col_index + 1).Trim();
 
-		if (header == "ResponseHeader")
-			m_ResponseHeader = params;
-		else if (header == "OutputFormat")
-			m_OutputFormat = params;
-		else if (header == "KeepAlive")
-			m_KeepAlive = (params == "on");
-		else if (header == "Columns") {
-			m_ColumnHeaders = false; // Might be explicitly re-enabled later on
-			boost::algorithm::split(m_Columns, params, boost::is_any_of(" "));
-		} else if (header == "Separators") {
-			std::vector<String> separators;
-
-			boost::algorithm::split(separators, params, boost::is_any_of(" "));
-			/* ugly ascii long to char conversion, but works */
-			if (separators.size() > 0)
-				m_Separators[0] = String(1, static_cast<char>(Convert::ToLong(separators[0])));
-			if (separators.size() > 1)
-				m_Separators[1] = String(1, static_cast<char>(Convert::ToLong(separators[1])));
-			if (separators.size() > 2)
-				m_Separators[2] = String(1, static_cast<char>(Convert::ToLong(separators[2])));
-			if (separators.size() > 3)
-				m_Separators[3] = String(1, static_cast<char>(Convert::ToLong(separators[3])));
-		} else if (header == "ColumnHeaders")
-			m_ColumnHeaders = (params == "on");
-		else if (header == "Limit")
-			m_Limit = Convert::ToLong(params);
-		else if (header == "Filter") {
-			Filter::Ptr filter = ParseFilter(params, m_LogTimeFrom, m_LogTimeUntil);
-
-			if (!filter) {
-				m_Verb = "ERROR";
-				m_ErrorCode = LivestatusErrorQuery;
-				m_ErrorMessage = "Invalid filter specification: " + line;
-				return;
-			}
-
-			filters.push_back(filter);
-		} else if (header == "Stats") {
-			m_ColumnHeaders = false; // Might be explicitly re-enabled later on
-
-			std::vector<String> tokens;
-			boost::algorithm::split(tokens, params, boost::is_any_of(" "));
-
-			if (tokens.size() < 2) {
-				m_Verb = "ERROR";
-				m_ErrorCode = LivestatusErrorQuery;
-				m_ErrorMessage = "Missing aggregator column name: " + line;
-				return;
-			}
+		/* Only GET queries have a table; column, filter and stats headers are
+		 * meaningless for COMMAND queries and are ignored.
+		 */
+		if (!table && (header == "Columns" || header == "Filter" || header == "Stats" ||
+		    header == "Or" || header == "And" || header == "StatsOr" || header == "StatsAnd" ||
+		    header == "Negate" || header == "StatsNegate"))
+			continue;
 
-			String aggregate_arg = tokens[0];
-			String aggregate_attr = tokens[1];
-
-			Aggregator::Ptr aggregator;
-			Filter::Ptr filter;
-
-			if (aggregate_arg == "sum") {
-				aggregator = new SumAggregator(aggregate_attr);
-			} else if (aggregate_arg == "min") {
-				aggregator = new MinAggregator(aggregate_attr);
-			} else if (aggregate_arg == "max") {
-				aggregator = new MaxAggregator(aggregate_attr);
-			} else if (aggregate_arg == "avg") {
-				aggregator = new AvgAggregator(aggregate_attr);
-			} else if (aggregate_arg == "std") {
-				aggregator = new StdAggregator(aggregate_attr);
-			} else if (aggregate_arg == "suminv") {
-				aggregator = new InvSumAggregator(aggregate_attr);
-			} else if (aggregate_arg == "avginv") {
-				aggregator = new InvAvgAggregator(aggregate_attr);
-			} else {
-				filter = ParseFilter(params, m_LogTimeFrom, m_LogTimeUntil);
+		try {
+			if (header == "ResponseHeader")
+				m_ResponseHeader = params;
+			else if (header == "OutputFormat")
+				m_OutputFormat = params;
+			else if (header == "KeepAlive")
+				m_KeepAlive = (params == "on");
+			else if (header == "Columns") {
+				m_ColumnHeaders = false; // Might be explicitly re-enabled later on
+				boost::algorithm::split(m_Columns, params, boost::is_any_of(" "));
+
+				m_ColumnIds.clear();
+
+				for (const String& columnName : m_Columns)
+					m_ColumnIds.push_back(table->GetColumnId(columnName));
+			} else if (header == "Separators") {
+				std::vector<String> separators;
+
+				boost::algorithm::split(separators, params, boost::is_any_of(" "));
+				/* ugly ascii long to char conversion, but works */
+				if (separators.size() > 0)
+					m_Separators[0] = String(1, static_cast<char>(Convert::ToLong(separators[0])));
+				if (separators.size() > 1)
+					m_Separators[1] = String(1, static_cast<char>(Convert::ToLong(separators[1])));
+				if (separators.size() > 2)
+					m_Separators[2] = String(1, static_cast<char>(Convert::ToLong(separators[2])));
+				if (separators.size() > 3)
+					m_Separators[3] = String(1, static_cast<char>(Convert::ToLong(separators[3])));
+			} else if (header == "ColumnHeaders")
+				m_ColumnHeaders = (params == "on");
+			else if (header == "Limit")
+				m_Limit = Convert::ToLong(params);
+			else if (header == "Filter") {
+				Filter::Ptr filter = ParseFilter(table, params, m_LogTimeFrom, m_LogTimeUntil);
 
 				if (!filter) {
 					m_Verb = "ERROR";
@@ -194,76 +185,128 @@ LivestatusQuery::LivestatusQuery(const std::vector<String>& lines, const String&
 					return;
 				}
 
-				aggregator = new CountAggregator();
-			}
+				filters.push_back(filter);
+			} else if (header == "Stats") {
+				m_ColumnHeaders = false; // Might be explicitly re-enabled later on
 
-			aggregator->SetFilter(filter);
-			aggregators.push_back(aggregator);
+				std::vector<String> tokens;
+				boost::algorithm::split(tokens, params, boost::is_any_of(" "));
 
-			stats.push_back(filter);
-		} else if (header == "Or" || header == "And" || header == "StatsOr" || header == "StatsAnd") {
-			std::deque<Filter::Ptr>& deq = (header == "Or" || header == "And") ? filters : stats;
+				if (tokens.size() < 2) {
+					m_Verb = "ERROR";
+					m_ErrorCode = LivestatusErrorQuery;
+					m_ErrorMessage = "Missing aggregator column name: " + line;
+					return;
+				}
 
-			unsigned int num = Convert::ToLong(params);
-			CombinerFilter::Ptr filter;
+				String aggregate_arg = tokens[0];
+				String aggregate_attr = tokens[1];
+
+				Aggregator::Ptr aggregator;
+				Filter::Ptr filter;
+
+				if (aggregate_arg == "sum") {
+					aggregator = new SumAggregator(table->GetColumnId(aggregate_attr));
+				} else if (aggregate_arg == "min") {
+					aggregator = new MinAggregator(table->GetColumnId(aggregate_attr));
+				} else if (aggregate_arg == "max") {
+					aggregator = new MaxAggregator(table->GetColumnId(aggregate_attr));
+				} else if (aggregate_arg == "avg") {
+					aggregator = new AvgAggregator(table->GetColumnId(aggregate_attr));
+				} else if (aggregate_arg == "std") {
+					aggregator = new StdAggregator(table->GetColumnId(aggregate_attr));
+				} else if (aggregate_arg == "suminv") {
+					aggregator = new InvSumAggregator(table->GetColumnId(aggregate_attr));
+				} else if (aggregate_arg == "avginv") {
+					aggregator = new InvAvgAggregator(table->GetColumnId(aggregate_attr));
+				} else {
+					filter = ParseFilter(table, params, m_LogTimeFrom, m_LogTimeUntil);
+
+					if (!filter) {
+						m_Verb = "ERROR";
+						m_ErrorCode = LivestatusErrorQuery;
+						m_ErrorMessage = "Invalid filter specification: " + line;
+						return;
+					}
+
+					aggregator = new CountAggregator();
+				}
 
-			if (header == "Or" || header == "StatsOr") {
-				filter = new OrFilter();
-				Log(LogDebug, "LivestatusQuery")
-				    << "Add OR filter for " << params << " column(s). " << deq.size() << " filters available.";
-			} else {
-				filter = new AndFilter();
-				Log(LogDebug, "LivestatusQuery")
-				    << "Add AND filter for " << params << " column(s). " << deq.size() << " filters available.";
-			}
+				aggregator->SetFilter(filter);
+				aggregators.push_back(aggregator);
 
-			if (num > deq.size()) {
-				m_Verb = "ERROR";
-				m_ErrorCode = 451;
-				m_ErrorMessage = "Or/StatsOr is referencing " + Convert::ToString(num) + " filters; stack only contains " + Convert::ToString(static_cast<long>(deq.size())) + " filters";
-				return;
-			}
+				stats.push_back(filter);
+			} else if (header == "Or" || header == "And" || header == "StatsOr" || header == "StatsAnd") {
+				std::deque<Filter::Ptr>& deq = (header == "Or" || header == "And") ? filters : stats;
+
+				unsigned int num = Convert::ToLong(params);
+				CombinerFilter::Ptr filter;
+
+				if (header == "Or" || header == "StatsOr") {
+					filter = new OrFilter();
+					Log(LogDebug, "LivestatusQuery")
+					    << "Add OR filter for " << params << " column(s). " << deq.size() << " filters available.";
+				} else {
+					filter = new AndFilter();
+					Log(LogDebug, "LivestatusQuery")
+					    << "Add AND filter for " << params << " column(s). " << deq.size() << " filters available.";
+				}
 
-			while (num > 0 && num--) {
-				filter->AddSubFilter(deq.back());
-				Log(LogDebug, "LivestatusQuery")
-				    << "Add " << num << " filter.";
-				deq.pop_back();
-				if (&deq == &stats)
-					aggregators.pop_back();
-			}
+				if (num > deq.size()) {
+					m_Verb = "ERROR";
+					m_ErrorCode = 451;
+					m_ErrorMessage = "Or/StatsOr is referencing " + Convert::ToString(num) + " filters; stack only contains " + Convert::ToString(static_cast<long>(deq.size())) + " filters";
+					return;
+				}
 
-			deq.push_back(filter);
-			if (&deq == &stats) {
-				Aggregator::Ptr aggregator = new CountAggregator();
-				aggregator->SetFilter(filter);
-				aggregators.push_back(aggregator);
-			}
-		} else if (header == "Negate" || header == "StatsNegate") {
-			std::deque<Filter::Ptr>& deq = (header == "Negate") ? filters : stats;
+				while (num > 0 && num--) {
+					filter->AddSubFilter(deq.back());
+					Log(LogDebug, "LivestatusQuery")
+					    << "Add " << num << " filter.";
+					deq.pop_back();
+					if (&deq == &stats)
+						aggregators.pop_back();
+				}
 
-			if (deq.empty()) {
-				m_Verb = "ERROR";
-				m_ErrorCode = 451;
-				m_ErrorMessage = "Negate/StatsNegate used, however the filter stack is empty";
-				return;
-			}
+				deq.push_back(filter);
+				if (&deq == &stats) {
+					Aggregator::Ptr aggregator = new CountAggregator();
+					aggregator->SetFilter(filter);
+					aggregators.push_back(aggregator);
+				}
+			} else if (header == "Negate" || header == "StatsNegate") {
+				std::deque<Filter::Ptr>& deq = (header == "Negate") ? filters : stats;
 
-			Filter::Ptr filter = deq.back();
-			deq.pop_back();
+				if (deq.empty()) {
+					m_Verb = "ERROR";
+					m_ErrorCode = 451;
+					m_ErrorMessage = "Negate/StatsNegate used, however the filter stack is empty";
+					return;
+				}
 
-			if (!filter) {
-				m_Verb = "ERROR";
-				m_ErrorCode = 451;
-				m_ErrorMessage = "Negate/StatsNegate used, however last stats doesn't have a filter";
-				return;
-			}
+				Filter::Ptr filter = deq.back();
+				deq.pop_back();
+
+				if (!filter) {
+					m_Verb = "ERROR";
+					m_ErrorCode = 451;
+					m_ErrorMessage = "Negate/StatsNegate used, however last stats doesn't have a filter";
+					return;
+				}
 
-			deq.push_back(new NegateFilter(filter));
+				deq.push_back(new NegateFilter(filter));
 
-			if (deq == stats) {
-				Aggregator::Ptr aggregator = aggregators.back();
-				aggregator->SetFilter(filter);
+				if (deq == stats) {
+					Aggregator::Ptr aggregator = aggregators.back();
+					aggregator->SetFilter(filter);
+				}
+			}
+		} catch (const std::invalid_argument& ex) {
+			/* keep parsing so that the response header settings are still honored */
+			if (m_Verb != "ERROR") {
+				m_Verb = "ERROR";
+				m_ErrorCode = LivestatusErrorQuery;
+				m_ErrorMessage = ex.what();
 			}
 		}
 	}
@@ -286,7 +329,7 @@ int LivestatusQuery::GetExternalCommands(void)
 	return l_ExternalCommands;
 }
 
-Filter::Ptr LivestatusQuery::ParseFilter(const String& params, unsigned long& from, unsigned long& until)
+Filter::Ptr LivestatusQuery::ParseFilter(const Table::Ptr& table, const String& params, unsigned long& from, unsigned long& until)
 {
 	/*
 	 * time >= 1382696656
@@ -319,7 +362,7 @@ Filter::Ptr LivestatusQuery::ParseFilter(const String& params, unsigned long& fr
 	if (tokens.size() == 2)
 		tokens.push_back("");
 
-	if (tokens.size() < 3)
+	if (tokens.size() < 3 || !table)
 		return Filter::Ptr();
 
 	bool negate = false;
@@ -341,7 +384,7 @@ Filter::Ptr LivestatusQuery::ParseFilter(const String& params, unsigned long& fr
 		negate = true;
 	}
 
-	Filter::Ptr filter = new AttributeFilter(attr, op, val);
+	Filter::Ptr filter = new AttributeFilter(table, attr, op, val);
 
 	if (negate)
 		filter = new NegateFilter(filter);
@@ -471,11 +514,16 @@ void LivestatusQuery::ExecuteGetHelper(const Stream::Ptr& stream)
 
 	std::vector<LivestatusRowValue> objects = table->FilterRows(m_Filter, m_Limit);
 	std::vector<String> columns;
+	std::vector<int> columnIds;
 
-	if (m_Columns.size() > 0)
+	if (m_Columns.size() > 0) {
 		columns = m_Columns;
-	else
-		columns = table->GetColumnNames();
+		columnIds = m_ColumnIds;
+	} else {
+		TableSchema::Ptr schema = table->GetSchema();
+		columns = schema->GetColumnNames();
+		columnIds = schema->GetColumnIds();
+	}
 
 	std::ostringstream result;
 	bool first_row = true;
@@ -484,13 +532,13 @@ void LivestatusQuery::ExecuteGetHelper(const Stream::Ptr& stream)
 	if (m_Aggregators.empty()) {
 		Array::Ptr header = new Array();
 
-		typedef std::pair<String, Column> ColumnPair;
+		typedef std::pair<String, const Column *> ColumnPair;
 
 		std::vector<ColumnPair> column_objs;
 		column_objs.reserve(columns.size());
 
-		for (const String& columnName : columns)
-			column_objs.push_back(std::make_pair(columnName, table->GetColumn(columnName)));
+		for (size_t i = 0; i < columns.size(); i++)
+			column_objs.push_back(std::make_pair(columns[i], &table->GetColumn(columnIds[i])));
 
 		for (const LivestatusRowValue& object : objects) {
 			Array::Ptr row = new Array();
@@ -501,7 +549,7 @@ void LivestatusQuery::ExecuteGetHelper(const Stream::Ptr& stream)
 				if (m_ColumnHeaders)
 					header->Add(cv.first);
 
-				row->Add(cv.second.ExtractValue(object.Row, object.GroupByType, object.GroupByObject));
+				row->Add(cv.second->ExtractValue(object.Row, object.GroupByType, object.GroupByObject));
 			}
 
 			if (m_ColumnHeaders) {
@@ -512,17 +560,69 @@ void LivestatusQuery::ExecuteGetHelper(const Stream::Ptr& stream)
 			AppendResultRow(result, row, first_row);
 		}
 	} else {
-		std::vector<double> stats(m_Aggregators.size(), 0);
-		int index = 0;
+		LivestatusStatsGroups groups;
 
-		/* add aggregated stats */
-		for (const Aggregator::Ptr aggregator : m_Aggregators) {
-			for (const LivestatusRowValue& object : objects) {
-				aggregator->Apply(table, object.Row);
+		size_t partitionCount = objects.size() / l_StatsRowsPerPartition;
+
+		if (partitionCount > static_cast<size_t>(Application::GetConcurrency()))
+			partitionCount = Application::GetConcurrency();
+
+		if (partitionCount < 2) {
+			AggregateRows(table, objects, 0, objects.size(), groups);
+		} else {
+			/* aggregate partitions in parallel and merge them in order */
+			std::vector<LivestatusStatsGroups> partitions(partitionCount);
+			size_t partitionSize = (objects.size() + partitionCount - 1) / partitionCount;
+
+			/* The queue is shared by all queries, so wait for this query's
+			 * partitions only instead of joining the queue.
+			 */
+			boost::mutex mutex;
+			boost::condition_variable cv;
+			size_t remaining = partitionCount;
+			boost::exception_ptr error;
+
+			for (size_t i = 0; i < partitionCount; i++) {
+				size_t begin = i * partitionSize;
+				size_t end = std::min(begin + partitionSize, objects.size());
+
+				GetStatsQueue().Enqueue([this, &table, &objects, begin, end, &partitions, i, &mutex, &cv, &remaining, &error]() {
+					boost::exception_ptr ex;
+
+					try {
+						AggregateRows(table, objects, begin, end, partitions[i]);
+					} catch (...) {
+						ex = boost::current_exception();
+					}
+
+					boost::mutex::scoped_lock lock(mutex);
+
+					if (ex && !error)
+						error = ex;
+
+					if (--remaining == 0)
+						cv.notify_all();
+				});
+			}
+
+			{
+				boost::mutex::scoped_lock lock(mutex);
+
+				while (remaining > 0)
+					cv.wait(lock);
 			}
 
-			stats[index] = aggregator->GetResult();
-			index++;
+			if (error)
+				boost::rethrow_exception(error);
+
+			for (const LivestatusStatsGroups& partition : partitions)
+				MergeGroups(groups, partition);
+		}
+
+		/* without grouping columns there is exactly one result row */
+		if (m_ColumnIds.empty() && groups.Keys.empty()) {
+			groups.Keys.push_back(new Array());
+			groups.States.push_back(std::vector<AggregatorState>(m_Aggregators.size()));
 		}
 
 		/* add column headers both for raw and aggregated data */
@@ -540,33 +640,120 @@ void LivestatusQuery::ExecuteGetHelper(const Stream::Ptr& stream)
 			AppendResultRow(result, header, first_row);
 		}
 
-		Array::Ptr row = new Array();
+		for (size_t group = 0; group < groups.Keys.size(); group++) {
+			Array::Ptr row = groups.Keys[group]->ShallowClone();
 
-		row->Reserve(m_Columns.size() + m_Aggregators.size());
+			row->Reserve(m_Columns.size() + m_Aggregators.size());
 
-		/*
-		 * add selected columns next to stats
-		 * may not be accurate for grouping!
-		 */
-		if (objects.size() > 0 && m_Columns.size() > 0) {
-			for (const String& columnName : m_Columns) {
-				Column column = table->GetColumn(columnName);
+			for (size_t i = 0; i < m_Aggregators.size(); i++)
+				row->Add(m_Aggregators[i]->GetResult(groups.States[group][i]));
+
+			AppendResultRow(result, row, first_row);
+		}
+	}
 
-				LivestatusRowValue object = objects[0]; //first object wins
+	EndResultSet(result);
 
-				row->Add(column.ExtractValue(object.Row, object.GroupByType, object.GroupByObject));
-			}
+	SendResponse(stream, LivestatusErrorOK, result.str());
+}
+
+WorkQueue& LivestatusQuery::GetStatsQueue(void)
+{
+	/* Intentionally leaked so that the worker threads outlive static destructors. */
+	static WorkQueue *queue = []() {
+		WorkQueue *wq = new WorkQueue(0, Application::GetConcurrency());
+		wq->SetName("LivestatusQuery, Stats");
+		return wq;
+	}();
+
+	return *queue;
+}
+
+/**
+ * Appends a column value to a stats group key. Each value is prefixed with
+ * its type and length so that different values can't produce the same key.
+ */
+void LivestatusQuery::AppendGroupKey(std::string& key, const Value& value)
+{
+	String data;
+
+	if (value.IsObject())
+		data = JsonEncode(value);
+	else
+		data = value;
+
+	key += static_cast<char>('0' + value.GetType());
+	key += Convert::ToString(data.GetLength()).GetData();
+	key += ':';
+	key += data.GetData();
+}
+
+/**
+ * Evaluates all stats aggregators for a range of rows in a single pass,
+ * grouping the rows by the values of the requested columns.
+ */
+void LivestatusQuery::AggregateRows(const Table::Ptr& table, const std::vector<LivestatusRowValue>& objects,
+    size_t begin, size_t end, LivestatusStatsGroups& groups) const
+{
+	std::vector<const Column *> columns;
+
+	for (int columnId : m_ColumnIds)
+		columns.push_back(&table->GetColumn(columnId));
+
+	for (size_t index = begin; index < end; index++) {
+		const LivestatusRowValue& object = objects[index];
+
+		Array::Ptr values = new Array();
+		values->Reserve(columns.size());
+
+		std::string key;
+
+		for (const Column *column : columns) {
+			Value value = column->ExtractValue(object.Row, object.GroupByType, object.GroupByObject);
+			AppendGroupKey(key, value);
+			values->Add(value);
 		}
 
-		for (size_t i = 0; i < m_Aggregators.size(); i++)
-			row->Add(stats[i]);
+		auto it = groups.Index.find(key);
+		size_t group;
 
-		AppendResultRow(result, row, first_row);
+		if (it == groups.Index.end()) {
+			group = groups.Keys.size();
+			groups.Index[key] = group;
+			groups.Keys.push_back(values);
+			groups.States.push_back(std::vector<AggregatorState>(m_Aggregators.size()));
+		} else
+			group = it->second;
+
+		std::vector<AggregatorState>& states = groups.States[group];
+
+		for (size_t i = 0; i < m_Aggregators.size(); i++)
+			m_Aggregators[i]->Apply(table, object.Row, states[i]);
 	}
+}
 
-	EndResultSet(result);
+void LivestatusQuery::MergeGroups(LivestatusStatsGroups& groups, const LivestatusStatsGroups& other) const
+{
+	std::vector<std::string> keys(other.Keys.size());
 
-	SendResponse(stream, LivestatusErrorOK, result.str());
+	for (const auto& kv : other.Index)
+		keys[kv.second] = kv.first;
+
+	for (size_t group = 0; group < other.Keys.size(); group++) {
+		auto it = groups.Index.find(keys[group]);
+
+		if (it == groups.Index.end()) {
+			groups.Index[keys[group]] = groups.Keys.size();
+			groups.Keys.push_back(other.Keys[group]);
+			groups.States.push_back(other.States[group]);
+			continue;
+		}
+
+		std::vector<AggregatorState>& states = groups.States[it->second];
+
+		for (size_t i = 0; i < m_Aggregators.size(); i++)
+			m_Aggregators[i]->Merge(states[i], other.States[group][i]);
+	}
 }
 
 void LivestatusQuery::ExecuteCommandHelper(const Stream::Ptr& stream)
@@ -620,6 +807,17 @@ void LivestatusQuery::PrintFixed16(const Stream::Ptr& stream, int code, const St
 	}
 }
 
+/**
+ * Replaces the query with an error response, e.g. when it cannot be
+ * scheduled for execution.
+ */
+void LivestatusQuery::SetError(int code, const String& message)
+{
+	m_Verb = "ERROR";
+	m_ErrorCode = code;
+	m_ErrorMessage = message;
+}
+
 bool LivestatusQuery::Execute(const Stream::Ptr& stream)
 {
 	try {
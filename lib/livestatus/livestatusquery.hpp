@@ -26,7 +26,9 @@
 #include "base/array.hpp"
 #include "base/stream.hpp"
 #include "base/scriptframe.hpp"
+#include "base/workqueue.hpp"
 #include <deque>
+#include <unordered_map>
 
 using namespace icinga;
 
@@ -40,6 +42,18 @@ enum LivestatusError
 	LivestatusErrorQuery = 452
 };
 
+/**
+ * Stats results grouped by the values of the query's columns.
+ *
+ * @ingroup livestatus
+ */
+struct LivestatusStatsGroups
+{
+	std::vector<Array::Ptr> Keys;
+	std::vector<std::vector<AggregatorState> > States;
+	std::unordered_map<std::string, size_t> Index;
+};
+
 /**
  * @ingroup livestatus
  */
@@ -52,6 +66,8 @@ public:
 
 	bool Execute(const Stream::Ptr& stream);
 
+	void SetError(int code, const String& message);
+
 	static int GetExternalCommands(void);
 
 private:
@@ -62,6 +78,7 @@ private:
 	/* Parameters for GET queries. */
 	String m_Table;
 	std::vector<String> m_Columns;
+	std::vector<int> m_ColumnIds;
 	std::vector<String> m_Separators;
 
 	Filter::Ptr m_Filter;
@@ -93,13 +110,18 @@ private:
 	static String QuoteStringPython(const String& str);
 
 	void ExecuteGetHelper(const Stream::Ptr& stream);
+	void AggregateRows(const Table::Ptr& table, const std::vector<LivestatusRowValue>& objects,
+	    size_t begin, size_t end, LivestatusStatsGroups& groups) const;
+	void MergeGroups(LivestatusStatsGroups& groups, const LivestatusStatsGroups& other) const;
+	static void AppendGroupKey(std::string& key, const Value& value);
+	static WorkQueue& GetStatsQueue(void);
 	void ExecuteCommandHelper(const Stream::Ptr& stream);
 	void ExecuteErrorHelper(const Stream::Ptr& stream);
 
 	void SendResponse(const Stream::Ptr& stream, int code, const String& data);
 	void PrintFixed16(const Stream::Ptr& stream, int code, const String& data);
 
-	static Filter::Ptr ParseFilter(const String& params, unsigned long& from, unsigned long& until);
+	static Filter::Ptr ParseFilter(const Table::Ptr& table, const String& params, unsigned long& from, unsigned long& until);
 };
 
 }
@@ -53,7 +53,7 @@ LogTable::LogTable(const String& compat_log_path, time_t from, time_t until)
 	m_TimeUntil = until;
 	m_CompatLogPath = compat_log_path;
 
-	AddColumns(this);
+	InitializeSchema("log", &LogTable::AddColumns);
 }
 
 void LogTable::AddColumns(Table *table, const String& prefix,
@@ -21,21 +21,32 @@
 
 using namespace icinga;
 
-MaxAggregator::MaxAggregator(const String& attr)
-    : m_Max(0), m_MaxAttr(attr)
+MaxAggregator::MaxAggregator(int column)
+    : m_MaxColumn(column)
 { }
 
-void MaxAggregator::Apply(const Table::Ptr& table, const Value& row)
+void MaxAggregator::Apply(const Table::Ptr& table, const Value& row, AggregatorState& state) const
 {
-	Column column = table->GetColumn(m_MaxAttr);
+	Value value = table->GetColumn(m_MaxColumn).ExtractValue(row);
 
-	Value value = column.ExtractValue(row);
+	if (state.Count == 0 || value > state.Accumulator)
+		state.Accumulator = value;
 
-	if (value > m_Max)
-		m_Max = value;
+	state.Count++;
 }
 
-double MaxAggregator::GetResult(void) const
+void MaxAggregator::Merge(AggregatorState& state, const AggregatorState& other) const
 {
-	return m_Max;
+	if (other.Count == 0)
+		return;
+
+	if (state.Count == 0 || other.Accumulator > state.Accumulator)
+		state.Accumulator = other.Accumulator;
+
+	state.Count += other.Count;
+}
+
+double MaxAggregator::GetResult(const AggregatorState& state) const
+{
+	return state.Accumulator;
 }
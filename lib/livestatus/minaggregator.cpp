@@ -21,21 +21,32 @@
 
 using namespace icinga;
 
-MinAggregator::MinAggregator(const String& attr)
-    : m_Min(0), m_MinAttr(attr)
+MinAggregator::MinAggregator(int column)
+    : m_MinColumn(column)
 { }
 
-void MinAggregator::Apply(const Table::Ptr& table, const Value& row)
+void MinAggregator::Apply(const Table::Ptr& table, const Value& row, AggregatorState& state) const
 {
-	Column column = table->GetColumn(m_MinAttr);
+	Value value = table->GetColumn(m_MinColumn).ExtractValue(row);
 
-	Value value = column.ExtractValue(row);
+	if (state.Count == 0 || value < state.Accumulator)
+		state.Accumulator = value;
 
-	if (value < m_Min)
-		m_Min = value;
+	state.Count++;
 }
 
-double MinAggregator::GetResult(void) const
+void MinAggregator::Merge(AggregatorState& state, const AggregatorState& other) const
 {
-	return m_Min;
+	if (other.Count == 0)
+		return;
+
+	if (state.Count == 0 || other.Accumulator < state.Accumulator)
+		state.Accumulator = other.Accumulator;
+
+	state.Count += other.Count;
+}
+
+double MinAggregator::GetResult(const AggregatorState& state) const
+{
+	return state.Accumulator;
 }
@@ -34,14 +34,14 @@ class I2_LIVESTATUS_API MinAggregator : public Aggregator
 public:
 	DECLARE_PTR_TYPEDEFS(MinAggregator);
 
-	MinAggregator(const String& attr);
+	MinAggregator(int column);
 
-	virtual void Apply(const Table::Ptr& table, const Value& row) override;
-	virtual double GetResult(void) const override;
+	virtual void Apply(const Table::Ptr& table, const Value& row, AggregatorState& state) const override;
+	virtual double GetResult(const AggregatorState& state) const override;
+	virtual void Merge(AggregatorState& state, const AggregatorState& other) const override;
 
 private:
-	double m_Min;
-	String m_MinAttr;
+	int m_MinColumn;
 };
 
 }
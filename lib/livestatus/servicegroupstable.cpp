@@ -25,7 +25,7 @@ using namespace icinga;
 
 ServiceGroupsTable::ServiceGroupsTable(void)
 {
-	AddColumns(this);
+	InitializeSchema("servicegroups", &ServiceGroupsTable::AddColumns);
 }
 
 void ServiceGroupsTable::AddColumns(Table *table, const String& prefix,
@@ -166,14 +166,7 @@ Value ServiceGroupsTable::WorstServiceStateAccessor(const Value& row)
 	if (!sg)
 		return Empty;
 
-	Value worst_service = ServiceOK;
-
-	for (const Service::Ptr& service : sg->GetMembers()) {
-		if (service->GetState() > worst_service)
-			worst_service = service->GetState();
-	}
-
-	return worst_service;
+	return sg->GetServiceStateCounters().GetWorstState();
 }
 
 Value ServiceGroupsTable::NumServicesAccessor(const Value& row)
@@ -183,7 +176,7 @@ Value ServiceGroupsTable::NumServicesAccessor(const Value& row)
 	if (!sg)
 		return Empty;
 
-	return sg->GetMembers().size();
+	return sg->GetServiceStateCounters().GetTotal();
 }
 
 Value ServiceGroupsTable::NumServicesOkAccessor(const Value& row)
@@ -193,14 +186,7 @@ Value ServiceGroupsTable::NumServicesOkAccessor(const Value& row)
 	if (!sg)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Service::Ptr& service : sg->GetMembers()) {
-		if (service->GetState() == ServiceOK)
-			num_services++;
-	}
-
-	return num_services;
+	return sg->GetServiceStateCounters().GetState(ServiceOK);
 }
 
 Value ServiceGroupsTable::NumServicesWarnAccessor(const Value& row)
@@ -210,14 +196,7 @@ Value ServiceGroupsTable::NumServicesWarnAccessor(const Value& row)
 	if (!sg)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Service::Ptr& service : sg->GetMembers()) {
-		if (service->GetState() == ServiceWarning)
-			num_services++;
-	}
-
-	return num_services;
+	return sg->GetServiceStateCounters().GetState(ServiceWarning);
 }
 
 Value ServiceGroupsTable::NumServicesCritAccessor(const Value& row)
@@ -227,14 +206,7 @@ Value ServiceGroupsTable::NumServicesCritAccessor(const Value& row)
 	if (!sg)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Service::Ptr& service : sg->GetMembers()) {
-		if (service->GetState() == ServiceCritical)
-			num_services++;
-	}
-
-	return num_services;
+	return sg->GetServiceStateCounters().GetState(ServiceCritical);
 }
 
 Value ServiceGroupsTable::NumServicesUnknownAccessor(const Value& row)
@@ -244,14 +216,7 @@ Value ServiceGroupsTable::NumServicesUnknownAccessor(const Value& row)
 	if (!sg)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Service::Ptr& service : sg->GetMembers()) {
-		if (service->GetState() == ServiceUnknown)
-			num_services++;
-	}
-
-	return num_services;
+	return sg->GetServiceStateCounters().GetState(ServiceUnknown);
 }
 
 Value ServiceGroupsTable::NumServicesPendingAccessor(const Value& row)
@@ -261,14 +226,7 @@ Value ServiceGroupsTable::NumServicesPendingAccessor(const Value& row)
 	if (!sg)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Service::Ptr& service : sg->GetMembers()) {
-		if (!service->GetLastCheckResult())
-			num_services++;
-	}
-
-	return num_services;
+	return sg->GetServiceStateCounters().GetPending();
 }
 
 Value ServiceGroupsTable::NumServicesHardOkAccessor(const Value& row)
@@ -278,14 +236,7 @@ Value ServiceGroupsTable::NumServicesHardOkAccessor(const Value& row)
 	if (!sg)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Service::Ptr& service : sg->GetMembers()) {
-		if (service->GetStateType() == StateTypeHard && service->GetState() == ServiceOK)
-			num_services++;
-	}
-
-	return num_services;
+	return sg->GetServiceStateCounters().GetHardState(ServiceOK);
 }
 
 Value ServiceGroupsTable::NumServicesHardWarnAccessor(const Value& row)
@@ -295,14 +246,7 @@ Value ServiceGroupsTable::NumServicesHardWarnAccessor(const Value& row)
 	if (!sg)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Service::Ptr& service : sg->GetMembers()) {
-		if (service->GetStateType() == StateTypeHard && service->GetState() == ServiceWarning)
-			num_services++;
-	}
-
-	return num_services;
+	return sg->GetServiceStateCounters().GetHardState(ServiceWarning);
 }
 
 Value ServiceGroupsTable::NumServicesHardCritAccessor(const Value& row)
@@ -312,14 +256,7 @@ Value ServiceGroupsTable::NumServicesHardCritAccessor(const Value& row)
 	if (!sg)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Service::Ptr& service : sg->GetMembers()) {
-		if (service->GetStateType() == StateTypeHard && service->GetState() == ServiceCritical)
-			num_services++;
-	}
-
-	return num_services;
+	return sg->GetServiceStateCounters().GetHardState(ServiceCritical);
 }
 
 Value ServiceGroupsTable::NumServicesHardUnknownAccessor(const Value& row)
@@ -329,12 +266,5 @@ Value ServiceGroupsTable::NumServicesHardUnknownAccessor(const Value& row)
 	if (!sg)
 		return Empty;
 
-	int num_services = 0;
-
-	for (const Service::Ptr& service : sg->GetMembers()) {
-		if (service->GetStateType() == StateTypeHard && service->GetState() == ServiceUnknown)
-			num_services++;
-	}
-
-	return num_services;
+	return sg->GetServiceStateCounters().GetHardState(ServiceUnknown);
 }
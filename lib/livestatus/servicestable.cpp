@@ -44,7 +44,7 @@ using namespace icinga;
 ServicesTable::ServicesTable(LivestatusGroupByType type)
     : Table(type)
 {
-	AddColumns(this);
+	InitializeSchema("services", &ServicesTable::AddColumns);
 }
 
 
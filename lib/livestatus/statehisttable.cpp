@@ -53,7 +53,7 @@ StateHistTable::StateHistTable(const String& compat_log_path, time_t from, time_
 	m_TimeUntil = until;
 	m_CompatLogPath = compat_log_path;
 
-	AddColumns(this);
+	InitializeSchema("statehist", &StateHistTable::AddColumns);
 }
 
 void StateHistTable::UpdateLogEntries(const Dictionary::Ptr& log_entry_attrs, int line_count, int lineno, const AddRowFunction& addRowFn)
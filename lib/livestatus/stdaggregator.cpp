@@ -22,22 +22,20 @@
 
 using namespace icinga;
 
-StdAggregator::StdAggregator(const String& attr)
-    : m_StdSum(0), m_StdQSum(0), m_StdCount(0), m_StdAttr(attr)
+StdAggregator::StdAggregator(int column)
+    : m_StdColumn(column)
 { }
 
-void StdAggregator::Apply(const Table::Ptr& table, const Value& row)
+void StdAggregator::Apply(const Table::Ptr& table, const Value& row, AggregatorState& state) const
 {
-	Column column = table->GetColumn(m_StdAttr);
+	Value value = table->GetColumn(m_StdColumn).ExtractValue(row);
 
-	Value value = column.ExtractValue(row);
-
-	m_StdSum += value;
-	m_StdQSum += pow(value, 2);
-	m_StdCount++;
+	state.Accumulator += value;
+	state.SquareSum += pow(value, 2);
+	state.Count++;
 }
 
-double StdAggregator::GetResult(void) const
+double StdAggregator::GetResult(const AggregatorState& state) const
 {
-	return sqrt((m_StdQSum - (1 / m_StdCount) * pow(m_StdSum, 2)) / (m_StdCount - 1));
+	return sqrt((state.SquareSum - (1 / state.Count) * pow(state.Accumulator, 2)) / (state.Count - 1));
 }
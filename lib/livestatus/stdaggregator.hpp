@@ -34,16 +34,13 @@ class I2_LIVESTATUS_API StdAggregator : public Aggregator
 public:
 	DECLARE_PTR_TYPEDEFS(StdAggregator);
 
-	StdAggregator(const String& attr);
+	StdAggregator(int column);
 
-	virtual void Apply(const Table::Ptr& table, const Value& row) override;
-	virtual double GetResult(void) const override;
+	virtual void Apply(const Table::Ptr& table, const Value& row, AggregatorState& state) const override;
+	virtual double GetResult(const AggregatorState& state) const override;
 
 private:
-	double m_StdSum;
-	double m_StdQSum;
-	double m_StdCount;
-	String m_StdAttr;
+	int m_StdColumn;
 };
 
 }
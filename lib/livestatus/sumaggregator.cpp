@@ -21,20 +21,18 @@
 
 using namespace icinga;
 
-SumAggregator::SumAggregator(const String& attr)
-    : m_Sum(0), m_SumAttr(attr)
+SumAggregator::SumAggregator(int column)
+    : m_SumColumn(column)
 { }
 
-void SumAggregator::Apply(const Table::Ptr& table, const Value& row)
+void SumAggregator::Apply(const Table::Ptr& table, const Value& row, AggregatorState& state) const
 {
-	Column column = table->GetColumn(m_SumAttr);
+	Value value = table->GetColumn(m_SumColumn).ExtractValue(row);
 
-	Value value = column.ExtractValue(row);
-
-	m_Sum += value;
+	state.Accumulator += value;
 }
 
-double SumAggregator::GetResult(void) const
+double SumAggregator::GetResult(const AggregatorState& state) const
 {
-	return m_Sum;
+	return state.Accumulator;
 }
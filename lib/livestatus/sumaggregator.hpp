@@ -34,14 +34,13 @@ class I2_LIVESTATUS_API SumAggregator : public Aggregator
 public:
 	DECLARE_PTR_TYPEDEFS(SumAggregator);
 
-	SumAggregator(const String& attr);
+	SumAggregator(int column);
 
-	virtual void Apply(const Table::Ptr& table, const Value& row) override;
-	virtual double GetResult(void) const override;
+	virtual void Apply(const Table::Ptr& table, const Value& row, AggregatorState& state) const override;
+	virtual double GetResult(const AggregatorState& state) const override;
 
 private:
-	double m_Sum;
-	String m_SumAttr;
+	int m_SumColumn;
 };
 
 }
@@ -36,16 +36,46 @@
 #include "livestatus/filter.hpp"
 #include "base/array.hpp"
 #include "base/dictionary.hpp"
+#include "base/convert.hpp"
 #include <boost/algorithm/string/case_conv.hpp>
 #include <boost/tuple/tuple.hpp>
 #include <boost/bind.hpp>
 
 using namespace icinga;
 
+static boost::mutex l_SchemasMutex;
+static std::map<String, TableSchema::Ptr> l_Schemas;
+
 Table::Table(LivestatusGroupByType type)
     : m_GroupByType(type), m_GroupByObject(Empty)
 { }
 
+/**
+ * Attaches the shared schema for this table type. The schema is built
+ * using the specified function when the first instance is created.
+ *
+ * @param name The schema name.
+ * @param addColumnsFn The function which adds the table's columns.
+ */
+void Table::InitializeSchema(const String& name, AddColumnsFunction addColumnsFn)
+{
+	String key = name + ":" + Convert::ToString(m_GroupByType);
+
+	boost::mutex::scoped_lock lock(l_SchemasMutex);
+
+	auto it = l_Schemas.find(key);
+
+	if (it != l_Schemas.end()) {
+		m_Schema = it->second;
+		return;
+	}
+
+	m_Schema = new TableSchema();
+	addColumnsFn(this, String(), Column::ObjectAccessor());
+
+	l_Schemas[key] = m_Schema;
+}
+
 Table::Ptr Table::GetByName(const String& name, const String& compat_log_path, const unsigned long& from, const unsigned long& until)
 {
 	if (name == "status")
@@ -90,15 +120,22 @@ Table::Ptr Table::GetByName(const String& name, const String& compat_log_path, c
 
 void Table::AddColumn(const String& name, const Column& column)
 {
-	std::pair<String, Column> item = std::make_pair(name, column);
-
-	auto ret = m_Columns.insert(item);
-
-	if (!ret.second)
-		ret.first->second = column;
+	m_Schema->AddColumn(name, column);
 }
 
 Column Table::GetColumn(const String& name) const
+{
+	return m_Schema->GetColumn(GetColumnId(name));
+}
+
+/**
+ * Resolves a column name to its ID. IDs are shared by all instances of
+ * the same table type and should be resolved once per query.
+ *
+ * @param name The column name, optionally including the table's prefix.
+ * @returns The column ID.
+ */
+int Table::GetColumnId(const String& name) const
 {
 	String dname = name;
 	String prefix = GetPrefix() + "_";
@@ -106,23 +143,27 @@ Column Table::GetColumn(const String& name) const
 	if (dname.Find(prefix) == 0)
 		dname = dname.SubStr(prefix.GetLength());
 
-	auto it = m_Columns.find(dname);
+	int id = m_Schema->GetColumnId(dname);
 
-	if (it == m_Columns.end())
+	if (id == -1)
 		BOOST_THROW_EXCEPTION(std::invalid_argument("Column '" + dname + "' does not exist in table '" + GetName() + "'."));
 
-	return it->second;
+	return id;
 }
 
-std::vector<String> Table::GetColumnNames(void) const
+const Column& Table::GetColumn(int id) const
 {
-	std::vector<String> names;
+	return m_Schema->GetColumn(id);
+}
 
-	for (const auto& kv : m_Columns) {
-		names.push_back(kv.first);
-	}
+std::vector<String> Table::GetColumnNames(void) const
+{
+	return m_Schema->GetColumnNames();
+}
 
-	return names;
+TableSchema::Ptr Table::GetSchema(void) const
+{
+	return m_Schema;
 }
 
 std::vector<LivestatusRowValue> Table::FilterRows(const Filter::Ptr& filter, int limit)
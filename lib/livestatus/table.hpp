@@ -20,7 +20,7 @@
 #ifndef TABLE_H
 #define TABLE_H
 
-#include "livestatus/column.hpp"
+#include "livestatus/tableschema.hpp"
 #include "base/object.hpp"
 #include "base/dictionary.hpp"
 #include "base/array.hpp"
@@ -57,8 +57,12 @@ public:
 
 	void AddColumn(const String& name, const Column& column);
 	Column GetColumn(const String& name) const;
+	int GetColumnId(const String& name) const;
+	const Column& GetColumn(int id) const;
 	std::vector<String> GetColumnNames(void) const;
 
+	TableSchema::Ptr GetSchema(void) const;
+
 	virtual LivestatusGroupByType GetGroupByType(void) const;
 
 protected:
@@ -66,6 +70,10 @@ protected:
 
 	virtual void FetchRows(const AddRowFunction& addRowFn) = 0;
 
+	typedef void (*AddColumnsFunction)(Table *table, const String& prefix, const Column::ObjectAccessor& objectAccessor);
+
+	void InitializeSchema(const String& name, AddColumnsFunction addColumnsFn);
+
 	static Value ZeroAccessor(const Value&);
 	static Value OneAccessor(const Value&);
 	static Value EmptyStringAccessor(const Value&);
@@ -76,7 +84,7 @@ protected:
 	Value m_GroupByObject;
 
 private:
-	std::map<String, Column> m_Columns;
+	TableSchema::Ptr m_Schema;
 
 	bool FilteredAddRow(std::vector<LivestatusRowValue>& rs, const intrusive_ptr<Filter>& filter, int limit, const Value& row, LivestatusGroupByType groupByType, const Object::Ptr& groupByObject);
 };
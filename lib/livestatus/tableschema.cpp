@@ -0,0 +1,84 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "livestatus/tableschema.hpp"
+
+using namespace icinga;
+
+void TableSchema::AddColumn(const String& name, const Column& column)
+{
+	auto it = m_Index.find(name);
+
+	if (it != m_Index.end()) {
+		m_Columns[it->second] = column;
+		return;
+	}
+
+	m_Index[name] = m_Columns.size();
+	m_Columns.push_back(column);
+	m_Names.push_back(name);
+}
+
+/**
+ * Looks up the ID for a column.
+ *
+ * @param name The column name.
+ * @returns The column ID or -1 if the column does not exist.
+ */
+int TableSchema::GetColumnId(const String& name) const
+{
+	auto it = m_Index.find(name);
+
+	if (it == m_Index.end())
+		return -1;
+
+	return it->second;
+}
+
+const Column& TableSchema::GetColumn(int id) const
+{
+	return m_Columns[id];
+}
+
+String TableSchema::GetColumnName(int id) const
+{
+	return m_Names[id];
+}
+
+std::vector<String> TableSchema::GetColumnNames(void) const
+{
+	std::vector<String> names;
+
+	for (const auto& kv : m_Index) {
+		names.push_back(kv.first);
+	}
+
+	return names;
+}
+
+std::vector<int> TableSchema::GetColumnIds(void) const
+{
+	std::vector<int> ids;
+
+	for (const auto& kv : m_Index) {
+		ids.push_back(kv.second);
+	}
+
+	return ids;
+}
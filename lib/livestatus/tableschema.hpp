@@ -0,0 +1,59 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#ifndef TABLESCHEMA_H
+#define TABLESCHEMA_H
+
+#include "livestatus/column.hpp"
+#include "base/object.hpp"
+#include <vector>
+#include <map>
+
+namespace icinga
+{
+
+/**
+ * The column definitions for a table type. Schemas are built once per
+ * table type and shared by all table instances. Columns are identified
+ * by their index which remains stable for the lifetime of the process.
+ *
+ * @ingroup livestatus
+ */
+class I2_LIVESTATUS_API TableSchema : public Object
+{
+public:
+	DECLARE_PTR_TYPEDEFS(TableSchema);
+
+	void AddColumn(const String& name, const Column& column);
+
+	int GetColumnId(const String& name) const;
+	const Column& GetColumn(int id) const;
+	String GetColumnName(int id) const;
+	std::vector<String> GetColumnNames(void) const;
+	std::vector<int> GetColumnIds(void) const;
+
+private:
+	std::vector<Column> m_Columns;
+	std::vector<String> m_Names;
+	std::map<String, int> m_Index;
+};
+
+}
+
+#endif /* TABLESCHEMA_H */
@@ -30,7 +30,7 @@ using namespace icinga;
 
 TimePeriodsTable::TimePeriodsTable(void)
 {
-	AddColumns(this);
+	InitializeSchema("timeperiods", &TimePeriodsTable::AddColumns);
 }
 
 void TimePeriodsTable::AddColumns(Table *table, const String& prefix,
@@ -25,7 +25,7 @@ using namespace icinga;
 
 ZonesTable::ZonesTable(void)
 {
-	AddColumns(this);
+	InitializeSchema("zones", &ZonesTable::AddColumns);
 }
 
 void ZonesTable::AddColumns(Table *table, const String& prefix,
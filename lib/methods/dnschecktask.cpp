@@ -0,0 +1,395 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "methods/dnschecktask.hpp"
+#include "icinga/perfdatavalue.hpp"
+#include "base/function.hpp"
+#include "base/utility.hpp"
+#include "base/convert.hpp"
+#include <boost/algorithm/string/join.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/thread/once.hpp>
+#include <fstream>
+
+using namespace icinga;
+
+REGISTER_SCRIPTFUNCTION_NS(Internal, DnsCheck, &DnsCheckTask::ScriptFunc);
+
+static boost::once_flag l_DefaultServerOnce = BOOST_ONCE_INIT;
+static String l_DefaultServer;
+
+DnsCheckTask::DnsCheckTask(const Socket::Ptr& socket, const Dictionary::Ptr& args, int type, const CheckResult::Ptr& cr)
+	: NetworkProbe(socket, args->Get("server"), "53", cr, args->Get("timeout")),
+	  m_Lookup(args->Get("lookup")), m_Type(type), m_ID(Utility::Random() & 0xffff),
+	  m_ExpectedAnswers(args->Get("expected_answers")), m_WarnTime(args->Get("wtime")), m_CritTime(args->Get("ctime"))
+{ }
+
+void DnsCheckTask::ScriptFunc(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr,
+    const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros)
+{
+	MacroProcessor::ResolverList resolvers = GetResolvers(checkable);
+
+	Dictionary::Ptr args = new Dictionary();
+
+	for (const String& name : { "lookup", "server", "query_type", "expected_answers", "wtime", "ctime", "timeout" })
+		args->Set(name, ResolveMacro("dns_" + name, resolvers, checkable, resolvedMacros, useResolvedMacros));
+
+	if (resolvedMacros && !useResolvedMacros)
+		return;
+
+	Checkable::IncreasePendingChecks();
+
+	Probe(args, cr, boost::bind(&NetworkProbe::ProcessCheckResult, checkable, _1));
+}
+
+/**
+ * Starts a DNS probe.
+ *
+ * @param args The resolved arguments: lookup, server, query_type,
+ *        expected_answers, wtime, ctime and timeout.
+ * @param cr The check result which is filled in.
+ * @param callback Invoked with the check result once the probe has finished.
+ */
+void DnsCheckTask::Probe(const Dictionary::Ptr& args, const CheckResult::Ptr& cr, const CompletionCallback& callback)
+{
+	if (String(args->Get("lookup")).IsEmpty()) {
+		ReportFailure(cr, ServiceUnknown, "DNS UNKNOWN - Macro 'dns_lookup' must be set.", callback);
+		return;
+	}
+
+	String queryType = args->Get("query_type");
+	int type = ParseQueryType(queryType.IsEmpty() ? "A" : queryType);
+
+	if (type < 0) {
+		ReportFailure(cr, ServiceUnknown, "DNS UNKNOWN - Unsupported query type '" + queryType + "'.", callback);
+		return;
+	}
+
+	if (String(args->Get("server")).IsEmpty())
+		args->Set("server", GetDefaultServer());
+
+	if (args->Get("timeout").IsEmpty())
+		args->Set("timeout", 10);
+
+	int connectError;
+	Socket::Ptr socket;
+
+	try {
+		socket = Connect(args->Get("server"), "53", SOCK_DGRAM, connectError);
+	} catch (const std::exception& ex) {
+		ReportFailure(cr, ServiceUnknown, ex.what(), callback);
+		return;
+	}
+
+	DnsCheckTask::Ptr probe = new DnsCheckTask(socket, args, type, cr);
+	probe->Start(callback, connectError);
+}
+
+void DnsCheckTask::OnConnected(void)
+{
+	try {
+		Send(BuildQuery(m_Lookup, m_Type, m_ID));
+	} catch (const std::exception& ex) {
+		Finish(ServiceUnknown, "DNS UNKNOWN - " + String(ex.what()));
+	}
+}
+
+void DnsCheckTask::OnData(const char *data, size_t length)
+{
+	std::vector<String> answers;
+	int rcode;
+
+	try {
+		rcode = ParseResponse(String(data, data + length), m_Type, m_ID, answers);
+	} catch (const std::exception& ex) {
+		Finish(ServiceCritical, "DNS CRITICAL - Invalid response from DNS server: " + String(ex.what()));
+		return;
+	}
+
+	/* not the response to our query, keep waiting */
+	if (rcode < 0)
+		return;
+
+	double elapsed = GetElapsed();
+
+	if (rcode == 3) {
+		Finish(ServiceCritical, "DNS CRITICAL - Domain '" + m_Lookup + "' was not found by the server");
+		return;
+	}
+
+	if (rcode != 0) {
+		Finish(ServiceCritical, "DNS CRITICAL - Server " + GetHost() + " returned error code " + Convert::ToString(rcode));
+		return;
+	}
+
+	if (answers.empty()) {
+		Finish(ServiceCritical, "DNS CRITICAL - '" + m_Lookup + "' returns no records");
+		return;
+	}
+
+	std::sort(answers.begin(), answers.end());
+	String result = boost::algorithm::join(answers, ",");
+
+	if (!m_ExpectedAnswers.IsEmpty()) {
+		std::vector<String> expected;
+		boost::algorithm::split(expected, m_ExpectedAnswers, boost::is_any_of(","));
+		std::sort(expected.begin(), expected.end());
+
+		if (expected != answers) {
+			Finish(ServiceCritical, "DNS CRITICAL - expected '" + m_ExpectedAnswers + "' but got '" + result + "'");
+			return;
+		}
+	}
+
+	ServiceState state = CheckThresholds(elapsed, m_WarnTime, m_CritTime);
+
+	String output = "DNS " + Service::StateToString(state) + ": " + FormatSeconds(elapsed)
+	    + " seconds response time. " + m_Lookup + " returns " + result;
+
+	Array::Ptr perfdata = new Array();
+	perfdata->Add(new PerfdataValue("time", elapsed, false, "seconds", m_WarnTime, m_CritTime, 0));
+
+	Finish(state, output, perfdata);
+}
+
+/**
+ * Returns the numeric resource record type for a query type name or -1
+ * if the type is not supported.
+ */
+int DnsCheckTask::ParseQueryType(const String& type)
+{
+	if (type == "A")
+		return 1;
+	else if (type == "NS")
+		return 2;
+	else if (type == "CNAME")
+		return 5;
+	else if (type == "PTR")
+		return 12;
+	else if (type == "MX")
+		return 15;
+	else if (type == "TXT")
+		return 16;
+	else if (type == "AAAA")
+		return 28;
+	else
+		return -1;
+}
+
+/**
+ * Builds a recursive query for a single name.
+ */
+String DnsCheckTask::BuildQuery(const String& name, int type, unsigned short id)
+{
+	String query;
+
+	query += static_cast<char>(id >> 8);
+	query += static_cast<char>(id & 0xff);
+
+	/* flags: recursion desired; one question */
+	const char header[] = { 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+	query.GetData().append(header, sizeof(header));
+
+	std::vector<String> labels;
+	boost::algorithm::split(labels, name, boost::is_any_of("."));
+
+	for (const String& label : labels) {
+		if (label.IsEmpty())
+			continue;
+
+		if (label.GetLength() > 63)
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid domain name: " + name));
+
+		query += static_cast<char>(label.GetLength());
+		query += label;
+	}
+
+	query += '\0';
+
+	query += static_cast<char>(type >> 8);
+	query += static_cast<char>(type & 0xff);
+
+	/* class IN */
+	query += '\0';
+	query += '\x01';
+
+	return query;
+}
+
+static unsigned short ReadUInt16(const String& message, size_t pos)
+{
+	if (pos + 2 > message.GetLength())
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Truncated message"));
+
+	return (static_cast<unsigned char>(message[pos]) << 8) | static_cast<unsigned char>(message[pos + 1]);
+}
+
+static String ReadName(const String& message, size_t& pos)
+{
+	String name;
+	size_t current = pos;
+	bool jumped = false;
+
+	for (int i = 0; i < 128; i++) {
+		if (current >= message.GetLength())
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Truncated name"));
+
+		unsigned char length = message[current];
+
+		if (length == 0) {
+			if (!jumped)
+				pos = current + 1;
+
+			return name;
+		}
+
+		if ((length & 0xc0) == 0xc0) {
+			size_t target = ReadUInt16(message, current) & 0x3fff;
+
+			if (!jumped)
+				pos = current + 2;
+
+			jumped = true;
+			current = target;
+			continue;
+		}
+
+		if (current + 1 + length > message.GetLength())
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Truncated name"));
+
+		if (!name.IsEmpty())
+			name += ".";
+
+		name += message.SubStr(current + 1, length);
+		current += 1 + length;
+	}
+
+	BOOST_THROW_EXCEPTION(std::invalid_argument("Name compression loop"));
+}
+
+/**
+ * Parses a response and collects the answers of the requested type.
+ *
+ * @returns The response code or -1 if the message is not a response to
+ *          the query with the specified ID.
+ */
+int DnsCheckTask::ParseResponse(const String& response, int type, unsigned short id, std::vector<String>& answers)
+{
+	if (response.GetLength() < 12)
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Truncated header"));
+
+	if (ReadUInt16(response, 0) != id || !(response[2] & 0x80))
+		return -1;
+
+	int rcode = response[3] & 0x0f;
+
+	unsigned short questions = ReadUInt16(response, 4);
+	unsigned short records = ReadUInt16(response, 6);
+
+	size_t pos = 12;
+
+	for (unsigned short i = 0; i < questions; i++) {
+		ReadName(response, pos);
+		pos += 4;
+	}
+
+	for (unsigned short i = 0; i < records; i++) {
+		ReadName(response, pos);
+
+		int rtype = ReadUInt16(response, pos);
+		size_t length = ReadUInt16(response, pos + 8);
+		size_t data = pos + 10;
+
+		if (data + length > response.GetLength())
+			BOOST_THROW_EXCEPTION(std::invalid_argument("Truncated record"));
+
+		pos = data + length;
+
+		if (rtype != type)
+			continue;
+
+		char address[INET6_ADDRSTRLEN];
+
+		switch (type) {
+			case 1:
+			case 28:
+				if (length != (type == 1 ? 4u : 16u))
+					BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid address record"));
+
+				inet_ntop(type == 1 ? AF_INET : AF_INET6, response.CStr() + data, address, sizeof(address));
+				answers.push_back(address);
+				break;
+			case 15:
+				data += 2;
+				answers.push_back(ReadName(response, data));
+				break;
+			case 16:
+				{
+					String text;
+
+					for (size_t offset = data; offset < pos; ) {
+						size_t chunk = static_cast<unsigned char>(response[offset]);
+
+						if (offset + 1 + chunk > pos)
+							BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid text record"));
+
+						text += response.SubStr(offset + 1, chunk);
+						offset += 1 + chunk;
+					}
+
+					answers.push_back(text);
+				}
+				break;
+			default:
+				answers.push_back(ReadName(response, data));
+				break;
+		}
+	}
+
+	return rcode;
+}
+
+static void InitializeDefaultServer(void)
+{
+	l_DefaultServer = "127.0.0.1";
+
+	std::ifstream fp("/etc/resolv.conf");
+	std::string line;
+
+	while (std::getline(fp, line)) {
+		std::vector<String> tokens;
+		boost::algorithm::split(tokens, line, boost::is_any_of(" \t"), boost::token_compress_on);
+
+		if (tokens.size() >= 2 && tokens[0] == "nameserver") {
+			l_DefaultServer = tokens[1];
+			break;
+		}
+	}
+}
+
+/**
+ * Returns the first name server from /etc/resolv.conf.
+ */
+String DnsCheckTask::GetDefaultServer(void)
+{
+	boost::call_once(l_DefaultServerOnce, &InitializeDefaultServer);
+
+	return l_DefaultServer;
+}
@@ -0,0 +1,67 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#ifndef DNSCHECKTASK_H
+#define DNSCHECKTASK_H
+
+#include "methods/networkprobe.hpp"
+
+namespace icinga
+{
+
+/**
+ * Native replacement for check_dns. Sends a single query via UDP and
+ * compares the answers with the expected ones.
+ *
+ * @ingroup methods
+ */
+class I2_METHODS_API DnsCheckTask : public NetworkProbe
+{
+public:
+	DECLARE_PTR_TYPEDEFS(DnsCheckTask);
+
+	static void ScriptFunc(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr,
+	    const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros);
+
+	static void Probe(const Dictionary::Ptr& args, const CheckResult::Ptr& cr, const CompletionCallback& callback);
+
+	static int ParseQueryType(const String& type);
+	static String BuildQuery(const String& name, int type, unsigned short id);
+	static int ParseResponse(const String& response, int type, unsigned short id, std::vector<String>& answers);
+
+protected:
+	virtual void OnConnected(void) override;
+	virtual void OnData(const char *data, size_t length) override;
+
+private:
+	String m_Lookup;
+	int m_Type;
+	unsigned short m_ID;
+	String m_ExpectedAnswers;
+	Value m_WarnTime;
+	Value m_CritTime;
+
+	DnsCheckTask(const Socket::Ptr& socket, const Dictionary::Ptr& args, int type, const CheckResult::Ptr& cr);
+
+	static String GetDefaultServer(void);
+};
+
+}
+
+#endif /* DNSCHECKTASK_H */
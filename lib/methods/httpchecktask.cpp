@@ -0,0 +1,311 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "methods/httpchecktask.hpp"
+#include "icinga/perfdatavalue.hpp"
+#include "base/application.hpp"
+#include "base/function.hpp"
+#include "base/utility.hpp"
+#include "base/convert.hpp"
+#include "base/tlsutility.hpp"
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
+
+using namespace icinga;
+
+REGISTER_SCRIPTFUNCTION_NS(Internal, HttpCheck, &HttpCheckTask::ScriptFunc);
+
+/* Only this much of the response is kept for the status line and the string match. */
+static const size_t l_MaxResponseSize = 1024 * 1024;
+
+HttpCheckTask::HttpCheckTask(const Socket::Ptr& socket, const Dictionary::Ptr& args, const CheckResult::Ptr& cr)
+	: NetworkProbe(socket, args->Get("address"), args->Get("port"), cr, args->Get("timeout")),
+	  m_Args(args), m_UseTls(args->Get("ssl").ToBool()), m_CertificateOnly(!args->Get("certificate").IsEmpty()),
+	  m_ResponseSize(0)
+{ }
+
+void HttpCheckTask::ScriptFunc(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr,
+    const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros)
+{
+	MacroProcessor::ResolverList resolvers = GetResolvers(checkable);
+
+	Dictionary::Ptr args = new Dictionary();
+
+	for (const String& name : { "address", "vhost", "port", "uri", "ssl", "sni", "certificate", "warn_time",
+	    "critical_time", "expect", "string", "onredirect", "method", "timeout" })
+		args->Set(name, ResolveMacro("http_" + name, resolvers, checkable, resolvedMacros, useResolvedMacros));
+
+	if (resolvedMacros && !useResolvedMacros)
+		return;
+
+	Checkable::IncreasePendingChecks();
+
+	Probe(args, cr, boost::bind(&NetworkProbe::ProcessCheckResult, checkable, _1));
+}
+
+/**
+ * Starts an HTTP probe.
+ *
+ * @param args The resolved arguments, named like the http_* custom attributes
+ *        without their prefix.
+ * @param cr The check result which is filled in.
+ * @param callback Invoked with the check result once the probe has finished.
+ */
+void HttpCheckTask::Probe(const Dictionary::Ptr& args, const CheckResult::Ptr& cr, const CompletionCallback& callback)
+{
+	String address = args->Get("address");
+
+	if (address.IsEmpty())
+		address = args->Get("vhost");
+
+	if (address.IsEmpty()) {
+		ReportFailure(cr, ServiceUnknown, "UNKNOWN - Macro 'http_address' or 'http_vhost' must be set.", callback);
+		return;
+	}
+
+	args->Set("address", address);
+
+	String thresholdSpec = args->Get("certificate");
+
+	if (!thresholdSpec.IsEmpty()) {
+		/* Parse the thresholds here rather than on the I/O thread which
+		 * finishes the probe. */
+		std::vector<String> thresholds;
+		boost::algorithm::split(thresholds, thresholdSpec, boost::is_any_of(","));
+
+		try {
+			args->Set("certificate_warn", Convert::ToLong(thresholds[0]));
+			args->Set("certificate_critical", (thresholds.size() > 1) ? Convert::ToLong(thresholds[1]) : 0);
+		} catch (const std::exception&) {
+			ReportFailure(cr, ServiceUnknown, "UNKNOWN - Invalid value '" + thresholdSpec +
+			    "' for macro 'http_certificate', expected 'warn[,crit]' days.", callback);
+			return;
+		}
+
+		/* checking the certificate implies using TLS */
+		args->Set("ssl", true);
+	}
+
+	if (args->Get("port").IsEmpty())
+		args->Set("port", args->Get("ssl").ToBool() ? 443 : 80);
+
+	if (args->Get("timeout").IsEmpty())
+		args->Set("timeout", 10);
+
+	int connectError;
+	Socket::Ptr socket;
+
+	try {
+		socket = Connect(address, args->Get("port"), SOCK_STREAM, connectError);
+	} catch (const std::exception& ex) {
+		ReportFailure(cr, ServiceUnknown, ex.what(), callback);
+		return;
+	}
+
+	HttpCheckTask::Ptr probe = new HttpCheckTask(socket, args, cr);
+	probe->Start(callback, connectError);
+}
+
+void HttpCheckTask::OnConnected(void)
+{
+	if (!m_UseTls) {
+		SendRequest();
+		return;
+	}
+
+	String serverName;
+
+	if (m_Args->Get("sni").ToBool()) {
+		serverName = m_Args->Get("vhost");
+
+		if (serverName.IsEmpty())
+			serverName = GetHost();
+	}
+
+	StartTls(serverName);
+}
+
+void HttpCheckTask::OnTlsEstablished(void)
+{
+	if (m_CertificateOnly)
+		CheckCertificate();
+	else
+		SendRequest();
+}
+
+void HttpCheckTask::OnData(const char *data, size_t length)
+{
+	m_ResponseSize += length;
+
+	if (m_Response.size() < l_MaxResponseSize)
+		m_Response.append(data, std::min(length, l_MaxResponseSize - m_Response.size()));
+}
+
+void HttpCheckTask::OnEof(void)
+{
+	CheckResponse();
+}
+
+void HttpCheckTask::SendRequest(void)
+{
+	String method = m_Args->Get("method");
+
+	if (method.IsEmpty())
+		method = "GET";
+
+	String uri = m_Args->Get("uri");
+
+	if (uri.IsEmpty())
+		uri = "/";
+
+	String hostHeader = m_Args->Get("vhost");
+
+	if (hostHeader.IsEmpty())
+		hostHeader = GetHost();
+
+	if (GetPort() != (m_UseTls ? "443" : "80"))
+		hostHeader += ":" + GetPort();
+
+	/* HTTP/1.0 keeps the response free of chunked encoding */
+	Send(method + " " + uri + " HTTP/1.0\r\n"
+	    "User-Agent: Icinga/" + Application::GetAppVersion() + "\r\n"
+	    "Connection: close\r\n"
+	    "Host: " + hostHeader + "\r\n"
+	    "\r\n");
+}
+
+void HttpCheckTask::CheckCertificate(void)
+{
+	X509 *cert = SSL_get_peer_certificate(GetSSL());
+
+	if (!cert) {
+		Finish(ServiceCritical, "SSL CRITICAL - Cannot retrieve server certificate.");
+		return;
+	}
+
+	boost::shared_ptr<X509> certificate(cert, X509_free);
+
+	int warnDays = m_Args->Get("certificate_warn");
+	int critDays = m_Args->Get("certificate_critical");
+
+	int days, seconds;
+
+	if (!ASN1_TIME_diff(&days, &seconds, NULL, X509_get_notAfter(cert))) {
+		Finish(ServiceUnknown, "SSL UNKNOWN - Cannot parse the certificate's expiry date.");
+		return;
+	}
+
+	double expiry = Utility::GetTime() + days * 86400.0 + seconds;
+	String cn = GetCertificateCN(certificate);
+	String date = Utility::FormatDateTime("%Y-%m-%d %H:%M:%S %z", expiry);
+
+	if (days < 0 || (days == 0 && seconds < 0))
+		Finish(ServiceCritical, "SSL CRITICAL - Certificate '" + cn + "' expired on " + date + ".");
+	else if (days < critDays)
+		Finish(ServiceCritical, "SSL CRITICAL - Certificate '" + cn + "' expires in " + Convert::ToString(days) + " day(s) (" + date + ").");
+	else if (days < warnDays)
+		Finish(ServiceWarning, "SSL WARNING - Certificate '" + cn + "' expires in " + Convert::ToString(days) + " day(s) (" + date + ").");
+	else
+		Finish(ServiceOK, "SSL OK - Certificate '" + cn + "' will expire on " + date + ".");
+}
+
+void HttpCheckTask::CheckResponse(void)
+{
+	double elapsed = GetElapsed();
+
+	size_t lineEnd = m_Response.find("\r\n");
+	String statusLine = m_Response.substr(0, lineEnd);
+
+	std::vector<String> tokens;
+	boost::algorithm::split(tokens, statusLine, boost::is_any_of(" "));
+
+	int statusCode = 0;
+
+	if (tokens.size() >= 2 && tokens[0].SubStr(0, 5) == "HTTP/" && tokens[1].GetLength() == 3 &&
+	    tokens[1].FindFirstNotOf("0123456789") == String::NPos)
+		statusCode = Convert::ToLong(tokens[1]);
+
+	if (statusCode < 100 || statusCode > 599) {
+		Finish(ServiceCritical, "HTTP CRITICAL - Invalid HTTP response received from host on port " + GetPort());
+		return;
+	}
+
+	String expect = m_Args->Get("expect");
+	ServiceState state;
+	String reason;
+
+	if (!expect.IsEmpty()) {
+		std::vector<String> expected;
+		boost::algorithm::split(expected, expect, boost::is_any_of(","));
+
+		state = ServiceCritical;
+
+		for (const String& exp : expected) {
+			if (statusLine.Find(exp) != String::NPos) {
+				state = ServiceOK;
+				break;
+			}
+		}
+
+		if (state != ServiceOK) {
+			Finish(ServiceCritical, "HTTP CRITICAL - Invalid HTTP response received from host on port " + GetPort() + ": " + statusLine);
+			return;
+		}
+	} else if (statusCode >= 500)
+		state = ServiceCritical;
+	else if (statusCode >= 400)
+		state = ServiceWarning;
+	else if (statusCode >= 300) {
+		String onredirect = m_Args->Get("onredirect");
+
+		if (onredirect == "warning")
+			state = ServiceWarning;
+		else if (onredirect == "critical")
+			state = ServiceCritical;
+		else
+			state = ServiceOK;
+	} else
+		state = ServiceOK;
+
+	String search = m_Args->Get("string");
+
+	if (!search.IsEmpty()) {
+		size_t bodyStart = m_Response.find("\r\n\r\n");
+
+		if (bodyStart == std::string::npos || m_Response.find(search.GetData(), bodyStart + 4) == std::string::npos) {
+			state = ServiceCritical;
+			reason = " - string '" + search + "' not found on '" + (m_UseTls ? "https" : "http") + "://"
+			    + GetHost() + ":" + GetPort() + String(m_Args->Get("uri")) + "'";
+		}
+	}
+
+	Value warnTime = m_Args->Get("warn_time");
+	Value critTime = m_Args->Get("critical_time");
+
+	state = MaxState(state, CheckThresholds(elapsed, warnTime, critTime));
+
+	String output = "HTTP " + Service::StateToString(state) + ": " + statusLine + reason + " - "
+	    + Convert::ToString(static_cast<long>(m_ResponseSize)) + " bytes in " + FormatSeconds(elapsed) + " second response time";
+
+	Array::Ptr perfdata = new Array();
+	perfdata->Add(new PerfdataValue("time", elapsed, false, "seconds", warnTime, critTime, 0, GetTimeout()));
+	perfdata->Add(new PerfdataValue("size", m_ResponseSize, false, "bytes", Empty, Empty, 0));
+
+	Finish(state, output, perfdata);
+}
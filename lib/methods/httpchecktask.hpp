@@ -0,0 +1,67 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#ifndef HTTPCHECKTASK_H
+#define HTTPCHECKTASK_H
+
+#include "methods/networkprobe.hpp"
+
+namespace icinga
+{
+
+/**
+ * Native replacement for check_http. Sends a single HTTP request and
+ * checks the status code, response time and body, or only checks the
+ * expiry of the server's certificate.
+ *
+ * @ingroup methods
+ */
+class I2_METHODS_API HttpCheckTask : public NetworkProbe
+{
+public:
+	DECLARE_PTR_TYPEDEFS(HttpCheckTask);
+
+	static void ScriptFunc(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr,
+	    const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros);
+
+	static void Probe(const Dictionary::Ptr& args, const CheckResult::Ptr& cr, const CompletionCallback& callback);
+
+protected:
+	virtual void OnConnected(void) override;
+	virtual void OnTlsEstablished(void) override;
+	virtual void OnData(const char *data, size_t length) override;
+	virtual void OnEof(void) override;
+
+private:
+	Dictionary::Ptr m_Args;
+	bool m_UseTls;
+	bool m_CertificateOnly;
+	std::string m_Response;
+	size_t m_ResponseSize;
+
+	HttpCheckTask(const Socket::Ptr& socket, const Dictionary::Ptr& args, const CheckResult::Ptr& cr);
+
+	void SendRequest(void);
+	void CheckCertificate(void);
+	void CheckResponse(void);
+};
+
+}
+
+#endif /* HTTPCHECKTASK_H */
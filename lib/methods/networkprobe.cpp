@@ -0,0 +1,638 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "methods/networkprobe.hpp"
+#include "icinga/checkcommand.hpp"
+#include "icinga/icingaapplication.hpp"
+#include "base/tlsutility.hpp"
+#include "base/utility.hpp"
+#include "base/convert.hpp"
+#include "base/logger.hpp"
+#include "base/exception.hpp"
+#include <boost/thread/once.hpp>
+#include <boost/exception/errinfo_api_function.hpp>
+#include <boost/exception/errinfo_errno.hpp>
+#include <set>
+
+using namespace icinga;
+
+static boost::mutex l_ProbesMutex;
+static std::set<std::pair<double, NetworkProbe::Ptr> > l_Probes;
+static Timer::Ptr l_ProbeTimeoutTimer;
+
+static boost::once_flag l_ProbeSSLContextOnce = BOOST_ONCE_INIT;
+static boost::shared_ptr<SSL_CTX> l_ProbeSSLContext;
+
+static void InitializeProbeSSLContext(void)
+{
+	l_ProbeSSLContext = MakeSSLContext();
+}
+
+NetworkProbe::NetworkProbe(const Socket::Ptr& socket, const String& host, const String& port,
+    const CheckResult::Ptr& cr, double timeout)
+	: SocketEvents(socket, this), m_Socket(socket), m_Host(host), m_Port(port), m_CheckResult(cr),
+	  m_Timeout(timeout), m_Start(Utility::GetTime()), m_Deadline(m_Start + timeout), m_Connected(false),
+	  m_Handshake(false), m_WantWrite(false), m_Finished(false), m_Completed(false), m_SSL(NULL)
+{ }
+
+NetworkProbe::~NetworkProbe(void)
+{
+	if (m_SSL)
+		SSL_free(m_SSL);
+}
+
+/**
+ * Starts the probe. The callback is invoked exactly once, either from
+ * one of the socket I/O threads or from the timer thread.
+ *
+ * @param callback The function which receives the check result.
+ * @param connectError The error returned by Connect(), if any.
+ */
+void NetworkProbe::Start(const CompletionCallback& callback, int connectError)
+{
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+		m_Callback = callback;
+	}
+
+	{
+		boost::mutex::scoped_lock lock(l_ProbesMutex);
+
+		if (!l_ProbeTimeoutTimer) {
+			l_ProbeTimeoutTimer = new Timer();
+			l_ProbeTimeoutTimer->SetInterval(0.25);
+			l_ProbeTimeoutTimer->OnTimerExpired.connect(boost::bind(&NetworkProbe::TimeoutTimerHandler));
+			l_ProbeTimeoutTimer->Start();
+		}
+
+		l_Probes.insert(std::make_pair(m_Deadline, this));
+	}
+
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+
+		if (connectError != 0)
+			OnError(connectError);
+
+		if (!m_Finished) {
+			UpdateEvents();
+			return;
+		}
+	}
+
+	Complete();
+}
+
+/**
+ * Opens a non-blocking socket and starts connecting it. The connection
+ * is completed asynchronously once the probe has been started.
+ *
+ * @param connectError Set to the error code if connect() failed right
+ *        away (e.g. for refused connections on the loopback interface).
+ * @returns The socket.
+ */
+Socket::Ptr NetworkProbe::Connect(const String& host, const String& port, int socktype, int& connectError)
+{
+	addrinfo hints;
+	addrinfo *result;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = socktype;
+
+	int rc = getaddrinfo(host.CStr(), port.CStr(), &hints, &result);
+
+	if (rc != 0)
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid hostname, address or socket: " + host));
+
+	SOCKET fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+
+	if (fd == INVALID_SOCKET) {
+#ifdef _WIN32
+		int error = WSAGetLastError();
+#else /* _WIN32 */
+		int error = errno;
+#endif /* _WIN32 */
+
+		freeaddrinfo(result);
+
+		BOOST_THROW_EXCEPTION(std::runtime_error("Cannot create socket: " + Utility::FormatErrorNumber(error)));
+	}
+
+	Socket::Ptr socket = new Socket(fd);
+	socket->MakeNonBlocking();
+
+#ifndef _WIN32
+	Utility::SetCloExec(fd);
+#endif /* _WIN32 */
+
+	connectError = 0;
+
+	if (connect(fd, result->ai_addr, result->ai_addrlen) < 0) {
+#ifdef _WIN32
+		connectError = WSAGetLastError();
+
+		if (connectError == WSAEWOULDBLOCK)
+			connectError = 0;
+#else /* _WIN32 */
+		connectError = errno;
+
+		if (connectError == EINPROGRESS)
+			connectError = 0;
+#endif /* _WIN32 */
+	}
+
+	freeaddrinfo(result);
+
+	return socket;
+}
+
+/**
+ * Reports a result for a probe which could not be started.
+ */
+void NetworkProbe::ReportFailure(const CheckResult::Ptr& cr, ServiceState state, const String& output,
+    const CompletionCallback& callback)
+{
+	double now = Utility::GetTime();
+
+	cr->SetState(state);
+	cr->SetExitStatus(state);
+	cr->SetOutput(output);
+	cr->SetExecutionStart(now);
+	cr->SetExecutionEnd(now);
+
+	callback(cr);
+}
+
+/**
+ * Hands a finished check result back to the checkable. This is used as
+ * the completion callback by the check tasks.
+ */
+void NetworkProbe::ProcessCheckResult(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr)
+{
+	Checkable::DecreasePendingChecks();
+
+	Utility::QueueAsyncCallback(boost::bind(&Checkable::ProcessCheckResult, checkable, cr, MessageOrigin::Ptr()));
+}
+
+void NetworkProbe::OnTlsEstablished(void)
+{ }
+
+void NetworkProbe::OnEof(void)
+{
+	Finish(ServiceCritical, "CRITICAL - Connection closed by remote host");
+}
+
+void NetworkProbe::OnError(int error)
+{
+	Finish(ServiceCritical, FormatConnectError(m_Host, m_Port, error));
+}
+
+void NetworkProbe::OnTimeout(void)
+{
+	Finish(ServiceCritical, "CRITICAL - Socket timeout after " + Convert::ToString(static_cast<long>(m_Timeout)) + " seconds");
+}
+
+/**
+ * Queues data for sending. Must be called from one of the hooks.
+ */
+void NetworkProbe::Send(const String& data)
+{
+	m_SendBuffer.append(data.Begin(), data.End());
+}
+
+/**
+ * Starts a TLS handshake on the connected socket. OnTlsEstablished() is
+ * called once the handshake has finished. Must be called from one of the
+ * hooks.
+ *
+ * @param serverName The server name for SNI, may be empty.
+ */
+void NetworkProbe::StartTls(const String& serverName)
+{
+	boost::call_once(l_ProbeSSLContextOnce, &InitializeProbeSSLContext);
+
+	m_SSL = SSL_new(l_ProbeSSLContext.get());
+
+	if (!m_SSL) {
+		Finish(ServiceUnknown, "UNKNOWN - Cannot create SSL context.");
+		return;
+	}
+
+	SSL_set_fd(m_SSL, m_Socket->GetFD());
+
+	if (!serverName.IsEmpty())
+		SSL_set_tlsext_host_name(m_SSL, serverName.CStr());
+
+	SSL_set_connect_state(m_SSL);
+
+	m_Handshake = true;
+
+	HandleHandshake();
+}
+
+/**
+ * Sets the result for this probe. Only the first call has an effect; the
+ * connection is closed once the current hook returns.
+ */
+void NetworkProbe::Finish(ServiceState state, const String& output, const Array::Ptr& perfdata)
+{
+	if (m_Finished)
+		return;
+
+	m_Finished = true;
+
+	m_CheckResult->SetState(state);
+	m_CheckResult->SetExitStatus(state);
+	m_CheckResult->SetOutput(output);
+	m_CheckResult->SetPerformanceData(perfdata);
+	m_CheckResult->SetExecutionStart(m_Start);
+	m_CheckResult->SetExecutionEnd(Utility::GetTime());
+}
+
+SSL *NetworkProbe::GetSSL(void) const
+{
+	return m_SSL;
+}
+
+double NetworkProbe::GetElapsed(void) const
+{
+	return Utility::GetTime() - m_Start;
+}
+
+double NetworkProbe::GetTimeout(void) const
+{
+	return m_Timeout;
+}
+
+String NetworkProbe::GetHost(void) const
+{
+	return m_Host;
+}
+
+String NetworkProbe::GetPort(void) const
+{
+	return m_Port;
+}
+
+String NetworkProbe::FormatConnectError(const String& host, const String& port, int error)
+{
+	return "connect to address " + host + " and port " + port + ": " + Utility::FormatErrorNumber(error);
+}
+
+MacroProcessor::ResolverList NetworkProbe::GetResolvers(const Checkable::Ptr& checkable)
+{
+	Host::Ptr host;
+	Service::Ptr service;
+	tie(host, service) = GetHostService(checkable);
+
+	MacroProcessor::ResolverList resolvers;
+	if (service)
+		resolvers.push_back(std::make_pair("service", service));
+	resolvers.push_back(std::make_pair("host", host));
+	resolvers.push_back(std::make_pair("command", checkable->GetCheckCommand()));
+	resolvers.push_back(std::make_pair("icinga", IcingaApplication::GetInstance()));
+
+	return resolvers;
+}
+
+/**
+ * Resolves a single custom attribute for a check task.
+ *
+ * @returns The value or Empty if the macro could not be resolved.
+ */
+Value NetworkProbe::ResolveMacro(const String& name, const MacroProcessor::ResolverList& resolvers,
+    const Checkable::Ptr& checkable, const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros)
+{
+	String missingMacro;
+
+	Value value = MacroProcessor::ResolveMacros("$" + name + "$", resolvers, checkable->GetLastCheckResult(),
+	    &missingMacro, MacroProcessor::EscapeCallback(), resolvedMacros, useResolvedMacros);
+
+	if (!missingMacro.IsEmpty())
+		return Empty;
+
+	return value;
+}
+
+String NetworkProbe::FormatSeconds(double seconds)
+{
+	char buffer[32];
+	sprintf(buffer, "%.3f", seconds);
+	return buffer;
+}
+
+ServiceState NetworkProbe::MaxState(ServiceState a, ServiceState b)
+{
+	if (a == ServiceCritical || b == ServiceCritical)
+		return ServiceCritical;
+
+	return std::max(a, b);
+}
+
+/**
+ * Compares a value against the warning and critical thresholds the way
+ * the monitoring plugins do for simple "greater than" ranges.
+ */
+ServiceState NetworkProbe::CheckThresholds(double value, const Value& warn, const Value& crit)
+{
+	if (!crit.IsEmpty() && value > static_cast<double>(crit))
+		return ServiceCritical;
+
+	if (!warn.IsEmpty() && value > static_cast<double>(warn))
+		return ServiceWarning;
+
+	return ServiceOK;
+}
+
+void NetworkProbe::OnEvent(int revents)
+{
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+
+		if (m_Finished)
+			return;
+
+		if (!m_Connected)
+			HandleConnect();
+		else if (m_Handshake)
+			HandleHandshake();
+		else {
+			if (revents & (POLLIN | POLLHUP | POLLERR))
+				HandleRead();
+
+			if (!m_Finished && (revents & POLLOUT))
+				HandleWrite();
+		}
+
+		if (!m_Finished) {
+			UpdateEvents();
+			return;
+		}
+	}
+
+	Complete();
+}
+
+void NetworkProbe::HandleConnect(void)
+{
+	int error = 0;
+	socklen_t len = sizeof(error);
+
+	if (getsockopt(m_Socket->GetFD(), SOL_SOCKET, SO_ERROR, reinterpret_cast<char *>(&error), &len) < 0) {
+#ifdef _WIN32
+		error = WSAGetLastError();
+#else /* _WIN32 */
+		error = errno;
+#endif /* _WIN32 */
+	}
+
+	if (error != 0) {
+		OnError(error);
+		return;
+	}
+
+	m_Connected = true;
+
+	OnConnected();
+
+	if (!m_Finished && !m_Handshake)
+		HandleWrite();
+}
+
+void NetworkProbe::HandleHandshake(void)
+{
+	ERR_clear_error();
+
+	int rc = SSL_connect(m_SSL);
+
+	if (rc == 1) {
+		m_Handshake = false;
+		m_WantWrite = false;
+
+		OnTlsEstablished();
+
+		if (!m_Finished)
+			HandleWrite();
+
+		return;
+	}
+
+	switch (SSL_get_error(m_SSL, rc)) {
+		case SSL_ERROR_WANT_READ:
+			m_WantWrite = false;
+			break;
+		case SSL_ERROR_WANT_WRITE:
+			m_WantWrite = true;
+			break;
+		default:
+			Finish(ServiceCritical, "CRITICAL - Cannot make SSL connection.");
+			break;
+	}
+}
+
+void NetworkProbe::HandleRead(void)
+{
+	char buffer[16 * 1024];
+
+	while (!m_Finished) {
+		int rc;
+
+		if (m_SSL) {
+			ERR_clear_error();
+
+			rc = SSL_read(m_SSL, buffer, sizeof(buffer));
+
+			if (rc <= 0) {
+				int error = SSL_get_error(m_SSL, rc);
+
+				if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE)
+					return;
+
+				if (error == SSL_ERROR_SYSCALL && errno != 0)
+					OnError(errno);
+				else
+					OnEof();
+
+				return;
+			}
+		} else {
+			rc = recv(m_Socket->GetFD(), buffer, sizeof(buffer), 0);
+
+			if (rc < 0) {
+#ifdef _WIN32
+				int error = WSAGetLastError();
+
+				if (error == WSAEWOULDBLOCK)
+					return;
+#else /* _WIN32 */
+				int error = errno;
+
+				if (error == EAGAIN || error == EWOULDBLOCK || error == EINTR)
+					return;
+#endif /* _WIN32 */
+
+				OnError(error);
+				return;
+			}
+
+			if (rc == 0) {
+				OnEof();
+				return;
+			}
+		}
+
+		OnData(buffer, rc);
+	}
+}
+
+void NetworkProbe::HandleWrite(void)
+{
+	while (!m_Finished && !m_SendBuffer.empty()) {
+		int rc;
+
+		if (m_SSL) {
+			ERR_clear_error();
+
+			rc = SSL_write(m_SSL, m_SendBuffer.c_str(), m_SendBuffer.size());
+
+			if (rc <= 0) {
+				int error = SSL_get_error(m_SSL, rc);
+
+				if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE)
+					return;
+
+				Finish(ServiceCritical, "CRITICAL - Error sending data to " + m_Host + ".");
+				return;
+			}
+		} else {
+#ifdef MSG_NOSIGNAL
+			rc = send(m_Socket->GetFD(), m_SendBuffer.c_str(), m_SendBuffer.size(), MSG_NOSIGNAL);
+#else /* MSG_NOSIGNAL */
+			rc = send(m_Socket->GetFD(), m_SendBuffer.c_str(), m_SendBuffer.size(), 0);
+#endif /* MSG_NOSIGNAL */
+
+			if (rc < 0) {
+#ifdef _WIN32
+				int error = WSAGetLastError();
+
+				if (error == WSAEWOULDBLOCK)
+					return;
+#else /* _WIN32 */
+				int error = errno;
+
+				if (error == EAGAIN || error == EWOULDBLOCK || error == EINTR)
+					return;
+#endif /* _WIN32 */
+
+				OnError(error);
+				return;
+			}
+		}
+
+		m_SendBuffer.erase(0, rc);
+	}
+}
+
+void NetworkProbe::UpdateEvents(void)
+{
+	int events;
+
+	if (!m_Connected)
+		events = POLLOUT;
+	else if (m_Handshake)
+		events = m_WantWrite ? POLLOUT : POLLIN;
+	else
+		events = m_SendBuffer.empty() ? POLLIN : (POLLIN | POLLOUT);
+
+	ChangeEvents(events);
+}
+
+void NetworkProbe::HandleTimeout(void)
+{
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+
+		if (m_Finished)
+			return;
+
+		OnTimeout();
+
+		/* make sure the probe terminates even if OnTimeout() was overridden */
+		NetworkProbe::OnTimeout();
+	}
+
+	Complete();
+}
+
+void NetworkProbe::Complete(void)
+{
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+
+		if (m_Completed)
+			return;
+
+		m_Completed = true;
+	}
+
+	Unregister();
+
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+
+		if (m_SSL) {
+			SSL_free(m_SSL);
+			m_SSL = NULL;
+		}
+
+		m_Socket->Close();
+	}
+
+	{
+		boost::mutex::scoped_lock lock(l_ProbesMutex);
+		l_Probes.erase(std::make_pair(m_Deadline, NetworkProbe::Ptr(this)));
+	}
+
+	try {
+		m_Callback(m_CheckResult);
+	} catch (const std::exception& ex) {
+		Log(LogCritical, "NetworkProbe")
+		    << "Exception thrown in completion callback for probe of '" << m_Host << "': " << DiagnosticInformation(ex);
+	}
+}
+
+void NetworkProbe::TimeoutTimerHandler(void)
+{
+	std::vector<NetworkProbe::Ptr> expired;
+
+	{
+		boost::mutex::scoped_lock lock(l_ProbesMutex);
+
+		double now = Utility::GetTime();
+
+		while (!l_Probes.empty() && l_Probes.begin()->first <= now) {
+			expired.push_back(l_Probes.begin()->second);
+			l_Probes.erase(l_Probes.begin());
+		}
+	}
+
+	for (const NetworkProbe::Ptr& probe : expired)
+		probe->HandleTimeout();
+}
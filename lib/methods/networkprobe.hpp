@@ -0,0 +1,126 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#ifndef NETWORKPROBE_H
+#define NETWORKPROBE_H
+
+#include "methods/i2-methods.hpp"
+#include "icinga/service.hpp"
+#include "icinga/macroprocessor.hpp"
+#include "base/socket.hpp"
+#include "base/socketevents.hpp"
+#include "base/timer.hpp"
+#include <openssl/ssl.h>
+
+namespace icinga
+{
+
+/**
+ * Base class for check methods which talk to a network service without
+ * running a plugin. Probes connect without blocking and are driven by the
+ * socket event engine, so thousands of them can be in progress at once.
+ *
+ * Derived classes implement the protocol by overriding the On*() hooks and
+ * report the result with Finish(). The hooks are called with the probe's
+ * mutex held; they must not block.
+ *
+ * @ingroup methods
+ */
+class I2_METHODS_API NetworkProbe : public Object, private SocketEvents
+{
+public:
+	DECLARE_PTR_TYPEDEFS(NetworkProbe);
+
+	typedef boost::function<void (const CheckResult::Ptr&)> CompletionCallback;
+
+	~NetworkProbe(void);
+
+	void Start(const CompletionCallback& callback, int connectError = 0);
+
+	static void ProcessCheckResult(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
+
+protected:
+	NetworkProbe(const Socket::Ptr& socket, const String& host, const String& port,
+	    const CheckResult::Ptr& cr, double timeout);
+
+	virtual void OnConnected(void) = 0;
+	virtual void OnTlsEstablished(void);
+	virtual void OnData(const char *data, size_t length) = 0;
+	virtual void OnEof(void);
+	virtual void OnError(int error);
+	virtual void OnTimeout(void);
+
+	void Send(const String& data);
+	void StartTls(const String& serverName);
+	void Finish(ServiceState state, const String& output, const Array::Ptr& perfdata = Array::Ptr());
+
+	SSL *GetSSL(void) const;
+	double GetElapsed(void) const;
+	double GetTimeout(void) const;
+	String GetHost(void) const;
+	String GetPort(void) const;
+
+	static Socket::Ptr Connect(const String& host, const String& port, int socktype, int& connectError);
+	static void ReportFailure(const CheckResult::Ptr& cr, ServiceState state, const String& output,
+	    const CompletionCallback& callback);
+	static String FormatConnectError(const String& host, const String& port, int error);
+
+	static MacroProcessor::ResolverList GetResolvers(const Checkable::Ptr& checkable);
+	static Value ResolveMacro(const String& name, const MacroProcessor::ResolverList& resolvers,
+	    const Checkable::Ptr& checkable, const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros);
+
+	static String FormatSeconds(double seconds);
+	static ServiceState MaxState(ServiceState a, ServiceState b);
+	static ServiceState CheckThresholds(double value, const Value& warn, const Value& crit);
+
+private:
+	boost::mutex m_Mutex;
+	Socket::Ptr m_Socket;
+	String m_Host;
+	String m_Port;
+	CheckResult::Ptr m_CheckResult;
+	CompletionCallback m_Callback;
+	double m_Timeout;
+	double m_Start;
+	double m_Deadline;
+
+	bool m_Connected;
+	bool m_Handshake;
+	bool m_WantWrite;
+	bool m_Finished;
+	bool m_Completed;
+	SSL *m_SSL;
+	std::string m_SendBuffer;
+
+	virtual void OnEvent(int revents) override;
+
+	void HandleConnect(void);
+	void HandleHandshake(void);
+	void HandleRead(void);
+	void HandleWrite(void);
+	void UpdateEvents(void);
+	void HandleTimeout(void);
+	void Complete(void);
+
+	static void TimeoutTimerHandler(void);
+};
+
+}
+
+#endif /* NETWORKPROBE_H */
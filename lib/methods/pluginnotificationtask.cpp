@@ -29,6 +29,7 @@
 #include "base/utility.hpp"
 #include "base/process.hpp"
 #include "base/convert.hpp"
+#include "base/json.hpp"
 
 using namespace icinga;
 
@@ -39,23 +40,71 @@ void PluginNotificationTask::ScriptFunc(const Notification::Ptr& notification,
     const String& author, const String& comment, const Dictionary::Ptr& resolvedMacros,
     bool useResolvedMacros)
 {
-	NotificationCommand::Ptr commandObj = notification->GetCommand();
+	PendingNotification pn;
+	pn.NotificationObject = notification;
+	pn.UserObject = user;
+	pn.CR = cr;
+	pn.Type = static_cast<NotificationType>(itype);
+	pn.Author = author;
+	pn.Comment = comment;
+
+	/* Macros which are resolved for (or by) another endpoint belong to
+	 * exactly one notification and can't be aggregated. */
+	if (!resolvedMacros && NotificationAggregator::Enqueue(notification->GetCommand(), pn, &PluginNotificationTask::ExecuteAggregated))
+		return;
+
+	ExecuteNotification(pn, Dictionary::Ptr(), resolvedMacros, useResolvedMacros);
+}
+
+void PluginNotificationTask::ExecuteAggregated(const std::vector<PendingNotification>& notifications)
+{
+	const PendingNotification& first = notifications[0];
+
+	String summary;
+
+	for (const PendingNotification& pn : notifications) {
+		if (!summary.IsEmpty())
+			summary += "\n";
+
+		summary += GetNotificationSummary(pn);
+	}
+
+	Dictionary::Ptr aggregation = new Dictionary();
+	aggregation->Set("aggregated_count", notifications.size());
+	aggregation->Set("aggregated_summary", summary);
 
-	NotificationType type = static_cast<NotificationType>(itype);
+	if (notifications.size() > 1) {
+		Log(LogInformation, "PluginNotificationTask")
+		    << "Sending " << notifications.size() << " '" << Notification::NotificationTypeToString(first.Type)
+		    << "' notifications for user '" << first.UserObject->GetName() << "' with a single invocation of command '"
+		    << first.NotificationObject->GetCommand()->GetName() << "'.";
+	}
+
+	ExecuteNotification(first, aggregation, Dictionary::Ptr(), false);
+}
+
+void PluginNotificationTask::ExecuteNotification(const PendingNotification& pn, const Dictionary::Ptr& aggregation,
+    const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros)
+{
+	Notification::Ptr notification = pn.NotificationObject;
+	NotificationCommand::Ptr commandObj = notification->GetCommand();
 
 	Checkable::Ptr checkable = notification->GetCheckable();
 
 	Dictionary::Ptr notificationExtra = new Dictionary();
-	notificationExtra->Set("type", Notification::NotificationTypeToString(type));
-	notificationExtra->Set("author", author);
-	notificationExtra->Set("comment", comment);
+	notificationExtra->Set("type", Notification::NotificationTypeToString(pn.Type));
+	notificationExtra->Set("author", pn.Author);
+	notificationExtra->Set("comment", pn.Comment);
+
+	if (aggregation)
+		aggregation->CopyTo(notificationExtra);
 
 	Host::Ptr host;
 	Service::Ptr service;
 	tie(host, service) = GetHostService(checkable);
 
 	MacroProcessor::ResolverList resolvers;
-	resolvers.push_back(std::make_pair("user", user));
+	resolvers.push_back(std::make_pair("user", pn.UserObject));
 	resolvers.push_back(std::make_pair("notification", notificationExtra));
 	resolvers.push_back(std::make_pair("notification", notification));
 	if (service)
@@ -64,9 +113,81 @@ void PluginNotificationTask::ScriptFunc(const Notification::Ptr& notification,
 	resolvers.push_back(std::make_pair("command", commandObj));
 	resolvers.push_back(std::make_pair("icinga", IcingaApplication::GetInstance()));
 
-	PluginUtility::ExecuteCommand(commandObj, checkable, cr, resolvers,
-	    resolvedMacros, useResolvedMacros,
-	    boost::bind(&PluginNotificationTask::ProcessFinishedHandler, checkable, _1, _2));
+	boost::function<void (const Value&, const ProcessResult&)> callback =
+	    boost::bind(&PluginNotificationTask::ProcessFinishedHandler, checkable, _1, _2);
+
+	/* only collecting the macros for another endpoint */
+	if (resolvedMacros && !useResolvedMacros) {
+		PluginUtility::ExecuteCommand(commandObj, checkable, pn.CR, resolvers,
+		    resolvedMacros, useResolvedMacros, callback);
+		return;
+	}
+
+	double window = commandObj->GetAggregationWindow();
+
+	if (window <= 0 && commandObj->GetRateLimit() <= 0) {
+		PluginUtility::ExecuteCommand(commandObj, checkable, pn.CR, resolvers,
+		    resolvedMacros, useResolvedMacros, callback);
+		return;
+	}
+
+	Dictionary::Ptr macros = resolvedMacros;
+	String commandLine;
+
+	/* The resolved macros identify the command line: users which share
+	 * a command line (e.g. a chat channel) only need one invocation. */
+	if (window > 0) {
+		if (!macros) {
+			macros = new Dictionary();
+			PluginUtility::ExecuteCommand(commandObj, checkable, pn.CR, resolvers,
+			    macros, false, boost::function<void (const Value&, const ProcessResult&)>());
+		}
+
+		try {
+			commandLine = JsonEncode(macros);
+		} catch (const std::exception&) {
+			/* not every macro value can be serialized: don't skip anything then */
+		}
+	}
+
+	if (!NotificationAggregator::ShouldExecute(commandObj, commandLine))
+		return;
+
+	if (macros)
+		PluginUtility::ExecuteCommand(commandObj, checkable, pn.CR, resolvers,
+		    macros, true, callback);
+	else
+		PluginUtility::ExecuteCommand(commandObj, checkable, pn.CR, resolvers,
+		    resolvedMacros, useResolvedMacros, callback);
+}
+
+String PluginNotificationTask::GetNotificationSummary(const PendingNotification& pn)
+{
+	Checkable::Ptr checkable = pn.NotificationObject->GetCheckable();
+
+	Host::Ptr host;
+	Service::Ptr service;
+	tie(host, service) = GetHostService(checkable);
+
+	String summary;
+
+	if (service)
+		summary = host->GetName() + "!" + service->GetShortName() + " is " + Service::StateToString(service->GetState());
+	else
+		summary = host->GetName() + " is " + Host::StateToString(host->GetState());
+
+	if (pn.CR) {
+		String output = pn.CR->GetOutput();
+		size_t pos = output.FindFirstOf("\r\n");
+
+		if (pos != String::NPos)
+			output = output.SubStr(0, pos);
+
+		if (!output.IsEmpty())
+			summary += ": " + output;
+	}
+
+	return summary;
 }
 
 void PluginNotificationTask::ProcessFinishedHandler(const Checkable::Ptr& checkable, const Value& commandLine, const ProcessResult& pr)
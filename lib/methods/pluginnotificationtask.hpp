@@ -23,6 +23,7 @@
 #include "methods/i2-methods.hpp"
 #include "icinga/notification.hpp"
 #include "icinga/service.hpp"
+#include "icinga/notificationaggregator.hpp"
 #include "base/process.hpp"
 
 namespace icinga
@@ -44,6 +45,11 @@ public:
 private:
 	PluginNotificationTask(void);
 
+	static void ExecuteAggregated(const std::vector<PendingNotification>& notifications);
+	static void ExecuteNotification(const PendingNotification& pn, const Dictionary::Ptr& aggregation,
+	    const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros);
+	static String GetNotificationSummary(const PendingNotification& pn);
+
 	static void ProcessFinishedHandler(const Checkable::Ptr& checkable,
 	    const Value& commandLine, const ProcessResult& pr);
 };
@@ -0,0 +1,423 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "methods/simulationchecktask.hpp"
+#include "icinga/perfdatavalue.hpp"
+#include "icinga/icingaapplication.hpp"
+#include "icinga/macroprocessor.hpp"
+#include "base/objectlock.hpp"
+#include "base/function.hpp"
+#include "base/utility.hpp"
+#include "base/convert.hpp"
+#include "base/logger.hpp"
+#include "base/timer.hpp"
+#include "base/ringbuffer.hpp"
+#include "base/statsfunction.hpp"
+#include <boost/thread/thread.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/once.hpp>
+#include <cmath>
+#include <map>
+
+using namespace icinga;
+
+REGISTER_SCRIPTFUNCTION_NS(Internal, SimulationCheck, &SimulationCheckTask::ScriptFunc);
+REGISTER_STATSFUNCTION(SimulationCheckTask, &SimulationCheckTask::StatsFunc);
+
+namespace {
+
+struct SimulatedCheck
+{
+	Checkable::Ptr Object;
+	CheckResult::Ptr Result;
+};
+
+/* Statistics for one report interval. */
+struct SimulationWindow
+{
+	double Start;
+	unsigned long Checks;
+	double DriftSum;
+	double DriftMax;
+	double DelaySum;
+	double DelayMax;
+
+	SimulationWindow(void)
+		: Start(0), Checks(0), DriftSum(0), DriftMax(0), DelaySum(0), DelayMax(0)
+	{ }
+};
+
+}
+
+static boost::once_flag l_SimulationOnceFlag = BOOST_ONCE_INIT;
+static boost::mutex l_SimulationMutex;
+static boost::condition_variable l_SimulationCV;
+static std::multimap<double, SimulatedCheck> l_SimulatedChecks;
+static RingBuffer l_SimulationChecks(15 * 60);
+static unsigned long l_SimulationExecuted = 0;
+static SimulationWindow l_SimulationWindow;
+static Dictionary::Ptr l_SimulationLastReport;
+static Timer::Ptr l_SimulationReportTimer;
+
+static Value ResolveArgument(const String& name, const Value& defaultValue, const MacroProcessor::ResolverList& resolvers,
+    const Checkable::Ptr& checkable, const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros)
+{
+	String missingMacro;
+
+	Value value = MacroProcessor::ResolveMacros("$" + name + "$", resolvers, checkable->GetLastCheckResult(),
+	    &missingMacro, MacroProcessor::EscapeCallback(), resolvedMacros, useResolvedMacros);
+
+	if (!missingMacro.IsEmpty() || value.IsEmpty())
+		return defaultValue;
+
+	return value;
+}
+
+void SimulationCheckTask::ScriptFunc(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr,
+    const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros)
+{
+	CheckCommand::Ptr commandObj = checkable->GetCheckCommand();
+
+	Host::Ptr host;
+	Service::Ptr service;
+	tie(host, service) = GetHostService(checkable);
+
+	MacroProcessor::ResolverList resolvers;
+	if (service)
+		resolvers.push_back(std::make_pair("service", service));
+	resolvers.push_back(std::make_pair("host", host));
+	resolvers.push_back(std::make_pair("command", commandObj));
+	resolvers.push_back(std::make_pair("icinga", IcingaApplication::GetInstance()));
+
+	String distribution = ResolveArgument("simulation_latency_distribution", "fixed", resolvers, checkable, resolvedMacros, useResolvedMacros);
+	double latency = ResolveArgument("simulation_latency", 1, resolvers, checkable, resolvedMacros, useResolvedMacros);
+	double deviation = ResolveArgument("simulation_latency_deviation", latency / 4, resolvers, checkable, resolvedMacros, useResolvedMacros);
+	double shape = ResolveArgument("simulation_latency_shape", 2, resolvers, checkable, resolvedMacros, useResolvedMacros);
+	double maxLatency = ResolveArgument("simulation_latency_max", commandObj->GetTimeout(), resolvers, checkable, resolvedMacros, useResolvedMacros);
+	int outputSize = ResolveArgument("simulation_output_size", 0, resolvers, checkable, resolvedMacros, useResolvedMacros);
+	int perfdataCount = ResolveArgument("simulation_perfdata_count", 1, resolvers, checkable, resolvedMacros, useResolvedMacros);
+	double changeProbability = ResolveArgument("simulation_state_change_probability", 0, resolvers, checkable, resolvedMacros, useResolvedMacros);
+
+	if (resolvedMacros && !useResolvedMacros)
+		return;
+
+	boost::call_once(l_SimulationOnceFlag, &SimulationCheckTask::StaticInitialize);
+
+	try {
+		latency = SampleLatency(distribution, latency, deviation, shape, maxLatency);
+	} catch (const std::exception& ex) {
+		cr->SetOutput(ex.what());
+		cr->SetState(ServiceUnknown);
+		checkable->ProcessCheckResult(cr);
+		return;
+	}
+
+	ServiceState state = SampleState(checkable->GetStateRaw(), changeProbability);
+
+	cr->SetOutput(GenerateOutput(state, distribution, latency, outputSize));
+	cr->SetPerformanceData(GeneratePerfdata(latency, perfdataCount));
+	cr->SetState(state);
+
+	Checkable::IncreasePendingChecks();
+
+	Schedule(checkable, cr, Utility::GetTime() + latency);
+}
+
+/**
+ * Returns a latency from the specified distribution.
+ *
+ * @param distribution "fixed", "normal" or "longtail".
+ * @param latency The fixed latency, the mean of the normal distribution or
+ *        the minimum of the long-tail (Pareto) distribution.
+ * @param deviation The standard deviation of the normal distribution.
+ * @param shape The shape of the long-tail distribution; smaller values
+ *        produce a heavier tail.
+ * @param maxLatency The upper bound for all distributions.
+ * @returns The latency in seconds.
+ */
+double SimulationCheckTask::SampleLatency(const String& distribution, double latency, double deviation, double shape, double maxLatency)
+{
+	double result;
+
+	if (distribution == "fixed") {
+		result = latency;
+	} else if (distribution == "normal") {
+		/* Box-Muller transform */
+		double u1 = GetUniformRandom();
+		double u2 = GetUniformRandom();
+		result = latency + deviation * std::sqrt(-2 * std::log(u1)) * std::cos(2 * M_PI * u2);
+	} else if (distribution == "longtail") {
+		if (shape <= 0)
+			BOOST_THROW_EXCEPTION(std::invalid_argument("The shape of the long-tail latency distribution must be greater than 0."));
+
+		result = latency / std::pow(GetUniformRandom(), 1 / shape);
+	} else
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Invalid latency distribution '" + distribution + "': must be one of 'fixed', 'normal' or 'longtail'."));
+
+	if (result < 0)
+		result = 0;
+
+	if (maxLatency > 0 && result > maxLatency)
+		result = maxLatency;
+
+	return result;
+}
+
+/**
+ * Returns the state for the next check result: with the specified
+ * probability one of the other states, otherwise the current state.
+ */
+ServiceState SimulationCheckTask::SampleState(ServiceState current, double changeProbability)
+{
+	if (changeProbability <= 0 || GetUniformRandom() > changeProbability)
+		return current;
+
+	int offset = 1 + Utility::Random() % 3;
+	return static_cast<ServiceState>((current + offset) % 4);
+}
+
+String SimulationCheckTask::GenerateOutput(ServiceState state, const String& distribution, double latency, int size)
+{
+	String output = "SIMULATION " + Service::StateToString(state) + " - Simulated check with " + distribution
+	    + " latency of " + Convert::ToString(latency) + " seconds";
+
+	/* pad the output with lines of 80 characters */
+	while (static_cast<int>(output.GetLength()) < size) {
+		size_t length = std::min<size_t>(size - output.GetLength(), 80);
+		output += "\n" + String(length - 1, 'x');
+	}
+
+	return output;
+}
+
+Array::Ptr SimulationCheckTask::GeneratePerfdata(double latency, int count)
+{
+	Array::Ptr perfdata = new Array();
+
+	if (count > 0)
+		perfdata->Add(new PerfdataValue("latency", latency, false, "seconds"));
+
+	for (int i = 1; i < count; i++)
+		perfdata->Add(new PerfdataValue("value_" + Convert::ToString(i), Utility::Random() % 1000));
+
+	return perfdata;
+}
+
+void SimulationCheckTask::StaticInitialize(void)
+{
+	l_SimulationWindow.Start = Utility::GetTime();
+
+	boost::thread thread(&SimulationCheckTask::SchedulerThreadProc);
+	thread.detach();
+
+	l_SimulationReportTimer = new Timer();
+	l_SimulationReportTimer->SetInterval(60);
+	l_SimulationReportTimer->OnTimerExpired.connect(boost::bind(&SimulationCheckTask::ReportTimerHandler));
+	l_SimulationReportTimer->Start();
+}
+
+void SimulationCheckTask::Schedule(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr, double completionTime)
+{
+	SimulatedCheck check;
+	check.Object = checkable;
+	check.Result = cr;
+
+	boost::mutex::scoped_lock lock(l_SimulationMutex);
+
+	bool first = l_SimulatedChecks.empty() || completionTime < l_SimulatedChecks.begin()->first;
+
+	l_SimulatedChecks.insert(std::make_pair(completionTime, check));
+	l_SimulationExecuted++;
+
+	if (first)
+		l_SimulationCV.notify_all();
+}
+
+/**
+ * Completes the simulated checks once their latency has elapsed and
+ * records the scheduling drift (time between next_check and the actual
+ * start of the check) and the delay of the simulator itself.
+ */
+void SimulationCheckTask::SchedulerThreadProc(void)
+{
+	Utility::SetThreadName("Simulation Checks");
+
+	for (;;) {
+		std::vector<SimulatedCheck> completed;
+
+		{
+			boost::mutex::scoped_lock lock(l_SimulationMutex);
+
+			while (l_SimulatedChecks.empty())
+				l_SimulationCV.wait(lock);
+
+			double wait = l_SimulatedChecks.begin()->first - Utility::GetTime();
+
+			if (wait > 0) {
+				l_SimulationCV.timed_wait(lock, boost::posix_time::milliseconds(static_cast<long>(wait * 1000) + 1));
+				continue;
+			}
+
+			double now = Utility::GetTime();
+
+			for (auto it = l_SimulatedChecks.begin(); it != l_SimulatedChecks.end() && it->first <= now; ) {
+				const CheckResult::Ptr& cr = it->second.Result;
+
+				double drift = std::max(0.0, cr->GetExecutionStart() - cr->GetScheduleStart());
+				double delay = now - it->first;
+
+				l_SimulationWindow.Checks++;
+				l_SimulationWindow.DriftSum += drift;
+				l_SimulationWindow.DriftMax = std::max(l_SimulationWindow.DriftMax, drift);
+				l_SimulationWindow.DelaySum += delay;
+				l_SimulationWindow.DelayMax = std::max(l_SimulationWindow.DelayMax, delay);
+
+				completed.push_back(it->second);
+				l_SimulatedChecks.erase(it++);
+			}
+
+			l_SimulationChecks.InsertValue(now, completed.size());
+		}
+
+		double now = Utility::GetTime();
+
+		for (const SimulatedCheck& check : completed) {
+			check.Result->SetExecutionEnd(now);
+			check.Result->SetScheduleEnd(now);
+
+			Checkable::DecreasePendingChecks();
+
+			Utility::QueueAsyncCallback(boost::bind(&Checkable::ProcessCheckResult, check.Object, check.Result, MessageOrigin::Ptr()));
+		}
+	}
+}
+
+/**
+ * Logs the latency drift and the saturation of the check pipeline for the
+ * last report interval.
+ */
+void SimulationCheckTask::ReportTimerHandler(void)
+{
+	Dictionary::Ptr stats = GetStats();
+	Dictionary::Ptr interval;
+
+	{
+		boost::mutex::scoped_lock lock(l_SimulationMutex);
+
+		double now = Utility::GetTime();
+
+		interval = new Dictionary();
+		interval->Set("duration", now - l_SimulationWindow.Start);
+		interval->Set("checks", l_SimulationWindow.Checks);
+		interval->Set("checks_rate", l_SimulationWindow.Checks / std::max(1.0, now - l_SimulationWindow.Start));
+		interval->Set("drift_avg", l_SimulationWindow.Checks > 0 ? l_SimulationWindow.DriftSum / l_SimulationWindow.Checks : 0);
+		interval->Set("drift_max", l_SimulationWindow.DriftMax);
+		interval->Set("completion_delay_avg", l_SimulationWindow.Checks > 0 ? l_SimulationWindow.DelaySum / l_SimulationWindow.Checks : 0);
+		interval->Set("completion_delay_max", l_SimulationWindow.DelayMax);
+
+		l_SimulationLastReport = interval;
+		l_SimulationWindow = SimulationWindow();
+		l_SimulationWindow.Start = now;
+	}
+
+	if (interval->Get("checks") == 0)
+		return;
+
+	Log(LogInformation, "SimulationCheckTask")
+	    << "Simulated " << interval->Get("checks") << " checks in the last " << interval->Get("duration")
+	    << " seconds (" << interval->Get("checks_rate") << "/s, " << stats->Get("in_flight") << " in flight). "
+	    << "Latency drift: avg " << interval->Get("drift_avg") << "s, max " << interval->Get("drift_max") << "s. "
+	    << "Pending checks: " << stats->Get("pending_checks") << " of " << stats->Get("concurrent_checks")
+	    << " (saturation " << Convert::ToLong(stats->Get("saturation") * 100) << "%).";
+}
+
+Dictionary::Ptr SimulationCheckTask::GetStats(void)
+{
+	Dictionary::Ptr stats = new Dictionary();
+
+	{
+		boost::mutex::scoped_lock lock(l_SimulationMutex);
+
+		stats->Set("executed", l_SimulationExecuted);
+		stats->Set("in_flight", l_SimulatedChecks.size());
+		stats->Set("checks_1min", l_SimulationChecks.GetValues(60));
+
+		if (l_SimulationLastReport)
+			stats->Set("last_interval", l_SimulationLastReport);
+	}
+
+	/* The checker library isn't available here, so the concurrency
+	 * limit which is currently in effect (either the static
+	 * concurrent_checks setting or the adaptive limit) is taken from
+	 * the CheckerComponent stats.
+	 */
+	double concurrentChecks = 0;
+	StatsFunction::Ptr checkerStats = StatsFunctionRegistry::GetInstance()->GetItem("CheckerComponent");
+
+	if (checkerStats) {
+		Dictionary::Ptr status = new Dictionary();
+		checkerStats->Invoke(status, new Array());
+
+		Dictionary::Ptr nodes = status->Get("checkercomponent");
+
+		if (nodes) {
+			ObjectLock olock(nodes);
+
+			for (const Dictionary::Pair& kv : nodes) {
+				Dictionary::Ptr node = kv.second;
+				concurrentChecks += node->Get("concurrent_checks");
+			}
+		}
+	}
+
+	int pendingChecks = Checkable::GetPendingChecks();
+
+	stats->Set("pending_checks", pendingChecks);
+	stats->Set("concurrent_checks", concurrentChecks);
+	stats->Set("saturation", concurrentChecks > 0 ? pendingChecks / concurrentChecks : 0);
+
+	return stats;
+}
+
+void SimulationCheckTask::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata)
+{
+	Dictionary::Ptr stats = GetStats();
+
+	if (stats->Get("executed") == 0)
+		return;
+
+	status->Set("simulationchecktask", stats);
+
+	perfdata->Add(new PerfdataValue("simulationchecktask_in_flight", stats->Get("in_flight")));
+	perfdata->Add(new PerfdataValue("simulationchecktask_checks_1min", stats->Get("checks_1min")));
+	perfdata->Add(new PerfdataValue("simulationchecktask_saturation", stats->Get("saturation")));
+
+	Dictionary::Ptr interval = stats->Get("last_interval");
+
+	if (interval) {
+		perfdata->Add(new PerfdataValue("simulationchecktask_drift_avg", interval->Get("drift_avg")));
+		perfdata->Add(new PerfdataValue("simulationchecktask_drift_max", interval->Get("drift_max")));
+	}
+}
+
+double SimulationCheckTask::GetUniformRandom(void)
+{
+	/* (0, 1] so that the result can be passed to log() */
+	return (Utility::Random() + 1.0) / (static_cast<double>(RAND_MAX) + 1.0);
+}
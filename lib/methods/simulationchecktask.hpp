@@ -0,0 +1,65 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#ifndef SIMULATIONCHECKTASK_H
+#define SIMULATIONCHECKTASK_H
+
+#include "methods/i2-methods.hpp"
+#include "icinga/service.hpp"
+#include "base/dictionary.hpp"
+
+namespace icinga
+{
+
+/**
+ * Load simulation check type. Completes asynchronously after a latency
+ * taken from a configurable distribution and returns check results with
+ * a configurable output size, number of performance data labels and
+ * state change probability.
+ *
+ * @ingroup methods
+ */
+class I2_METHODS_API SimulationCheckTask
+{
+public:
+	static void ScriptFunc(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr,
+	    const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros);
+
+	static double SampleLatency(const String& distribution, double latency, double deviation, double shape, double maxLatency);
+	static ServiceState SampleState(ServiceState current, double changeProbability);
+	static String GenerateOutput(ServiceState state, const String& distribution, double latency, int size);
+	static Array::Ptr GeneratePerfdata(double latency, int count);
+
+	static Dictionary::Ptr GetStats(void);
+	static void StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata);
+
+private:
+	SimulationCheckTask(void);
+
+	static void StaticInitialize(void);
+	static void SchedulerThreadProc(void);
+	static void ReportTimerHandler(void);
+	static void Schedule(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr, double completionTime);
+
+	static double GetUniformRandom(void);
+};
+
+}
+
+#endif /* SIMULATIONCHECKTASK_H */
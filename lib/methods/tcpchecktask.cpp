@@ -0,0 +1,174 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "methods/tcpchecktask.hpp"
+#include "icinga/perfdatavalue.hpp"
+#include "base/function.hpp"
+#include "base/utility.hpp"
+#include "base/convert.hpp"
+
+using namespace icinga;
+
+REGISTER_SCRIPTFUNCTION_NS(Internal, TcpCheck, &TcpCheckTask::ScriptFunc);
+
+TcpCheckTask::TcpCheckTask(const Socket::Ptr& socket, const Dictionary::Ptr& args, const CheckResult::Ptr& cr)
+	: NetworkProbe(socket, args->Get("address"), args->Get("port"), cr, args->Get("timeout")),
+	  m_Send(args->Get("send")), m_Expect(args->Get("expect")),
+	  m_RefuseState(ParseStateOption(args->Get("refuse"), ServiceCritical)),
+	  m_MismatchState(ParseStateOption(args->Get("mismatch"), ServiceWarning)),
+	  m_WarnTime(args->Get("wtime")), m_CritTime(args->Get("ctime")), m_ConnectTime(0)
+{ }
+
+void TcpCheckTask::ScriptFunc(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr,
+    const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros)
+{
+	MacroProcessor::ResolverList resolvers = GetResolvers(checkable);
+
+	Dictionary::Ptr args = new Dictionary();
+
+	for (const String& name : { "address", "port", "send", "expect", "refuse", "mismatch", "wtime", "ctime", "timeout" })
+		args->Set(name, ResolveMacro("tcp_" + name, resolvers, checkable, resolvedMacros, useResolvedMacros));
+
+	if (resolvedMacros && !useResolvedMacros)
+		return;
+
+	Checkable::IncreasePendingChecks();
+
+	Probe(args, cr, boost::bind(&NetworkProbe::ProcessCheckResult, checkable, _1));
+}
+
+/**
+ * Starts a TCP probe.
+ *
+ * @param args The resolved arguments: address, port, send, expect, refuse,
+ *        mismatch, wtime, ctime and timeout.
+ * @param cr The check result which is filled in.
+ * @param callback Invoked with the check result once the probe has finished.
+ */
+void TcpCheckTask::Probe(const Dictionary::Ptr& args, const CheckResult::Ptr& cr, const CompletionCallback& callback)
+{
+	String address = args->Get("address");
+	String port = args->Get("port");
+
+	if (address.IsEmpty() || port.IsEmpty()) {
+		ReportFailure(cr, ServiceUnknown, "UNKNOWN - Macros 'tcp_address' and 'tcp_port' must be set.", callback);
+		return;
+	}
+
+	if (args->Get("timeout").IsEmpty())
+		args->Set("timeout", 10);
+
+	int connectError;
+	Socket::Ptr socket;
+
+	try {
+		socket = Connect(address, port, SOCK_STREAM, connectError);
+	} catch (const std::exception& ex) {
+		ReportFailure(cr, ServiceUnknown, ex.what(), callback);
+		return;
+	}
+
+	TcpCheckTask::Ptr probe = new TcpCheckTask(socket, args, cr);
+	probe->Start(callback, connectError);
+}
+
+void TcpCheckTask::OnConnected(void)
+{
+	m_ConnectTime = GetElapsed();
+
+	if (m_Send.IsEmpty() && m_Expect.IsEmpty()) {
+		FinishResponse(true);
+		return;
+	}
+
+	if (!m_Send.IsEmpty())
+		Send(m_Send);
+}
+
+void TcpCheckTask::OnData(const char *data, size_t length)
+{
+	m_Response.GetData().append(data, length);
+
+	if (m_Expect.IsEmpty()) {
+		FinishResponse(true);
+		return;
+	}
+
+	/* the expect string must match the beginning of the response */
+	if (m_Response.GetLength() >= m_Expect.GetLength())
+		FinishResponse(m_Response.SubStr(0, m_Expect.GetLength()) == m_Expect);
+}
+
+void TcpCheckTask::OnEof(void)
+{
+	FinishResponse(m_Expect.IsEmpty());
+}
+
+void TcpCheckTask::OnError(int error)
+{
+#ifdef _WIN32
+	ServiceState state = (error == WSAECONNREFUSED) ? m_RefuseState : ServiceCritical;
+#else /* _WIN32 */
+	ServiceState state = (error == ECONNREFUSED) ? m_RefuseState : ServiceCritical;
+#endif /* _WIN32 */
+
+	Finish(state, FormatConnectError(GetHost(), GetPort(), error));
+}
+
+void TcpCheckTask::FinishResponse(bool matched)
+{
+	double elapsed = GetElapsed();
+
+	ServiceState state = matched ? ServiceOK : m_MismatchState;
+	state = MaxState(state, CheckThresholds(elapsed, m_WarnTime, m_CritTime));
+
+	String status = m_Response;
+	size_t pos = status.FindFirstOf("\r\n");
+
+	if (pos != String::NPos)
+		status = status.SubStr(0, pos);
+
+	String output = "TCP " + Service::StateToString(state) + " - ";
+
+	if (!matched)
+		output += "Unexpected response from host/socket: " + status;
+	else {
+		output += FormatSeconds(elapsed) + " second response time on " + GetHost() + " port " + GetPort();
+
+		if (!status.IsEmpty())
+			output += " [" + status + "]";
+	}
+
+	Array::Ptr perfdata = new Array();
+	perfdata->Add(new PerfdataValue("time", elapsed, false, "seconds", m_WarnTime, m_CritTime, 0, GetTimeout()));
+
+	Finish(state, output, perfdata);
+}
+
+ServiceState TcpCheckTask::ParseStateOption(const String& option, ServiceState defaultState)
+{
+	if (option == "ok")
+		return ServiceOK;
+	else if (option == "warn")
+		return ServiceWarning;
+	else if (option == "crit")
+		return ServiceCritical;
+	else
+		return defaultState;
+}
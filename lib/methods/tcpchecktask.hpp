@@ -0,0 +1,69 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#ifndef TCPCHECKTASK_H
+#define TCPCHECKTASK_H
+
+#include "methods/networkprobe.hpp"
+
+namespace icinga
+{
+
+/**
+ * Native replacement for check_tcp. Connects to a TCP port, optionally
+ * sends a string and compares the response with an expected string.
+ *
+ * @ingroup methods
+ */
+class I2_METHODS_API TcpCheckTask : public NetworkProbe
+{
+public:
+	DECLARE_PTR_TYPEDEFS(TcpCheckTask);
+
+	static void ScriptFunc(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr,
+	    const Dictionary::Ptr& resolvedMacros, bool useResolvedMacros);
+
+	static void Probe(const Dictionary::Ptr& args, const CheckResult::Ptr& cr, const CompletionCallback& callback);
+
+protected:
+	virtual void OnConnected(void) override;
+	virtual void OnData(const char *data, size_t length) override;
+	virtual void OnEof(void) override;
+	virtual void OnError(int error) override;
+
+private:
+	String m_Send;
+	String m_Expect;
+	ServiceState m_RefuseState;
+	ServiceState m_MismatchState;
+	Value m_WarnTime;
+	Value m_CritTime;
+	String m_Response;
+	double m_ConnectTime;
+
+	TcpCheckTask(const Socket::Ptr& socket, const Dictionary::Ptr& args, const CheckResult::Ptr& cr);
+
+	void FinishResponse(bool matched);
+
+	static ServiceState ParseStateOption(const String& option, ServiceState defaultState);
+};
+
+}
+
+#endif /* TCPCHECKTASK_H */
@@ -21,12 +21,14 @@
 #include "notification/notificationcomponent.tcpp"
 #include "icinga/service.hpp"
 #include "icinga/icingaapplication.hpp"
+#include "icinga/notificationaggregator.hpp"
 #include "base/configtype.hpp"
 #include "base/objectlock.hpp"
 #include "base/logger.hpp"
 #include "base/utility.hpp"
 #include "base/exception.hpp"
 #include "base/statsfunction.hpp"
+#include "icinga/perfdatavalue.hpp"
 
 using namespace icinga;
 
@@ -34,12 +36,20 @@ REGISTER_TYPE(NotificationComponent);
 
 REGISTER_STATSFUNCTION(NotificationComponent, &NotificationComponent::StatsFunc);
 
-void NotificationComponent::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr&)
+void NotificationComponent::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata)
 {
 	Dictionary::Ptr nodes = new Dictionary();
 
 	for (const NotificationComponent::Ptr& notification_component : ConfigType::GetObjectsByType<NotificationComponent>()) {
-		nodes->Set(notification_component->GetName(), 1); //add more stats
+		Dictionary::Ptr stats = NotificationAggregator::GetStats();
+
+		nodes->Set(notification_component->GetName(), stats);
+
+		String perfdata_prefix = "notificationcomponent_" + notification_component->GetName() + "_";
+		perfdata->Add(new PerfdataValue(perfdata_prefix + "executed", stats->Get("executed"), true));
+		perfdata->Add(new PerfdataValue(perfdata_prefix + "aggregated", stats->Get("aggregated"), true));
+		perfdata->Add(new PerfdataValue(perfdata_prefix + "suppressed", stats->Get("suppressed"), true));
+		perfdata->Add(new PerfdataValue(perfdata_prefix + "pending", stats->Get("pending")));
 	}
 
 	status->Set("notificationcomponent", nodes);
@@ -66,6 +76,9 @@ void NotificationComponent::Start(bool runtimeCreated)
 
 void NotificationComponent::Stop(bool runtimeRemoved)
 {
+	/* don't lose notifications which are waiting to be aggregated */
+	NotificationAggregator::Flush(true);
+
 	Log(LogInformation, "NotificationComponent")
 	    << "'" << GetName() << "' stopped.";
 
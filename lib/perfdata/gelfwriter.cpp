@@ -33,12 +33,30 @@
 #include "base/networkstream.hpp"
 #include "base/json.hpp"
 #include "base/context.hpp"
+#include "base/statsfunction.hpp"
 #include <boost/algorithm/string/replace.hpp>
 
 using namespace icinga;
 
 REGISTER_TYPE(GelfWriter);
 
+REGISTER_STATSFUNCTION(GelfWriter, &GelfWriter::StatsFunc);
+
+void GelfWriter::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata)
+{
+	Dictionary::Ptr nodes = new Dictionary();
+
+	for (const GelfWriter::Ptr& gelfwriter : ConfigType::GetObjectsByType<GelfWriter>()) {
+		if (!gelfwriter->m_Transport)
+			continue;
+
+		String name = gelfwriter->GetName();
+		nodes->Set(name, gelfwriter->m_Transport->GetStats("gelfwriter_" + name, perfdata));
+	}
+
+	status->Set("gelfwriter", nodes);
+}
+
 void GelfWriter::Start(bool runtimeCreated)
 {
 	ObjectImpl<GelfWriter>::Start(runtimeCreated);
@@ -46,14 +64,13 @@ void GelfWriter::Start(bool runtimeCreated)
 	Log(LogInformation, "GelfWriter")
 	    << "'" << GetName() << "' started.";
 
-	m_ReconnectTimer = new Timer();
-	m_ReconnectTimer->SetInterval(10);
-	m_ReconnectTimer->OnTimerExpired.connect(boost::bind(&GelfWriter::ReconnectTimerHandler, this));
-	m_ReconnectTimer->Start();
-	m_ReconnectTimer->Reschedule(0);
+	m_Transport = new PerfdataTransport("GelfWriter", GetHost(), GetPort(), GetQueueLimit());
+	m_Transport->Start();
 
 	// Send check results
-	Service::OnNewCheckResult.connect(boost::bind(&GelfWriter::CheckResultHandler, this, _1, _2));
+	m_CheckResultConsumer = new CheckResultConsumer("GelfWriter, " + GetName(),
+	    boost::bind(&GelfWriter::CheckResultHandler, this, _1, _2));
+	m_CheckResultConsumer->Start();
 	// Send notifications
 	Service::OnNotificationSentToUser.connect(boost::bind(&GelfWriter::NotificationToUserHandler, this, _1, _2, _3, _4, _5, _6, _7, _8));
 	// Send state change
@@ -62,34 +79,16 @@ void GelfWriter::Start(bool runtimeCreated)
 
 void GelfWriter::Stop(bool runtimeRemoved)
 {
+	m_CheckResultConsumer->Stop();
+	m_Transport->Stop();
+
 	Log(LogInformation, "GelfWriter")
 	    << "'" << GetName() << "' stopped.";
 
 	ObjectImpl<GelfWriter>::Stop(runtimeRemoved);
 }
 
-void GelfWriter::ReconnectTimerHandler(void)
-{
-	if (m_Stream)
-		return;
-
-	TcpSocket::Ptr socket = new TcpSocket();
-
-	Log(LogNotice, "GelfWriter")
-	    << "Reconnecting to GELF endpoint '" << GetHost() << "' port '" << GetPort() << "'.";
-
-	try {
-		socket->Connect(GetHost(), GetPort());
-	} catch (std::exception&) {
-		Log(LogCritical, "GelfWriter")
-		    << "Can't connect to GELF endpoint '" << GetHost() << "' port '" << GetPort() << "'.";
-		return;
-	}
-
-	m_Stream = new NetworkStream(socket);
-}
-
-void GelfWriter::CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr)
+CheckResultConsumer::Task GelfWriter::CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr)
 {
 	CONTEXT("GELF Processing check result for '" + checkable->GetName() + "'");
 
@@ -170,7 +169,7 @@ void GelfWriter::CheckResultHandler(const Checkable::Ptr& checkable, const Check
 		}
 	}
 
-	SendLogMessage(ComposeGelfMessage(fields, GetSource(), ts));
+	return boost::bind(&GelfWriter::SendLogMessage, GelfWriter::Ptr(this), ComposeGelfMessage(fields, GetSource(), ts));
 }
 
 void GelfWriter::NotificationToUserHandler(const Notification::Ptr& notification, const Checkable::Ptr& checkable,
@@ -271,26 +270,9 @@ String GelfWriter::ComposeGelfMessage(const Dictionary::Ptr& fields, const Strin
 
 void GelfWriter::SendLogMessage(const String& gelf)
 {
-	std::ostringstream msgbuf;
-	msgbuf << gelf;
-	msgbuf << '\0';
+	/* GELF messages are delimited by a null byte when sent over TCP. */
+	String message = gelf;
+	message += '\0';
 
-	String log = msgbuf.str();
-
-	ObjectLock olock(this);
-
-	if (!m_Stream)
-		return;
-
-	try {
-		//TODO remove
-		Log(LogDebug, "GelfWriter")
-		    << "Sending '" << log << "'.";
-		m_Stream->Write(log.CStr(), log.GetLength());
-	} catch (const std::exception& ex) {
-		Log(LogCritical, "GelfWriter")
-		    << "Cannot write to TCP socket on host '" << GetHost() << "' port '" << GetPort() << "'.";
-
-		m_Stream.reset();
-	}
+	m_Transport->Enqueue(message);
 }
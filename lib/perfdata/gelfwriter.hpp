@@ -21,7 +21,9 @@
 #define GELFWRITER_H
 
 #include "perfdata/gelfwriter.thpp"
+#include "perfdata/perfdatatransport.hpp"
 #include "icinga/service.hpp"
+#include "icinga/checkresultconsumer.hpp"
 #include "base/configobject.hpp"
 #include "base/tcpsocket.hpp"
 #include "base/timer.hpp"
@@ -41,24 +43,23 @@ public:
 	DECLARE_OBJECT(GelfWriter);
 	DECLARE_OBJECTNAME(GelfWriter);
 
+	static void StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata);
+
 protected:
 	virtual void Start(bool runtimeCreated) override;
 	virtual void Stop(bool runtimeRemoved) override;
 
 private:
-	Stream::Ptr m_Stream;
-
-	Timer::Ptr m_ReconnectTimer;
+	CheckResultConsumer::Ptr m_CheckResultConsumer;
+	PerfdataTransport::Ptr m_Transport;
 
-	void CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
+	CheckResultConsumer::Task CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
 	void NotificationToUserHandler(const Notification::Ptr& notification, const Checkable::Ptr& checkable,
 	const User::Ptr& user, NotificationType notification_type, CheckResult::Ptr const& cr,
 	const String& author, const String& comment_text, const String& command_name);
 	String ComposeGelfMessage(const Dictionary::Ptr& fields, const String& source, double ts);
 	void StateChangeHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr, StateType type);
 	void SendLogMessage(const String& gelf);
-
-	void ReconnectTimerHandler(void);
 };
 
 }
@@ -70,11 +70,15 @@ void GraphiteWriter::Start(bool runtimeCreated)
 	m_ReconnectTimer->Start();
 	m_ReconnectTimer->Reschedule(0);
 
-	Service::OnNewCheckResult.connect(boost::bind(&GraphiteWriter::CheckResultHandler, this, _1, _2));
+	m_CheckResultConsumer = new CheckResultConsumer("GraphiteWriter, " + GetName(),
+	    boost::bind(&GraphiteWriter::CheckResultHandler, this, _1, _2));
+	m_CheckResultConsumer->Start();
 }
 
 void GraphiteWriter::Stop(bool runtimeRemoved)
 {
+	m_CheckResultConsumer->Stop();
+
 	Log(LogInformation, "GraphiteWriter")
 	    << "'" << GetName() << "' stopped.";
 
@@ -83,8 +87,12 @@ void GraphiteWriter::Stop(bool runtimeRemoved)
 
 void GraphiteWriter::ReconnectTimerHandler(void)
 {
-	if (m_Stream)
-		return;
+	{
+		boost::mutex::scoped_lock lock(m_StreamMutex);
+
+		if (m_Stream)
+			return;
+	}
 
 	TcpSocket::Ptr socket = new TcpSocket();
 
@@ -99,15 +107,16 @@ void GraphiteWriter::ReconnectTimerHandler(void)
 		return;
 	}
 
+	boost::mutex::scoped_lock lock(m_StreamMutex);
 	m_Stream = new NetworkStream(socket);
 }
 
-void GraphiteWriter::CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr)
+CheckResultConsumer::Task GraphiteWriter::CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr)
 {
 	CONTEXT("Processing check result for '" + checkable->GetName() + "'");
 
 	if (!IcingaApplication::GetInstance()->GetEnablePerfdata() || !checkable->GetEnablePerfdata())
-		return;
+		return CheckResultConsumer::Task();
 
 	Service::Ptr service = dynamic_pointer_cast<Service>(checkable);
 	Host::Ptr host;
@@ -135,47 +144,65 @@ void GraphiteWriter::CheckResultHandler(const Checkable::Ptr& checkable, const C
 			prefix = MacroProcessor::ResolveMacros(GetHostNameTemplate(), resolvers, cr, NULL, boost::bind(&GraphiteWriter::EscapeMacroMetric, _1, false));
 		}
 
-		String prefix_perfdata = prefix + ".perfdata";
-		String prefix_metadata = prefix + ".metadata";
-
-		if (GetEnableSendMetadata()) {
+		Dictionary::Ptr metadata;
 
-			if (service) {
-				SendMetric(prefix_metadata, "state", service->GetState(), ts);
-			} else {
-				SendMetric(prefix_metadata, "state", host->GetState(), ts);
-			}
-
-			SendMetric(prefix_metadata, "current_attempt", checkable->GetCheckAttempt(), ts);
-			SendMetric(prefix_metadata, "max_check_attempts", checkable->GetMaxCheckAttempts(), ts);
-			SendMetric(prefix_metadata, "state_type", checkable->GetStateType(), ts);
-			SendMetric(prefix_metadata, "reachable", checkable->IsReachable(), ts);
-			SendMetric(prefix_metadata, "downtime_depth", checkable->GetDowntimeDepth(), ts);
-			SendMetric(prefix_metadata, "acknowledgement", checkable->GetAcknowledgement(), ts);
-			SendMetric(prefix_metadata, "latency", cr->CalculateLatency(), ts);
-			SendMetric(prefix_metadata, "execution_time", cr->CalculateExecutionTime(), ts);
-		}
+		if (GetEnableSendMetadata())
+			metadata = GetMetadata(checkable, cr);
 
-		SendPerfdata(prefix_perfdata, cr, ts);
+		return boost::bind(&GraphiteWriter::SendCheckResult, GraphiteWriter::Ptr(this),
+		    prefix + ".metadata", metadata, prefix + ".perfdata", cr, ts);
 	} else {
 		if (service) {
 			prefix = MacroProcessor::ResolveMacros(GetServiceNameTemplate(), resolvers, cr, NULL, boost::bind(&GraphiteWriter::EscapeMacroMetric, _1, true));
-			SendMetric(prefix, "state", service->GetState(), ts);
 		} else {
 			prefix = MacroProcessor::ResolveMacros(GetHostNameTemplate(), resolvers, cr, NULL, boost::bind(&GraphiteWriter::EscapeMacroMetric, _1, true));
-			SendMetric(prefix, "state", host->GetState(), ts);
 		}
 
-		SendMetric(prefix, "current_attempt", checkable->GetCheckAttempt(), ts);
-		SendMetric(prefix, "max_check_attempts", checkable->GetMaxCheckAttempts(), ts);
-		SendMetric(prefix, "state_type", checkable->GetStateType(), ts);
-		SendMetric(prefix, "reachable", checkable->IsReachable(), ts);
-		SendMetric(prefix, "downtime_depth", checkable->GetDowntimeDepth(), ts);
-		SendMetric(prefix, "acknowledgement", checkable->GetAcknowledgement(), ts);
-		SendMetric(prefix, "latency", cr->CalculateLatency(), ts);
-		SendMetric(prefix, "execution_time", cr->CalculateExecutionTime(), ts);
-		SendPerfdata(prefix, cr, ts);
+		return boost::bind(&GraphiteWriter::SendCheckResult, GraphiteWriter::Ptr(this),
+		    prefix, GetMetadata(checkable, cr), prefix, cr, ts);
+	}
+}
+
+/**
+ * Captures the checkable's state which is sent along with the check result.
+ */
+Dictionary::Ptr GraphiteWriter::GetMetadata(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr)
+{
+	Host::Ptr host;
+	Service::Ptr service;
+	tie(host, service) = GetHostService(checkable);
+
+	Dictionary::Ptr metadata = new Dictionary();
+
+	if (service)
+		metadata->Set("state", service->GetState());
+	else
+		metadata->Set("state", host->GetState());
+
+	metadata->Set("current_attempt", checkable->GetCheckAttempt());
+	metadata->Set("max_check_attempts", checkable->GetMaxCheckAttempts());
+	metadata->Set("state_type", checkable->GetStateType());
+	metadata->Set("reachable", checkable->IsReachable());
+	metadata->Set("downtime_depth", checkable->GetDowntimeDepth());
+	metadata->Set("acknowledgement", checkable->GetAcknowledgement());
+	metadata->Set("latency", cr->CalculateLatency());
+	metadata->Set("execution_time", cr->CalculateExecutionTime());
+
+	return metadata;
+}
+
+void GraphiteWriter::SendCheckResult(const String& prefixMetadata, const Dictionary::Ptr& metadata,
+    const String& prefixPerfdata, const CheckResult::Ptr& cr, double ts)
+{
+	if (metadata) {
+		ObjectLock olock(metadata);
+
+		for (const Dictionary::Pair& kv : metadata) {
+			SendMetric(prefixMetadata, kv.first, kv.second, ts);
+		}
 	}
+
+	SendPerfdata(prefixPerfdata, cr, ts);
 }
 
 void GraphiteWriter::SendPerfdata(const String& prefix, const CheckResult::Ptr& cr, double ts)
@@ -246,7 +273,7 @@ void GraphiteWriter::SendMetric(const String& prefix, const String& name, double
 	msgbuf << "\n";
 	String metric = msgbuf.str();
 
-	ObjectLock olock(this);
+	boost::mutex::scoped_lock lock(m_StreamMutex);
 
 	if (!m_Stream)
 		return;
@@ -22,9 +22,11 @@
 
 #include "perfdata/graphitewriter.thpp"
 #include "icinga/service.hpp"
+#include "icinga/checkresultconsumer.hpp"
 #include "base/configobject.hpp"
 #include "base/tcpsocket.hpp"
 #include "base/timer.hpp"
+#include <boost/thread/mutex.hpp>
 #include <fstream>
 
 namespace icinga
@@ -51,11 +53,18 @@ protected:
 	virtual void Stop(bool runtimeRemoved) override;
 
 private:
+	CheckResultConsumer::Ptr m_CheckResultConsumer;
+	/* Not the object lock: Stop() waits for the queued metrics while
+	 * ConfigObject::Deactivate() holds it. */
+	boost::mutex m_StreamMutex;
 	Stream::Ptr m_Stream;
 
 	Timer::Ptr m_ReconnectTimer;
 
-	void CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
+	CheckResultConsumer::Task CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
+	static Dictionary::Ptr GetMetadata(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
+	void SendCheckResult(const String& prefixMetadata, const Dictionary::Ptr& metadata,
+	    const String& prefixPerfdata, const CheckResult::Ptr& cr, double ts);
 	void SendMetric(const String& prefix, const String& name, double value, double ts);
 	void SendPerfdata(const String& prefix, const CheckResult::Ptr& cr, double ts);
 	static String EscapeMetric(const String& str, bool legacyMode = false);
@@ -78,11 +78,15 @@ void InfluxdbWriter::Start(bool runtimeCreated)
 	m_FlushTimer->Start();
 	m_FlushTimer->Reschedule(0);
 
-	Service::OnNewCheckResult.connect(boost::bind(&InfluxdbWriter::CheckResultHandler, this, _1, _2));
+	m_CheckResultConsumer = new CheckResultConsumer("InfluxdbWriter, " + GetName(),
+	    boost::bind(&InfluxdbWriter::CheckResultHandler, this, _1, _2));
+	m_CheckResultConsumer->Start();
 }
 
 void InfluxdbWriter::Stop(bool runtimeRemoved)
 {
+	m_CheckResultConsumer->Stop();
+
 	Log(LogInformation, "InfluxdbWriter")
 	    << "'" << GetName() << "' stopped.";
 
@@ -129,12 +133,12 @@ Stream::Ptr InfluxdbWriter::Connect(TcpSocket::Ptr& socket)
 	}
 }
 
-void InfluxdbWriter::CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr)
+CheckResultConsumer::Task InfluxdbWriter::CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr)
 {
 	CONTEXT("Processing check result for '" + checkable->GetName() + "'");
 
 	if (!IcingaApplication::GetInstance()->GetEnablePerfdata() || !checkable->GetEnablePerfdata())
-		return;
+		return CheckResultConsumer::Task();
 
 	Host::Ptr host;
 	Service::Ptr service;
@@ -166,7 +170,27 @@ void InfluxdbWriter::CheckResultHandler(const Checkable::Ptr& checkable, const C
 		}
 	}
 
-	SendPerfdata(tmpl, checkable, cr, ts);
+	Dictionary::Ptr metadata;
+
+	if (GetEnableSendMetadata()) {
+		metadata = new Dictionary();
+
+		if (service)
+			metadata->Set(String("state"), FormatInteger(service->GetState()));
+		else
+			metadata->Set(String("state"), FormatInteger(host->GetState()));
+
+		metadata->Set(String("current_attempt"), FormatInteger(checkable->GetCheckAttempt()));
+		metadata->Set(String("max_check_attempts"), FormatInteger(checkable->GetMaxCheckAttempts()));
+		metadata->Set(String("state_type"), FormatInteger(checkable->GetStateType()));
+		metadata->Set(String("reachable"), FormatBoolean(checkable->IsReachable()));
+		metadata->Set(String("downtime_depth"), FormatInteger(checkable->GetDowntimeDepth()));
+		metadata->Set(String("acknowledgement"), FormatInteger(checkable->GetAcknowledgement()));
+		metadata->Set(String("latency"), cr->CalculateLatency());
+		metadata->Set(String("execution_time"), cr->CalculateExecutionTime());
+	}
+
+	return boost::bind(&InfluxdbWriter::SendPerfdata, InfluxdbWriter::Ptr(this), tmpl, metadata, cr, ts);
 }
 
 String InfluxdbWriter::FormatInteger(const int val)
@@ -179,7 +203,7 @@ String InfluxdbWriter::FormatBoolean(const bool val)
 	return val ? "true" : "false";
 }
 
-void InfluxdbWriter::SendPerfdata(const Dictionary::Ptr& tmpl, const Checkable::Ptr& checkable, const CheckResult::Ptr& cr, double ts)
+void InfluxdbWriter::SendPerfdata(const Dictionary::Ptr& tmpl, const Dictionary::Ptr& metadata, const CheckResult::Ptr& cr, double ts)
 {
 	Array::Ptr perfdata = cr->GetPerformanceData();
 	if (perfdata) {
@@ -217,29 +241,8 @@ void InfluxdbWriter::SendPerfdata(const Dictionary::Ptr& tmpl, const Checkable::
 		}
 	}
 
-	if (GetEnableSendMetadata()) {
-		Host::Ptr host;
-		Service::Ptr service;
-		boost::tie(host, service) = GetHostService(checkable);
-
-		Dictionary::Ptr fields = new Dictionary();
-
-		if (service)
-			fields->Set(String("state"), FormatInteger(service->GetState()));
-		else
-			fields->Set(String("state"), FormatInteger(host->GetState()));
-
-		fields->Set(String("current_attempt"), FormatInteger(checkable->GetCheckAttempt()));
-		fields->Set(String("max_check_attempts"), FormatInteger(checkable->GetMaxCheckAttempts()));
-		fields->Set(String("state_type"), FormatInteger(checkable->GetStateType()));
-		fields->Set(String("reachable"), FormatBoolean(checkable->IsReachable()));
-		fields->Set(String("downtime_depth"), FormatInteger(checkable->GetDowntimeDepth()));
-		fields->Set(String("acknowledgement"), FormatInteger(checkable->GetAcknowledgement()));
-		fields->Set(String("latency"), cr->CalculateLatency());
-		fields->Set(String("execution_time"), cr->CalculateExecutionTime());
-
-		SendMetric(tmpl, String(), fields, ts);
-	}
+	if (metadata)
+		SendMetric(tmpl, String(), metadata, ts);
 }
 
 String InfluxdbWriter::EscapeKey(const String& str)
@@ -22,6 +22,7 @@
 
 #include "perfdata/influxdbwriter.thpp"
 #include "icinga/service.hpp"
+#include "icinga/checkresultconsumer.hpp"
 #include "base/configobject.hpp"
 #include "base/tcpsocket.hpp"
 #include "base/timer.hpp"
@@ -51,11 +52,12 @@ protected:
 	virtual void Stop(bool runtimeRemoved) override;
 
 private:
+	CheckResultConsumer::Ptr m_CheckResultConsumer;
 	Timer::Ptr m_FlushTimer;
 	Array::Ptr m_DataBuffer;
 
-	void CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
-	void SendPerfdata(const Dictionary::Ptr& tmpl, const Checkable::Ptr& checkable, const CheckResult::Ptr& cr, double ts);
+	CheckResultConsumer::Task CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
+	void SendPerfdata(const Dictionary::Ptr& tmpl, const Dictionary::Ptr& metadata, const CheckResult::Ptr& cr, double ts);
 	void SendMetric(const Dictionary::Ptr& tmpl, const String& label, const Dictionary::Ptr& fields, double ts);
 	void FlushTimeout(void);
 	void Flush(void);
@@ -39,6 +39,7 @@
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/replace.hpp>
+#include <algorithm>
 
 using namespace icinga;
 
@@ -46,12 +47,16 @@ REGISTER_TYPE(OpenTsdbWriter);
 
 REGISTER_STATSFUNCTION(OpenTsdbWriter, &OpenTsdbWriter::StatsFunc);
 
-void OpenTsdbWriter::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr&)
+void OpenTsdbWriter::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr& perfdata)
 {
 	Dictionary::Ptr nodes = new Dictionary();
 
 	for (const OpenTsdbWriter::Ptr& opentsdbwriter : ConfigType::GetObjectsByType<OpenTsdbWriter>()) {
-		nodes->Set(opentsdbwriter->GetName(), 1); //add more stats
+		if (!opentsdbwriter->m_Transport)
+			continue;
+
+		String name = opentsdbwriter->GetName();
+		nodes->Set(name, opentsdbwriter->m_Transport->GetStats("opentsdbwriter_" + name, perfdata));
 	}
 
 	status->Set("opentsdbwriter", nodes);
@@ -64,50 +69,31 @@ void OpenTsdbWriter::Start(bool runtimeCreated)
 	Log(LogInformation, "OpentsdbWriter")
 	    << "'" << GetName() << "' started.";
 
-	m_ReconnectTimer = new Timer();
-	m_ReconnectTimer->SetInterval(10);
-	m_ReconnectTimer->OnTimerExpired.connect(boost::bind(&OpenTsdbWriter::ReconnectTimerHandler, this));
-	m_ReconnectTimer->Start();
-	m_ReconnectTimer->Reschedule(0);
+	m_Transport = new PerfdataTransport("OpenTsdbWriter", GetHost(), GetPort(), GetQueueLimit());
+	m_Transport->Start();
 
-	Service::OnNewCheckResult.connect(boost::bind(&OpenTsdbWriter::CheckResultHandler, this, _1, _2));
+	m_CheckResultConsumer = new CheckResultConsumer("OpenTsdbWriter, " + GetName(),
+	    boost::bind(&OpenTsdbWriter::CheckResultHandler, this, _1, _2));
+	m_CheckResultConsumer->Start();
 }
 
 void OpenTsdbWriter::Stop(bool runtimeRemoved)
 {
+	m_CheckResultConsumer->Stop();
+	m_Transport->Stop();
+
 	Log(LogInformation, "OpentsdbWriter")
 	    << "'" << GetName() << "' stopped.";
 
 	ObjectImpl<OpenTsdbWriter>::Stop(runtimeRemoved);
 }
 
-void OpenTsdbWriter::ReconnectTimerHandler(void)
-{
-	if (m_Stream)
-		return;
-
-	TcpSocket::Ptr socket = new TcpSocket();
-
-	Log(LogNotice, "OpenTsdbWriter")
-		<< "Reconnect to OpenTSDB TSD on host '" << GetHost() << "' port '" << GetPort() << "'.";
-
-	try {
-		socket->Connect(GetHost(), GetPort());
-	} catch (std::exception&) {
-		Log(LogCritical, "OpenTsdbWriter")
-			<< "Can't connect to OpenTSDB TSD on host '" << GetHost() << "' port '" << GetPort() << "'.";
-		return;
-	}
-
-	m_Stream = new NetworkStream(socket);
-}
-
-void OpenTsdbWriter::CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr)
+CheckResultConsumer::Task OpenTsdbWriter::CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr)
 {
 	CONTEXT("Processing check result for '" + checkable->GetName() + "'");
 
 	if (!IcingaApplication::GetInstance()->GetEnablePerfdata() || !checkable->GetEnablePerfdata())
-		return;
+		return CheckResultConsumer::Task();
 
 	Service::Ptr service = dynamic_pointer_cast<Service>(checkable);
 	Host::Ptr host;
@@ -123,25 +109,29 @@ void OpenTsdbWriter::CheckResultHandler(const Checkable::Ptr& checkable, const C
 	String escaped_hostName = EscapeMetric(host->GetName());
 	tags["host"] = escaped_hostName;
 
-	double ts = cr->GetExecutionEnd();
+	String ts = Convert::ToString(static_cast<long>(cr->GetExecutionEnd()));
+
+	/* All metrics for this check result are sent with a single write. */
+	String buffer;
+	String tags_string = FormatTags(tags);
 
 	if (service) {
 		String serviceName = service->GetShortName();
 		String escaped_serviceName = EscapeMetric(serviceName);
 		metric = "icinga.service." + escaped_serviceName;
 
-		SendMetric(metric + ".state", tags, service->GetState(), ts);
+		AppendMetric(buffer, metric + ".state", tags_string, service->GetState(), ts);
 	} else {
 		metric = "icinga.host";
-		SendMetric(metric + ".state", tags, host->GetState(), ts);
+		AppendMetric(buffer, metric + ".state", tags_string, host->GetState(), ts);
 	}
 
-	SendMetric(metric + ".state_type", tags, checkable->GetStateType(), ts);
-	SendMetric(metric + ".reachable", tags, checkable->IsReachable(), ts);
-	SendMetric(metric + ".downtime_depth", tags, checkable->GetDowntimeDepth(), ts);
-	SendMetric(metric + ".acknowledgement", tags, checkable->GetAcknowledgement(), ts);
+	AppendMetric(buffer, metric + ".state_type", tags_string, checkable->GetStateType(), ts);
+	AppendMetric(buffer, metric + ".reachable", tags_string, checkable->IsReachable(), ts);
+	AppendMetric(buffer, metric + ".downtime_depth", tags_string, checkable->GetDowntimeDepth(), ts);
+	AppendMetric(buffer, metric + ".acknowledgement", tags_string, checkable->GetAcknowledgement(), ts);
 
-	SendPerfdata(metric, tags, cr, ts);
+	AppendPerfdata(buffer, metric, tags_string, cr, ts);
 
 	metric = "icinga.check";
 
@@ -154,13 +144,22 @@ void OpenTsdbWriter::CheckResultHandler(const Checkable::Ptr& checkable, const C
 		tags["type"] = "host";
 	}
 
-	SendMetric(metric + ".current_attempt", tags, checkable->GetCheckAttempt(), ts);
-	SendMetric(metric + ".max_check_attempts", tags, checkable->GetMaxCheckAttempts(), ts);
-	SendMetric(metric + ".latency", tags, cr->CalculateLatency(), ts);
-	SendMetric(metric + ".execution_time", tags, cr->CalculateExecutionTime(), ts);
+	tags_string = FormatTags(tags);
+
+	AppendMetric(buffer, metric + ".current_attempt", tags_string, checkable->GetCheckAttempt(), ts);
+	AppendMetric(buffer, metric + ".max_check_attempts", tags_string, checkable->GetMaxCheckAttempts(), ts);
+	AppendMetric(buffer, metric + ".latency", tags_string, cr->CalculateLatency(), ts);
+	AppendMetric(buffer, metric + ".execution_time", tags_string, cr->CalculateExecutionTime(), ts);
+
+	size_t count = std::count(buffer.Begin(), buffer.End(), '\n');
+
+	Log(LogDebug, "OpenTsdbWriter")
+	    << "Add " << count << " metrics for '" << checkable->GetName() << "' to the send queue.";
+
+	return boost::bind(&PerfdataTransport::Enqueue, m_Transport, buffer, count);
 }
 
-void OpenTsdbWriter::SendPerfdata(const String& metric, const std::map<String, String>& tags, const CheckResult::Ptr& cr, double ts)
+void OpenTsdbWriter::AppendPerfdata(String& buffer, const String& metric, const String& tags, const CheckResult::Ptr& cr, const String& ts)
 {
 	Array::Ptr perfdata = cr->GetPerformanceData();
 
@@ -186,54 +185,45 @@ void OpenTsdbWriter::SendPerfdata(const String& metric, const std::map<String, S
 		String escaped_key = EscapeMetric(pdv->GetLabel());
 		boost::algorithm::replace_all(escaped_key, "::", ".");
 
-		SendMetric(metric + "." + escaped_key, tags, pdv->GetValue(), ts);
+		AppendMetric(buffer, metric + "." + escaped_key, tags, pdv->GetValue(), ts);
 
 		if (pdv->GetCrit())
-			SendMetric(metric + "." + escaped_key + "_crit", tags, pdv->GetCrit(), ts);
+			AppendMetric(buffer, metric + "." + escaped_key + "_crit", tags, pdv->GetCrit(), ts);
 		if (pdv->GetWarn())
-			SendMetric(metric + "." + escaped_key + "_warn", tags, pdv->GetWarn(), ts);
+			AppendMetric(buffer, metric + "." + escaped_key + "_warn", tags, pdv->GetWarn(), ts);
 		if (pdv->GetMin())
-			SendMetric(metric + "." + escaped_key + "_min", tags, pdv->GetMin(), ts);
+			AppendMetric(buffer, metric + "." + escaped_key + "_min", tags, pdv->GetMin(), ts);
 		if (pdv->GetMax())
-			SendMetric(metric + "." + escaped_key + "_max", tags, pdv->GetMax(), ts);
+			AppendMetric(buffer, metric + "." + escaped_key + "_max", tags, pdv->GetMax(), ts);
 	}
 }
 
-void OpenTsdbWriter::SendMetric(const String& metric, const std::map<String, String>& tags, double value, double ts)
+/*
+ * must be (http://opentsdb.net/docs/build/html/user_guide/writing.html)
+ * put <metric> <timestamp> <value> <tagk1=tagv1[ tagk2=tagv2 ...tagkN=tagvN]>
+ * "tags" must include at least one tag, we use "host=HOSTNAME"
+ */
+void OpenTsdbWriter::AppendMetric(String& buffer, const String& metric, const String& tags, double value, const String& ts)
 {
-	String tags_string = "";
-	for (const Dictionary::Pair& tag : tags) {
-		tags_string += " " + tag.first + "=" + Convert::ToString(tag.second);
-	}
-
-	std::ostringstream msgbuf;
-	/*
-	 * must be (http://opentsdb.net/docs/build/html/user_guide/writing.html)
-	 * put <metric> <timestamp> <value> <tagk1=tagv1[ tagk2=tagv2 ...tagkN=tagvN]>
-	 * "tags" must include at least one tag, we use "host=HOSTNAME"
-	 */
-	msgbuf << "put " << metric << " " << static_cast<long>(ts) << " " << Convert::ToString(value) << " " << tags_string;
-
-	Log(LogDebug, "OpenTsdbWriter")
-		<< "Add to metric list:'" << msgbuf.str() << "'.";
-
-	/* do not send \n to debug log */
-	msgbuf << "\n";
-	String put = msgbuf.str();
-
-	ObjectLock olock(this);
-
-	if (!m_Stream)
-		return;
+	buffer += "put ";
+	buffer += metric;
+	buffer += " ";
+	buffer += ts;
+	buffer += " ";
+	buffer += Convert::ToString(value);
+	buffer += tags;
+	buffer += "\n";
+}
 
-	try {
-		m_Stream->Write(put.CStr(), put.GetLength());
-	} catch (const std::exception& ex) {
-		Log(LogCritical, "OpenTsdbWriter")
-			<< "Cannot write to OpenTSDB TSD on host '" << GetHost() << "' port '" << GetPort() + "'.";
+String OpenTsdbWriter::FormatTags(const std::map<String, String>& tags)
+{
+	String tags_string;
 
-		m_Stream.reset();
+	for (const Dictionary::Pair& tag : tags) {
+		tags_string += " " + tag.first + "=" + tag.second;
 	}
+
+	return tags_string;
 }
 
 /* for metric and tag name rules, see
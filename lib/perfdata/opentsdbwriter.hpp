@@ -21,7 +21,9 @@
 #define OPENTSDBWRITER_H
 
 #include "perfdata/opentsdbwriter.thpp"
+#include "perfdata/perfdatatransport.hpp"
 #include "icinga/service.hpp"
+#include "icinga/checkresultconsumer.hpp"
 #include "base/configobject.hpp"
 #include "base/tcpsocket.hpp"
 #include "base/timer.hpp"
@@ -48,17 +50,15 @@ protected:
 	virtual void Stop(bool runtimeRemoved) override;
 
 private:
-	Stream::Ptr m_Stream;
+	CheckResultConsumer::Ptr m_CheckResultConsumer;
+	PerfdataTransport::Ptr m_Transport;
 
-	Timer::Ptr m_ReconnectTimer;
-
-	void CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
-	void SendMetric(const String& metric, const std::map<String, String>& tags, double value, double ts);
-	void SendPerfdata(const String& metric, const std::map<String, String>& tags, const CheckResult::Ptr& cr, double ts);
+	CheckResultConsumer::Task CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
+	static void AppendMetric(String& buffer, const String& metric, const String& tags, double value, const String& ts);
+	static void AppendPerfdata(String& buffer, const String& metric, const String& tags, const CheckResult::Ptr& cr, const String& ts);
+	static String FormatTags(const std::map<String, String>& tags);
 	static String EscapeTag(const String& str);
 	static String EscapeMetric(const String& str);
-
-	void ReconnectTimerHandler(void);
 };
 
 }
@@ -0,0 +1,90 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#ifndef PERFDATASPOOL_H
+#define PERFDATASPOOL_H
+
+#include "perfdata/i2-perfdata.hpp"
+#include <boost/cstdint.hpp>
+
+namespace icinga
+{
+
+/*
+ * Binary perfdata spool segments consist of a PerfdataSpoolHeader followed
+ * by fixed-size PerfdataSpoolRecords. Object and label names are interned
+ * and stored in a companion text file (segment path + ".dict") with one
+ * tab-separated entry per line:
+ *
+ *   O <id> <host name> <service name> <check command>
+ *   L <id> <label> <unit suffix>
+ */
+
+#define PERFDATASPOOL_MAGIC "I2PDSPL"
+#define PERFDATASPOOL_VERSION 1
+
+/**
+ * @ingroup perfdata
+ */
+struct PerfdataSpoolHeader
+{
+	char Magic[8];
+	boost::uint32_t Version;
+	boost::uint32_t RecordSize;
+	boost::uint64_t Capacity;
+	boost::uint64_t Count;
+	char Reserved[32];
+};
+
+/**
+ * @ingroup perfdata
+ */
+enum PerfdataSpoolFlags
+{
+	PerfdataSpoolHasWarn = 1,
+	PerfdataSpoolHasCrit = 2,
+	PerfdataSpoolHasMin = 4,
+	PerfdataSpoolHasMax = 8
+};
+
+/**
+ * A single performance data value.
+ *
+ * @ingroup perfdata
+ */
+struct PerfdataSpoolRecord
+{
+	double Timestamp;
+	boost::uint32_t ObjectID;
+	boost::uint32_t LabelID;
+	double Value;
+	double Warn;
+	double Crit;
+	double Min;
+	double Max;
+	boost::uint32_t Flags;
+	boost::uint8_t State;
+	boost::uint8_t StateType;
+	boost::uint8_t HostState;
+	boost::uint8_t HostStateType;
+};
+
+}
+
+#endif /* PERFDATASPOOL_H */
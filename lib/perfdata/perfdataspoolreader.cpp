@@ -0,0 +1,214 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "perfdata/perfdataspoolreader.hpp"
+#include "base/exception.hpp"
+#include "base/convert.hpp"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
+#include <fstream>
+#include <cstring>
+
+using namespace icinga;
+
+PerfdataSpoolReader::PerfdataSpoolReader(const String& path)
+	: m_Header(NULL), m_Records(NULL)
+{
+	boost::interprocess::file_mapping mapping(path.CStr(), boost::interprocess::read_only);
+	boost::interprocess::mapped_region(mapping, boost::interprocess::read_only).swap(m_Region);
+
+	if (m_Region.get_size() < sizeof(PerfdataSpoolHeader))
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Perfdata spool file '" + path + "' is truncated."));
+
+	m_Header = static_cast<const PerfdataSpoolHeader *>(m_Region.get_address());
+	m_Records = reinterpret_cast<const PerfdataSpoolRecord *>(m_Header + 1);
+
+	if (strncmp(m_Header->Magic, PERFDATASPOOL_MAGIC, sizeof(m_Header->Magic)) != 0)
+		BOOST_THROW_EXCEPTION(std::invalid_argument("File '" + path + "' is not a perfdata spool file."));
+
+	if (m_Header->Version != PERFDATASPOOL_VERSION || m_Header->RecordSize != sizeof(PerfdataSpoolRecord))
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Perfdata spool file '" + path + "' has an unsupported version."));
+
+	if (m_Region.get_size() < sizeof(PerfdataSpoolHeader) + m_Header->Count * sizeof(PerfdataSpoolRecord))
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Perfdata spool file '" + path + "' is truncated."));
+
+	ReadDictionary(path + ".dict");
+}
+
+void PerfdataSpoolReader::ReadDictionary(const String& path)
+{
+	std::ifstream fp(path.CStr());
+
+	if (!fp)
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Could not open perfdata spool dictionary '" + path + "'."));
+
+	std::string line;
+
+	while (std::getline(fp, line)) {
+		std::vector<String> tokens;
+		boost::algorithm::split(tokens, line, boost::is_any_of("\t"));
+
+		if (tokens.size() < 2)
+			continue;
+
+		size_t id = Convert::ToLong(tokens[1]);
+
+		if (tokens[0] == "O" && tokens.size() == 5) {
+			if (id >= m_Objects.size())
+				m_Objects.resize(id + 1);
+
+			PerfdataSpoolObject& object = m_Objects[id];
+			object.Host = tokens[2];
+			object.Service = tokens[3];
+			object.CheckCommand = tokens[4];
+		} else if (tokens[0] == "L" && tokens.size() == 4) {
+			if (id >= m_Labels.size())
+				m_Labels.resize(id + 1);
+
+			PerfdataSpoolLabel& label = m_Labels[id];
+			label.Label = tokens[2];
+			label.Unit = tokens[3];
+		}
+	}
+}
+
+size_t PerfdataSpoolReader::GetCount(void) const
+{
+	return m_Header->Count;
+}
+
+const PerfdataSpoolRecord& PerfdataSpoolReader::GetRecord(size_t index) const
+{
+	if (index >= m_Header->Count)
+		BOOST_THROW_EXCEPTION(std::out_of_range("Record index is out of range."));
+
+	return m_Records[index];
+}
+
+const PerfdataSpoolObject& PerfdataSpoolReader::GetObject(boost::uint32_t id) const
+{
+	if (id >= m_Objects.size())
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Unknown object ID " + Convert::ToString(id) + " in perfdata spool."));
+
+	return m_Objects[id];
+}
+
+const PerfdataSpoolLabel& PerfdataSpoolReader::GetLabel(boost::uint32_t id) const
+{
+	if (id >= m_Labels.size())
+		BOOST_THROW_EXCEPTION(std::invalid_argument("Unknown label ID " + Convert::ToString(id) + " in perfdata spool."));
+
+	return m_Labels[id];
+}
+
+/**
+ * Formats a record the same way as PerfdataValue::Format().
+ */
+String PerfdataSpoolReader::FormatValue(const PerfdataSpoolRecord& record) const
+{
+	const PerfdataSpoolLabel& label = GetLabel(record.LabelID);
+
+	String result;
+
+	if (label.Label.FindFirstOf(" ") != String::NPos)
+		result = "'" + label.Label + "'";
+	else
+		result = label.Label;
+
+	result += "=" + Convert::ToString(record.Value) + label.Unit;
+
+	if (record.Flags & PerfdataSpoolHasWarn) {
+		result += ";" + Convert::ToString(record.Warn);
+
+		if (record.Flags & PerfdataSpoolHasCrit) {
+			result += ";" + Convert::ToString(record.Crit);
+
+			if (record.Flags & PerfdataSpoolHasMin) {
+				result += ";" + Convert::ToString(record.Min);
+
+				if (record.Flags & PerfdataSpoolHasMax)
+					result += ";" + Convert::ToString(record.Max);
+			}
+		}
+	}
+
+	return result;
+}
+
+static const char *GetServiceStateString(int state)
+{
+	static const char *states[] = { "OK", "WARNING", "CRITICAL", "UNKNOWN" };
+	return (state >= 0 && state < 4) ? states[state] : "UNKNOWN";
+}
+
+static const char *GetHostStateString(int state)
+{
+	return (state == 0) ? "UP" : "DOWN";
+}
+
+static const char *GetStateTypeString(int stateType)
+{
+	return (stateType == 0) ? "SOFT" : "HARD";
+}
+
+/**
+ * Writes the segment in the format of the default PerfdataWriter
+ * host_format_template/service_format_template. Consecutive records
+ * for the same object and timestamp make up one line.
+ */
+void PerfdataSpoolReader::WriteLegacyText(std::ostream& fp) const
+{
+	size_t count = GetCount();
+
+	for (size_t i = 0; i < count; ) {
+		const PerfdataSpoolRecord& first = m_Records[i];
+		const PerfdataSpoolObject& object = GetObject(first.ObjectID);
+
+		String perfdata;
+
+		for (; i < count && m_Records[i].ObjectID == first.ObjectID && m_Records[i].Timestamp == first.Timestamp; i++) {
+			if (!perfdata.IsEmpty())
+				perfdata += " ";
+
+			perfdata += FormatValue(m_Records[i]);
+		}
+
+		if (!object.Service.IsEmpty()) {
+			fp << "DATATYPE::SERVICEPERFDATA\t"
+			   << "TIMET::" << Convert::ToString(first.Timestamp) << "\t"
+			   << "HOSTNAME::" << object.Host << "\t"
+			   << "SERVICEDESC::" << object.Service << "\t"
+			   << "SERVICEPERFDATA::" << perfdata << "\t"
+			   << "SERVICECHECKCOMMAND::" << object.CheckCommand << "\t"
+			   << "HOSTSTATE::" << GetHostStateString(first.HostState) << "\t"
+			   << "HOSTSTATETYPE::" << GetStateTypeString(first.HostStateType) << "\t"
+			   << "SERVICESTATE::" << GetServiceStateString(first.State) << "\t"
+			   << "SERVICESTATETYPE::" << GetStateTypeString(first.StateType) << "\n";
+		} else {
+			fp << "DATATYPE::HOSTPERFDATA\t"
+			   << "TIMET::" << Convert::ToString(first.Timestamp) << "\t"
+			   << "HOSTNAME::" << object.Host << "\t"
+			   << "HOSTPERFDATA::" << perfdata << "\t"
+			   << "HOSTCHECKCOMMAND::" << object.CheckCommand << "\t"
+			   << "HOSTSTATE::" << GetHostStateString(first.HostState) << "\t"
+			   << "HOSTSTATETYPE::" << GetStateTypeString(first.HostStateType) << "\n";
+		}
+	}
+}
@@ -0,0 +1,86 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#ifndef PERFDATASPOOLREADER_H
+#define PERFDATASPOOLREADER_H
+
+#include "perfdata/i2-perfdata.hpp"
+#include "base/object.hpp"
+#include "base/string.hpp"
+#include "perfdata/perfdataspool.hpp"
+#include <boost/interprocess/mapped_region.hpp>
+#include <iostream>
+#include <vector>
+
+namespace icinga
+{
+
+/**
+ * @ingroup perfdata
+ */
+struct PerfdataSpoolObject
+{
+	String Host;
+	String Service;
+	String CheckCommand;
+};
+
+/**
+ * @ingroup perfdata
+ */
+struct PerfdataSpoolLabel
+{
+	String Label;
+	String Unit;
+};
+
+/**
+ * Reads spool segments which were written by PerfdataSpoolWriter.
+ *
+ * @ingroup perfdata
+ */
+class I2_PERFDATA_API PerfdataSpoolReader : public Object
+{
+public:
+	DECLARE_PTR_TYPEDEFS(PerfdataSpoolReader);
+
+	PerfdataSpoolReader(const String& path);
+
+	size_t GetCount(void) const;
+	const PerfdataSpoolRecord& GetRecord(size_t index) const;
+	const PerfdataSpoolObject& GetObject(boost::uint32_t id) const;
+	const PerfdataSpoolLabel& GetLabel(boost::uint32_t id) const;
+
+	String FormatValue(const PerfdataSpoolRecord& record) const;
+	void WriteLegacyText(std::ostream& fp) const;
+
+private:
+	boost::interprocess::mapped_region m_Region;
+	const PerfdataSpoolHeader *m_Header;
+	const PerfdataSpoolRecord *m_Records;
+
+	std::vector<PerfdataSpoolObject> m_Objects;
+	std::vector<PerfdataSpoolLabel> m_Labels;
+
+	void ReadDictionary(const String& path);
+};
+
+}
+
+#endif /* PERFDATASPOOLREADER_H */
@@ -0,0 +1,158 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "perfdata/perfdataspoolwriter.hpp"
+#include "base/exception.hpp"
+#include "base/convert.hpp"
+#include <boost/static_assert.hpp>
+#include <cstring>
+
+using namespace icinga;
+
+BOOST_STATIC_ASSERT(sizeof(PerfdataSpoolHeader) == 64);
+BOOST_STATIC_ASSERT(sizeof(PerfdataSpoolRecord) == 64);
+
+/**
+ * Creates a new spool segment. Existing files are overwritten.
+ *
+ * @param path The path of the segment file.
+ * @param capacity The maximum number of records in this segment.
+ */
+PerfdataSpoolWriter::PerfdataSpoolWriter(const String& path, size_t capacity)
+	: m_Path(path), m_Capacity(capacity), m_Header(NULL), m_Records(NULL)
+{
+	size_t size = sizeof(PerfdataSpoolHeader) + capacity * sizeof(PerfdataSpoolRecord);
+
+	{
+		std::ofstream fp(path.CStr(), std::ofstream::binary | std::ofstream::trunc);
+		fp.seekp(size - 1);
+		fp.put('\0');
+
+		if (!fp.good())
+			BOOST_THROW_EXCEPTION(std::runtime_error("Could not create perfdata spool file '" + path + "'."));
+	}
+
+	boost::interprocess::file_mapping mapping(path.CStr(), boost::interprocess::read_write);
+	boost::interprocess::mapped_region(mapping, boost::interprocess::read_write).swap(m_Region);
+
+	m_Header = static_cast<PerfdataSpoolHeader *>(m_Region.get_address());
+	m_Records = reinterpret_cast<PerfdataSpoolRecord *>(m_Header + 1);
+
+	memset(m_Header, 0, sizeof(*m_Header));
+	strncpy(m_Header->Magic, PERFDATASPOOL_MAGIC, sizeof(m_Header->Magic));
+	m_Header->Version = PERFDATASPOOL_VERSION;
+	m_Header->RecordSize = sizeof(PerfdataSpoolRecord);
+	m_Header->Capacity = capacity;
+
+	String dictPath = path + ".dict";
+	m_Dictionary.open(dictPath.CStr(), std::ofstream::trunc);
+
+	if (!m_Dictionary.good())
+		BOOST_THROW_EXCEPTION(std::runtime_error("Could not create perfdata spool dictionary '" + dictPath + "'."));
+}
+
+PerfdataSpoolWriter::~PerfdataSpoolWriter(void)
+{
+	try {
+		Close();
+	} catch (...) {
+		/* Nothing we can do about it here. */
+	}
+}
+
+boost::uint32_t PerfdataSpoolWriter::Intern(std::map<String, boost::uint32_t>& index, char type, const String& entry)
+{
+	auto it = index.find(entry);
+
+	if (it != index.end())
+		return it->second;
+
+	boost::uint32_t id = index.size();
+	index[entry] = id;
+
+	m_Dictionary << type << '\t' << id << '\t' << entry << '\n' << std::flush;
+
+	return id;
+}
+
+boost::uint32_t PerfdataSpoolWriter::InternObject(const String& host, const String& service, const String& checkCommand)
+{
+	return Intern(m_Objects, 'O', host + "\t" + service + "\t" + checkCommand);
+}
+
+boost::uint32_t PerfdataSpoolWriter::InternLabel(const String& label, const String& unit)
+{
+	return Intern(m_Labels, 'L', label + "\t" + unit);
+}
+
+/**
+ * Appends a record to the segment.
+ *
+ * @returns false if the segment is full or has been closed.
+ */
+bool PerfdataSpoolWriter::Append(const PerfdataSpoolRecord& record)
+{
+	if (!m_Header || m_Header->Count >= m_Capacity)
+		return false;
+
+	memcpy(&m_Records[m_Header->Count], &record, sizeof(record));
+
+	/* Readers only look at records below Count. */
+	m_Header->Count++;
+
+	return true;
+}
+
+/**
+ * Unmaps the segment and truncates the file to the records that were
+ * actually written.
+ */
+void PerfdataSpoolWriter::Close(void)
+{
+	if (!m_Header)
+		return;
+
+	size_t size = sizeof(PerfdataSpoolHeader) + m_Header->Count * sizeof(PerfdataSpoolRecord);
+
+	m_Region.flush();
+	boost::interprocess::mapped_region().swap(m_Region);
+	m_Header = NULL;
+	m_Records = NULL;
+
+	m_Dictionary.close();
+
+#ifndef _WIN32
+	if (truncate(m_Path.CStr(), size) < 0) {
+		BOOST_THROW_EXCEPTION(posix_error()
+		    << boost::errinfo_api_function("truncate")
+		    << boost::errinfo_errno(errno)
+		    << boost::errinfo_file_name(m_Path));
+	}
+#endif /* _WIN32 */
+}
+
+size_t PerfdataSpoolWriter::GetCount(void) const
+{
+	return m_Header ? m_Header->Count : 0;
+}
+
+size_t PerfdataSpoolWriter::GetCapacity(void) const
+{
+	return m_Capacity;
+}
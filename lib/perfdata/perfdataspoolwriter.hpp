@@ -0,0 +1,73 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#ifndef PERFDATASPOOLWRITER_H
+#define PERFDATASPOOLWRITER_H
+
+#include "perfdata/i2-perfdata.hpp"
+#include "base/object.hpp"
+#include "base/string.hpp"
+#include "perfdata/perfdataspool.hpp"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <fstream>
+#include <map>
+
+namespace icinga
+{
+
+/**
+ * Appends performance data records to a memory-mapped spool segment.
+ *
+ * @ingroup perfdata
+ */
+class I2_PERFDATA_API PerfdataSpoolWriter : public Object
+{
+public:
+	DECLARE_PTR_TYPEDEFS(PerfdataSpoolWriter);
+
+	PerfdataSpoolWriter(const String& path, size_t capacity);
+	~PerfdataSpoolWriter(void);
+
+	boost::uint32_t InternObject(const String& host, const String& service, const String& checkCommand);
+	boost::uint32_t InternLabel(const String& label, const String& unit);
+
+	bool Append(const PerfdataSpoolRecord& record);
+	void Close(void);
+
+	size_t GetCount(void) const;
+	size_t GetCapacity(void) const;
+
+private:
+	String m_Path;
+	size_t m_Capacity;
+	boost::interprocess::mapped_region m_Region;
+	PerfdataSpoolHeader *m_Header;
+	PerfdataSpoolRecord *m_Records;
+
+	std::ofstream m_Dictionary;
+	std::map<String, boost::uint32_t> m_Objects;
+	std::map<String, boost::uint32_t> m_Labels;
+
+	boost::uint32_t Intern(std::map<String, boost::uint32_t>& index, char type, const String& entry);
+};
+
+}
+
+#endif /* PERFDATASPOOLWRITER_H */
@@ -0,0 +1,230 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "perfdata/perfdatatransport.hpp"
+#include "icinga/perfdatavalue.hpp"
+#include "base/tcpsocket.hpp"
+#include "base/networkstream.hpp"
+#include "base/logger.hpp"
+#include "base/utility.hpp"
+#include "base/exception.hpp"
+
+using namespace icinga;
+
+/* Queued data is combined into writes of about this size. */
+static const size_t l_MaxBatchSize = 64 * 1024;
+
+PerfdataTransport::PerfdataTransport(const String& name, const String& host, const String& port, size_t maxItems)
+	: m_Name(name), m_Host(host), m_Port(port), m_MaxItems(maxItems), m_QueuedItems(0),
+	  m_Stopped(false), m_Connected(false), m_Overflow(false), m_Dropped(0), m_Sent(0), m_SentStats(15 * 60)
+{ }
+
+void PerfdataTransport::Start(void)
+{
+	m_Thread = boost::thread(boost::bind(&PerfdataTransport::ThreadProc, this));
+}
+
+/**
+ * Sends the remaining data if the endpoint is connected and stops the
+ * sender thread.
+ */
+void PerfdataTransport::Stop(void)
+{
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+		m_Stopped = true;
+		m_CV.notify_all();
+	}
+
+	if (m_Thread.joinable())
+		m_Thread.join();
+}
+
+void PerfdataTransport::Enqueue(const String& data, size_t items)
+{
+	boost::mutex::scoped_lock lock(m_Mutex);
+
+	if (m_QueuedItems + items > m_MaxItems) {
+		if (!m_Overflow) {
+			Log(LogWarning, m_Name)
+			    << "Send queue for host '" << m_Host << "' port '" << m_Port << "' is full, dropping data.";
+			m_Overflow = true;
+		}
+
+		m_Dropped += items;
+		return;
+	}
+
+	Chunk chunk;
+	chunk.Data = data;
+	chunk.Items = items;
+
+	m_Queue.push_back(chunk);
+	m_QueuedItems += items;
+
+	if (m_Queue.size() == 1)
+		m_CV.notify_all();
+}
+
+/**
+ * Adds the transport's perfdata values using the specified prefix and
+ * returns its statistics.
+ */
+Dictionary::Ptr PerfdataTransport::GetStats(const String& prefix, const Array::Ptr& perfdata) const
+{
+	size_t queued;
+	int dropped, sent;
+	double sentPerSecond;
+	bool connected;
+
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+		queued = m_QueuedItems;
+		dropped = m_Dropped;
+		sent = m_Sent;
+		sentPerSecond = m_SentStats.GetValues(60) / 60.0;
+		connected = m_Connected;
+	}
+
+	Dictionary::Ptr stats = new Dictionary();
+	stats->Set("connected", connected);
+	stats->Set("queued", queued);
+	stats->Set("dropped", dropped);
+	stats->Set("sent", sent);
+	stats->Set("sent_per_second", sentPerSecond);
+
+	perfdata->Add(new PerfdataValue(prefix + "_queued", queued));
+	perfdata->Add(new PerfdataValue(prefix + "_dropped", dropped));
+	perfdata->Add(new PerfdataValue(prefix + "_sent_per_second", sentPerSecond));
+
+	return stats;
+}
+
+Stream::Ptr PerfdataTransport::Connect(void)
+{
+	TcpSocket::Ptr socket = new TcpSocket();
+
+	Log(LogNotice, m_Name)
+	    << "Reconnecting to host '" << m_Host << "' port '" << m_Port << "'.";
+
+	try {
+		socket->Connect(m_Host, m_Port);
+	} catch (const std::exception&) {
+		Log(LogCritical, m_Name)
+		    << "Can't connect to host '" << m_Host << "' port '" << m_Port << "'.";
+		return Stream::Ptr();
+	}
+
+	return new NetworkStream(socket);
+}
+
+void PerfdataTransport::ThreadProc(void)
+{
+	Utility::SetThreadName(m_Name);
+
+	Stream::Ptr stream;
+	double nextConnect = 0;
+
+	for (;;) {
+		std::vector<Chunk> batch;
+		size_t batchSize = 0;
+
+		{
+			boost::mutex::scoped_lock lock(m_Mutex);
+
+			while (m_Queue.empty() && !m_Stopped)
+				m_CV.wait(lock);
+
+			if (m_Stopped && (m_Queue.empty() || !stream))
+				break;
+
+			if (!stream) {
+				double now = Utility::GetTime();
+
+				if (now < nextConnect) {
+					m_CV.timed_wait(lock, boost::posix_time::milliseconds(static_cast<long>((nextConnect - now) * 1000)));
+					continue;
+				}
+			} else {
+				while (!m_Queue.empty() && batchSize < l_MaxBatchSize) {
+					batchSize += m_Queue.front().Data.GetLength();
+					batch.push_back(m_Queue.front());
+					m_Queue.pop_front();
+				}
+			}
+		}
+
+		if (!stream) {
+			stream = Connect();
+
+			boost::mutex::scoped_lock lock(m_Mutex);
+			m_Connected = static_cast<bool>(stream);
+
+			if (!stream)
+				nextConnect = Utility::GetTime() + 10;
+
+			continue;
+		}
+
+		std::string buffer;
+		buffer.reserve(batchSize);
+
+		size_t items = 0;
+
+		for (const Chunk& chunk : batch) {
+			buffer += chunk.Data.GetData();
+			items += chunk.Items;
+		}
+
+		try {
+			stream->Write(buffer.c_str(), buffer.size());
+		} catch (const std::exception&) {
+			Log(LogCritical, m_Name)
+			    << "Cannot write to host '" << m_Host << "' port '" << m_Port << "'.";
+
+			stream.reset();
+
+			boost::mutex::scoped_lock lock(m_Mutex);
+			m_Connected = false;
+			nextConnect = Utility::GetTime() + 10;
+
+			/* Replay the batch once we're connected again. */
+			m_Queue.insert(m_Queue.begin(), batch.begin(), batch.end());
+
+			continue;
+		}
+
+		boost::mutex::scoped_lock lock(m_Mutex);
+		m_QueuedItems -= items;
+		m_Sent += items;
+		m_SentStats.InsertValue(Utility::GetTime(), items);
+		m_Overflow = false;
+	}
+
+	if (stream)
+		stream->Close();
+
+	boost::mutex::scoped_lock lock(m_Mutex);
+	m_Connected = false;
+
+	if (m_QueuedItems > 0) {
+		Log(LogWarning, m_Name)
+		    << "Discarding " << m_QueuedItems << " queued items for host '" << m_Host << "' port '" << m_Port << "'.";
+	}
+}
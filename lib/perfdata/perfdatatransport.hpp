@@ -0,0 +1,94 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#ifndef PERFDATATRANSPORT_H
+#define PERFDATATRANSPORT_H
+
+#include "perfdata/i2-perfdata.hpp"
+#include "base/object.hpp"
+#include "base/stream.hpp"
+#include "base/ringbuffer.hpp"
+#include "base/array.hpp"
+#include "base/dictionary.hpp"
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <deque>
+
+namespace icinga
+{
+
+/**
+ * Sends data to a TCP endpoint from a dedicated thread.
+ *
+ * Writers queue preformatted data with Enqueue(). Everything that has
+ * been queued while the previous write was in progress is sent with a
+ * single write. Data which could not be written is kept at the front of
+ * the queue and replayed once the connection has been re-established,
+ * so the endpoint may see a partially written batch twice. When the
+ * queue is full new data is dropped.
+ *
+ * @ingroup perfdata
+ */
+class I2_PERFDATA_API PerfdataTransport : public Object
+{
+public:
+	DECLARE_PTR_TYPEDEFS(PerfdataTransport);
+
+	PerfdataTransport(const String& name, const String& host, const String& port, size_t maxItems);
+
+	void Start(void);
+	void Stop(void);
+
+	void Enqueue(const String& data, size_t items = 1);
+
+	Dictionary::Ptr GetStats(const String& prefix, const Array::Ptr& perfdata) const;
+
+private:
+	struct Chunk
+	{
+		String Data;
+		size_t Items;
+	};
+
+	String m_Name;
+	String m_Host;
+	String m_Port;
+	size_t m_MaxItems;
+
+	mutable boost::mutex m_Mutex;
+	boost::condition_variable m_CV;
+	std::deque<Chunk> m_Queue;
+	size_t m_QueuedItems;
+	bool m_Stopped;
+	bool m_Connected;
+	bool m_Overflow;
+	int m_Dropped;
+	int m_Sent;
+	RingBuffer m_SentStats;
+
+	boost::thread m_Thread;
+
+	Stream::Ptr Connect(void);
+	void ThreadProc(void);
+};
+
+}
+
+#endif /* PERFDATATRANSPORT_H */
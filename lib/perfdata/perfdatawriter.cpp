@@ -22,6 +22,7 @@
 #include "icinga/service.hpp"
 #include "icinga/macroprocessor.hpp"
 #include "icinga/icingaapplication.hpp"
+#include "icinga/perfdatavalue.hpp"
 #include "base/configtype.hpp"
 #include "base/objectlock.hpp"
 #include "base/logger.hpp"
@@ -38,6 +39,9 @@ REGISTER_TYPE(PerfdataWriter);
 
 REGISTER_STATSFUNCTION(PerfdataWriter, &PerfdataWriter::StatsFunc);
 
+/* Maximum number of records per binary spool segment (64 MiB). */
+static const size_t l_SpoolCapacity = 1024 * 1024;
+
 void PerfdataWriter::StatsFunc(const Dictionary::Ptr& status, const Array::Ptr&)
 {
 	Dictionary::Ptr nodes = new Dictionary();
@@ -56,19 +60,32 @@ void PerfdataWriter::Start(bool runtimeCreated)
 	Log(LogInformation, "PerfdataWriter")
 	    << "'" << GetName() << "' started.";
 
-	Checkable::OnNewCheckResult.connect(boost::bind(&PerfdataWriter::CheckResultHandler, this, _1, _2));
+	m_CheckResultConsumer = new CheckResultConsumer("PerfdataWriter, " + GetName(),
+	    boost::bind(&PerfdataWriter::CheckResultHandler, this, _1, _2));
+	m_CheckResultConsumer->Start();
 
 	m_RotationTimer = new Timer();
 	m_RotationTimer->OnTimerExpired.connect(boost::bind(&PerfdataWriter::RotationTimerHandler, this));
 	m_RotationTimer->SetInterval(GetRotationInterval());
 	m_RotationTimer->Start();
 
-	RotateFile(m_ServiceOutputFile, GetServiceTempPath(), GetServicePerfdataPath());
-	RotateFile(m_HostOutputFile, GetHostTempPath(), GetHostPerfdataPath());
+	RotateOutput();
 }
 
 void PerfdataWriter::Stop(bool runtimeRemoved)
 {
+	m_CheckResultConsumer->Stop();
+
+	{
+		boost::mutex::scoped_lock lock(m_OutputMutex);
+
+		if (m_ServiceSpool)
+			m_ServiceSpool->Close();
+
+		if (m_HostSpool)
+			m_HostSpool->Close();
+	}
+
 	Log(LogInformation, "PerfdataWriter")
 	    << "'" << GetName() << "' stopped.";
 
@@ -83,12 +100,12 @@ Value PerfdataWriter::EscapeMacroMetric(const Value& value)
 		return value;
 }
 
-void PerfdataWriter::CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr)
+CheckResultConsumer::Task PerfdataWriter::CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr)
 {
 	CONTEXT("Writing performance data for object '" + checkable->GetName() + "'");
 
 	if (!IcingaApplication::GetInstance()->GetEnablePerfdata() || !checkable->GetEnablePerfdata())
-		return;
+		return CheckResultConsumer::Task();
 
 	Service::Ptr service = dynamic_pointer_cast<Service>(checkable);
 	Host::Ptr host;
@@ -98,39 +115,72 @@ void PerfdataWriter::CheckResultHandler(const Checkable::Ptr& checkable, const C
 	else
 		host = static_pointer_cast<Host>(checkable);
 
+	if (GetEnableBinarySpool()) {
+		PerfdataSpoolRecord record;
+		memset(&record, 0, sizeof(record));
+		record.Timestamp = cr->GetExecutionEnd();
+
+		/* Use the state this check result produced rather than the
+		 * checkable's current state, which may already be newer. */
+		ServiceState state = cr->GetState();
+		StateType stateType = checkable->GetStateType();
+		Dictionary::Ptr vars_after = cr->GetVarsAfter();
+
+		if (vars_after) {
+			state = static_cast<ServiceState>(static_cast<int>(vars_after->Get("state")));
+			stateType = static_cast<StateType>(static_cast<int>(vars_after->Get("state_type")));
+		}
+
+		if (service) {
+			record.State = state;
+			record.StateType = stateType;
+			record.HostState = host->GetState();
+			record.HostStateType = host->GetStateType();
+		} else {
+			record.State = Host::CalculateState(state);
+			record.StateType = stateType;
+			record.HostState = record.State;
+			record.HostStateType = stateType;
+		}
+
+		return boost::bind(&PerfdataWriter::WriteSpoolRecords, PerfdataWriter::Ptr(this), static_cast<bool>(service),
+		    record, host->GetName(), service ? service->GetShortName() : "", checkable->GetCheckCommandRaw(), cr);
+	}
+
 	MacroProcessor::ResolverList resolvers;
 	if (service)
 		resolvers.push_back(std::make_pair("service", service));
 	resolvers.push_back(std::make_pair("host", host));
 	resolvers.push_back(std::make_pair("icinga", IcingaApplication::GetInstance()));
 
-	if (service) {
-		String line = MacroProcessor::ResolveMacros(GetServiceFormatTemplate(), resolvers, cr, NULL, &PerfdataWriter::EscapeMacroMetric);
+	String line;
 
-		{
-			ObjectLock olock(this);
-			if (!m_ServiceOutputFile.good())
-				return;
+	if (service)
+		line = MacroProcessor::ResolveMacros(GetServiceFormatTemplate(), resolvers, cr, NULL, &PerfdataWriter::EscapeMacroMetric);
+	else
+		line = MacroProcessor::ResolveMacros(GetHostFormatTemplate(), resolvers, cr, NULL, &PerfdataWriter::EscapeMacroMetric);
 
-			m_ServiceOutputFile << line << "\n";
-		}
-	} else {
-		String line = MacroProcessor::ResolveMacros(GetHostFormatTemplate(), resolvers, cr, NULL, &PerfdataWriter::EscapeMacroMetric);
+	return boost::bind(&PerfdataWriter::WriteLine, PerfdataWriter::Ptr(this), static_cast<bool>(service), line);
+}
 
-		{
-			ObjectLock olock(this);
-			if (!m_HostOutputFile.good())
-				return;
+void PerfdataWriter::WriteLine(bool service, const String& line)
+{
+	boost::mutex::scoped_lock lock(m_OutputMutex);
 
-			m_HostOutputFile << line << "\n";
-		}
-	}
+	std::ofstream& output = service ? m_ServiceOutputFile : m_HostOutputFile;
+
+	if (!output.good())
+		return;
+
+	output << line << "\n";
 }
 
+/**
+ * Closes the current output file and opens a new one. The caller must
+ * hold m_OutputMutex.
+ */
 void PerfdataWriter::RotateFile(std::ofstream& output, const String& temp_path, const String& perfdata_path)
 {
-	ObjectLock olock(this);
-
 	if (output.good()) {
 		output.close();
 
@@ -152,10 +202,146 @@ void PerfdataWriter::RotateFile(std::ofstream& output, const String& temp_path,
 		    << "Could not open perfdata file '" << temp_path << "' for writing. Perfdata will be lost.";
 }
 
+/**
+ * Appends the check result's performance data to a binary spool segment.
+ * The record's timestamp and states have been filled in by the caller.
+ * Values which cannot be parsed are skipped.
+ */
+void PerfdataWriter::WriteSpoolRecords(bool service, PerfdataSpoolRecord record, const String& hostName,
+    const String& serviceName, const String& checkCommand, const CheckResult::Ptr& cr)
+{
+	Array::Ptr perfdata = cr->GetPerformanceData();
+
+	if (!perfdata)
+		return;
+
+	std::vector<PerfdataValue::Ptr> values;
+
+	{
+		ObjectLock olock(perfdata);
+
+		for (const Value& val : perfdata) {
+			if (val.IsObjectType<PerfdataValue>()) {
+				values.push_back(val);
+				continue;
+			}
+
+			try {
+				values.push_back(PerfdataValue::Parse(val));
+			} catch (const std::exception&) {
+				/* The text format would contain the raw value, we can't store it. */
+			}
+		}
+	}
+
+	if (values.empty())
+		return;
+
+	boost::mutex::scoped_lock lock(m_OutputMutex);
+
+	PerfdataSpoolWriter::Ptr& spool = service ? m_ServiceSpool : m_HostSpool;
+
+	/* Object and label IDs are only valid within a single segment. */
+	if (spool && spool->GetCount() + values.size() > spool->GetCapacity()) {
+		if (service)
+			RotateSpool(spool, GetServiceTempPath(), GetServicePerfdataPath());
+		else
+			RotateSpool(spool, GetHostTempPath(), GetHostPerfdataPath());
+	}
+
+	if (!spool)
+		return;
+
+	record.ObjectID = spool->InternObject(hostName, serviceName, checkCommand);
+
+	for (const PerfdataValue::Ptr& pdv : values) {
+		String unit;
+
+		if (pdv->GetCounter())
+			unit = "c";
+		else if (pdv->GetUnit() == "seconds")
+			unit = "s";
+		else if (pdv->GetUnit() == "percent")
+			unit = "%";
+		else if (pdv->GetUnit() == "bytes")
+			unit = "B";
+
+		record.LabelID = spool->InternLabel(pdv->GetLabel(), unit);
+		record.Value = pdv->GetValue();
+		record.Flags = 0;
+
+		if (!pdv->GetWarn().IsEmpty()) {
+			record.Warn = pdv->GetWarn();
+			record.Flags |= PerfdataSpoolHasWarn;
+		}
+
+		if (!pdv->GetCrit().IsEmpty()) {
+			record.Crit = pdv->GetCrit();
+			record.Flags |= PerfdataSpoolHasCrit;
+		}
+
+		if (!pdv->GetMin().IsEmpty()) {
+			record.Min = pdv->GetMin();
+			record.Flags |= PerfdataSpoolHasMin;
+		}
+
+		if (!pdv->GetMax().IsEmpty()) {
+			record.Max = pdv->GetMax();
+			record.Flags |= PerfdataSpoolHasMax;
+		}
+
+		spool->Append(record);
+	}
+}
+
+/**
+ * Closes the current spool segment and opens a new one. The caller must
+ * hold m_OutputMutex.
+ */
+void PerfdataWriter::RotateSpool(PerfdataSpoolWriter::Ptr& spool, const String& temp_path, const String& perfdata_path)
+{
+	if (spool) {
+		spool->Close();
+		spool.reset();
+
+		if (Utility::PathExists(temp_path)) {
+			String finalFile = perfdata_path + "." + Convert::ToString((long)Utility::GetTime());
+			if (rename(temp_path.CStr(), finalFile.CStr()) < 0) {
+				BOOST_THROW_EXCEPTION(posix_error()
+				    << boost::errinfo_api_function("rename")
+				    << boost::errinfo_errno(errno)
+				    << boost::errinfo_file_name(temp_path));
+			}
+
+			(void) rename((temp_path + ".dict").CStr(), (finalFile + ".dict").CStr());
+		}
+	}
+
+	try {
+		spool = new PerfdataSpoolWriter(temp_path, l_SpoolCapacity);
+	} catch (const std::exception& ex) {
+		Log(LogWarning, "PerfdataWriter")
+		    << "Could not open perfdata spool '" << temp_path << "' for writing. Perfdata will be lost: "
+		    << DiagnosticInformation(ex, false);
+	}
+}
+
+void PerfdataWriter::RotateOutput(void)
+{
+	boost::mutex::scoped_lock lock(m_OutputMutex);
+
+	if (GetEnableBinarySpool()) {
+		RotateSpool(m_ServiceSpool, GetServiceTempPath(), GetServicePerfdataPath());
+		RotateSpool(m_HostSpool, GetHostTempPath(), GetHostPerfdataPath());
+	} else {
+		RotateFile(m_ServiceOutputFile, GetServiceTempPath(), GetServicePerfdataPath());
+		RotateFile(m_HostOutputFile, GetHostTempPath(), GetHostPerfdataPath());
+	}
+}
+
 void PerfdataWriter::RotationTimerHandler(void)
 {
-	RotateFile(m_ServiceOutputFile, GetServiceTempPath(), GetServicePerfdataPath());
-	RotateFile(m_HostOutputFile, GetHostTempPath(), GetHostPerfdataPath());
+	RotateOutput();
 }
 
 void PerfdataWriter::ValidateHostFormatTemplate(const String& value, const ValidationUtils& utils)
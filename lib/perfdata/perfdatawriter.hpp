@@ -21,9 +21,12 @@
 #define PERFDATAWRITER_H
 
 #include "perfdata/perfdatawriter.thpp"
+#include "perfdata/perfdataspoolwriter.hpp"
 #include "icinga/service.hpp"
+#include "icinga/checkresultconsumer.hpp"
 #include "base/configobject.hpp"
 #include "base/timer.hpp"
+#include <boost/thread/mutex.hpp>
 #include <fstream>
 
 namespace icinga
@@ -50,15 +53,27 @@ protected:
 	virtual void Stop(bool runtimeRemoved) override;
 
 private:
-	void CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
+	CheckResultConsumer::Ptr m_CheckResultConsumer;
+	CheckResultConsumer::Task CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr);
+	void WriteLine(bool service, const String& line);
 	static Value EscapeMacroMetric(const Value& value);
 
 	Timer::Ptr m_RotationTimer;
 	void RotationTimerHandler(void);
 
+	/* Not the object lock: Stop() waits for the queued writes while
+	 * ConfigObject::Deactivate() holds it. */
+	boost::mutex m_OutputMutex;
 	std::ofstream m_ServiceOutputFile;
 	std::ofstream m_HostOutputFile;
 	void RotateFile(std::ofstream& output, const String& temp_path, const String& perfdata_path);
+
+	PerfdataSpoolWriter::Ptr m_ServiceSpool;
+	PerfdataSpoolWriter::Ptr m_HostSpool;
+	void WriteSpoolRecords(bool service, PerfdataSpoolRecord record, const String& hostName,
+	    const String& serviceName, const String& checkCommand, const CheckResult::Ptr& cr);
+	void RotateSpool(PerfdataSpoolWriter::Ptr& spool, const String& temp_path, const String& perfdata_path);
+	void RotateOutput(void);
 };
 
 }
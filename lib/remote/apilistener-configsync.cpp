@@ -343,7 +343,7 @@ void ApiListener::UpdateConfigObject(const ConfigObject::Ptr& object, const Mess
 #endif /* I2_DEBUG */
 
 	if (client)
-		JsonRpc::SendMessage(client->GetStream(), message);
+		JsonRpc::SendMessage(client->GetMessageStream(), message);
 	else {
 		Zone::Ptr target = static_pointer_cast<Zone>(object->GetZone());
 
@@ -391,7 +391,7 @@ void ApiListener::DeleteConfigObject(const ConfigObject::Ptr& object, const Mess
 #endif /* I2_DEBUG */
 
 	if (client)
-		JsonRpc::SendMessage(client->GetStream(), message);
+		JsonRpc::SendMessage(client->GetMessageStream(), message);
 	else {
 		Zone::Ptr target = static_pointer_cast<Zone>(object->GetZone());
 
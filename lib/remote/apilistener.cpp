@@ -41,6 +41,7 @@ using namespace icinga;
 REGISTER_TYPE(ApiListener);
 
 boost::signals2::signal<void(bool)> ApiListener::OnMasterChanged;
+boost::signals2::signal<void(void)> ApiListener::OnStopping;
 ApiListener::Ptr ApiListener::m_Instance;
 
 REGISTER_STATSFUNCTION(ApiListener, &ApiListener::StatsFunc);
@@ -169,6 +170,10 @@ void ApiListener::Start(bool runtimeCreated)
 
 void ApiListener::Stop(bool runtimeDeleted)
 {
+	/* Gives the cluster events a chance to relay pending messages
+	 * before the replay log is closed. */
+	OnStopping();
+
 	ObjectImpl<ApiListener>::Stop(runtimeDeleted);
 
 	Log(LogInformation, "ApiListener")
@@ -416,7 +421,11 @@ void ApiListener::NewClientHandlerInternal(const Socket::Ptr& client, const Stri
 		Dictionary::Ptr message = new Dictionary();
 		message->Set("jsonrpc", "2.0");
 		message->Set("method", "icinga::Hello");
-		message->Set("params", new Dictionary());
+
+		Dictionary::Ptr params = new Dictionary();
+		params->Set("capabilities", GetCapabilities());
+		message->Set("params", params);
+
 		JsonRpc::SendMessage(tlsStream, message);
 		ctype = ClientJsonRpc;
 	} else {
@@ -469,6 +478,14 @@ void ApiListener::SyncClient(const JsonRpcConnection::Ptr& aclient, const Endpoi
 			endpoint->SetSyncing(true);
 		}
 
+		/* Give the peer a chance to agree on compression before we send
+		 * the config files and the replay log.
+		 */
+		if (endpoint->GetCompressionLevel() > 0 && !aclient->WaitForCapabilities(5)) {
+			Log(LogInformation, "ApiListener")
+			    << "Endpoint '" << endpoint->GetName() << "' does not support compression.";
+		}
+
 		/* Make sure that the config updates are synced
 		 * before the logs are replayed.
 		 */
@@ -704,11 +721,23 @@ void ApiListener::SyncSendMessage(const Endpoint::Ptr& endpoint, const Dictionar
 				maxTs = client->GetTimestamp();
 		}
 
+		std::vector<Dictionary::Ptr> messages;
+
 		for (const JsonRpcConnection::Ptr& client : endpoint->GetClients()) {
 			if (client->GetTimestamp() != maxTs)
 				continue;
 
-			client->SendMessage(message);
+			if (client->HasCapability(message->Get("method"))) {
+				client->SendMessage(message);
+				continue;
+			}
+
+			/* Peers which don't support batched messages get them one by one. */
+			if (messages.empty())
+				SplitBatchMessage(message, messages);
+
+			for (const Dictionary::Ptr& smessage : messages)
+				client->SendMessage(smessage);
 		}
 	}
 }
@@ -1006,7 +1035,17 @@ void ApiListener::ReplayLog(const JsonRpcConnection::Ptr& client)
 				}
 
 				try  {
-					NetString::WriteStringToStream(client->GetStream(), pmessage->Get("message"));
+					String rmessage = pmessage->Get("message");
+
+					if (rmessage.Find("event::CheckResults") != String::NPos && !client->HasCapability("event::CheckResults")) {
+						std::vector<Dictionary::Ptr> messages;
+						SplitBatchMessage(JsonDecode(rmessage), messages);
+
+						for (const Dictionary::Ptr& smessage : messages)
+							NetString::WriteStringToStream(client->GetMessageStream(), JsonEncode(smessage));
+					} else
+						NetString::WriteStringToStream(client->GetMessageStream(), rmessage);
+
 					count++;
 				} catch (const std::exception& ex) {
 					Log(LogWarning, "ApiListener")
@@ -1027,7 +1066,7 @@ void ApiListener::ReplayLog(const JsonRpcConnection::Ptr& client)
 					lmessage->Set("method", "log::SetLogPosition");
 					lmessage->Set("params", lparams);
 
-					JsonRpc::SendMessage(client->GetStream(), lmessage);
+					JsonRpc::SendMessage(client->GetMessageStream(), lmessage);
 				}
 			}
 
@@ -1152,6 +1191,46 @@ std::pair<Dictionary::Ptr, Dictionary::Ptr> ApiListener::GetStatus(void)
 
 	status->Set("zones", connectedZones);
 
+	Dictionary::Ptr transferStats = new Dictionary();
+
+	for (const Endpoint::Ptr& endpoint : ConfigType::GetObjectsByType<Endpoint>()) {
+		std::set<JsonRpcConnection::Ptr> clients = endpoint->GetClients();
+
+		if (clients.empty())
+			continue;
+
+		double bytesIn = 0, compressedBytesIn = 0, bytesOut = 0, compressedBytesOut = 0, cpuTime = 0;
+		bool compressedIn = false, compressedOut = false;
+
+		for (const JsonRpcConnection::Ptr& client : clients) {
+			ZlibStream::Ptr stream = client->GetMessageStream();
+
+			bytesIn += stream->GetBytesIn();
+			compressedBytesIn += stream->GetCompressedBytesIn();
+			bytesOut += stream->GetBytesOut();
+			compressedBytesOut += stream->GetCompressedBytesOut();
+			cpuTime += stream->GetCpuTime();
+
+			compressedIn = compressedIn || stream->IsInflating();
+			compressedOut = compressedOut || stream->IsDeflating();
+		}
+
+		Dictionary::Ptr endpointStats = new Dictionary();
+		endpointStats->Set("compressed_in", compressedIn);
+		endpointStats->Set("compressed_out", compressedOut);
+		endpointStats->Set("bytes_in", bytesIn);
+		endpointStats->Set("wire_bytes_in", compressedBytesIn);
+		endpointStats->Set("bytes_out", bytesOut);
+		endpointStats->Set("wire_bytes_out", compressedBytesOut);
+		endpointStats->Set("compression_ratio_in", compressedBytesIn > 0 ? bytesIn / compressedBytesIn : 1);
+		endpointStats->Set("compression_ratio_out", compressedBytesOut > 0 ? bytesOut / compressedBytesOut : 1);
+		endpointStats->Set("compression_cpu_time", cpuTime);
+
+		transferStats->Set(endpoint->GetName(), endpointStats);
+	}
+
+	status->Set("endpoint_transfer", transferStats);
+
 	perfdata->Set("num_endpoints", allEndpoints);
 	perfdata->Set("num_conn_endpoints", Convert::ToDouble(allConnectedEndpoints->GetLength()));
 	perfdata->Set("num_not_conn_endpoints", Convert::ToDouble(allNotConnectedEndpoints->GetLength()));
@@ -1208,9 +1287,81 @@ std::set<HttpServerConnection::Ptr> ApiListener::GetHttpClients(void) const
 
 Value ApiListener::HelloAPIHandler(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params)
 {
+	if (!params || !params->Contains("capabilities"))
+		return Empty;
+
+	JsonRpcConnection::Ptr client = origin->FromClient;
+
+	client->SetCapabilities(params->Get("capabilities"));
+
+	/* Clients send their hello message first, let them know what we support. */
+	if (client->GetRole() == RoleServer) {
+		Dictionary::Ptr rparams = new Dictionary();
+		rparams->Set("capabilities", GetCapabilities());
+
+		Dictionary::Ptr message = new Dictionary();
+		message->Set("jsonrpc", "2.0");
+		message->Set("method", "icinga::Hello");
+		message->Set("params", rparams);
+
+		client->SendMessage(message);
+	}
+
 	return Empty;
 }
 
+/**
+ * Returns the optional protocol features this instance understands. They
+ * are exchanged in the icinga::Hello message when a connection is set up.
+ */
+Array::Ptr ApiListener::GetCapabilities(void)
+{
+	Array::Ptr capabilities = new Array();
+	capabilities->Add("event::CheckResults");
+
+	if (ZlibStream::IsSupported())
+		capabilities->Add("icinga::Compression");
+	return capabilities;
+}
+
+/**
+ * Splits a batched message into the individual messages it is made of, for
+ * peers which don't support batching. Other messages are returned as-is.
+ */
+void ApiListener::SplitBatchMessage(const Dictionary::Ptr& message, std::vector<Dictionary::Ptr>& messages)
+{
+	if (message->Get("method") != "event::CheckResults") {
+		messages.push_back(message);
+		return;
+	}
+
+	Dictionary::Ptr params = message->Get("params");
+
+	if (!params)
+		return;
+
+	Array::Ptr results = params->Get("results");
+
+	if (!results)
+		return;
+
+	ObjectLock olock(results);
+	for (const Dictionary::Ptr& result : results) {
+		Dictionary::Ptr smessage = new Dictionary();
+		smessage->Set("jsonrpc", "2.0");
+		smessage->Set("method", "event::CheckResult");
+		smessage->Set("params", result);
+
+		if (message->Contains("ts"))
+			smessage->Set("ts", message->Get("ts"));
+
+		if (message->Contains("originZone"))
+			smessage->Set("originZone", message->Get("originZone"));
+
+		messages.push_back(smessage);
+	}
+}
+
 Endpoint::Ptr ApiListener::GetLocalEndpoint(void) const
 {
 	return m_LocalEndpoint;
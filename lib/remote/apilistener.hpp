@@ -56,6 +56,7 @@ public:
 	DECLARE_OBJECTNAME(ApiListener);
 
 	static boost::signals2::signal<void(bool)> OnMasterChanged;
+	static boost::signals2::signal<void(void)> OnStopping;
 
 	ApiListener(void);
 
@@ -95,8 +96,10 @@ public:
 	static Value ConfigDeleteObjectAPIHandler(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params);
 	
 	static Value HelloAPIHandler(const MessageOrigin::Ptr& origin, const Dictionary::Ptr& params);
+	static Array::Ptr GetCapabilities(void);
 
 	static void UpdateObjectAuthority(void);
+	static void InvalidateObjectAuthority(void);
 
 	static bool IsHACluster(void);
 
@@ -146,6 +149,7 @@ private:
 	void CloseLogFile(void);
 	static void LogGlobHandler(std::vector<int>& files, const String& file);
 	void ReplayLog(const JsonRpcConnection::Ptr& client);
+	static void SplitBatchMessage(const Dictionary::Ptr& message, std::vector<Dictionary::Ptr>& messages);
 
 	/* filesync */
 	static ConfigDirInformation LoadConfigDir(const String& dir);
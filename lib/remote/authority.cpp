@@ -19,11 +19,29 @@
 
 #include "remote/zone.hpp"
 #include "remote/apilistener.hpp"
+#include "remote/rendezvoushash.hpp"
 #include "base/configtype.hpp"
+#include "base/convert.hpp"
+#include "base/logger.hpp"
 #include "base/utility.hpp"
+#include <boost/thread/mutex.hpp>
 
 using namespace icinga;
 
+static boost::mutex l_AuthorityMutex;
+static bool l_AuthorityValid = false;
+static String l_AuthorityMembership;
+
+/**
+ * Forces the next call to UpdateObjectAuthority() to re-evaluate all
+ * objects, e.g. because new objects were created at runtime.
+ */
+void ApiListener::InvalidateObjectAuthority(void)
+{
+	boost::mutex::scoped_lock lock(l_AuthorityMutex);
+	l_AuthorityValid = false;
+}
+
 void ApiListener::UpdateObjectAuthority(void)
 {
 	Zone::Ptr my_zone = Zone::GetLocalZone();
@@ -57,6 +75,30 @@ void ApiListener::UpdateObjectAuthority(void)
 		);
 	}
 
+	RendezvousHash ring;
+	String membership;
+	int my_index = -1;
+
+	for (const Endpoint::Ptr& endpoint : endpoints) {
+		if (endpoint == my_endpoint)
+			my_index = ring.GetNodeCount();
+
+		ring.AddNode(endpoint->GetName(), endpoint->GetAuthorityWeight());
+
+		if (!membership.IsEmpty())
+			membership += ", ";
+
+		membership += endpoint->GetName() + " (" + Convert::ToString(endpoint->GetAuthorityWeight()) + ")";
+	}
+
+	boost::mutex::scoped_lock lock(l_AuthorityMutex);
+
+	/* Objects only change owner when the zone membership changes. */
+	if (l_AuthorityValid && membership == l_AuthorityMembership)
+		return;
+
+	int total = 0, moved = 0;
+
 	for (const Type::Ptr& type : Type::GetAllTypes()) {
 		ConfigType *dtype = dynamic_cast<ConfigType *>(type.get());
 
@@ -72,9 +114,26 @@ void ApiListener::UpdateObjectAuthority(void)
 			if (!my_zone)
 				authority = true;
 			else
-				authority = endpoints[Utility::SDBM(object->GetName()) % endpoints.size()] == my_endpoint;
+				authority = ring.GetNode(object->GetName()) == my_index;
+
+			total++;
+
+			if (authority == object->IsPaused())
+				moved++;
 
 			object->SetAuthority(authority);
 		}
 	}
+
+	if (!l_AuthorityMembership.IsEmpty() && membership != l_AuthorityMembership) {
+		Log(LogInformation, "ApiListener")
+		    << "Zone membership changed to [" << membership << "]: "
+		    << moved << " of " << total << " objects changed authority on this endpoint.";
+	} else {
+		Log(LogNotice, "ApiListener")
+		    << "Updated authority for " << total << " objects (" << moved << " changed).";
+	}
+
+	l_AuthorityValid = true;
+	l_AuthorityMembership = membership;
 }
@@ -151,6 +151,7 @@ bool ConfigObjectUtility::CreateObject(const Type::Ptr& type, const String& full
 			return false;
 		}
 
+		ApiListener::InvalidateObjectAuthority();
 		ApiListener::UpdateObjectAuthority();
 	} catch (const std::exception& ex) {
 		delete expr;
@@ -26,6 +26,8 @@
 #include "base/utility.hpp"
 #include "base/exception.hpp"
 #include "base/convert.hpp"
+#include "base/zlibstream.hpp"
+#include <boost/assign/list_of.hpp>
 
 using namespace icinga;
 
@@ -117,3 +119,14 @@ Endpoint::Ptr Endpoint::GetLocalEndpoint(void)
 
 	return listener->GetLocalEndpoint();
 }
+
+void Endpoint::ValidateCompressionLevel(int value, const ValidationUtils& utils)
+{
+	ObjectImpl<Endpoint>::ValidateCompressionLevel(value, utils);
+
+	if (value < 0 || value > 9)
+		BOOST_THROW_EXCEPTION(ValidationError(this, boost::assign::list_of("compression_level"), "Compression level must be between 0 and 9."));
+
+	if (value > 0 && !ZlibStream::IsSupported())
+		BOOST_THROW_EXCEPTION(ValidationError(this, boost::assign::list_of("compression_level"), "Icinga was built without zlib support."));
+}
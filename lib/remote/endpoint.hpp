@@ -56,6 +56,8 @@ public:
 
 	void SetCachedZone(const intrusive_ptr<Zone>& zone);
 
+	virtual void ValidateCompressionLevel(int value, const ValidationUtils& utils) override;
+
 protected:
 	virtual void OnAllConfigLoaded(void) override;
 
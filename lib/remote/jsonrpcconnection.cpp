@@ -27,6 +27,8 @@
 #include "base/logger.hpp"
 #include "base/exception.hpp"
 #include "base/convert.hpp"
+#include "base/json.hpp"
+#include "base/netstring.hpp"
 #include <boost/thread/once.hpp>
 
 using namespace icinga;
@@ -45,8 +47,8 @@ static int l_JsonRpcConnectionNextID;
 JsonRpcConnection::JsonRpcConnection(const String& identity, bool authenticated,
     const TlsStream::Ptr& stream, ConnectionRole role)
 	: m_ID(l_JsonRpcConnectionNextID++), m_Identity(identity), m_Authenticated(authenticated), m_Stream(stream),
-	  m_Role(role), m_Timestamp(Utility::GetTime()), m_Seen(Utility::GetTime()),
-	  m_NextHeartbeat(0), m_HeartbeatTimeout(0)
+	  m_MessageStream(new ZlibStream(stream)), m_Role(role), m_Timestamp(Utility::GetTime()), m_Seen(Utility::GetTime()),
+	  m_NextHeartbeat(0), m_HeartbeatTimeout(0), m_CapabilitiesReceived(false)
 {
 	boost::call_once(l_JsonRpcConnectionOnceFlag, &JsonRpcConnection::StaticInitialize);
 
@@ -102,6 +104,15 @@ TlsStream::Ptr JsonRpcConnection::GetStream(void) const
 	return m_Stream;
 }
 
+/**
+ * Returns the stream messages have to be written to. It takes care of
+ * compressing them once this has been negotiated with the peer.
+ */
+ZlibStream::Ptr JsonRpcConnection::GetMessageStream(void) const
+{
+	return m_MessageStream;
+}
+
 ConnectionRole JsonRpcConnection::GetRole(void) const
 {
 	return m_Role;
@@ -113,7 +124,7 @@ void JsonRpcConnection::SendMessage(const Dictionary::Ptr& message)
 		ObjectLock olock(m_Stream);
 		if (m_Stream->IsEof())
 			return;
-		JsonRpc::SendMessage(m_Stream, message);
+		JsonRpc::SendMessage(m_MessageStream, message);
 	} catch (const std::exception& ex) {
 		std::ostringstream info;
 		info << "Error while sending JSON-RPC message for identity '" << m_Identity << "'";
@@ -124,6 +135,89 @@ void JsonRpcConnection::SendMessage(const Dictionary::Ptr& message)
 	}
 }
 
+/**
+ * Stores the list of optional protocol features the peer announced in its
+ * icinga::Hello message.
+ */
+void JsonRpcConnection::SetCapabilities(const Array::Ptr& capabilities)
+{
+	std::set<String> caps;
+
+	if (capabilities) {
+		ObjectLock olock(capabilities);
+		for (const Value& capability : capabilities)
+			caps.insert(capability);
+	}
+
+	{
+		boost::mutex::scoped_lock lock(m_CapabilitiesMutex);
+		m_Capabilities.swap(caps);
+	}
+
+	StartCompression();
+
+	boost::mutex::scoped_lock lock(m_CapabilitiesMutex);
+	m_CapabilitiesReceived = true;
+	m_CapabilitiesCV.notify_all();
+}
+
+/**
+ * Waits until the peer has told us which features it supports.
+ *
+ * @returns false if the peer didn't send its capabilities in time, e.g.
+ *	    because it is running an older version.
+ */
+bool JsonRpcConnection::WaitForCapabilities(double timeout)
+{
+	boost::mutex::scoped_lock lock(m_CapabilitiesMutex);
+
+	boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(static_cast<long>(timeout * 1000));
+
+	while (!m_CapabilitiesReceived) {
+		if (!m_CapabilitiesCV.timed_wait(lock, deadline))
+			break;
+	}
+
+	return m_CapabilitiesReceived;
+}
+
+/**
+ * Compresses all further messages to the peer if it supports this and
+ * a compression level is configured for its endpoint.
+ */
+void JsonRpcConnection::StartCompression(void)
+{
+	if (!m_Endpoint || !ZlibStream::IsSupported() || !HasCapability("icinga::Compression"))
+		return;
+
+	int level = m_Endpoint->GetCompressionLevel();
+
+	if (level <= 0)
+		return;
+
+	Dictionary::Ptr params = new Dictionary();
+	params->Set("algorithm", "deflate");
+
+	Dictionary::Ptr message = new Dictionary();
+	message->Set("jsonrpc", "2.0");
+	message->Set("method", "icinga::Compression");
+	message->Set("params", params);
+
+	std::ostringstream msgbuf;
+	NetString::WriteStringToStream(msgbuf, JsonEncode(message));
+
+	m_MessageStream->StartDeflate(level, msgbuf.str());
+
+	Log(LogInformation, "JsonRpcConnection")
+	    << "Compressing messages for identity '" << m_Identity << "' with level " << level << ".";
+}
+
+bool JsonRpcConnection::HasCapability(const String& capability) const
+{
+	boost::mutex::scoped_lock lock(m_CapabilitiesMutex);
+	return m_Capabilities.find(capability) != m_Capabilities.end();
+}
+
 void JsonRpcConnection::Disconnect(void)
 {
 	Log(LogWarning, "JsonRpcConnection")
@@ -220,11 +314,32 @@ bool JsonRpcConnection::ProcessMessage(void)
 {
 	String message;
 
-	StreamReadStatus srs = JsonRpc::ReadMessage(m_Stream, &message, m_Context, false);
+	StreamReadStatus srs = JsonRpc::ReadMessage(m_MessageStream, &message, m_Context, false);
 
 	if (srs != StatusNewItem)
 		return false;
 
+	/* Everything after this message is compressed, including what we've already buffered. */
+	if (message.Find("icinga::Compression") != String::NPos && !m_MessageStream->IsInflating()) {
+		Dictionary::Ptr cmessage = JsonRpc::DecodeMessage(message);
+
+		if (cmessage->Get("method") == "icinga::Compression") {
+			Dictionary::Ptr params = cmessage->Get("params");
+
+			if (!params || params->Get("algorithm") != "deflate")
+				BOOST_THROW_EXCEPTION(std::invalid_argument("Unsupported compression algorithm."));
+
+			m_MessageStream->StartInflate(m_Context.Buffer, m_Context.Size);
+			m_Context.DropData(m_Context.Size);
+			m_Context.MustRead = true;
+
+			Log(LogInformation, "JsonRpcConnection")
+			    << "Identity '" << m_Identity << "' enabled compression.";
+
+			return true;
+		}
+	}
+
 	l_JsonRpcConnectionWorkQueues[m_ID % l_JsonRpcConnectionWorkQueueCount].Enqueue(boost::bind(&JsonRpcConnection::MessageHandlerWrapper, JsonRpcConnection::Ptr(this), message));
 
 	return true;
@@ -22,6 +22,7 @@
 
 #include "remote/endpoint.hpp"
 #include "base/tlsstream.hpp"
+#include "base/zlibstream.hpp"
 #include "base/timer.hpp"
 #include "base/workqueue.hpp"
 #include "remote/i2-remote.hpp"
@@ -62,12 +63,17 @@ public:
 	bool IsAuthenticated(void) const;
 	Endpoint::Ptr GetEndpoint(void) const;
 	TlsStream::Ptr GetStream(void) const;
+	ZlibStream::Ptr GetMessageStream(void) const;
 	ConnectionRole GetRole(void) const;
 
 	void Disconnect(void);
 
 	void SendMessage(const Dictionary::Ptr& request);
 
+	void SetCapabilities(const Array::Ptr& capabilities);
+	bool HasCapability(const String& capability) const;
+	bool WaitForCapabilities(double timeout);
+
 	static void HeartbeatTimerHandler(void);
 	static Value HeartbeatAPIHandler(const intrusive_ptr<MessageOrigin>& origin, const Dictionary::Ptr& params);
 
@@ -77,16 +83,22 @@ private:
 	bool m_Authenticated;
 	Endpoint::Ptr m_Endpoint;
 	TlsStream::Ptr m_Stream;
+	ZlibStream::Ptr m_MessageStream;
 	ConnectionRole m_Role;
 	double m_Timestamp;
 	double m_Seen;
 	double m_NextHeartbeat;
 	double m_HeartbeatTimeout;
 	boost::mutex m_DataHandlerMutex;
+	mutable boost::mutex m_CapabilitiesMutex;
+	boost::condition_variable m_CapabilitiesCV;
+	bool m_CapabilitiesReceived;
+	std::set<String> m_Capabilities;
 
 	StreamReadContext m_Context;
 
 	bool ProcessMessage(void);
+	void StartCompression(void);
 	void MessageHandlerWrapper(const String& jsonString);
 	void MessageHandler(const String& jsonString);
 	void DataAvailableHandler(void);
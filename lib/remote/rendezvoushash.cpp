@@ -0,0 +1,105 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "remote/rendezvoushash.hpp"
+#include <cmath>
+
+using namespace icinga;
+
+void RendezvousHash::AddNode(const String& name, double weight)
+{
+	Node node;
+	node.Hash = HashString(name);
+	node.Weight = weight;
+	m_Nodes.push_back(node);
+}
+
+size_t RendezvousHash::GetNodeCount(void) const
+{
+	return m_Nodes.size();
+}
+
+/**
+ * Returns the index of the node the key is assigned to, or -1 if there
+ * are no nodes. Nodes with a weight of zero are only used when no node
+ * has a positive weight. Ties are resolved in favour of the node which
+ * was added first.
+ */
+int RendezvousHash::GetNode(const String& key) const
+{
+	uint64_t keyHash = HashString(key);
+
+	bool weighted = false;
+
+	for (const Node& node : m_Nodes) {
+		if (node.Weight > 0) {
+			weighted = true;
+			break;
+		}
+	}
+
+	int result = -1;
+	double bestScore = 0;
+
+	for (std::vector<Node>::size_type i = 0; i < m_Nodes.size(); i++) {
+		const Node& node = m_Nodes[i];
+
+		double weight = weighted ? node.Weight : 1;
+
+		if (weight <= 0)
+			continue;
+
+		/* Map the combined hash onto (0, 1) and apply the weight so that
+		 * each node receives a share of keys proportional to its weight. */
+		uint64_t hash = Mix(keyHash ^ node.Hash);
+		double uniform = ((hash >> 11) + 0.5) / 9007199254740992.0;
+		double score = -weight / std::log(uniform);
+
+		if (result == -1 || score > bestScore) {
+			result = i;
+			bestScore = score;
+		}
+	}
+
+	return result;
+}
+
+/* FNV-1a */
+uint64_t RendezvousHash::HashString(const String& str)
+{
+	uint64_t hash = 14695981039346656037ULL;
+
+	for (char ch : str) {
+		hash ^= static_cast<unsigned char>(ch);
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+/* splitmix64 finalizer */
+uint64_t RendezvousHash::Mix(uint64_t value)
+{
+	value ^= value >> 30;
+	value *= 0xbf58476d1ce4e5b9ULL;
+	value ^= value >> 27;
+	value *= 0x94d049bb133111ebULL;
+	value ^= value >> 31;
+	return value;
+}
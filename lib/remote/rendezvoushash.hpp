@@ -0,0 +1,61 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#ifndef RENDEZVOUSHASH_H
+#define RENDEZVOUSHASH_H
+
+#include "remote/i2-remote.hpp"
+#include "base/string.hpp"
+#include <vector>
+#include <stdint.h>
+
+namespace icinga
+{
+
+/**
+ * Weighted rendezvous (highest random weight) hashing. Every key is assigned
+ * to the node with the highest score for that key, so adding or removing a
+ * node only moves the keys which are assigned to that node.
+ *
+ * @ingroup remote
+ */
+class I2_REMOTE_API RendezvousHash
+{
+public:
+	void AddNode(const String& name, double weight = 1);
+	size_t GetNodeCount(void) const;
+
+	int GetNode(const String& key) const;
+
+private:
+	struct Node
+	{
+		uint64_t Hash;
+		double Weight;
+	};
+
+	std::vector<Node> m_Nodes;
+
+	static uint64_t HashString(const String& str);
+	static uint64_t Mix(uint64_t value);
+};
+
+}
+
+#endif /* RENDEZVOUSHASH_H */
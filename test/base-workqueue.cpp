@@ -0,0 +1,103 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "base/workqueue.hpp"
+#include "base/utility.hpp"
+#include <boost/bind.hpp>
+#include <BoostTestTargetConfig.h>
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(base_workqueue)
+
+static void AppendTask(boost::mutex& mutex, std::vector<int>& order, int id)
+{
+	boost::mutex::scoped_lock lock(mutex);
+	order.push_back(id);
+}
+
+BOOST_AUTO_TEST_CASE(priority_order)
+{
+	WorkQueue wq;
+
+	boost::mutex mutex;
+	std::vector<int> order;
+
+	/* keep the worker busy while the other tasks are enqueued */
+	wq.Enqueue(boost::bind(&Utility::Sleep, 0.2));
+
+	wq.Enqueue(boost::bind(&AppendTask, boost::ref(mutex), boost::ref(order), 1), PriorityLow);
+	wq.Enqueue(boost::bind(&AppendTask, boost::ref(mutex), boost::ref(order), 2), PriorityNormal);
+	wq.Enqueue(boost::bind(&AppendTask, boost::ref(mutex), boost::ref(order), 3), PriorityHigh);
+	wq.Enqueue(boost::bind(&AppendTask, boost::ref(mutex), boost::ref(order), 4), PriorityNormal);
+	wq.Enqueue(boost::bind(&AppendTask, boost::ref(mutex), boost::ref(order), 5), PriorityHigh);
+
+	wq.Join();
+
+	BOOST_REQUIRE(order.size() == 5);
+	BOOST_CHECK(order[0] == 3);
+	BOOST_CHECK(order[1] == 5);
+	BOOST_CHECK(order[2] == 2);
+	BOOST_CHECK(order[3] == 4);
+	BOOST_CHECK(order[4] == 1);
+}
+
+static void CountTask(boost::mutex& mutex, int& count)
+{
+	boost::mutex::scoped_lock lock(mutex);
+	count++;
+}
+
+BOOST_AUTO_TEST_CASE(many_threads)
+{
+	WorkQueue wq(100, 4);
+
+	boost::mutex mutex;
+	int count = 0;
+
+	for (int i = 0; i < 10000; i++)
+		wq.Enqueue(boost::bind(&CountTask, boost::ref(mutex), boost::ref(count)));
+
+	wq.Join();
+
+	BOOST_CHECK(count == 10000);
+	BOOST_CHECK(wq.GetLength() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(stats)
+{
+	WorkQueue wq;
+	wq.SetName("base_workqueue/stats");
+
+	Dictionary::Ptr stats = wq.GetStats();
+
+	BOOST_CHECK(stats->Get("length") == 0);
+	BOOST_CHECK(stats->Contains("task_rate"));
+	BOOST_CHECK(stats->Contains("avg_latency"));
+
+	Dictionary::Ptr status = new Dictionary();
+	WorkQueue::StatsFunc(status, new Array());
+
+	Dictionary::Ptr queues = status->Get("workqueue");
+
+	BOOST_REQUIRE(queues);
+	BOOST_CHECK(queues->Contains("base_workqueue/stats"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
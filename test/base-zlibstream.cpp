@@ -0,0 +1,101 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "base/zlibstream.hpp"
+#include "base/fifo.hpp"
+#include "base/netstring.hpp"
+#include <BoostTestTargetConfig.h>
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(base_zlibstream)
+
+BOOST_AUTO_TEST_CASE(passthrough)
+{
+	FIFO::Ptr fifo = new FIFO();
+	ZlibStream::Ptr stream = new ZlibStream(fifo);
+
+	stream->Write("hello", 5);
+	BOOST_CHECK(fifo->GetAvailableBytes() == 5);
+
+	char buffer[5];
+	BOOST_CHECK(stream->Read(buffer, sizeof(buffer), true) == 5);
+	BOOST_CHECK(memcmp(buffer, "hello", 5) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(roundtrip)
+{
+	if (!ZlibStream::IsSupported())
+		return;
+
+	FIFO::Ptr fifo = new FIFO();
+	ZlibStream::Ptr writer = new ZlibStream(fifo);
+
+	String payload;
+
+	for (int i = 0; i < 200; i++)
+		payload += "{\"method\":\"event::CheckResult\",\"params\":{\"host\":\"host1\",\"cr\":{\"state\":0}}}";
+
+	NetString::WriteStringToStream(writer, "plain");
+	writer->StartDeflate(6, "MARK");
+	NetString::WriteStringToStream(writer, payload);
+	NetString::WriteStringToStream(writer, "last");
+
+	BOOST_CHECK(writer->IsDeflating());
+	BOOST_CHECK(writer->GetBytesOut() > writer->GetCompressedBytesOut() * 10);
+
+	/* Read everything like a connection would, including the start of the compressed data. */
+	ZlibStream::Ptr reader = new ZlibStream(fifo);
+	StreamReadContext context;
+	String message;
+
+	BOOST_CHECK(NetString::ReadStringFromStream(reader, &message, context) == StatusNewItem);
+	BOOST_CHECK(message == "plain");
+	BOOST_REQUIRE(context.Size > 4);
+	BOOST_CHECK(memcmp(context.Buffer, "MARK", 4) == 0);
+
+	reader->StartInflate(context.Buffer + 4, context.Size - 4);
+	context.DropData(context.Size);
+	context.MustRead = true;
+
+	BOOST_CHECK(NetString::ReadStringFromStream(reader, &message, context) == StatusNewItem);
+	BOOST_CHECK(message == payload);
+	BOOST_CHECK(NetString::ReadStringFromStream(reader, &message, context) == StatusNewItem);
+	BOOST_CHECK(message == "last");
+
+	BOOST_CHECK(reader->IsInflating());
+	BOOST_CHECK(reader->GetBytesIn() > reader->GetCompressedBytesIn());
+}
+
+BOOST_AUTO_TEST_CASE(corrupt)
+{
+	if (!ZlibStream::IsSupported())
+		return;
+
+	FIFO::Ptr fifo = new FIFO();
+	fifo->Write("not compressed", 14);
+
+	ZlibStream::Ptr reader = new ZlibStream(fifo);
+	reader->StartInflate(NULL, 0);
+
+	char buffer[64];
+	BOOST_CHECK_THROW(reader->Read(buffer, sizeof(buffer), true), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,575 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "bench/benchmark.hpp"
+#include "icinga/host.hpp"
+#include "icinga/service.hpp"
+#include "icinga/dependency.hpp"
+#include "icinga/clusterevents.hpp"
+#include "icinga/cib.hpp"
+#include "config/configcompiler.hpp"
+#include "config/configitem.hpp"
+#include "config/activationcontext.hpp"
+#include "remote/apiuser.hpp"
+#include "remote/httphandler.hpp"
+#include "remote/jsonrpc.hpp"
+#include "remote/messageorigin.hpp"
+#include "remote/url.hpp"
+#include "base/configtype.hpp"
+#include "base/json.hpp"
+#include "base/statsfunction.hpp"
+#include "base/scriptglobal.hpp"
+#include "base/serializer.hpp"
+#include "base/scriptframe.hpp"
+#include "base/workqueue.hpp"
+#include "base/fifo.hpp"
+#include "base/utility.hpp"
+#include "base/exception.hpp"
+#ifdef I2_BENCH_WITH_LIVESTATUS
+#	include "livestatus/livestatusquery.hpp"
+#endif /* I2_BENCH_WITH_LIVESTATUS */
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
+#include <algorithm>
+#include <fstream>
+
+using namespace icinga;
+
+Benchmark::Benchmark(const ConfigGenerator& generator, int iterations, const String& workDir)
+	: m_Generator(generator), m_Iterations(iterations), m_WorkDir(workDir)
+{ }
+
+/**
+ * Compiles, evaluates, commits and activates the generated configuration.
+ */
+Dictionary::Ptr Benchmark::RunConfig(void)
+{
+	String config = m_Generator.GenerateConfig();
+
+	Dictionary::Ptr result = new Dictionary();
+	result->Set("config_bytes", config.GetLength());
+
+	ActivationScope ascope;
+
+	double start = Utility::GetTime();
+
+	Expression *expression = ConfigCompiler::CompileText("<bench>", config);
+
+	double compiled = Utility::GetTime();
+
+	{
+		ScriptFrame frame;
+		expression->Evaluate(frame);
+	}
+
+	delete expression;
+
+	double evaluated = Utility::GetTime();
+
+	WorkQueue upq(25000, Application::GetConcurrency());
+	upq.SetName("Benchmark::RunConfig");
+
+	std::vector<ConfigItem::Ptr> newItems;
+
+	if (!ConfigItem::CommitItems(ascope.GetContext(), upq, newItems))
+		BOOST_THROW_EXCEPTION(std::runtime_error("Could not commit the generated configuration."));
+
+	double committed = Utility::GetTime();
+
+	if (!ConfigItem::ActivateItems(upq, newItems))
+		BOOST_THROW_EXCEPTION(std::runtime_error("Could not activate the generated configuration."));
+
+	double activated = Utility::GetTime();
+
+	result->Set("compile_seconds", compiled - start);
+	result->Set("evaluate_seconds", evaluated - compiled);
+	result->Set("commit_seconds", committed - evaluated);
+	result->Set("activate_seconds", activated - committed);
+	result->Set("total_seconds", activated - start);
+	result->Set("objects", newItems.size());
+	result->Set("hosts", ConfigType::GetObjectsByType<Host>().size());
+	result->Set("services", ConfigType::GetObjectsByType<Service>().size());
+	result->Set("dependencies", ConfigType::GetObjectsByType<Dependency>().size());
+
+	return result;
+}
+
+/**
+ * Dumps the state of all objects into a state file and restores it.
+ */
+Dictionary::Ptr Benchmark::RunState(void)
+{
+	String path = m_WorkDir + "/icinga2-bench.state";
+
+	double start = Utility::GetTime();
+
+	ConfigObject::DumpObjects(path);
+
+	double dumped = Utility::GetTime();
+
+	ConfigObject::RestoreObjects(path);
+
+	double restored = Utility::GetTime();
+
+	std::ifstream fp(path.CStr(), std::ios::in | std::ios::binary | std::ios::ate);
+	std::streamoff size = fp.tellg();
+	fp.close();
+
+	(void) unlink(path.CStr());
+
+	Dictionary::Ptr result = new Dictionary();
+	result->Set("dump_seconds", dumped - start);
+	result->Set("restore_seconds", restored - dumped);
+	result->Set("state_bytes", static_cast<double>(size));
+
+	return result;
+}
+
+/**
+ * Feeds check results with changing states to all hosts and services
+ * using Checkable::ProcessCheckResult.
+ */
+Dictionary::Ptr Benchmark::RunCheckResults(void)
+{
+	std::vector<Checkable::Ptr> checkables;
+
+	for (const Host::Ptr& host : ConfigType::GetObjectsByType<Host>())
+		checkables.push_back(host);
+
+	for (const Service::Ptr& service : ConfigType::GetObjectsByType<Service>())
+		checkables.push_back(service);
+
+	size_t count = 0;
+	double start = Utility::GetTime();
+
+	for (int i = 0; i < m_Iterations; i++) {
+		for (size_t k = 0; k < checkables.size(); k++) {
+			CheckResult::Ptr cr = new CheckResult();
+
+			double now = Utility::GetTime();
+			cr->SetScheduleStart(now);
+			cr->SetScheduleEnd(now);
+			cr->SetExecutionStart(now);
+			cr->SetExecutionEnd(now);
+			cr->SetState(static_cast<ServiceState>((i + k) % 4));
+			cr->SetOutput("Benchmark check result " + Convert::ToString(i));
+
+			checkables[k]->ProcessCheckResult(cr);
+			count++;
+		}
+	}
+
+	double duration = Utility::GetTime() - start;
+
+	Dictionary::Ptr result = new Dictionary();
+	result->Set("check_results", count);
+	result->Set("seconds", duration);
+	result->Set("rate", duration > 0 ? count / duration : 0);
+
+	return result;
+}
+
+/**
+ * Runs a set of livestatus queries against the generated objects.
+ */
+Dictionary::Ptr Benchmark::RunLivestatus(void)
+{
+	Dictionary::Ptr result = new Dictionary();
+
+#ifdef I2_BENCH_WITH_LIVESTATUS
+	std::map<String, String> queries;
+	queries["hosts"] = "GET hosts\nColumns: name state address\nOutputFormat: json";
+	queries["services_by_host"] = "GET services\nColumns: host_name description state\nFilter: host_name = "
+	    + m_Generator.GetHostName(m_Generator.GetHostCount() / 2) + "\nOutputFormat: json";
+	queries["services_stats"] = "GET services\nStats: state = 0\nStats: state = 1\nStats: state = 2\nStats: state = 3\nOutputFormat: json";
+	queries["servicegroups"] = "GET servicegroups\nColumns: name num_services num_services_ok\nOutputFormat: json";
+
+	typedef std::pair<String, String> QueryPair;
+
+	for (const QueryPair& kv : queries) {
+		std::vector<String> lines;
+		boost::algorithm::split(lines, kv.second, boost::is_any_of("\n"));
+		lines.push_back("");
+
+		result->Set(kv.first, MeasureQuery([&lines]() {
+			LivestatusQuery::Ptr query = new LivestatusQuery(lines, "");
+			FIFO::Ptr fifo = new FIFO();
+			query->Execute(fifo);
+			return fifo->GetAvailableBytes();
+		}));
+	}
+#endif /* I2_BENCH_WITH_LIVESTATUS */
+
+	return result;
+}
+
+/**
+ * Runs the queries behind a tactical overview: the service totals used by
+ * the status checks and the per host and per group service state columns.
+ */
+Dictionary::Ptr Benchmark::RunTacticalOverview(void)
+{
+	Dictionary::Ptr result = new Dictionary();
+
+	result->Set("service_stats", MeasureQuery([]() {
+		ServiceStatistics ss = CIB::CalculateServiceStats();
+		return sizeof(ss);
+	}));
+
+#ifdef I2_BENCH_WITH_LIVESTATUS
+	std::map<String, String> queries;
+	queries["hostgroups"] = "GET hostgroups\nColumns: name num_services num_services_ok num_services_warn "
+	    "num_services_crit num_services_unknown num_services_pending num_services_hard_crit worst_service_state\nOutputFormat: json";
+	queries["servicegroups"] = "GET servicegroups\nColumns: name num_services num_services_ok num_services_warn "
+	    "num_services_crit num_services_unknown num_services_pending worst_service_state\nOutputFormat: json";
+	queries["hosts"] = "GET hosts\nColumns: name num_services num_services_ok num_services_crit "
+	    "num_services_pending worst_service_hard_state\nOutputFormat: json";
+
+	typedef std::pair<String, String> QueryPair;
+
+	for (const QueryPair& kv : queries) {
+		std::vector<String> lines;
+		boost::algorithm::split(lines, kv.second, boost::is_any_of("\n"));
+		lines.push_back("");
+
+		result->Set(kv.first, MeasureQuery([&lines]() {
+			LivestatusQuery::Ptr query = new LivestatusQuery(lines, "");
+			FIFO::Ptr fifo = new FIFO();
+			query->Execute(fifo);
+			return fifo->GetAvailableBytes();
+		}));
+	}
+#endif /* I2_BENCH_WITH_LIVESTATUS */
+
+	return result;
+}
+
+/**
+ * Runs a set of /v1/objects queries through the HTTP handlers without
+ * involving the TLS connection handling.
+ */
+Dictionary::Ptr Benchmark::RunApiQueries(void)
+{
+	ApiUser::Ptr user = new ApiUser();
+	Array::Ptr permissions = new Array();
+	permissions->Add("*");
+	user->SetPermissions(permissions);
+
+	std::map<String, String> queries;
+	queries["hosts"] = "/v1/objects/hosts";
+	queries["services_attrs"] = "/v1/objects/services?attrs=state&attrs=last_check_result";
+	queries["services_filter"] = "/v1/objects/services?filter=host.name%3D%3D%22"
+	    + m_Generator.GetHostName(m_Generator.GetHostCount() / 2) + "%22";
+	queries["host_joins"] = "/v1/objects/services?attrs=state&joins=host.name&joins=host.address";
+
+	Dictionary::Ptr result = new Dictionary();
+
+	typedef std::pair<String, String> QueryPair;
+
+	for (const QueryPair& kv : queries) {
+		String url = kv.second;
+
+		result->Set(kv.first, MeasureQuery([&user, &url]() {
+			FIFO::Ptr fifo = new FIFO();
+
+			HttpRequest request(fifo);
+			request.RequestMethod = "GET";
+			request.RequestUrl = new Url(url);
+			request.ProtocolVersion = HttpVersion11;
+
+			HttpResponse response(fifo, request);
+			HttpHandler::ProcessRequest(user, request, response);
+			response.Finish();
+
+			size_t bytes = fifo->GetAvailableBytes();
+
+			/* HttpResponse doesn't keep the status code it sent, check the status line instead */
+			char status[13] = {};
+			fifo->Peek(status, sizeof(status) - 1, true);
+
+			if (strncmp(status + 8, " 200", 4) != 0)
+				BOOST_THROW_EXCEPTION(std::runtime_error("API query '" + url + "' failed: " + String(status)));
+
+			return bytes;
+		}));
+	}
+
+	return result;
+}
+
+/**
+ * Encodes event::CheckResult messages as they are relayed to other
+ * endpoints, reads them back from the stream and decodes them again.
+ */
+Dictionary::Ptr Benchmark::RunJsonRpc(void)
+{
+	std::vector<Checkable::Ptr> checkables;
+
+	for (const Service::Ptr& service : ConfigType::GetObjectsByType<Service>())
+		checkables.push_back(service);
+
+	FIFO::Ptr fifo = new FIFO();
+	StreamReadContext src;
+
+	size_t count = 0, bytes = 0;
+	double encodeTime = 0, decodeTime = 0;
+
+	for (int i = 0; i < m_Iterations; i++) {
+		for (const Checkable::Ptr& checkable : checkables) {
+			CheckResult::Ptr cr = checkable->GetLastCheckResult();
+
+			if (!cr) {
+				cr = new CheckResult();
+				cr->SetOutput("Benchmark check result");
+			}
+
+			double start = Utility::GetTime();
+
+			Dictionary::Ptr message = ClusterEvents::MakeCheckResultMessage(checkable, cr);
+			JsonRpc::SendMessage(fifo, message);
+
+			double encoded = Utility::GetTime();
+
+			bytes += fifo->GetAvailableBytes();
+
+			String jsonString;
+			StreamReadStatus srs;
+
+			do {
+				srs = JsonRpc::ReadMessage(fifo, &jsonString, src);
+			} while (srs == StatusNeedData);
+
+			if (srs != StatusNewItem)
+				BOOST_THROW_EXCEPTION(std::runtime_error("Could not read JSON-RPC message."));
+
+			Dictionary::Ptr decoded = JsonRpc::DecodeMessage(jsonString);
+			Dictionary::Ptr params = decoded->Get("params");
+			CheckResult::Ptr newCr = new CheckResult();
+			Deserialize(newCr, params->Get("cr"), true);
+
+			double finished = Utility::GetTime();
+
+			encodeTime += encoded - start;
+			decodeTime += finished - encoded;
+			count++;
+		}
+	}
+
+	Dictionary::Ptr result = new Dictionary();
+	result->Set("messages", count);
+	result->Set("bytes", bytes);
+	result->Set("encode_seconds", encodeTime);
+	result->Set("decode_seconds", decodeTime);
+	result->Set("rate", encodeTime + decodeTime > 0 ? count / (encodeTime + decodeTime) : 0);
+
+	return result;
+}
+
+/**
+ * Writes check results with performance data through a PerfdataWriter
+ * with the text output (host_format_template/service_format_template)
+ * and with the binary spool.
+ */
+Dictionary::Ptr Benchmark::RunPerfdata(void)
+{
+	Dictionary::Ptr result = new Dictionary();
+
+#ifdef I2_BENCH_WITH_PERFDATA
+	result->Set("text", MeasurePerfdataWriter(false));
+	result->Set("spool", MeasurePerfdataWriter(true));
+#endif /* I2_BENCH_WITH_PERFDATA */
+
+	return result;
+}
+
+static Dictionary::Ptr GetCheckResultConsumerStats(const String& name)
+{
+	StatsFunction::Ptr func = StatsFunctionRegistry::GetInstance()->GetItem("CheckResultConsumer");
+
+	if (!func)
+		return Dictionary::Ptr();
+
+	Dictionary::Ptr status = new Dictionary();
+	func->Invoke(status, new Array());
+
+	Dictionary::Ptr nodes = status->Get("checkresultconsumer");
+
+	if (!nodes)
+		return Dictionary::Ptr();
+
+	return nodes->Get(name);
+}
+
+Dictionary::Ptr Benchmark::MeasurePerfdataWriter(bool binarySpool) const
+{
+	String name = binarySpool ? "icinga2-bench-spool" : "icinga2-bench-text";
+	String prefix = m_WorkDir + "/" + name;
+
+	std::vector<String> paths;
+	paths.push_back(prefix + "-host-perfdata");
+	paths.push_back(prefix + "-service-perfdata");
+	paths.push_back(prefix + "-host-tmp");
+	paths.push_back(prefix + "-service-tmp");
+
+	/* the PerfdataWriter's defaults refer to it */
+	if (!ScriptGlobal::Exists("LocalStateDir"))
+		Application::DeclareLocalStateDir(m_WorkDir);
+
+	String config = "library \"perfdata\"\n"
+	    "object PerfdataWriter " + JsonEncode(name) + " {\n"
+	    "  host_perfdata_path = " + JsonEncode(paths[0]) + "\n"
+	    "  service_perfdata_path = " + JsonEncode(paths[1]) + "\n"
+	    "  host_temp_path = " + JsonEncode(paths[2]) + "\n"
+	    "  service_temp_path = " + JsonEncode(paths[3]) + "\n"
+	    "  rotation_interval = 3600\n"
+	    "  enable_binary_spool = " + (binarySpool ? "true" : "false") + "\n"
+	    "}\n";
+
+	{
+		ActivationScope ascope;
+
+		Expression *expression = ConfigCompiler::CompileText("<bench>", config);
+
+		{
+			ScriptFrame frame;
+			expression->Evaluate(frame);
+		}
+
+		delete expression;
+
+		WorkQueue upq(25000, Application::GetConcurrency());
+		upq.SetName("Benchmark::RunPerfdata");
+
+		std::vector<ConfigItem::Ptr> newItems;
+
+		if (!ConfigItem::CommitItems(ascope.GetContext(), upq, newItems) || !ConfigItem::ActivateItems(upq, newItems))
+			BOOST_THROW_EXCEPTION(std::runtime_error("Could not activate the PerfdataWriter object."));
+	}
+
+	ConfigObject::Ptr writer = ConfigObject::GetObject("PerfdataWriter", name);
+
+	if (!writer)
+		BOOST_THROW_EXCEPTION(std::runtime_error("Could not find the PerfdataWriter object."));
+
+	String consumer = "PerfdataWriter, " + name;
+
+	Array::Ptr perfdata = new Array();
+	perfdata->Add("time=0.012345s;1;5;0");
+	perfdata->Add("size=10240B;;;0");
+	perfdata->Add("pl=0%;20;60;0;100");
+
+	std::vector<Service::Ptr> services = ConfigType::GetObjectsByType<Service>();
+
+	size_t count = 0;
+	double start = Utility::GetTime();
+
+	for (int i = 0; i < m_Iterations; i++) {
+		for (size_t k = 0; k < services.size(); k++) {
+			CheckResult::Ptr cr = new CheckResult();
+
+			double now = Utility::GetTime();
+			cr->SetScheduleStart(now);
+			cr->SetScheduleEnd(now);
+			cr->SetExecutionStart(now);
+			cr->SetExecutionEnd(now);
+			cr->SetState(static_cast<ServiceState>((i + k) % 4));
+			cr->SetOutput("Benchmark check result " + Convert::ToString(i));
+			cr->SetPerformanceData(perfdata);
+
+			Checkable::OnNewCheckResult(services[k], cr, MessageOrigin::Ptr());
+			count++;
+
+			/* The writer drops check results when it falls too far
+			 * behind, which would make it look faster than it is. */
+			if (count % 1000 == 0) {
+				for (;;) {
+					Dictionary::Ptr stats = GetCheckResultConsumerStats(consumer);
+
+					if (!stats || stats->Get("pending") < 10000)
+						break;
+
+					Utility::Sleep(0.001);
+				}
+			}
+		}
+	}
+
+	Dictionary::Ptr stats = GetCheckResultConsumerStats(consumer);
+	int dropped = 0;
+
+	if (stats)
+		dropped = stats->Get("dropped");
+
+	/* waits until all queued check results have been written */
+	writer->Deactivate(true);
+
+	double duration = Utility::GetTime() - start;
+
+	ConfigItem::Ptr item = ConfigItem::GetByTypeAndName("PerfdataWriter", name);
+
+	if (item)
+		item->Unregister();
+	else
+		writer->Unregister();
+
+	for (const String& path : paths) {
+		(void) unlink(path.CStr());
+		(void) unlink((path + ".dict").CStr());
+	}
+
+	Dictionary::Ptr result = new Dictionary();
+	result->Set("check_results", count);
+	result->Set("dropped", dropped);
+	result->Set("seconds", duration);
+	result->Set("rate", duration > 0 ? count / duration : 0);
+
+	return result;
+}
+
+Dictionary::Ptr Benchmark::MeasureQuery(const boost::function<size_t (void)>& query) const
+{
+	std::vector<double> durations;
+	size_t bytes = 0;
+
+	for (int i = 0; i < m_Iterations; i++) {
+		double start = Utility::GetTime();
+		bytes = query();
+		durations.push_back(Utility::GetTime() - start);
+	}
+
+	std::sort(durations.begin(), durations.end());
+
+	double sum = 0;
+
+	for (double duration : durations)
+		sum += duration;
+
+	Dictionary::Ptr result = new Dictionary();
+	result->Set("iterations", durations.size());
+	result->Set("response_bytes", bytes);
+
+	if (!durations.empty()) {
+		result->Set("min_seconds", durations.front());
+		result->Set("avg_seconds", sum / durations.size());
+		result->Set("median_seconds", durations[durations.size() / 2]);
+		result->Set("max_seconds", durations.back());
+	}
+
+	return result;
+}
@@ -0,0 +1,60 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "bench/configgenerator.hpp"
+#include "base/dictionary.hpp"
+#include <boost/function.hpp>
+
+namespace icinga
+{
+
+/**
+ * Benchmark drivers. Each driver returns a dictionary with its results,
+ * durations are in seconds. The config driver has to be run first because
+ * all other drivers work on the objects it creates.
+ */
+class Benchmark
+{
+public:
+	Benchmark(const ConfigGenerator& generator, int iterations, const String& workDir);
+
+	Dictionary::Ptr RunConfig(void);
+	Dictionary::Ptr RunState(void);
+	Dictionary::Ptr RunCheckResults(void);
+	Dictionary::Ptr RunLivestatus(void);
+	Dictionary::Ptr RunTacticalOverview(void);
+	Dictionary::Ptr RunApiQueries(void);
+	Dictionary::Ptr RunJsonRpc(void);
+	Dictionary::Ptr RunPerfdata(void);
+
+private:
+	const ConfigGenerator& m_Generator;
+	int m_Iterations;
+	String m_WorkDir;
+
+	Dictionary::Ptr MeasureQuery(const boost::function<size_t (void)>& query) const;
+	Dictionary::Ptr MeasurePerfdataWriter(bool binarySpool) const;
+};
+
+}
+
+#endif /* BENCHMARK_H */
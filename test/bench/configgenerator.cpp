@@ -0,0 +1,141 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "bench/configgenerator.hpp"
+#include "base/convert.hpp"
+#include <sstream>
+
+using namespace icinga;
+
+ConfigGenerator::ConfigGenerator(int hosts, int servicesPerHost, int groups, bool dependencies)
+	: m_Hosts(hosts), m_ServicesPerHost(servicesPerHost), m_Groups(groups), m_Dependencies(dependencies)
+{ }
+
+int ConfigGenerator::GetHostCount(void) const
+{
+	return m_Hosts;
+}
+
+int ConfigGenerator::GetServicesPerHost(void) const
+{
+	return m_ServicesPerHost;
+}
+
+int ConfigGenerator::GetGroupCount(void) const
+{
+	return m_Groups;
+}
+
+bool ConfigGenerator::GetDependencies(void) const
+{
+	return m_Dependencies;
+}
+
+String ConfigGenerator::GetHostName(int index) const
+{
+	return "bench-host-" + Convert::ToString(index);
+}
+
+String ConfigGenerator::GetServiceName(int index) const
+{
+	return "bench-service-" + Convert::ToString(index);
+}
+
+String ConfigGenerator::GenerateConfig(void) const
+{
+	std::ostringstream msgbuf;
+
+	msgbuf << "/* Synthetic benchmark configuration: " << m_Hosts << " hosts, "
+	    << m_ServicesPerHost << " services per host, " << m_Groups << " groups */\n\n"
+	    << "object CheckCommand \"bench-dummy\" {\n"
+	    << "  command = [ \"/bin/true\" ]\n"
+	    << "}\n\n"
+	    << "template Host \"bench-host\" {\n"
+	    << "  check_command = \"bench-dummy\"\n"
+	    << "  check_interval = 5m\n"
+	    << "  retry_interval = 1m\n"
+	    << "  max_check_attempts = 3\n"
+	    << "}\n\n"
+	    << "template Service \"bench-service\" {\n"
+	    << "  check_command = \"bench-dummy\"\n"
+	    << "  check_interval = 5m\n"
+	    << "  retry_interval = 1m\n"
+	    << "  max_check_attempts = 3\n"
+	    << "}\n\n";
+
+	for (int i = 0; i < m_Groups; i++) {
+		msgbuf << "object HostGroup \"bench-hostgroup-" << i << "\" {\n"
+		    << "  assign where host.vars.group == " << i << "\n"
+		    << "}\n\n"
+		    << "object ServiceGroup \"bench-servicegroup-" << i << "\" {\n"
+		    << "  assign where service.vars.group == " << i << "\n"
+		    << "}\n\n";
+	}
+
+	for (int i = 0; i < m_Hosts; i++) {
+		msgbuf << "object Host \"" << GetHostName(i) << "\" {\n"
+		    << "  import \"bench-host\"\n"
+		    << "  address = \"127.0." << (i / 256) % 256 << "." << i % 256 << "\"\n"
+		    << "  vars.index = " << i << "\n";
+
+		if (m_Groups > 0)
+			msgbuf << "  vars.group = " << i % m_Groups << "\n";
+
+		msgbuf << "  vars.os = \"" << (i % 2 == 0 ? "Linux" : "Windows") << "\"\n"
+		    << "}\n\n";
+	}
+
+	for (int i = 0; i < m_ServicesPerHost; i++) {
+		msgbuf << "apply Service \"" << GetServiceName(i) << "\" {\n"
+		    << "  import \"bench-service\"\n"
+		    << "  vars.index = " << i << "\n";
+
+		if (m_Groups > 0)
+			msgbuf << "  vars.group = " << i % m_Groups << "\n";
+
+		msgbuf << "  assign where host.vars.index >= 0\n"
+		    << "}\n\n";
+	}
+
+	if (m_Dependencies && m_Hosts > 1) {
+		msgbuf << "apply Dependency \"bench-uplink\" to Host {\n"
+		    << "  parent_host_name = \"" << GetHostName(0) << "\"\n"
+		    << "  assign where host.name != \"" << GetHostName(0) << "\"\n"
+		    << "}\n\n";
+	}
+
+	if (m_Dependencies && m_ServicesPerHost > 1) {
+		msgbuf << "apply Dependency \"bench-service\" to Service {\n"
+		    << "  parent_service_name = \"" << GetServiceName(0) << "\"\n"
+		    << "  assign where service.name != \"" << GetServiceName(0) << "\"\n"
+		    << "}\n\n";
+	}
+
+	return msgbuf.str();
+}
+
+Dictionary::Ptr ConfigGenerator::GetParameters(void) const
+{
+	Dictionary::Ptr params = new Dictionary();
+	params->Set("hosts", m_Hosts);
+	params->Set("services_per_host", m_ServicesPerHost);
+	params->Set("groups", m_Groups);
+	params->Set("dependencies", m_Dependencies);
+	return params;
+}
@@ -0,0 +1,64 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#ifndef CONFIGGENERATOR_H
+#define CONFIGGENERATOR_H
+
+#include "base/dictionary.hpp"
+#include "base/string.hpp"
+
+namespace icinga
+{
+
+/**
+ * Generates a synthetic configuration for the benchmarks.
+ *
+ * The configuration consists of a check command, host and service
+ * templates, the given number of hosts (one object definition each) and
+ * one apply rule per service name. Host and service groups are assigned
+ * using group rules, and dependencies are created using apply rules which
+ * make every host depend on the first one and every service depend on the
+ * host's first service.
+ */
+class ConfigGenerator
+{
+public:
+	ConfigGenerator(int hosts, int servicesPerHost, int groups, bool dependencies);
+
+	int GetHostCount(void) const;
+	int GetServicesPerHost(void) const;
+	int GetGroupCount(void) const;
+	bool GetDependencies(void) const;
+
+	String GetHostName(int index) const;
+	String GetServiceName(int index) const;
+
+	String GenerateConfig(void) const;
+	Dictionary::Ptr GetParameters(void) const;
+
+private:
+	int m_Hosts;
+	int m_ServicesPerHost;
+	int m_Groups;
+	bool m_Dependencies;
+};
+
+}
+
+#endif /* CONFIGGENERATOR_H */
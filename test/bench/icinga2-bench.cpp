@@ -0,0 +1,177 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "bench/benchmark.hpp"
+#include "icinga/icingaapplication.hpp"
+#include "base/application.hpp"
+#include "base/logger.hpp"
+#include "base/json.hpp"
+#include "base/exception.hpp"
+#include <boost/program_options.hpp>
+#include <fstream>
+#include <iostream>
+
+using namespace icinga;
+namespace po = boost::program_options;
+
+static Dictionary::Ptr RunBenchmark(Benchmark& benchmark, const String& name)
+{
+	if (name == "config")
+		return benchmark.RunConfig();
+	else if (name == "state")
+		return benchmark.RunState();
+	else if (name == "checkresults")
+		return benchmark.RunCheckResults();
+	else if (name == "livestatus")
+		return benchmark.RunLivestatus();
+	else if (name == "tactical")
+		return benchmark.RunTacticalOverview();
+	else if (name == "api")
+		return benchmark.RunApiQueries();
+	else if (name == "jsonrpc")
+		return benchmark.RunJsonRpc();
+	else if (name == "perfdata")
+		return benchmark.RunPerfdata();
+
+	BOOST_THROW_EXCEPTION(std::invalid_argument("Unknown benchmark '" + name + "'."));
+}
+
+static int RunBenchmarks(const po::variables_map& vm)
+{
+	ConfigGenerator generator(vm["hosts"].as<int>(), vm["services"].as<int>(),
+	    vm["groups"].as<int>(), !vm.count("no-dependencies"));
+
+	if (vm.count("generate-config")) {
+		String path = vm["generate-config"].as<std::string>();
+		std::ofstream fp(path.CStr(), std::ios::out | std::ios::trunc);
+		fp << generator.GenerateConfig();
+		fp.close();
+
+		if (fp.fail()) {
+			std::cerr << "Could not write configuration file '" << path << "'.\n";
+			return EXIT_FAILURE;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	std::vector<std::string> names;
+
+	if (vm.count("benchmark"))
+		names = vm["benchmark"].as<std::vector<std::string> >();
+	else
+		names = { "state", "checkresults", "livestatus", "tactical", "api", "jsonrpc", "perfdata" };
+
+	Benchmark benchmark(generator, vm["iterations"].as<int>(), vm["work-dir"].as<std::string>());
+
+	Dictionary::Ptr params = generator.GetParameters();
+	params->Set("iterations", vm["iterations"].as<int>());
+	params->Set("concurrency", Application::GetConcurrency());
+
+	Dictionary::Ptr results = new Dictionary();
+
+	/* all other benchmarks depend on the objects created by this one */
+	results->Set("config", benchmark.RunConfig());
+
+	for (const String& name : names) {
+		if (name == "config")
+			continue;
+
+		results->Set(name, RunBenchmark(benchmark, name));
+	}
+
+	Dictionary::Ptr output = new Dictionary();
+	output->Set("version", Application::GetAppVersion());
+	output->Set("timestamp", Utility::GetTime());
+	output->Set("parameters", params);
+	output->Set("results", results);
+
+	String json = JsonEncode(output);
+
+	if (vm.count("output")) {
+		String path = vm["output"].as<std::string>();
+		std::ofstream fp(path.CStr(), std::ios::out | std::ios::trunc);
+		fp << json << "\n";
+		fp.close();
+
+		if (fp.fail()) {
+			std::cerr << "Could not write results to '" << path << "'.\n";
+			return EXIT_FAILURE;
+		}
+	} else
+		std::cout << json << "\n";
+
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+	po::options_description desc("Options");
+	desc.add_options()
+		("help,h", "show this help message")
+		("hosts", po::value<int>()->default_value(1000), "number of hosts")
+		("services", po::value<int>()->default_value(10), "number of services per host")
+		("groups", po::value<int>()->default_value(10), "number of host and service groups")
+		("no-dependencies", "don't generate dependencies")
+		("iterations", po::value<int>()->default_value(10), "number of iterations for each query and check result round")
+		("benchmark,b", po::value<std::vector<std::string> >(), "benchmark to run (state, checkresults, livestatus, tactical, api, jsonrpc, perfdata); may be specified multiple times, defaults to all")
+		("work-dir", po::value<std::string>()->default_value("."), "directory for temporary files")
+		("output,o", po::value<std::string>(), "write the JSON results to this file instead of stdout")
+		("generate-config", po::value<std::string>(), "write the generated configuration to this file and exit")
+		("log-level,x", po::value<std::string>()->default_value("warning"), "console log level");
+
+	po::variables_map vm;
+
+	try {
+		po::store(po::parse_command_line(argc, argv, desc), vm);
+		po::notify(vm);
+	} catch (const std::exception& ex) {
+		std::cerr << "Error while parsing command-line options: " << ex.what() << "\n";
+		return EXIT_FAILURE;
+	}
+
+	if (vm.count("help")) {
+		std::cout << "Usage: " << argv[0] << " [options]\n\n"
+		    << "Runs the Icinga 2 benchmarks against a generated configuration and\n"
+		    << "prints the results as JSON.\n\n"
+		    << desc;
+		return EXIT_SUCCESS;
+	}
+
+	Application::InitializeBase();
+
+	Logger::SetConsoleLogSeverity(Logger::StringToSeverity(vm["log-level"].as<std::string>()));
+
+	IcingaApplication::Ptr appInst = new IcingaApplication();
+	static_pointer_cast<ConfigObject>(appInst)->OnConfigLoaded();
+
+	int rc;
+
+	try {
+		rc = RunBenchmarks(vm);
+	} catch (const std::exception& ex) {
+		Log(LogCritical, "icinga2-bench")
+		    << "Benchmark failed: " << DiagnosticInformation(ex);
+		rc = EXIT_FAILURE;
+	}
+
+	appInst.reset();
+
+	Application::Exit(rc);
+}
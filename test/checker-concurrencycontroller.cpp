@@ -0,0 +1,142 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "checker/concurrencycontroller.hpp"
+#include <BoostTestTargetConfig.h>
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(checker_concurrencycontroller)
+
+BOOST_AUTO_TEST_CASE(bounds)
+{
+	ConcurrencyController controller;
+	controller.SetBounds(10, 20);
+
+	controller.SetLimit(100);
+	BOOST_CHECK(controller.GetLimit() == 20);
+
+	controller.SetLimit(1);
+	BOOST_CHECK(controller.GetLimit() == 10);
+
+	controller.SetLimit(15);
+	BOOST_CHECK(controller.GetLimit() == 15);
+
+	controller.SetBounds(0, 5);
+	BOOST_CHECK(controller.GetLimit() == 5);
+}
+
+BOOST_AUTO_TEST_CASE(increase)
+{
+	ConcurrencyController controller;
+	controller.SetBounds(1, 20);
+	controller.SetLimit(16);
+
+	/* the limit only grows while checks have to wait for a slot */
+	controller.Update(0, -1);
+	BOOST_CHECK(controller.GetLimit() == 16);
+
+	controller.NotifySaturated();
+	controller.Update(0, -1);
+	BOOST_CHECK(controller.GetLimit() == 20);
+	BOOST_CHECK(controller.GetStats()->Get("decision") == "increase");
+
+	controller.NotifySaturated();
+	controller.Update(0, -1);
+	BOOST_CHECK(controller.GetLimit() == 20);
+}
+
+BOOST_AUTO_TEST_CASE(decrease_load)
+{
+	ConcurrencyController controller;
+	controller.SetBounds(10, 100);
+	controller.SetLimit(20);
+
+	controller.Update(0, 3);
+	BOOST_CHECK(controller.GetLimit() == 16);
+	BOOST_CHECK(controller.GetStats()->Get("decision") == "decrease (load)");
+
+	/* the limit is held while the decrease takes effect */
+	for (int i = 0; i < 3; i++) {
+		controller.NotifySaturated();
+		controller.Update(0, -1);
+		BOOST_CHECK(controller.GetLimit() == 16);
+	}
+
+	controller.Update(0, 3);
+	BOOST_CHECK(controller.GetLimit() == 12);
+
+	for (int i = 0; i < 3; i++)
+		controller.Update(0, -1);
+
+	/* never below the lower bound */
+	controller.Update(0, 3);
+	BOOST_CHECK(controller.GetLimit() == 10);
+}
+
+BOOST_AUTO_TEST_CASE(decrease_spawn_backlog)
+{
+	ConcurrencyController controller;
+	controller.SetBounds(1, 100);
+	controller.SetLimit(50);
+
+	controller.Update(16, -1);
+	BOOST_CHECK(controller.GetLimit() == 50);
+
+	controller.Update(17, -1);
+	BOOST_CHECK(controller.GetLimit() == 40);
+	BOOST_CHECK(controller.GetStats()->Get("decision") == "decrease (spawn_backlog)");
+}
+
+BOOST_AUTO_TEST_CASE(latency_per_command)
+{
+	ConcurrencyController controller;
+	controller.SetBounds(1, 100);
+	controller.SetLimit(50);
+
+	controller.AddLatencySample("ping", 0.1);
+	controller.AddLatencySample("disk", 0.2);
+	controller.AddLatencySample("http", 1);
+	controller.Update(0, -1);
+	BOOST_CHECK(controller.GetLimit() == 50);
+
+	/* a slow command which wasn't executed before has its own baseline */
+	controller.AddLatencySample("ping", 0.1);
+	controller.AddLatencySample("disk", 0.2);
+	controller.AddLatencySample("http", 1);
+	controller.AddLatencySample("sql", 30);
+	controller.Update(0, -1);
+	BOOST_CHECK(controller.GetLimit() == 50);
+
+	/* a single command slowing down doesn't affect the median */
+	controller.AddLatencySample("ping", 0.1);
+	controller.AddLatencySample("disk", 0.2);
+	controller.AddLatencySample("http", 10);
+	controller.Update(0, -1);
+	BOOST_CHECK(controller.GetLimit() == 50);
+
+	controller.AddLatencySample("ping", 1);
+	controller.AddLatencySample("disk", 2);
+	controller.AddLatencySample("http", 10);
+	controller.Update(0, -1);
+	BOOST_CHECK(controller.GetLimit() == 40);
+	BOOST_CHECK(controller.GetStats()->Get("decision") == "decrease (latency)");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
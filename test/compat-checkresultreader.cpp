@@ -0,0 +1,159 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "config/configcompiler.hpp"
+#include "config/configitem.hpp"
+#include "icinga/service.hpp"
+#include "base/application.hpp"
+#include "base/scriptglobal.hpp"
+#include "base/utility.hpp"
+#include "base/convert.hpp"
+#include <boost/thread/mutex.hpp>
+#include <fstream>
+#include <stdlib.h>
+#include <unistd.h>
+#include <utime.h>
+#include <BoostTestTargetConfig.h>
+
+using namespace icinga;
+
+static boost::mutex l_StatesMutex;
+static std::vector<ServiceState> l_States;
+static String l_SpoolDir;
+
+static void CheckResultHandler(const Checkable::Ptr& checkable, const CheckResult::Ptr& cr)
+{
+	Host::Ptr host;
+	Service::Ptr service;
+	tie(host, service) = GetHostService(checkable);
+
+	if (!service || service->GetShortName() != "passive")
+		return;
+
+	boost::mutex::scoped_lock lock(l_StatesMutex);
+	l_States.push_back(cr->GetState());
+}
+
+static void WriteCheckResultFile(const String& spoolDir, const String& name, int returnCode, time_t mtime)
+{
+	String path = spoolDir + "/" + name;
+
+	std::ofstream fp(path.CStr());
+	fp << "### Check result file ###\n"
+	    << "host_name=test-crr\n"
+	    << "service_description=passive\n"
+	    << "start_time=" << mtime << "\n"
+	    << "finish_time=" << mtime << "\n"
+	    << "return_code=" << returnCode << "\n"
+	    << "output=state " << returnCode << "\n";
+	fp.close();
+
+	std::ofstream okfp((path + ".ok").CStr());
+	okfp.close();
+
+	struct utimbuf times;
+	times.actime = mtime;
+	times.modtime = mtime;
+	utime(path.CStr(), &times);
+	utime((path + ".ok").CStr(), &times);
+}
+
+static void CreateTestObjects(void)
+{
+	String config = R"CONFIG(
+library "compat"
+
+object CheckCommand "dummy" {
+  command = "/bin/echo"
+}
+
+object Host "test-crr" {
+  check_command = "dummy"
+}
+
+object Service "passive" {
+  host_name = "test-crr"
+  check_command = "dummy"
+}
+)CONFIG";
+
+	config += "object CheckResultReader \"test-crr\" {\n  spool_dir = \"" + l_SpoolDir + "\"\n}\n";
+
+	Expression *expr = ConfigCompiler::CompileText("<checkresultreader>", config);
+	expr->Evaluate(*ScriptFrame::GetCurrentFrame());
+}
+
+BOOST_AUTO_TEST_SUITE(compat_checkresultreader)
+
+BOOST_AUTO_TEST_CASE(mtime_order)
+{
+	char spoolTemplate[] = "/tmp/icinga2-crr-XXXXXX";
+	BOOST_REQUIRE(mkdtemp(spoolTemplate));
+	String spoolDir = spoolTemplate;
+	l_SpoolDir = spoolDir;
+
+	/* Used for the default value of the spool_dir attribute. */
+	if (!ScriptGlobal::Exists("LocalStateDir"))
+		Application::DeclareLocalStateDir(spoolDir);
+
+	/* The file names are in reverse order of the mtimes, the results must
+	 * be processed by mtime: CRITICAL, WARNING, OK. */
+	time_t now = time(NULL);
+	WriteCheckResultFile(spoolDir, "c000003", 2, now - 30);
+	WriteCheckResultFile(spoolDir, "c000002", 1, now - 20);
+	WriteCheckResultFile(spoolDir, "c000001", 0, now - 10);
+
+	boost::signals2::connection conn = Checkable::OnNewCheckResult.connect(boost::bind(&CheckResultHandler, _1, _2));
+
+	ConfigItem::RunWithActivationContext(new Function("CreateTestObjects", WrapFunction(CreateTestObjects)));
+
+	/* The spool directory is first scanned after 5 seconds. */
+	for (int i = 0; i < 150; i++) {
+		{
+			boost::mutex::scoped_lock lock(l_StatesMutex);
+
+			if (l_States.size() >= 3)
+				break;
+		}
+
+		Utility::Sleep(0.1);
+	}
+
+	ConfigObject::Ptr reader = ConfigObject::GetObject("CheckResultReader", "test-crr");
+	BOOST_REQUIRE(reader);
+	reader->Deactivate();
+
+	conn.disconnect();
+
+	{
+		boost::mutex::scoped_lock lock(l_StatesMutex);
+
+		BOOST_REQUIRE_EQUAL(l_States.size(), 3);
+		BOOST_CHECK_EQUAL(l_States[0], ServiceCritical);
+		BOOST_CHECK_EQUAL(l_States[1], ServiceWarning);
+		BOOST_CHECK_EQUAL(l_States[2], ServiceOK);
+	}
+
+	BOOST_CHECK(!Utility::PathExists(spoolDir + "/c000001.ok"));
+	BOOST_CHECK(!Utility::PathExists(spoolDir + "/c000003"));
+
+	(void) rmdir(spoolDir.CStr());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
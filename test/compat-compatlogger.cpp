@@ -0,0 +1,205 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "config/configcompiler.hpp"
+#include "config/configitem.hpp"
+#include "icinga/externalcommandprocessor.hpp"
+#include "base/application.hpp"
+#include "base/scriptglobal.hpp"
+#include "base/utility.hpp"
+#include "base/convert.hpp"
+#include <boost/thread/thread.hpp>
+#include <fstream>
+#include <stdlib.h>
+#include <unistd.h>
+#include <BoostTestTargetConfig.h>
+
+using namespace icinga;
+
+static String l_LogDir;
+static String l_FsyncPolicy;
+
+static void CreateTestLogger(void)
+{
+	String config = "library \"compat\"\n"
+	    "object CompatLogger \"test-compatlogger\" {\n"
+	    "  log_dir = \"" + l_LogDir + "\"\n"
+	    "  rotation_method = \"DAILY\"\n"
+	    "  fsync_policy = \"" + l_FsyncPolicy + "\"\n"
+	    "}\n";
+
+	Expression *expr = ConfigCompiler::CompileText("<compatlogger>", config);
+	expr->Evaluate(*ScriptFrame::GetCurrentFrame());
+	delete expr;
+}
+
+static ConfigObject::Ptr StartTestLogger(const String& fsyncPolicy)
+{
+	char logTemplate[] = "/tmp/icinga2-compatlogger-XXXXXX";
+
+	if (!mkdtemp(logTemplate))
+		return ConfigObject::Ptr();
+
+	l_LogDir = logTemplate;
+	l_FsyncPolicy = fsyncPolicy;
+
+	/* Used for the default value of the log_dir attribute. */
+	if (!ScriptGlobal::Exists("LocalStateDir"))
+		Application::DeclareLocalStateDir(l_LogDir);
+
+	if (!ConfigItem::RunWithActivationContext(new Function("CreateTestLogger", WrapFunction(CreateTestLogger))))
+		return ConfigObject::Ptr();
+
+	return ConfigObject::GetObject("CompatLogger", "test-compatlogger");
+}
+
+static void StopTestLogger(const ConfigObject::Ptr& logger)
+{
+	logger->Deactivate(true);
+
+	ConfigItem::Ptr item = ConfigItem::GetByTypeAndName("CompatLogger", logger->GetName());
+
+	if (item)
+		item->Unregister();
+	else
+		logger->Unregister();
+}
+
+static void RemoveLogDir(void)
+{
+	(void) unlink((l_LogDir + "/icinga.log").CStr());
+	(void) rmdir(l_LogDir.CStr());
+}
+
+static void SendCommands(const String& sender, int count)
+{
+	for (int i = 0; i < count; i++) {
+		std::vector<String> arguments;
+		arguments.push_back(sender);
+		arguments.push_back(Convert::ToString(i));
+
+		ExternalCommandProcessor::OnNewExternalCommand(Utility::GetTime(), "TEST_COMMAND", arguments);
+	}
+}
+
+/* returns the log lines without their timestamps */
+static std::vector<String> ReadLog(void)
+{
+	std::vector<String> lines;
+	std::ifstream fp((l_LogDir + "/icinga.log").CStr());
+	std::string line;
+
+	while (std::getline(fp, line)) {
+		String text = line;
+		size_t pos = text.Find("] ");
+
+		if (text[0] != '[' || pos == String::NPos)
+			text = "invalid: " + text;
+		else
+			text = text.SubStr(pos + 2);
+
+		lines.push_back(text);
+	}
+
+	return lines;
+}
+
+BOOST_AUTO_TEST_SUITE(compat_compatlogger)
+
+BOOST_AUTO_TEST_CASE(queued_lines)
+{
+	ConfigObject::Ptr logger = StartTestLogger("NONE");
+	BOOST_REQUIRE(logger);
+
+	SendCommands("queued", 1000);
+
+	/* Stop() must write everything that has been queued so far. */
+	StopTestLogger(logger);
+
+	std::vector<String> lines = ReadLog();
+	BOOST_REQUIRE(lines.size() >= 1002);
+
+	/* The header of the new file is written before the first line. */
+	BOOST_CHECK(lines[0] == "LOG ROTATION: DAILY");
+	BOOST_CHECK(lines[1] == "LOG VERSION: 2.0");
+
+	std::vector<String> commands;
+
+	for (const String& line : lines) {
+		BOOST_CHECK(line.Find("invalid: ") != 0);
+
+		if (line.Find("EXTERNAL COMMAND: ") == 0)
+			commands.push_back(line);
+	}
+
+	BOOST_REQUIRE_EQUAL(commands.size(), 1000);
+
+	for (int i = 0; i < 1000; i++)
+		BOOST_CHECK(commands[i] == "EXTERNAL COMMAND: TEST_COMMAND;queued;" + Convert::ToString(i));
+
+	RemoveLogDir();
+}
+
+BOOST_AUTO_TEST_CASE(flush_on_stop)
+{
+	ConfigObject::Ptr logger = StartTestLogger("BATCH");
+	BOOST_REQUIRE(logger);
+
+	/* The writer thread may still be busy with these when we stop the logger. */
+	boost::thread_group senders;
+
+	for (int i = 0; i < 4; i++)
+		senders.create_thread(boost::bind(&SendCommands, "sender" + Convert::ToString(i), 2500));
+
+	senders.join_all();
+
+	StopTestLogger(logger);
+
+	std::vector<String> lines = ReadLog();
+
+	/* Lines of each sender are written in the order they were queued. */
+	int next[4] = { 0, 0, 0, 0 };
+	int total = 0;
+
+	for (const String& line : lines) {
+		if (line.Find("EXTERNAL COMMAND: ") != 0)
+			continue;
+
+		total++;
+
+		String prefix = "EXTERNAL COMMAND: TEST_COMMAND;sender";
+		BOOST_REQUIRE(line.Find(prefix) == 0);
+
+		int sender = Convert::ToLong(line.SubStr(prefix.GetLength(), 1));
+		BOOST_REQUIRE(sender >= 0 && sender < 4);
+
+		BOOST_CHECK(line.SubStr(prefix.GetLength() + 2) == Convert::ToString(next[sender]));
+		next[sender]++;
+	}
+
+	BOOST_CHECK_EQUAL(total, 4 * 2500);
+
+	/* Nothing is written once the logger has been stopped. */
+	SendCommands("stopped", 10);
+	BOOST_CHECK_EQUAL(ReadLog().size(), lines.size());
+
+	RemoveLogDir();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,193 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "config/configcompiler.hpp"
+#include "base/streamlogger.hpp"
+#include "base/scriptglobal.hpp"
+#include "base/objectlock.hpp"
+#include "base/convert.hpp"
+#include "base/exception.hpp"
+#include <BoostTestTargetConfig.h>
+#include <fstream>
+#include <sstream>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace icinga;
+
+static String FragmentPath(const String& dir, int i)
+{
+	return dir + "/" + (i < 10 ? "0" : "") + Convert::ToString(i) + ".conf";
+}
+
+static void WriteFragments(const String& dir, int fragments, int syntaxError)
+{
+	for (int i = 0; i < fragments; i++) {
+		std::ofstream fp(FragmentPath(dir, i).CStr());
+
+		if (i == syntaxError)
+			fp << "ConfigIncludesOrder.add(" << i << "\n";
+		else
+			fp << "ConfigIncludesOrder.add(" << i << ")\n";
+	}
+}
+
+static void RemoveFragments(const String& dir, int fragments)
+{
+	for (int i = 0; i < fragments; i++)
+		(void) unlink(FragmentPath(dir, i).CStr());
+
+	(void) rmdir(dir.CStr());
+}
+
+static std::vector<int> GetOrder(const Array::Ptr& order)
+{
+	std::vector<int> result;
+
+	ObjectLock olock(order);
+
+	for (const Value& value : order)
+		result.push_back(value);
+
+	return result;
+}
+
+BOOST_AUTO_TEST_SUITE(config_includes)
+
+BOOST_AUTO_TEST_CASE(order)
+{
+	char dirTemplate[] = "/tmp/icinga2-config-includes-XXXXXX";
+	BOOST_REQUIRE(mkdtemp(dirTemplate));
+	String dir = dirTemplate;
+
+	/* Enough fragments for them to be compiled in parallel. */
+	const int fragments = 20;
+	const int syntaxError = 7;
+
+	WriteFragments(dir, fragments, syntaxError);
+
+	/* Files which can't be opened are skipped with a warning. */
+	std::vector<std::pair<String, String> > files;
+
+	for (int i = 0; i < fragments; i++) {
+		if (i == 3)
+			files.push_back(std::make_pair(dir + "/missing-1.conf", String()));
+
+		files.push_back(std::make_pair(FragmentPath(dir, i), String()));
+
+		if (i == 15)
+			files.push_back(std::make_pair(dir + "/missing-2.conf", String()));
+	}
+
+	std::ostringstream logbuf;
+	StreamLogger::Ptr logger = new StreamLogger();
+	logger->SetName("config-includes");
+	logger->SetSeverity("warning");
+	logger->BindStream(&logbuf, false);
+	logger->Activate();
+
+	std::vector<Expression *> expressions;
+	ConfigCompiler::CompileFiles(expressions, files, String());
+
+	logger->Deactivate();
+
+	/* The warnings are logged in the order of the files. */
+	String log = logbuf.str();
+	size_t first = log.Find("Cannot compile file '" + dir + "/missing-1.conf'");
+	size_t second = log.Find("Cannot compile file '" + dir + "/missing-2.conf'");
+
+	BOOST_CHECK(first != String::NPos);
+	BOOST_CHECK(second != String::NPos);
+	BOOST_CHECK(first < second);
+
+	BOOST_REQUIRE_EQUAL(expressions.size(), fragments);
+
+	/* The expressions are in the order of the files, the syntax error
+	 * is reported when its fragment is evaluated. */
+	Array::Ptr order = new Array();
+	ScriptGlobal::Set("ConfigIncludesOrder", order);
+
+	ScriptFrame frame;
+
+	for (int i = 0; i < fragments; i++) {
+		if (i == syntaxError) {
+			try {
+				expressions[i]->Evaluate(frame);
+				BOOST_ERROR("Syntax error was not reported");
+			} catch (const ScriptError& ex) {
+				BOOST_CHECK(ex.GetDebugInfo().Path == FragmentPath(dir, i));
+			}
+		} else
+			expressions[i]->Evaluate(frame);
+
+		delete expressions[i];
+	}
+
+	std::vector<int> expected;
+
+	for (int i = 0; i < fragments; i++) {
+		if (i != syntaxError)
+			expected.push_back(i);
+	}
+
+	std::vector<int> actual = GetOrder(order);
+	BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+
+	RemoveFragments(dir, fragments);
+}
+
+BOOST_AUTO_TEST_CASE(include_glob)
+{
+	char dirTemplate[] = "/tmp/icinga2-config-includes-XXXXXX";
+	BOOST_REQUIRE(mkdtemp(dirTemplate));
+	String dir = dirTemplate;
+
+	const int fragments = 20;
+	const int syntaxError = 12;
+
+	WriteFragments(dir, fragments, syntaxError);
+
+	Array::Ptr order = new Array();
+	ScriptGlobal::Set("ConfigIncludesOrder", order);
+
+	ScriptFrame frame;
+	Expression *expr = ConfigCompiler::CompileText("<test>", "include \"" + dir + "/*.conf\"");
+
+	/* The fragments are evaluated in glob order up to the syntax error. */
+	try {
+		expr->Evaluate(frame);
+		BOOST_ERROR("Syntax error was not reported");
+	} catch (const ScriptError& ex) {
+		BOOST_CHECK(ex.GetDebugInfo().Path == FragmentPath(dir, syntaxError));
+	}
+
+	delete expr;
+
+	std::vector<int> expected;
+
+	for (int i = 0; i < syntaxError; i++)
+		expected.push_back(i);
+
+	std::vector<int> actual = GetOrder(order);
+	BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+
+	RemoveFragments(dir, fragments);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,100 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "config/configcompilercontext.hpp"
+#include "config/objectsfileindex.hpp"
+#include "base/json.hpp"
+#include "base/convert.hpp"
+#include "base/utility.hpp"
+#include <fstream>
+#include <BoostTestTargetConfig.h>
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(config_objectsfileindex)
+
+static void WriteTestObject(const String& type, const String& name, const String& internalName)
+{
+	Dictionary::Ptr properties = new Dictionary();
+	properties->Set("__name", internalName);
+	properties->Set("name", name);
+
+	Dictionary::Ptr object = new Dictionary();
+	object->Set("type", type);
+	object->Set("name", internalName);
+	object->Set("properties", properties);
+
+	ConfigCompilerContext::GetInstance()->WriteObject(object);
+}
+
+BOOST_AUTO_TEST_CASE(lookup)
+{
+	String objectsPath = "objectsfileindex-test-" + Convert::ToString(Utility::GetPid());
+
+	ConfigCompilerContext::GetInstance()->OpenObjectsFile(objectsPath);
+	WriteTestObject("Service", "ping", "h1!ping");
+	WriteTestObject("Host", "h2", "h2");
+	WriteTestObject("Host", "h1", "h1");
+	WriteTestObject("Zone", "master", "master");
+	ConfigCompilerContext::GetInstance()->FinishObjectsFile();
+
+	ObjectsFileIndex index;
+	BOOST_REQUIRE(index.Open(objectsPath));
+	BOOST_CHECK(index.GetCount() == 4);
+
+	std::vector<ObjectsFileIndexEntry> entries = index.FindObjects("Host", "");
+	BOOST_REQUIRE(entries.size() == 2);
+	BOOST_CHECK(entries[0].InternalName == "h1");
+	BOOST_CHECK(entries[1].InternalName == "h2");
+
+	Dictionary::Ptr object = JsonDecode(index.ReadObject(entries[1]));
+	BOOST_CHECK(object->Get("type") == "Host");
+	BOOST_CHECK(object->Get("name") == "h2");
+
+	entries = index.FindObjects("Service", "*!ping");
+	BOOST_REQUIRE(entries.size() == 1);
+	object = JsonDecode(index.ReadObject(entries[0]));
+	BOOST_CHECK(object->Get("name") == "h1!ping");
+
+	BOOST_CHECK(index.FindObjects("", "h*").size() == 3);
+	BOOST_CHECK(index.FindObjects("*o*", "").size() == 3);
+	BOOST_CHECK(index.FindObjects("User", "").empty());
+
+	/* type filters are case-insensitive, just like Utility::Match() */
+	entries = index.FindObjects("host", "");
+	BOOST_REQUIRE(entries.size() == 2);
+	BOOST_CHECK(entries[0].InternalName == "h1");
+	BOOST_CHECK(entries[1].InternalName == "h2");
+	BOOST_CHECK(index.FindObjects("SERVICE", "*!ping").size() == 1);
+
+	index.Close();
+
+	/* a modified objects file invalidates the index */
+	{
+		std::ofstream fp(objectsPath.CStr(), std::ios::app);
+		fp << "2:{},";
+	}
+
+	BOOST_CHECK(!index.Open(objectsPath));
+
+	(void) unlink(objectsPath.CStr());
+	(void) unlink(ObjectsFileIndex::GetIndexPath(objectsPath).CStr());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,118 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "icinga/host.hpp"
+#include "icinga/checkcommand.hpp"
+#include "icinga/pluginutility.hpp"
+#include "base/utility.hpp"
+#include <BoostTestTargetConfig.h>
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(icinga_batchcheck)
+
+BOOST_AUTO_TEST_CASE(parse_output)
+{
+	std::map<String, std::pair<int, String> > results = PluginUtility::ParseBatchOutput(
+	    "10.0.0.1\t0\tPING OK - Packet loss = 0%|rta=0.5ms\n"
+	    "garbage line\n"
+	    "10.0.0.2\tx\tinvalid exit status\n"
+	    "10.0.0.3\t2\tfirst result\n"
+	    "10.0.0.3\t1\tsecond line\\nlong output \\\\ end\r\n"
+	    "\t0\tmissing target\n");
+
+	BOOST_CHECK(results.size() == 2);
+
+	BOOST_CHECK(results["10.0.0.1"].first == 0);
+	BOOST_CHECK(results["10.0.0.1"].second == "PING OK - Packet loss = 0%|rta=0.5ms");
+
+	BOOST_CHECK(results["10.0.0.3"].first == 1);
+	BOOST_CHECK(results["10.0.0.3"].second == "second line\nlong output \\ end");
+}
+
+static Host::Ptr MakeHost(const String& address)
+{
+	Host::Ptr host = new Host();
+	host->SetAddress(address);
+	host->SetMaxCheckAttempts(1);
+	host->Activate();
+	host->SetAuthority(true);
+
+	return host;
+}
+
+BOOST_AUTO_TEST_CASE(fake_plugin)
+{
+	/* a fake batch plugin: one result line per target, no result for 10.0.0.3;
+	 * '$' must be escaped because the command line is subject to macro expansion */
+	Array::Ptr commandLine = new Array();
+	commandLine->Add("/bin/sh");
+	commandLine->Add("-c");
+	commandLine->Add(
+	    "for target in \"$$@\"; do\n"
+	    "  case $$target in\n"
+	    "    10.0.0.1) printf '%s\\t0\\tPING OK - %s|rta=1ms\\n' $$target $$target ;;\n"
+	    "    10.0.0.2) printf '%s\\t2\\tPING CRITICAL - %s\\n' $$target $$target ;;\n"
+	    "  esac\n"
+	    "done\n");
+	commandLine->Add("fake-batch");
+
+	CheckCommand::Ptr command = new CheckCommand();
+	command->SetCommandLine(commandLine);
+	command->SetBatchSize(10);
+
+	std::vector<Checkable::Ptr> hosts;
+	hosts.push_back(MakeHost("10.0.0.1"));
+	hosts.push_back(MakeHost("10.0.0.2"));
+	hosts.push_back(MakeHost("10.0.0.3"));
+
+	Checkable::ExecuteCheckBatch(command, hosts);
+
+	for (int i = 0; i < 100; i++) {
+		bool done = true;
+
+		for (const Checkable::Ptr& host : hosts) {
+			if (!host->GetLastCheckResult())
+				done = false;
+		}
+
+		if (done)
+			break;
+
+		Utility::Sleep(0.1);
+	}
+
+	CheckResult::Ptr cr1 = hosts[0]->GetLastCheckResult();
+	CheckResult::Ptr cr2 = hosts[1]->GetLastCheckResult();
+	CheckResult::Ptr cr3 = hosts[2]->GetLastCheckResult();
+
+	BOOST_REQUIRE(cr1 && cr2 && cr3);
+
+	BOOST_CHECK(cr1->GetState() == ServiceOK);
+	BOOST_CHECK(cr1->GetOutput() == "PING OK - 10.0.0.1");
+	BOOST_CHECK(cr1->GetPerformanceData()->GetLength() == 1);
+
+	BOOST_CHECK(cr2->GetState() == ServiceCritical);
+	BOOST_CHECK(cr2->GetOutput() == "PING CRITICAL - 10.0.0.2");
+
+	BOOST_CHECK(cr3->GetState() == ServiceUnknown);
+	BOOST_CHECK(cr3->GetOutput() == "Batch check command returned no result for target '10.0.0.3'");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
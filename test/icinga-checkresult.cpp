@@ -18,6 +18,7 @@
  ******************************************************************************/
 
 #include "icinga/host.hpp"
+#include "icinga/checkresultconsumer.hpp"
 #include <BoostTestTargetConfig.h>
 
 using namespace icinga;
@@ -482,4 +483,46 @@ BOOST_AUTO_TEST_CASE(service_flapping_notification)
 
 #endif /* I2_DEBUG */
 }
+
+static void ConsumerAddState(std::vector<ServiceState> *states, ServiceState state)
+{
+	states->push_back(state);
+}
+
+static CheckResultConsumer::Task ConsumerHandler(std::vector<ServiceState> *states, const Checkable::Ptr& checkable, const CheckResult::Ptr&)
+{
+	/* live state must be read while preparing the task */
+	return boost::bind(&ConsumerAddState, states, checkable->GetStateRaw());
+}
+
+BOOST_AUTO_TEST_CASE(consumer_order)
+{
+	std::vector<ServiceState> states;
+
+	CheckResultConsumer::Ptr consumer = new CheckResultConsumer("test", boost::bind(&ConsumerHandler, &states, _1, _2));
+	consumer->Start();
+
+	Host::Ptr host = new Host();
+	host->SetMaxCheckAttempts(3);
+	host->Activate();
+	host->SetAuthority(true);
+
+	host->ProcessCheckResult(MakeCheckResult(ServiceCritical));
+	host->ProcessCheckResult(MakeCheckResult(ServiceOK));
+	host->ProcessCheckResult(MakeCheckResult(ServiceWarning));
+
+	/* Stop() waits for all pending check results */
+	consumer->Stop();
+
+	BOOST_CHECK(states.size() == 3);
+	BOOST_CHECK(states[0] == ServiceCritical);
+	BOOST_CHECK(states[1] == ServiceOK);
+	BOOST_CHECK(states[2] == ServiceWarning);
+	BOOST_CHECK(consumer->GetDropped() == 0);
+
+	/* no deliveries after Stop() */
+	host->ProcessCheckResult(MakeCheckResult(ServiceOK));
+	BOOST_CHECK(states.size() == 3);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
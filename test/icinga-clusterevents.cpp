@@ -0,0 +1,81 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "icinga/clusterevents.hpp"
+#include "base/application.hpp"
+#include "base/convert.hpp"
+#include <BoostTestTargetConfig.h>
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(icinga_clusterevents)
+
+BOOST_AUTO_TEST_CASE(batch_key)
+{
+	Zone::Ptr master = new Zone();
+	master->SetName("master");
+
+	Zone::Ptr satellite = new Zone();
+	satellite->SetName("satellite");
+
+	MessageOrigin::Ptr local = new MessageOrigin();
+
+	MessageOrigin::Ptr fromSatellite1 = new MessageOrigin();
+	fromSatellite1->FromZone = satellite;
+
+	MessageOrigin::Ptr fromSatellite2 = new MessageOrigin();
+	fromSatellite2->FromZone = satellite;
+
+	MessageOrigin::Ptr fromMaster = new MessageOrigin();
+	fromMaster->FromZone = master;
+
+	/* results with the same target zone and origin are merged */
+	BOOST_CHECK(ClusterEvents::GetCheckResultBatchKey(master, fromSatellite1) == ClusterEvents::GetCheckResultBatchKey(master, fromSatellite2));
+	BOOST_CHECK(ClusterEvents::GetCheckResultBatchKey(master, MessageOrigin::Ptr()) == ClusterEvents::GetCheckResultBatchKey(master, MessageOrigin::Ptr()));
+
+	/* ... and kept apart otherwise */
+	BOOST_CHECK(ClusterEvents::GetCheckResultBatchKey(master, fromSatellite1) != ClusterEvents::GetCheckResultBatchKey(satellite, fromSatellite1));
+	BOOST_CHECK(ClusterEvents::GetCheckResultBatchKey(master, fromSatellite1) != ClusterEvents::GetCheckResultBatchKey(master, fromMaster));
+	BOOST_CHECK(ClusterEvents::GetCheckResultBatchKey(master, fromSatellite1) != ClusterEvents::GetCheckResultBatchKey(master, local));
+	BOOST_CHECK(ClusterEvents::GetCheckResultBatchKey(master, local) != ClusterEvents::GetCheckResultBatchKey(master, MessageOrigin::Ptr()));
+}
+
+BOOST_AUTO_TEST_CASE(queue_index)
+{
+	std::set<size_t> indexes;
+
+	for (int i = 0; i < 100; i++) {
+		Dictionary::Ptr params = new Dictionary();
+		params->Set("host", "host" + Convert::ToString(i));
+		params->Set("service", "ping");
+
+		size_t index = ClusterEvents::GetCheckResultQueueIndex(params);
+		BOOST_CHECK(index < static_cast<size_t>(Application::GetConcurrency()));
+
+		/* results for the same checkable are processed by the same queue */
+		BOOST_CHECK(ClusterEvents::GetCheckResultQueueIndex(params->ShallowClone()) == index);
+
+		indexes.insert(index);
+	}
+
+	if (Application::GetConcurrency() > 1)
+		BOOST_CHECK(indexes.size() > 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,75 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "icinga/externalcommandprocessor.hpp"
+#include <BoostTestTargetConfig.h>
+
+using namespace icinga;
+
+static ExternalCommandLine ParseLine(const String& line)
+{
+	ExternalCommandLine cl;
+	ExternalCommandProcessor::ParseLine(line.CStr(), line.GetLength(), cl);
+	return cl;
+}
+
+BOOST_AUTO_TEST_SUITE(icinga_externalcommand)
+
+BOOST_AUTO_TEST_CASE(parse_line)
+{
+	/* The parsed line points into the original buffer. */
+	String line = "[1487075442] PROCESS_SERVICE_CHECK_RESULT;host1;ping;2;CRITICAL - a;b";
+	ExternalCommandLine cl = ParseLine(line);
+	BOOST_CHECK(cl.Timestamp == 1487075442);
+	BOOST_CHECK(String(cl.Command, cl.Command + cl.CommandLength) == "PROCESS_SERVICE_CHECK_RESULT");
+	BOOST_CHECK(String(cl.Arguments, cl.Arguments + cl.ArgumentsLength) == "host1;ping;2;CRITICAL - a;b");
+
+	line = "[1487075442.5] SHUTDOWN_PROCESS";
+	cl = ParseLine(line);
+	BOOST_CHECK(cl.Timestamp == 1487075442.5);
+	BOOST_CHECK(String(cl.Command, cl.Command + cl.CommandLength) == "SHUTDOWN_PROCESS");
+	BOOST_CHECK(cl.Arguments == NULL);
+
+	cl = ParseLine("[1487075442] ENABLE_HOST_CHECK;");
+	BOOST_CHECK(cl.Arguments != NULL && cl.ArgumentsLength == 0);
+
+	BOOST_CHECK_THROW(ParseLine("PROCESS_HOST_CHECK_RESULT;host1;0;OK"), std::invalid_argument);
+	BOOST_CHECK_THROW(ParseLine("[1487075442 PROCESS_HOST_CHECK_RESULT"), std::invalid_argument);
+	BOOST_CHECK_THROW(ParseLine("[abc] PROCESS_HOST_CHECK_RESULT"), std::invalid_argument);
+	BOOST_CHECK_THROW(ParseLine("[0] PROCESS_HOST_CHECK_RESULT"), std::invalid_argument);
+	BOOST_CHECK_THROW(ParseLine("[1487075442]"), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(checkresult_key)
+{
+	size_t key1, key2;
+
+	BOOST_CHECK(ExternalCommandProcessor::GetCheckResultKey(ParseLine("[1] PROCESS_SERVICE_CHECK_RESULT;host1;ping;0;OK"), key1));
+	BOOST_CHECK(ExternalCommandProcessor::GetCheckResultKey(ParseLine("[2] PROCESS_SERVICE_CHECK_RESULT;host1;ping;2;CRITICAL"), key2));
+	BOOST_CHECK(key1 == key2);
+
+	BOOST_CHECK(ExternalCommandProcessor::GetCheckResultKey(ParseLine("[1] PROCESS_HOST_CHECK_RESULT;host1;0;UP"), key1));
+	BOOST_CHECK(ExternalCommandProcessor::GetCheckResultKey(ParseLine("[2] PROCESS_HOST_CHECK_RESULT;host1;1;DOWN"), key2));
+	BOOST_CHECK(key1 == key2);
+
+	BOOST_CHECK(!ExternalCommandProcessor::GetCheckResultKey(ParseLine("[1] SCHEDULE_SVC_CHECK;host1;ping;1"), key1));
+	BOOST_CHECK(!ExternalCommandProcessor::GetCheckResultKey(ParseLine("[1] PROCESS_HOST_CHECK_RESULT"), key1));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -18,10 +18,30 @@
  ******************************************************************************/
 
 #include "icinga/notification.hpp"
+#include "icinga/notificationaggregator.hpp"
 #include <BoostTestTargetConfig.h>
 
 using namespace icinga;
 
+static std::vector<std::vector<PendingNotification> > l_Flushed;
+
+static void FlushHandler(const std::vector<PendingNotification>& notifications)
+{
+	l_Flushed.push_back(notifications);
+}
+
+static PendingNotification MakePendingNotification(const String& userName, NotificationType type, const String& comment)
+{
+	User::Ptr user = new User();
+	user->SetName(userName);
+
+	PendingNotification pn;
+	pn.UserObject = user;
+	pn.Type = type;
+	pn.Comment = comment;
+	return pn;
+}
+
 BOOST_AUTO_TEST_SUITE(icinga_notification)
 
 BOOST_AUTO_TEST_CASE(state_filter)
@@ -103,4 +123,124 @@ BOOST_AUTO_TEST_CASE(type_filter)
 	std::cout << "#4 Notification type: " << ftype << " against " << notification->GetTypeFilter() << " must fail." << std::endl;
 	BOOST_CHECK(!(notification->GetTypeFilter() & ftype));
 }
+
+BOOST_AUTO_TEST_CASE(identical_commands)
+{
+	NotificationCommand::Ptr command = new NotificationCommand();
+	command->SetName("test-identical");
+	command->SetAggregationWindow(10);
+
+	unsigned long aggregated = NotificationAggregator::GetStats()->Get("aggregated");
+
+	BOOST_CHECK(NotificationAggregator::ShouldExecute(command, "mail alice", 100));
+	BOOST_CHECK(NotificationAggregator::ShouldExecute(command, "mail bob", 100));
+	BOOST_CHECK(!NotificationAggregator::ShouldExecute(command, "mail alice", 105));
+	BOOST_CHECK(NotificationAggregator::ShouldExecute(command, "mail alice", 111));
+
+	/* command lines which can't be compared are never skipped */
+	BOOST_CHECK(NotificationAggregator::ShouldExecute(command, "", 112));
+	BOOST_CHECK(NotificationAggregator::ShouldExecute(command, "", 112));
+
+	BOOST_CHECK(static_cast<unsigned long>(NotificationAggregator::GetStats()->Get("aggregated")) == aggregated + 1);
+}
+
+BOOST_AUTO_TEST_CASE(rate_limit)
+{
+	NotificationCommand::Ptr command = new NotificationCommand();
+	command->SetName("test-rate-limit");
+	command->SetRateLimit(2);
+
+	unsigned long suppressed = NotificationAggregator::GetStats()->Get("suppressed");
+
+	BOOST_CHECK(NotificationAggregator::ShouldExecute(command, "a", 200));
+	BOOST_CHECK(NotificationAggregator::ShouldExecute(command, "a", 210));
+	BOOST_CHECK(!NotificationAggregator::ShouldExecute(command, "b", 220));
+	BOOST_CHECK(NotificationAggregator::ShouldExecute(command, "c", 261));
+
+	BOOST_CHECK(static_cast<unsigned long>(NotificationAggregator::GetStats()->Get("suppressed")) == suppressed + 1);
+}
+
+BOOST_AUTO_TEST_CASE(aggregation_disabled)
+{
+	NotificationCommand::Ptr command = new NotificationCommand();
+	command->SetName("test-no-aggregation");
+
+	l_Flushed.clear();
+
+	BOOST_CHECK(!NotificationAggregator::Enqueue(command, MakePendingNotification("alice", NotificationProblem, "1"), &FlushHandler));
+	NotificationAggregator::Flush(true);
+	BOOST_CHECK(l_Flushed.empty());
+}
+
+BOOST_AUTO_TEST_CASE(aggregate_problems)
+{
+	NotificationCommand::Ptr command = new NotificationCommand();
+	command->SetName("test-aggregate");
+	command->SetAggregationWindow(60);
+
+	l_Flushed.clear();
+
+	BOOST_CHECK(NotificationAggregator::Enqueue(command, MakePendingNotification("alice", NotificationProblem, "1"), &FlushHandler));
+	BOOST_CHECK(NotificationAggregator::Enqueue(command, MakePendingNotification("bob", NotificationProblem, "2"), &FlushHandler));
+	BOOST_CHECK(NotificationAggregator::Enqueue(command, MakePendingNotification("alice", NotificationProblem, "3"), &FlushHandler));
+
+	/* the window hasn't passed yet */
+	NotificationAggregator::Flush(false);
+	BOOST_CHECK(l_Flushed.empty());
+	BOOST_CHECK(static_cast<size_t>(NotificationAggregator::GetStats()->Get("pending")) == 3);
+
+	NotificationAggregator::Flush(true);
+	BOOST_REQUIRE(l_Flushed.size() == 2);
+
+	for (const std::vector<PendingNotification>& batch : l_Flushed) {
+		if (batch[0].UserObject->GetName() == "alice") {
+			BOOST_REQUIRE(batch.size() == 2);
+			BOOST_CHECK(batch[0].Comment == "1");
+			BOOST_CHECK(batch[1].Comment == "3");
+		} else {
+			BOOST_CHECK(batch.size() == 1);
+			BOOST_CHECK(batch[0].Comment == "2");
+		}
+	}
+
+	BOOST_CHECK(static_cast<size_t>(NotificationAggregator::GetStats()->Get("pending")) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(recovery_flushes_problems)
+{
+	NotificationCommand::Ptr command = new NotificationCommand();
+	command->SetName("test-recovery");
+	command->SetAggregationWindow(60);
+
+	l_Flushed.clear();
+
+	BOOST_CHECK(NotificationAggregator::Enqueue(command, MakePendingNotification("alice", NotificationProblem, "problem"), &FlushHandler));
+
+	/* the recovery is sent by the caller after the pending problem */
+	BOOST_CHECK(!NotificationAggregator::Enqueue(command, MakePendingNotification("alice", NotificationRecovery, "recovery"), &FlushHandler));
+	BOOST_REQUIRE(l_Flushed.size() == 1);
+	BOOST_CHECK(l_Flushed[0].size() == 1);
+	BOOST_CHECK(l_Flushed[0][0].Comment == "problem");
+
+	/* nothing is pending for this user anymore */
+	BOOST_CHECK(!NotificationAggregator::Enqueue(command, MakePendingNotification("alice", NotificationRecovery, "recovery"), &FlushHandler));
+	BOOST_CHECK(l_Flushed.size() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(batch_size)
+{
+	NotificationCommand::Ptr command = new NotificationCommand();
+	command->SetName("test-batch-size");
+	command->SetAggregationWindow(60);
+
+	l_Flushed.clear();
+
+	for (int i = 0; i < 100; i++)
+		BOOST_CHECK(NotificationAggregator::Enqueue(command, MakePendingNotification("alice", NotificationProblem, ""), &FlushHandler));
+
+	/* full batches are sent right away */
+	BOOST_REQUIRE(l_Flushed.size() == 1);
+	BOOST_CHECK(l_Flushed[0].size() == 100);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -51,6 +51,14 @@ object Host "test-02" {
   check_command = "dummy"
 }
 
+object HostGroup "test-hosts" {
+  assign where match("test-*", host.name)
+}
+
+object ServiceGroup "test-services" {
+  assign where service.name == "livestatus"
+}
+
 apply Service "livestatus" {
   check_command = "dummy"
   notes = "test livestatus"
@@ -18,10 +18,18 @@
  ******************************************************************************/
 
 #include "livestatus/livestatusquery.hpp"
+#include "livestatus/livestatuslistener.hpp"
+#include "icinga/service.hpp"
+#include "icinga/servicegroup.hpp"
+#include "config/configcompiler.hpp"
+#include "config/configitem.hpp"
 #include "base/application.hpp"
 #include "base/stdiostream.hpp"
 #include "base/json.hpp"
+#include "base/convert.hpp"
+#include "base/utility.hpp"
 #include <BoostTestTargetConfig.h>
+#include <sys/un.h>
 
 using namespace icinga;
 
@@ -119,6 +127,378 @@ BOOST_AUTO_TEST_CASE(services)
 
 	BOOST_TEST_MESSAGE("Done with testing livestatus services...");
 }
+
+BOOST_AUTO_TEST_CASE(unknown_column)
+{
+	BOOST_TEST_MESSAGE( "Querying Livestatus...");
+
+	std::vector<String> lines;
+	lines.push_back("GET hosts");
+	lines.push_back("Columns: host_name no_such_column");
+	lines.push_back("ResponseHeader: fixed16");
+	lines.push_back("\n");
+
+	/* use our query helper */
+	String output = LivestatusQueryHelper(lines);
+
+	/* column names are resolved when parsing the query */
+	BOOST_CHECK(output.Find("452") == 0);
+	BOOST_CHECK(output.Find("no_such_column") != String::NPos);
+
+	BOOST_TEST_MESSAGE("Done with testing livestatus unknown columns...");
+}
+
+BOOST_AUTO_TEST_CASE(command_with_table_headers)
+{
+	std::vector<String> lines;
+	lines.push_back("COMMAND [1234567890] NO_SUCH_COMMAND");
+	lines.push_back("Columns: host_name state");
+	lines.push_back("Filter: state = 0");
+	lines.push_back("Stats: state = 0");
+	lines.push_back("StatsAnd: 1");
+	lines.push_back("Negate:");
+	lines.push_back("\n");
+
+	/* COMMAND queries don't have a table the headers could refer to */
+	LivestatusQuery::Ptr query = new LivestatusQuery(lines, "");
+	BOOST_CHECK(query);
+}
+
+BOOST_AUTO_TEST_CASE(stats_grouping)
+{
+	BOOST_TEST_MESSAGE( "Querying Livestatus...");
+
+	std::vector<String> lines;
+	lines.push_back("GET services");
+	lines.push_back("Columns: host_name");
+	lines.push_back("Stats: description = livestatus");
+	lines.push_back("OutputFormat: json");
+	lines.push_back("\n");
+
+	/* use our query helper */
+	String output = LivestatusQueryHelper(lines);
+
+	Array::Ptr query_result = JsonDecode(output);
+
+	/* one row per host */
+	BOOST_CHECK(query_result->GetLength() == 2);
+
+	Array::Ptr res1 = query_result->Get(0);
+	Array::Ptr res2 = query_result->Get(1);
+
+	BOOST_CHECK(res1->Contains("test-01") || res2->Contains("test-01"));
+	BOOST_CHECK(res1->Contains("test-02") || res2->Contains("test-02"));
+	BOOST_CHECK(res1->Get(1) == 1 && res2->Get(1) == 1);
+
+	BOOST_TEST_MESSAGE("Done with testing livestatus stats grouping...");
+}
+
+BOOST_AUTO_TEST_CASE(state_counters)
+{
+	Service::Ptr service = Service::GetByNamePair("test-01", "livestatus");
+	BOOST_REQUIRE(service);
+
+	CheckResult::Ptr cr = new CheckResult();
+	cr->SetState(ServiceCritical);
+
+	double now = Utility::GetTime();
+	cr->SetScheduleStart(now);
+	cr->SetScheduleEnd(now);
+	cr->SetExecutionStart(now);
+	cr->SetExecutionEnd(now);
+
+	service->ProcessCheckResult(cr);
+
+	std::vector<String> errors = ServiceStateCounters::CheckConsistency();
+
+	for (const String& error : errors) {
+		BOOST_TEST_MESSAGE(error);
+	}
+
+	BOOST_CHECK(errors.empty());
+
+	std::vector<String> lines;
+	lines.push_back("GET hostgroups");
+	lines.push_back("Columns: name num_services num_services_crit num_services_pending worst_service_state");
+	lines.push_back("OutputFormat: json");
+	lines.push_back("\n");
+
+	Array::Ptr query_result = JsonDecode(LivestatusQueryHelper(lines));
+
+	BOOST_REQUIRE(query_result->GetLength() == 1);
+
+	Array::Ptr row = query_result->Get(0);
+
+	BOOST_CHECK(row->Get(0) == "test-hosts");
+	BOOST_CHECK(row->Get(1) == 2);
+	BOOST_CHECK(row->Get(2) == 1);
+	BOOST_CHECK(row->Get(3) == 1);
+	BOOST_CHECK(row->Get(4) >= ServiceCritical);
+
+	lines[0] = "GET servicegroups";
+	lines[1] = "Columns: name num_services num_services_crit";
+
+	query_result = JsonDecode(LivestatusQueryHelper(lines));
+
+	BOOST_REQUIRE(query_result->GetLength() == 1);
+
+	row = query_result->Get(0);
+
+	BOOST_CHECK(row->Get(1) == 2);
+	BOOST_CHECK(row->Get(2) == 1);
+
+	BOOST_TEST_MESSAGE("Done with testing livestatus state counters...");
+}
+
+static void CreateRuntimeService(void)
+{
+	Expression *expr = ConfigCompiler::CompileText("<livestatus>", R"CONFIG(
+object Service "runtime" {
+  host_name = "test-01"
+  check_command = "dummy"
+  groups = [ "test-services" ]
+}
+)CONFIG");
+	expr->Evaluate(*ScriptFrame::GetCurrentFrame());
+	delete expr;
+}
+
+BOOST_AUTO_TEST_CASE(state_counters_runtime_removal)
+{
+	Host::Ptr host = Host::GetByName("test-01");
+	ServiceGroup::Ptr sg = ServiceGroup::GetByName("test-services");
+	BOOST_REQUIRE(host && sg);
+
+	int hostTotal = host->GetTotalServices();
+	int groupTotal = sg->GetServiceStateCounters().GetTotal();
+	int globalTotal = ServiceStateCounters::GetGlobal().GetTotal();
+
+	BOOST_REQUIRE(ConfigItem::RunWithActivationContext(new Function("CreateRuntimeService", WrapFunction(CreateRuntimeService))));
+
+	Service::Ptr service = Service::GetByNamePair("test-01", "runtime");
+	BOOST_REQUIRE(service);
+
+	BOOST_CHECK(host->GetTotalServices() == hostTotal + 1);
+	BOOST_CHECK(sg->GetServiceStateCounters().GetTotal() == groupTotal + 1);
+	BOOST_CHECK(ServiceStateCounters::GetGlobal().GetTotal() == globalTotal + 1);
+
+	/* same steps as ConfigObjectUtility::DeleteObject */
+	service->Deactivate(true);
+
+	ConfigItem::Ptr item = ConfigItem::GetByTypeAndName("Service", service->GetName());
+
+	if (item)
+		item->Unregister();
+	else
+		service->Unregister();
+
+	BOOST_CHECK(host->GetTotalServices() == hostTotal);
+	BOOST_CHECK(sg->GetServiceStateCounters().GetTotal() == groupTotal);
+	BOOST_CHECK(ServiceStateCounters::GetGlobal().GetTotal() == globalTotal);
+	BOOST_CHECK(!host->GetServiceByShortName("runtime"));
+
+	std::vector<String> errors = ServiceStateCounters::CheckConsistency();
+
+	for (const String& error : errors) {
+		BOOST_TEST_MESSAGE(error);
+	}
+
+	BOOST_CHECK(errors.empty());
+}
+//____________________________________________________________________________//
+
+static const char *l_ListenerSocketPath = "livestatus-listener-test.sock";
+
+static void CreateTestListener(void)
+{
+	/* Used for the default values of the path attributes. */
+	if (!ScriptGlobal::Exists("RunDir"))
+		Application::DeclareRunDir(".");
+
+	if (!ScriptGlobal::Exists("LocalStateDir"))
+		Application::DeclareLocalStateDir(".");
+
+	Expression *expr = ConfigCompiler::CompileText("<livestatus>", R"CONFIG(
+object LivestatusListener "test-listener" {
+  socket_type = "unix"
+  socket_path = "livestatus-listener-test.sock"
+  compat_log_path = "."
+}
+)CONFIG");
+	expr->Evaluate(*ScriptFrame::GetCurrentFrame());
+	delete expr;
+}
+
+static void RemoveTestListener(const LivestatusListener::Ptr& listener)
+{
+	listener->Deactivate(true);
+
+	ConfigItem::Ptr item = ConfigItem::GetByTypeAndName("LivestatusListener", listener->GetName());
+
+	if (item)
+		item->Unregister();
+	else
+		listener->Unregister();
+
+	(void) unlink(l_ListenerSocketPath);
+}
+
+static int ConnectTestListener(void)
+{
+	sockaddr_un s_un;
+	memset(&s_un, 0, sizeof(s_un));
+	s_un.sun_family = AF_UNIX;
+	strncpy(s_un.sun_path, l_ListenerSocketPath, sizeof(s_un.sun_path) - 1);
+
+	/* the listener thread starts listening asynchronously */
+	for (int i = 0; i < 100; i++) {
+		int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+		if (connect(fd, reinterpret_cast<sockaddr *>(&s_un), sizeof(s_un)) == 0) {
+			struct timeval tv = { 15, 0 };
+			setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+			return fd;
+		}
+
+		close(fd);
+		Utility::Sleep(0.1);
+	}
+
+	return -1;
+}
+
+static String ReadExactly(int fd, size_t length)
+{
+	String data;
+	char buffer[4096];
+
+	while (data.GetLength() < length) {
+		ssize_t rc = recv(fd, buffer, std::min(sizeof(buffer), length - data.GetLength()), 0);
+
+		if (rc <= 0)
+			break;
+
+		data += String(buffer, buffer + rc);
+	}
+
+	return data;
+}
+
+/* reads a response which was sent with "ResponseHeader: fixed16" */
+static String ReadFixed16Response(int fd, int *code)
+{
+	String header = ReadExactly(fd, 16);
+
+	if (header.GetLength() != 16)
+		return String();
+
+	*code = Convert::ToLong(header.SubStr(0, 3));
+
+	return ReadExactly(fd, Convert::ToLong(header.SubStr(3, 12).Trim()));
+}
+
+static bool WaitForClients(int count)
+{
+	for (int i = 0; i < 150; i++) {
+		if (LivestatusListener::GetClientsConnected() == count)
+			return true;
+
+		Utility::Sleep(0.1);
+	}
+
+	return false;
+}
+
+BOOST_AUTO_TEST_CASE(listener_keepalive)
+{
+	BOOST_REQUIRE(ConfigItem::RunWithActivationContext(new Function("CreateTestListener", WrapFunction(CreateTestListener))));
+
+	LivestatusListener::Ptr listener = LivestatusListener::GetByName("test-listener");
+	BOOST_REQUIRE(listener);
+
+	int clients = LivestatusListener::GetClientsConnected();
+
+	int fd = ConnectTestListener();
+	BOOST_REQUIRE(fd >= 0);
+
+	/* send both requests at once, the responses must arrive in order */
+	String requests;
+
+	for (int i = 1; i <= 2; i++) {
+		requests += "GET hosts\nColumns: host_name\nFilter: host_name = test-0" + Convert::ToString(i) + "\n"
+		    "KeepAlive: on\nResponseHeader: fixed16\n\n";
+	}
+
+	BOOST_REQUIRE(send(fd, requests.CStr(), requests.GetLength(), 0) == static_cast<ssize_t>(requests.GetLength()));
+
+	int code = 0;
+	BOOST_CHECK(ReadFixed16Response(fd, &code) == "test-01\n");
+	BOOST_CHECK(code == LivestatusErrorOK);
+
+	code = 0;
+	BOOST_CHECK(ReadFixed16Response(fd, &code) == "test-02\n");
+	BOOST_CHECK(code == LivestatusErrorOK);
+
+	/* the connection is still usable after the pipelined requests */
+	String request = "GET hosts\nColumns: address\nFilter: host_name = test-02\nResponseHeader: fixed16\n\n";
+	BOOST_REQUIRE(send(fd, request.CStr(), request.GetLength(), 0) == static_cast<ssize_t>(request.GetLength()));
+
+	code = 0;
+	BOOST_CHECK(ReadFixed16Response(fd, &code) == "127.0.0.2\n");
+	BOOST_CHECK(code == LivestatusErrorOK);
+
+	/* without KeepAlive the listener closes the connection after the response */
+	char buffer[16];
+	BOOST_CHECK(recv(fd, buffer, sizeof(buffer), 0) == 0);
+	BOOST_CHECK(WaitForClients(clients));
+
+	close(fd);
+
+	RemoveTestListener(listener);
+}
+
+BOOST_AUTO_TEST_CASE(listener_disconnect)
+{
+	BOOST_REQUIRE(ConfigItem::RunWithActivationContext(new Function("CreateTestListener", WrapFunction(CreateTestListener))));
+
+	LivestatusListener::Ptr listener = LivestatusListener::GetByName("test-listener");
+	BOOST_REQUIRE(listener);
+
+	int clients = LivestatusListener::GetClientsConnected();
+
+	int idle = ConnectTestListener();
+	BOOST_REQUIRE(idle >= 0);
+
+	int fd = ConnectTestListener();
+	BOOST_REQUIRE(fd >= 0);
+
+	BOOST_CHECK(WaitForClients(clients + 2));
+
+	/* close the connection in the middle of a keep-alive request */
+	String request = "GET hosts\nColumns: host_name\nKeepAlive: on\n";
+	BOOST_REQUIRE(send(fd, request.CStr(), request.GetLength(), 0) == static_cast<ssize_t>(request.GetLength()));
+	close(fd);
+
+	BOOST_CHECK(WaitForClients(clients + 1));
+
+	/* the other client isn't affected */
+	request = "GET hosts\nColumns: host_name\nFilter: host_name = test-01\nKeepAlive: on\nResponseHeader: fixed16\n\n";
+	BOOST_REQUIRE(send(idle, request.CStr(), request.GetLength(), 0) == static_cast<ssize_t>(request.GetLength()));
+
+	int code = 0;
+	BOOST_CHECK(ReadFixed16Response(idle, &code) == "test-01\n");
+	BOOST_CHECK(code == LivestatusErrorOK);
+
+	/* stopping the listener drops the remaining connections */
+	RemoveTestListener(listener);
+
+	BOOST_CHECK(LivestatusListener::GetClientsConnected() == clients);
+
+	char buffer[16];
+	BOOST_CHECK(recv(idle, buffer, sizeof(buffer), 0) == 0);
+
+	close(idle);
+}
 //____________________________________________________________________________//
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,287 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "methods/tcpchecktask.hpp"
+#include "methods/httpchecktask.hpp"
+#include "methods/dnschecktask.hpp"
+#include "base/convert.hpp"
+#include <boost/thread.hpp>
+#include <BoostTestTargetConfig.h>
+
+using namespace icinga;
+
+struct ProbeResult
+{
+	boost::mutex Mutex;
+	boost::condition_variable CV;
+	bool Done;
+
+	ProbeResult(void)
+		: Done(false)
+	{ }
+
+	void Callback(const CheckResult::Ptr&)
+	{
+		boost::mutex::scoped_lock lock(Mutex);
+		Done = true;
+		CV.notify_all();
+	}
+
+	bool Wait(void)
+	{
+		boost::mutex::scoped_lock lock(Mutex);
+
+		while (!Done) {
+			if (!CV.timed_wait(lock, boost::posix_time::seconds(15)))
+				return false;
+		}
+
+		return true;
+	}
+};
+
+static int OpenListener(int type, String& port)
+{
+	int fd = socket(AF_INET, type, 0);
+
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+
+	if (type == SOCK_STREAM)
+		listen(fd, 5);
+
+	socklen_t len = sizeof(addr);
+	getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len);
+	port = Convert::ToString(ntohs(addr.sin_port));
+
+	return fd;
+}
+
+static void ServeOnce(int fd, const String& response, bool readRequest, bool keepOpen)
+{
+	int client = accept(fd, NULL, NULL);
+
+	if (readRequest) {
+		char buffer[1024];
+		(void) recv(client, buffer, sizeof(buffer), 0);
+	}
+
+	if (!response.IsEmpty())
+		(void) send(client, response.CStr(), response.GetLength(), 0);
+
+	if (keepOpen)
+		boost::this_thread::sleep(boost::posix_time::seconds(2));
+
+	close(client);
+	close(fd);
+}
+
+static CheckResult::Ptr RunProbe(void (*probe)(const Dictionary::Ptr&, const CheckResult::Ptr&, const NetworkProbe::CompletionCallback&),
+    const Dictionary::Ptr& args)
+{
+	CheckResult::Ptr cr = new CheckResult();
+	ProbeResult result;
+
+	probe(args, cr, boost::bind(&ProbeResult::Callback, &result, _1));
+
+	BOOST_REQUIRE(result.Wait());
+
+	return cr;
+}
+
+BOOST_AUTO_TEST_SUITE(methods_networkprobe)
+
+BOOST_AUTO_TEST_CASE(tcp_ok)
+{
+	String port;
+	int fd = OpenListener(SOCK_STREAM, port);
+	boost::thread server(boost::bind(&ServeOnce, fd, "SSH-2.0-Test\r\n", false, false));
+
+	Dictionary::Ptr args = new Dictionary();
+	args->Set("address", "127.0.0.1");
+	args->Set("port", port);
+	args->Set("expect", "SSH-");
+
+	CheckResult::Ptr cr = RunProbe(&TcpCheckTask::Probe, args);
+	server.join();
+
+	BOOST_CHECK(cr->GetState() == ServiceOK);
+	BOOST_CHECK(cr->GetOutput().Find("TCP OK - ") == 0);
+	BOOST_CHECK(cr->GetOutput().Find("port " + port + " [SSH-2.0-Test]") != String::NPos);
+	BOOST_CHECK(cr->GetPerformanceData()->GetLength() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(tcp_mismatch)
+{
+	String port;
+	int fd = OpenListener(SOCK_STREAM, port);
+	boost::thread server(boost::bind(&ServeOnce, fd, "220 smtp.example.com ESMTP\r\n", false, false));
+
+	Dictionary::Ptr args = new Dictionary();
+	args->Set("address", "127.0.0.1");
+	args->Set("port", port);
+	args->Set("expect", "SSH-");
+
+	CheckResult::Ptr cr = RunProbe(&TcpCheckTask::Probe, args);
+	server.join();
+
+	BOOST_CHECK(cr->GetState() == ServiceWarning);
+	BOOST_CHECK(cr->GetOutput() == "TCP WARNING - Unexpected response from host/socket: 220 smtp.example.com ESMTP");
+}
+
+BOOST_AUTO_TEST_CASE(tcp_refused)
+{
+	String port;
+	close(OpenListener(SOCK_STREAM, port));
+
+	Dictionary::Ptr args = new Dictionary();
+	args->Set("address", "127.0.0.1");
+	args->Set("port", port);
+
+	CheckResult::Ptr cr = RunProbe(&TcpCheckTask::Probe, args);
+
+	BOOST_CHECK(cr->GetState() == ServiceCritical);
+	BOOST_CHECK(cr->GetOutput().Find("connect to address 127.0.0.1 and port " + port + ": ") == 0);
+
+	args->Set("refuse", "ok");
+	cr = RunProbe(&TcpCheckTask::Probe, args);
+
+	BOOST_CHECK(cr->GetState() == ServiceOK);
+}
+
+BOOST_AUTO_TEST_CASE(tcp_timeout)
+{
+	String port;
+	int fd = OpenListener(SOCK_STREAM, port);
+	boost::thread server(boost::bind(&ServeOnce, fd, "", false, true));
+
+	Dictionary::Ptr args = new Dictionary();
+	args->Set("address", "127.0.0.1");
+	args->Set("port", port);
+	args->Set("expect", "SSH-");
+	args->Set("timeout", 1);
+
+	CheckResult::Ptr cr = RunProbe(&TcpCheckTask::Probe, args);
+	server.join();
+
+	BOOST_CHECK(cr->GetState() == ServiceCritical);
+	BOOST_CHECK(cr->GetOutput() == "CRITICAL - Socket timeout after 1 seconds");
+}
+
+BOOST_AUTO_TEST_CASE(http_status)
+{
+	String port;
+	int fd = OpenListener(SOCK_STREAM, port);
+	boost::thread server(boost::bind(&ServeOnce, fd, "HTTP/1.0 404 Not Found\r\nContent-Length: 4\r\n\r\nnope", true, false));
+
+	Dictionary::Ptr args = new Dictionary();
+	args->Set("address", "127.0.0.1");
+	args->Set("port", port);
+
+	CheckResult::Ptr cr = RunProbe(&HttpCheckTask::Probe, args);
+	server.join();
+
+	BOOST_CHECK(cr->GetState() == ServiceWarning);
+	BOOST_CHECK(cr->GetOutput().Find("HTTP WARNING: HTTP/1.0 404 Not Found - 49 bytes in ") == 0);
+	BOOST_CHECK(cr->GetPerformanceData()->GetLength() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(http_malformed_status)
+{
+	String port;
+	int fd = OpenListener(SOCK_STREAM, port);
+	boost::thread server(boost::bind(&ServeOnce, fd, "HTTP/1.1 ABC Not A Status\r\n\r\n", true, false));
+
+	Dictionary::Ptr args = new Dictionary();
+	args->Set("address", "127.0.0.1");
+	args->Set("port", port);
+
+	CheckResult::Ptr cr = RunProbe(&HttpCheckTask::Probe, args);
+	server.join();
+
+	BOOST_CHECK(cr->GetState() == ServiceCritical);
+	BOOST_CHECK(cr->GetOutput() == "HTTP CRITICAL - Invalid HTTP response received from host on port " + port);
+}
+
+BOOST_AUTO_TEST_CASE(http_string)
+{
+	String port;
+	int fd = OpenListener(SOCK_STREAM, port);
+	boost::thread server(boost::bind(&ServeOnce, fd, "HTTP/1.0 200 OK\r\n\r\nWelcome", true, false));
+
+	Dictionary::Ptr args = new Dictionary();
+	args->Set("address", "127.0.0.1");
+	args->Set("port", port);
+	args->Set("string", "Maintenance");
+
+	CheckResult::Ptr cr = RunProbe(&HttpCheckTask::Probe, args);
+	server.join();
+
+	BOOST_CHECK(cr->GetState() == ServiceCritical);
+	BOOST_CHECK(cr->GetOutput().Find("HTTP CRITICAL: HTTP/1.0 200 OK - string 'Maintenance' not found") == 0);
+}
+
+BOOST_AUTO_TEST_CASE(http_certificate_thresholds)
+{
+	Dictionary::Ptr args = new Dictionary();
+	args->Set("address", "127.0.0.1");
+	args->Set("port", 1);
+	args->Set("certificate", "thirty,7");
+
+	CheckResult::Ptr cr = RunProbe(&HttpCheckTask::Probe, args);
+
+	BOOST_CHECK(cr->GetState() == ServiceUnknown);
+	BOOST_CHECK(cr->GetOutput() == "UNKNOWN - Invalid value 'thirty,7' for macro 'http_certificate', expected 'warn[,crit]' days.");
+}
+
+static String BuildResponse(const String& query)
+{
+	/* answer with a compressed pointer to the question name */
+	String response = query;
+	response.GetData()[2] |= 0x80;
+	response.GetData()[7] = 1;
+
+	const char answer[] = { '\xc0', 0x0c, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x0e, 0x10, 0x00, 0x04, '\xc0', 0x00, 0x02, 0x01 };
+	response.GetData().append(answer, sizeof(answer));
+
+	return response;
+}
+
+BOOST_AUTO_TEST_CASE(dns_parse)
+{
+	String query = DnsCheckTask::BuildQuery("www.example.com.", 1, 0x1234);
+
+	BOOST_CHECK(query.GetLength() == 12 + 17 + 4);
+	BOOST_CHECK(query.SubStr(12, 5) == "\x03www\x07");
+
+	std::vector<String> answers;
+	BOOST_CHECK(DnsCheckTask::ParseResponse(BuildResponse(query), 1, 0x1234, answers) == 0);
+	BOOST_CHECK(answers.size() == 1 && answers[0] == "192.0.2.1");
+
+	answers.clear();
+	BOOST_CHECK(DnsCheckTask::ParseResponse(BuildResponse(query), 1, 0x4321, answers) == -1);
+
+	BOOST_CHECK_THROW(DnsCheckTask::ParseResponse(BuildResponse(query).SubStr(0, 40), 1, 0x1234, answers), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
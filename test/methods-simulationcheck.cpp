@@ -0,0 +1,76 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "methods/simulationchecktask.hpp"
+#include <BoostTestTargetConfig.h>
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(methods_simulationcheck)
+
+BOOST_AUTO_TEST_CASE(latency)
+{
+	BOOST_CHECK(SimulationCheckTask::SampleLatency("fixed", 2.5, 0, 0, 60) == 2.5);
+	BOOST_CHECK(SimulationCheckTask::SampleLatency("fixed", 2.5, 0, 0, 1) == 1);
+
+	double sum = 0;
+
+	for (int i = 0; i < 10000; i++) {
+		double latency = SimulationCheckTask::SampleLatency("normal", 5, 1, 0, 60);
+		BOOST_CHECK(latency >= 0 && latency <= 60);
+		sum += latency;
+	}
+
+	BOOST_CHECK(sum / 10000 > 4.8 && sum / 10000 < 5.2);
+
+	double max = 0;
+
+	for (int i = 0; i < 10000; i++) {
+		double latency = SimulationCheckTask::SampleLatency("longtail", 1, 0, 1.5, 100);
+		BOOST_CHECK(latency >= 1 && latency <= 100);
+		max = std::max(max, latency);
+	}
+
+	BOOST_CHECK(max > 10);
+
+	BOOST_CHECK_THROW(SimulationCheckTask::SampleLatency("uniform", 1, 0, 0, 60), std::invalid_argument);
+	BOOST_CHECK_THROW(SimulationCheckTask::SampleLatency("longtail", 1, 0, 0, 60), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(state_change)
+{
+	for (int i = 0; i < 100; i++) {
+		BOOST_CHECK(SimulationCheckTask::SampleState(ServiceWarning, 0) == ServiceWarning);
+		BOOST_CHECK(SimulationCheckTask::SampleState(ServiceWarning, 1) != ServiceWarning);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(output)
+{
+	String output = SimulationCheckTask::GenerateOutput(ServiceOK, "fixed", 1, 0);
+	BOOST_CHECK(output.Find("SIMULATION OK") == 0);
+
+	output = SimulationCheckTask::GenerateOutput(ServiceCritical, "fixed", 1, 4096);
+	BOOST_CHECK(output.GetLength() == 4096);
+
+	BOOST_CHECK(SimulationCheckTask::GeneratePerfdata(1, 0)->GetLength() == 0);
+	BOOST_CHECK(SimulationCheckTask::GeneratePerfdata(1, 25)->GetLength() == 25);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,163 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "perfdata/perfdataspoolwriter.hpp"
+#include "perfdata/perfdataspoolreader.hpp"
+#include "icinga/perfdatavalue.hpp"
+#include "icinga/pluginutility.hpp"
+#include "base/objectlock.hpp"
+#include <BoostTestTargetConfig.h>
+#include <sstream>
+#include <cstring>
+#include <cstdio>
+
+using namespace icinga;
+
+static PerfdataSpoolRecord MakeRecord(boost::uint32_t objectID, boost::uint32_t labelID, double ts, double value)
+{
+	PerfdataSpoolRecord record;
+	memset(&record, 0, sizeof(record));
+	record.Timestamp = ts;
+	record.ObjectID = objectID;
+	record.LabelID = labelID;
+	record.Value = value;
+	return record;
+}
+
+static void RemoveSpool(const String& path)
+{
+	(void) remove(path.CStr());
+	(void) remove((path + ".dict").CStr());
+}
+
+BOOST_AUTO_TEST_SUITE(perfdata_perfdataspool)
+
+BOOST_AUTO_TEST_CASE(roundtrip)
+{
+	String path = "perfdata-perfdataspool-roundtrip.spool";
+
+	PerfdataSpoolWriter::Ptr writer = new PerfdataSpoolWriter(path, 4);
+	boost::uint32_t obj = writer->InternObject("host1", "disk", "disk");
+	BOOST_CHECK(writer->InternObject("host1", "disk", "disk") == obj);
+	boost::uint32_t label = writer->InternLabel("/var", "B");
+
+	PerfdataSpoolRecord record = MakeRecord(obj, label, 1000, 42.5);
+	record.Flags = PerfdataSpoolHasWarn | PerfdataSpoolHasCrit;
+	record.Warn = 80;
+	record.Crit = 90;
+	record.State = 1;
+
+	BOOST_CHECK(writer->Append(record));
+
+	for (int i = 0; i < 3; i++)
+		BOOST_CHECK(writer->Append(MakeRecord(obj, label, 1001 + i, i)));
+
+	BOOST_CHECK(!writer->Append(record));
+	BOOST_CHECK(writer->GetCount() == 4);
+	writer->Close();
+
+	PerfdataSpoolReader::Ptr reader = new PerfdataSpoolReader(path);
+	BOOST_CHECK(reader->GetCount() == 4);
+
+	const PerfdataSpoolRecord& first = reader->GetRecord(0);
+	BOOST_CHECK(first.Value == 42.5);
+	BOOST_CHECK(first.State == 1);
+	BOOST_CHECK(reader->GetObject(first.ObjectID).Host == "host1");
+	BOOST_CHECK(reader->GetLabel(first.LabelID).Unit == "B");
+	BOOST_CHECK(reader->FormatValue(first) == "/var=42.500000B;80;90");
+	BOOST_CHECK_THROW(reader->GetRecord(4), std::out_of_range);
+
+	reader.reset();
+	RemoveSpool(path);
+}
+
+BOOST_AUTO_TEST_CASE(legacy_text)
+{
+	String path = "perfdata-perfdataspool-legacy.spool";
+
+	PerfdataSpoolWriter::Ptr writer = new PerfdataSpoolWriter(path, 16);
+	boost::uint32_t svc = writer->InternObject("host1", "load", "load");
+	boost::uint32_t hst = writer->InternObject("host1", "", "hostalive");
+	boost::uint32_t load1 = writer->InternLabel("load1", "");
+	boost::uint32_t load5 = writer->InternLabel("load5", "");
+	boost::uint32_t rta = writer->InternLabel("rta", "s");
+
+	writer->Append(MakeRecord(svc, load1, 1000, 1));
+	writer->Append(MakeRecord(svc, load5, 1000, 2));
+	writer->Append(MakeRecord(hst, rta, 1000, 0.5));
+	writer->Close();
+
+	std::ostringstream msgbuf;
+	PerfdataSpoolReader::Ptr reader = new PerfdataSpoolReader(path);
+	reader->WriteLegacyText(msgbuf);
+
+	BOOST_CHECK(msgbuf.str() ==
+	    "DATATYPE::SERVICEPERFDATA\tTIMET::1000\tHOSTNAME::host1\tSERVICEDESC::load\tSERVICEPERFDATA::load1=1 load5=2\t"
+	    "SERVICECHECKCOMMAND::load\tHOSTSTATE::UP\tHOSTSTATETYPE::SOFT\tSERVICESTATE::OK\tSERVICESTATETYPE::SOFT\n"
+	    "DATATYPE::HOSTPERFDATA\tTIMET::1000\tHOSTNAME::host1\tHOSTPERFDATA::rta=0.500000s\t"
+	    "HOSTCHECKCOMMAND::hostalive\tHOSTSTATE::UP\tHOSTSTATETYPE::SOFT\n");
+
+	reader.reset();
+	RemoveSpool(path);
+}
+
+BOOST_AUTO_TEST_CASE(plugin_perfdata)
+{
+	String path = "perfdata-perfdataspool-plugin.spool";
+
+	Array::Ptr pd = PluginUtility::SplitPerfdata("rta=0.5ms;100;500;0 pl=0%;20;60;0;100");
+
+	std::vector<PerfdataValue::Ptr> values;
+
+	{
+		ObjectLock olock(pd);
+		for (const Value& val : pd)
+			values.push_back(PerfdataValue::Parse(val));
+	}
+
+	PerfdataSpoolWriter::Ptr writer = new PerfdataSpoolWriter(path, 16);
+	boost::uint32_t obj = writer->InternObject("host1", "ping4", "ping4");
+
+	for (int i = 0; i < 3; i++) {
+		for (const PerfdataValue::Ptr& pdv : values) {
+			PerfdataSpoolRecord record = MakeRecord(obj, writer->InternLabel(pdv->GetLabel(), pdv->GetUnit()), 1000 + i, pdv->GetValue());
+			record.Warn = pdv->GetWarn();
+			record.Crit = pdv->GetCrit();
+			record.Min = pdv->GetMin();
+			record.Flags = PerfdataSpoolHasWarn | PerfdataSpoolHasCrit | PerfdataSpoolHasMin;
+			BOOST_CHECK(writer->Append(record));
+		}
+	}
+
+	BOOST_CHECK(writer->GetCount() == 3 * values.size());
+	writer->Close();
+
+	PerfdataSpoolReader::Ptr reader = new PerfdataSpoolReader(path);
+	BOOST_CHECK(reader->GetCount() == 3 * values.size());
+
+	const PerfdataSpoolRecord& last = reader->GetRecord(reader->GetCount() - 1);
+	BOOST_CHECK(last.Timestamp == 1002);
+	BOOST_CHECK(reader->GetObject(last.ObjectID).Service == "ping4");
+	BOOST_CHECK(reader->GetLabel(last.LabelID).Label == "pl");
+
+	reader.reset();
+	RemoveSpool(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
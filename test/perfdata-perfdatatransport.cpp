@@ -0,0 +1,230 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "perfdata/perfdatatransport.hpp"
+#include "base/convert.hpp"
+#include "base/utility.hpp"
+#include <boost/thread.hpp>
+#include <BoostTestTargetConfig.h>
+#include <cstring>
+#include <csignal>
+
+using namespace icinga;
+
+static int OpenListener(String& port)
+{
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+	/* Keep the socket buffers small so that the sender has to wait for us. */
+	int bufsize = 4096;
+	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char *>(&bufsize), sizeof(bufsize));
+
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+	listen(fd, 5);
+
+	socklen_t len = sizeof(addr);
+	getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len);
+	port = Convert::ToString(ntohs(addr.sin_port));
+
+	return fd;
+}
+
+static int AcceptClient(int fd)
+{
+	struct timeval tv;
+	tv.tv_sec = 30;
+	tv.tv_usec = 0;
+
+	fd_set readfds;
+	FD_ZERO(&readfds);
+	FD_SET(fd, &readfds);
+
+	if (select(fd + 1, &readfds, NULL, NULL, &tv) <= 0)
+		return -1;
+
+	int client = accept(fd, NULL, NULL);
+
+	setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char *>(&tv), sizeof(tv));
+
+	return client;
+}
+
+static String ReadExactly(int client, size_t length)
+{
+	String data;
+	char buffer[1024];
+
+	while (data.GetLength() < length) {
+		ssize_t rc = recv(client, buffer, std::min(sizeof(buffer), length - data.GetLength()), 0);
+
+		if (rc <= 0)
+			break;
+
+		data += String(buffer, buffer + rc);
+	}
+
+	return data;
+}
+
+static Dictionary::Ptr GetStats(const PerfdataTransport::Ptr& transport)
+{
+	return transport->GetStats("transport", new Array());
+}
+
+static bool WaitForSent(const PerfdataTransport::Ptr& transport, int sent)
+{
+	for (int i = 0; i < 300; i++) {
+		if (GetStats(transport)->Get("sent") == sent)
+			return true;
+
+		Utility::Sleep(0.1);
+	}
+
+	return false;
+}
+
+BOOST_AUTO_TEST_SUITE(perfdata_perfdatatransport)
+
+BOOST_AUTO_TEST_CASE(bounded_queue)
+{
+	PerfdataTransport::Ptr transport = new PerfdataTransport("PerfdataTransportTest", "127.0.0.1", "0", 4);
+
+	transport->Enqueue("a\n");
+	transport->Enqueue("b\nc\n", 2);
+	transport->Enqueue("d\ne\n", 2);
+	transport->Enqueue("f\n");
+	transport->Enqueue("g\n");
+
+	Array::Ptr perfdata = new Array();
+	Dictionary::Ptr stats = transport->GetStats("transport", perfdata);
+
+	BOOST_CHECK(stats->Get("queued") == 4);
+	BOOST_CHECK(stats->Get("dropped") == 3);
+	BOOST_CHECK(stats->Get("sent") == 0);
+	BOOST_CHECK(stats->Get("connected") == false);
+	BOOST_CHECK(perfdata->GetLength() == 3);
+
+	transport->Stop();
+}
+
+BOOST_AUTO_TEST_CASE(batching)
+{
+	String port;
+	int fd = OpenListener(port);
+
+	PerfdataTransport::Ptr transport = new PerfdataTransport("PerfdataTransportTest", "127.0.0.1", port, 1000);
+
+	/* Chunks are added to a batch until it holds at least 64 KiB,
+	 * i.e. every batch is made up of 66 of these 1000 byte chunks. */
+	const int chunks = 200;
+	const int chunksPerBatch = 66;
+
+	String expected;
+
+	for (int i = 0; i < chunks; i++) {
+		String chunk = String(999, 'a' + i % 26) + "\n";
+		transport->Enqueue(chunk);
+		expected += chunk;
+	}
+
+	transport->Start();
+
+	int client = AcceptClient(fd);
+	BOOST_REQUIRE(client >= 0);
+
+	String data;
+
+	while (data.GetLength() < expected.GetLength()) {
+		String part = ReadExactly(client, std::min<size_t>(4096, expected.GetLength() - data.GetLength()));
+
+		if (part.IsEmpty())
+			break;
+
+		data += part;
+
+		/* The sent counter only ever advances by whole batches. */
+		int sent = GetStats(transport)->Get("sent");
+		BOOST_CHECK(sent % chunksPerBatch == 0 || sent == chunks);
+	}
+
+	BOOST_CHECK(data == expected);
+	BOOST_CHECK(WaitForSent(transport, chunks));
+
+	Dictionary::Ptr stats = GetStats(transport);
+	BOOST_CHECK(stats->Get("queued") == 0);
+	BOOST_CHECK(stats->Get("dropped") == 0);
+	BOOST_CHECK(stats->Get("connected") == true);
+
+	transport->Stop();
+
+	close(client);
+	close(fd);
+}
+
+BOOST_AUTO_TEST_CASE(replay_after_failure)
+{
+	/* The transport would otherwise be killed by writing to the reset connection. */
+	signal(SIGPIPE, SIG_IGN);
+
+	String port;
+	int fd = OpenListener(port);
+
+	PerfdataTransport::Ptr transport = new PerfdataTransport("PerfdataTransportTest", "127.0.0.1", port, 10);
+
+	transport->Enqueue("first\n");
+	transport->Start();
+
+	int client = AcceptClient(fd);
+	BOOST_REQUIRE(client >= 0);
+	BOOST_CHECK(ReadExactly(client, 6) == "first\n");
+	BOOST_CHECK(WaitForSent(transport, 1));
+
+	/* Reset the connection so that the next write fails. */
+	struct linger lin;
+	lin.l_onoff = 1;
+	lin.l_linger = 0;
+	setsockopt(client, SOL_SOCKET, SO_LINGER, reinterpret_cast<const char *>(&lin), sizeof(lin));
+	close(client);
+
+	Utility::Sleep(0.5);
+
+	transport->Enqueue("second\n");
+
+	/* The transport reconnects after 10 seconds and sends the failed batch again. */
+	client = AcceptClient(fd);
+	BOOST_REQUIRE(client >= 0);
+	BOOST_CHECK(ReadExactly(client, 7) == "second\n");
+	BOOST_CHECK(WaitForSent(transport, 2));
+
+	Dictionary::Ptr stats = GetStats(transport);
+	BOOST_CHECK(stats->Get("queued") == 0);
+	BOOST_CHECK(stats->Get("dropped") == 0);
+
+	transport->Stop();
+
+	close(client);
+	close(fd);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,109 @@
+/******************************************************************************
+ * Icinga 2                                                                   *
+ * Copyright (C) 2012-2017 Icinga Development Team (https://www.icinga.com/)  *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or              *
+ * modify it under the terms of the GNU General Public License                *
+ * as published by the Free Software Foundation; either version 2             *
+ * of the License, or (at your option) any later version.                     *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU General Public License for more details.                               *
+ *                                                                            *
+ * You should have received a copy of the GNU General Public License          *
+ * along with this program; if not, write to the Free Software Foundation     *
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.             *
+ ******************************************************************************/
+
+#include "remote/rendezvoushash.hpp"
+#include "base/convert.hpp"
+#include <BoostTestTargetConfig.h>
+
+using namespace icinga;
+
+BOOST_AUTO_TEST_SUITE(remote_rendezvoushash)
+
+BOOST_AUTO_TEST_CASE(distribution)
+{
+	RendezvousHash ring;
+	BOOST_CHECK(ring.GetNode("host1") == -1);
+
+	ring.AddNode("master1");
+	ring.AddNode("master2");
+	ring.AddNode("master3");
+
+	int counts[3] = { 0, 0, 0 };
+
+	for (int i = 0; i < 9000; i++) {
+		String key = "host" + Convert::ToString(i) + "!ping";
+		int node = ring.GetNode(key);
+		BOOST_REQUIRE(node >= 0 && node < 3);
+		BOOST_CHECK(ring.GetNode(key) == node);
+		counts[node]++;
+	}
+
+	for (int i = 0; i < 3; i++)
+		BOOST_CHECK(counts[i] > 2700 && counts[i] < 3300);
+}
+
+BOOST_AUTO_TEST_CASE(minimal_movement)
+{
+	RendezvousHash all, partial;
+	all.AddNode("master1");
+	all.AddNode("master2");
+	all.AddNode("master3");
+	partial.AddNode("master1");
+	partial.AddNode("master3");
+
+	int moved = 0;
+
+	for (int i = 0; i < 3000; i++) {
+		String key = "host" + Convert::ToString(i);
+		int before = all.GetNode(key);
+		int after = partial.GetNode(key);
+
+		/* Only keys owned by the missing node may change owner. */
+		if (before == 1) {
+			moved++;
+			BOOST_CHECK(after == 0 || after == 1);
+		} else
+			BOOST_CHECK(after == (before == 0 ? 0 : 1));
+	}
+
+	BOOST_CHECK(moved > 800 && moved < 1200);
+}
+
+BOOST_AUTO_TEST_CASE(weights)
+{
+	RendezvousHash ring;
+	ring.AddNode("small", 1);
+	ring.AddNode("large", 3);
+	ring.AddNode("disabled", 0);
+
+	int counts[3] = { 0, 0, 0 };
+
+	for (int i = 0; i < 8000; i++)
+		counts[ring.GetNode("service" + Convert::ToString(i))]++;
+
+	BOOST_CHECK(counts[0] > 1700 && counts[0] < 2300);
+	BOOST_CHECK(counts[1] > 5700 && counts[1] < 6300);
+	BOOST_CHECK(counts[2] == 0);
+}
+
+BOOST_AUTO_TEST_CASE(zero_weight_fallback)
+{
+	RendezvousHash ring;
+	ring.AddNode("standby1", 0);
+	ring.AddNode("standby2", 0);
+
+	int counts[2] = { 0, 0 };
+
+	for (int i = 0; i < 1000; i++)
+		counts[ring.GetNode("service" + Convert::ToString(i))]++;
+
+	BOOST_CHECK(counts[0] > 0 && counts[1] > 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()